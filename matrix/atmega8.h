@@ -40,6 +40,13 @@ Author:
 #define HlDisableInterrupts() __asm__ __volatile__ ("cli" ::)
 #define HlEnableInterrupts() __asm__ __volatile__ ("sei" ::)
 
+//
+// This macro puts the processor into the sleep mode selected in the sleep
+// control register until an interrupt comes in.
+//
+
+#define HlSleep() __asm__ __volatile__ ("sleep" ::)
+
 //
 // This macro is used to create an Interrrupt Service Routine function.
 // The Vector parameter must be one of the vector names valid for the
@@ -119,6 +126,7 @@ Author:
 #define SPI_CONTROL 0x4C
 #define SPI_STATUS 0x4D
 #define SPI_DATA 0x4E
+#define SLEEP_CONTROL 0x53
 #define TIMER0_CONTROL_A 0x44
 #define TIMER0_CONTROL_B 0x45
 #define TIMER0_COUNTER 0x46
@@ -136,6 +144,12 @@ Author:
 #define TIMER1_COUNTER_LOW 0x84
 #define TIMER1_COMPARE_A_LOW 0x88
 #define TIMER1_COMPARE_A_HIGH 0x89
+#define USART_CONTROL_A 0xC0
+#define USART_CONTROL_B 0xC1
+#define USART_CONTROL_C 0xC2
+#define USART_BAUD_RATE_LOW 0xC4
+#define USART_BAUD_RATE_HIGH 0xC5
+#define USART_DATA 0xC6
 
 //
 // Timer 0 control bits.
@@ -187,12 +201,22 @@ Author:
 
 #define SPI_STATUS_INTERRUPT 0x80
 
+//
+// Sleep control bits.
+//
+
+#define SLEEP_CONTROL_ENABLE 0x01
+#define SLEEP_CONTROL_IDLE 0x00
+
 //
 // Analog to Digital (ADC) Control A bits.
 //
 
 #define ADC_CONTROL_A_GLOBAL_ENABLE 0x80
 #define ADC_CONTROL_A_START_CONVERSION 0x40
+#define ADC_CONTROL_A_AUTO_TRIGGER 0x20
+#define ADC_CONTROL_A_INTERRUPT_FLAG 0x10
+#define ADC_CONTROL_A_INTERRUPT_ENABLE 0x08
 #define ADC_CONTROL_A_PRESCALE_128 0x7
 
 //
@@ -208,6 +232,30 @@ Author:
 #define ADC_SELECTOR_AREF 0x00
 #define ADC_SELECTOR_AVCC 0x40
 #define ADC_SELECTOR_1V 0xC0
+#define ADC_SELECTOR_LEFT_ADJUST 0x20
+
+//
+// USART Control A bits.
+//
+
+#define USART_CONTROL_A_RECEIVE_COMPLETE 0x80
+#define USART_CONTROL_A_DATA_EMPTY 0x20
+#define USART_CONTROL_A_DATA_OVERRUN 0x08
+#define USART_CONTROL_A_DOUBLE_SPEED 0x02
+
+//
+// USART Control B bits.
+//
+
+#define USART_CONTROL_B_RECEIVE_INTERRUPT_ENABLE 0x80
+#define USART_CONTROL_B_RECEIVE_ENABLE 0x10
+#define USART_CONTROL_B_TRANSMIT_ENABLE 0x08
+
+//
+// USART Control C bits.
+//
+
+#define USART_CONTROL_C_8_BIT_CHARACTERS 0x06
 
 //
 // Valid ISR Vectors.
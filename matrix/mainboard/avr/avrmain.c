@@ -66,6 +66,23 @@ Environment:
 
 #define INPUT_PARALLEL_LOAD_SPIN_COUNT 1000
 
+//
+// Define the number of analog inputs the background scan cycles through,
+// starting from the external temperature input, and how heavily each reading
+// is filtered. Each new reading counts for one eighth of the cached value.
+//
+
+#define ANALOG_SCAN_CHANNELS 4
+#define ANALOG_FILTER_SHIFT 3
+
+//
+// Define the ADC settings for single conversions during the background scan.
+//
+
+#define ADC_SCAN_CONTROL \
+    (ADC_CONTROL_A_GLOBAL_ENABLE | ADC_CONTROL_A_INTERRUPT_ENABLE | \
+     ADC_CONTROL_A_PRESCALE_128)
+
 //
 // Define LCD control bits, which are all off of port C.
 //
@@ -134,6 +151,25 @@ Environment:
 #define LCD_FUNCTION_4_BIT_BUS 0x00
 #define LCD_FUNCTION_8_BIT_BUS 0x10
 
+//
+// Define the number of character cells on the LCD.
+//
+
+#define LCD_CELLS (2 * LCD_LINE_LENGTH)
+
+//
+// Define the number of no-op loops to hold each edge of the LCD enable pulse
+// for, which needs to be about half a microsecond.
+//
+
+#define LCD_ENABLE_SPIN_COUNT 4
+
+//
+// Define the size of the serial receive buffer, which must be a power of two.
+//
+
+#define SERIAL_BUFFER_SIZE 128
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -144,7 +180,12 @@ Environment:
 
 VOID
 HlpSendDisplay (
-    VOID
+    USHORT Tiles
+    );
+
+VOID
+HlpSendTile (
+    UCHAR Tile
     );
 
 UCHAR
@@ -152,8 +193,8 @@ HlpWriteSpiByte (
     UCHAR Byte
     );
 
-USHORT
-HlpReadAnalogSignal (
+VOID
+HlpSelectAnalogChannel (
     UCHAR InputChannel
     );
 
@@ -173,6 +214,17 @@ HlpWriteLcdCommand (
     UCHAR Data
     );
 
+VOID
+HlpSendLcdByte (
+    UCHAR ControlBits,
+    UCHAR Data
+    );
+
+VOID
+HlpUpdateLcd (
+    VOID
+    );
+
 UCHAR
 HlpSendSpiByte (
     UCHAR Byte
@@ -192,6 +244,74 @@ HlpNoop (
 // -------------------------------------------------------------------- Globals
 //
 
+//
+// Remember whether an outer timer interrupt is busy refreshing the display.
+//
+
+volatile UCHAR HlRefreshInProgress;
+
+//
+// Define the audio capture ring buffer. The ADC interrupt is the only writer,
+// and the head always points at the oldest sample, which is the next one to
+// be overwritten.
+//
+
+volatile UCHAR HlAudioSamples[AUDIO_BUFFER_SIZE];
+volatile UCHAR HlAudioSampleHead;
+volatile UCHAR HlAudioCaptureRunning;
+
+//
+// Define the filtered value of each scanned analog input, left adjusted to
+// 16 bits, and the index of the input being converted now.
+//
+
+volatile USHORT HlAnalogValues[ANALOG_SCAN_CHANNELS];
+volatile UCHAR HlAnalogScanIndex;
+
+//
+// Define the state of the random number generator. The ADC interrupt stirs
+// the noise from every conversion into it.
+//
+
+volatile USHORT HlRandomState;
+
+//
+// Define the LCD shadow buffers. Printing only stores into the requested
+// contents, and the periodic timer interrupt trickles out the cells that
+// differ from what the LCD is showing. Each buffer has a single writer, so
+// neither side needs to disable interrupts.
+//
+
+volatile UCHAR HlLcdContents[LCD_CELLS];
+volatile UCHAR HlLcdDisplayed[LCD_CELLS];
+
+//
+// Define the address the next printed character goes to, and the address the
+// LCD's own cursor is sitting at.
+//
+
+UCHAR HlLcdCursor;
+UCHAR HlLcdHardwareAddress;
+
+//
+// Store the tile number being offered to whichever slave has its button held
+// down, or SLAVE_TILE_NONE.
+//
+
+volatile UCHAR HlSlaveTileRequest;
+
+//
+// Define the serial receive ring buffer. The receive interrupt only moves the
+// head and the reader only moves the tail, and one entry is always left empty
+// to tell a full buffer from an empty one. The overflow flag is set when a
+// byte had to be thrown away.
+//
+
+volatile UCHAR HlSerialBuffer[SERIAL_BUFFER_SIZE];
+volatile UCHAR HlSerialHead;
+volatile UCHAR HlSerialTail;
+volatile UCHAR HlSerialOverflowed;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -221,6 +341,18 @@ Return Value:
 
     USHORT TickCount;
 
+    //
+    // Get the ADC ready for the background scan, which the periodic timer
+    // kicks off.
+    //
+
+    HlRandomState = 1;
+    HlAnalogScanIndex = 0;
+    HlSlaveTileRequest = SLAVE_TILE_NONE;
+    HlpSelectAnalogChannel(ANALOG_INPUT_EXTERNAL_TEMPERATURE);
+    HlWriteIo(ADC_CONTROL_B, ADC_CONTROL_B_FREE_RUNNING);
+    HlWriteIo(ADC_CONTROL_A, ADC_SCAN_CONTROL);
+
     //
     // Set up the periodic timer interrupt to generate an interrupt every 1ms.
     //
@@ -275,7 +407,64 @@ Return Value:
 
 {
 
-    return HlpReadAnalogSignal(ANALOG_INPUT_AUDIO);
+    USHORT State;
+
+    //
+    // Step a xorshift generator. If the ADC interrupt stirs in a sample in the
+    // middle of this, one of the two updates is lost, which is harmless.
+    //
+
+    State = HlRandomState;
+    State ^= State << 7;
+    State ^= State >> 9;
+    State ^= State << 8;
+    HlRandomState = State;
+    return State;
+}
+
+USHORT
+HlReadAnalogInput (
+    UCHAR Input
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the latest filtered value of an analog input. The
+    inputs are sampled in the background, so this never waits on the ADC.
+
+Arguments:
+
+    Input - Supplies the analog input to read. See ANALOG_INPUT_*
+        definitions.
+
+Return Value:
+
+    Returns the 10-bit value of the input.
+
+--*/
+
+{
+
+    UCHAR Index;
+    USHORT Value;
+
+    Index = Input - ANALOG_INPUT_EXTERNAL_TEMPERATURE;
+    if (Index >= ANALOG_SCAN_CHANNELS) {
+        return 0;
+    }
+
+    //
+    // The interrupt may update the value between reading its two bytes, so
+    // read until it holds still.
+    //
+
+    do {
+        Value = HlAnalogValues[Index];
+    } while (Value != HlAnalogValues[Index]);
+
+    return Value >> 6;
 }
 
 VOID
@@ -504,7 +693,7 @@ Return Value:
         }
     }
 
-    HlpSendDisplay();
+    KeDisplayDirty = TRUE;
     return;
 }
 
@@ -531,7 +720,13 @@ Return Value:
 
 {
 
-    HlpWriteLcdCommand(LCD_CONTROL_WRITE, LCD_COMMAND_CLEAR_DISPLAY);
+    UCHAR Cell;
+
+    for (Cell = 0; Cell < LCD_CELLS; Cell += 1) {
+        HlLcdContents[Cell] = ' ';
+    }
+
+    HlLcdCursor = LCD_FIRST_LINE;
     return;
 }
 
@@ -559,9 +754,7 @@ Return Value:
 
 {
 
-    HlpWriteLcdCommand(LCD_CONTROL_WRITE,
-                       LCD_COMMAND_SET_DDRAM_ADDRESS | Address);
-
+    HlLcdCursor = Address;
     return;
 }
 
@@ -694,6 +887,65 @@ Return Value:
 
 VOID
 HlUpdateDisplay (
+    USHORT Tiles
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends out the matrix and samples the inputs. It is called by
+    the executive from the periodic timer interrupt, applications should set
+    KeDisplayDirty instead.
+
+Arguments:
+
+    Tiles - Supplies the mask of slave tiles to send out.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    HlpSendDisplay(Tiles);
+    HlUpdateInputs();
+    return;
+}
+
+VOID
+HlRequestSlaveTile (
+    UCHAR Tile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine offers a tile number to the matrix slaves with every frame
+    sent out, until it is called again. A slave takes the number if its button
+    is held down, and keeps it across power cycles.
+
+Arguments:
+
+    Tile - Supplies the tile number to offer, or SLAVE_TILE_NONE to stop.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    HlSlaveTileRequest = Tile;
+    return;
+}
+
+VOID
+HlUpdateInputs (
     VOID
     )
 
@@ -701,7 +953,7 @@ HlUpdateDisplay (
 
 Routine Description:
 
-    This routine allows the hardware layer to update the matrix display.
+    This routine samples the inputs without sending out the matrix.
 
 Arguments:
 
@@ -715,15 +967,10 @@ Return Value:
 
 {
 
+    USHORT NewEdges;
     USHORT NewInputs;
     UCHAR PortB;
 
-    //
-    // Send out the matrix.
-    //
-
-    HlpSendDisplay();
-
     //
     // Toggle the input capture pin to snap the input values.
     //
@@ -742,29 +989,34 @@ Return Value:
     NewInputs = ~NewInputs;
 
     //
-    // OR in the values that have just turned on.
+    // OR in the values that have just turned on, and queue them up so that
+    // several presses between polls aren't lost.
     //
 
-    KeInputEdges |= (KeRawInputs ^ NewInputs) & NewInputs;
+    NewEdges = (KeRawInputs ^ NewInputs) & NewInputs;
+    KeInputEdges |= NewEdges;
     KeRawInputs = NewInputs;
+    if (NewEdges != 0) {
+        KeQueueInputEvent(NewEdges);
+    }
+
     HlWriteIo(PORTB, PortB | SPI_LOCAL_SLAVE_SELECT);
     HlpNoop(INPUT_PARALLEL_LOAD_SPIN_COUNT);
     HlWriteIo(PORTB, PortB);
     return;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
-ISR(TIMER1_COMPARE_A_VECTOR, ISR_BLOCK)
+VOID
+HlWaitForInterrupt (
+    VOID
+    )
 
 /*++
 
 Routine Description:
 
-    This routine implements the periodic timer interrupt service routine
-    function. This ISR leaves interrupts disabled the entire time.
+    This routine idles the processor until the next interrupt, which is at
+    most one periodic timer tick away.
 
 Arguments:
 
@@ -778,12 +1030,19 @@ Return Value:
 
 {
 
-    KeUpdateTime(PERIODIC_TIMER_RATE * (ULONG)32 / 1000);
+    //
+    // Idle mode leaves the timers and SPI running. If an interrupt sneaks in
+    // just before the sleep instruction, this sleeps for one extra tick.
+    //
+
+    HlWriteIo(SLEEP_CONTROL, SLEEP_CONTROL_IDLE | SLEEP_CONTROL_ENABLE);
+    HlSleep();
+    HlWriteIo(SLEEP_CONTROL, 0);
     return;
 }
 
 VOID
-HlpSendDisplay (
+HlEnterCriticalSection (
     VOID
     )
 
@@ -791,7 +1050,9 @@ HlpSendDisplay (
 
 Routine Description:
 
-    This routine sends the contents of the screen out to the SPI bus.
+    This routine holds off the periodic timer and input interrupts, so that
+    state they share with the application can be updated atomically. It
+    must not be called from an interrupt.
 
 Arguments:
 
@@ -805,190 +1066,781 @@ Return Value:
 
 {
 
-    UCHAR Length;
-    UCHAR PortB;
-    UCHAR ProtocolColumn;
-    UCHAR ProtocolRow;
-    USHORT RunningColor;
-
-    //
-    // Pull down the slave select line.
-    //
-
-    PortB = HlReadIo(PORTB) & (~SPI_MATRIX_SLAVE_SELECT);
-    HlWriteIo(PORTB, PortB);
-
-    //
-    // Write out the start of frame.
-    //
-
-    HlpWriteSpiByte(SYNC_BYTE0);
-    HlpWriteSpiByte(SYNC_BYTE1);
-    HlpWriteSpiByte(SYNC_BYTE2);
-
-    //
-    // Send out the screen.
-    //
+    HlDisableInterrupts();
+    return;
+}
 
-    RunningColor = KeMatrix[0][0];
-    Length = 0;
-    for (ProtocolRow = 0;
-         ProtocolRow < MATRIX_PROTOCOL_ROWS;
-         ProtocolRow += 1) {
+VOID
+HlLeaveCriticalSection (
+    VOID
+    )
 
-        for (ProtocolColumn = 0;
-             ProtocolColumn < MATRIX_PROTOCOL_COLUMNS;
-             ProtocolColumn += 1) {
+/*++
 
-            //
-            // If the color here doesn't match the current run or the
-            // maximum length has been reached, send the current run out.
-            //
+Routine Description:
 
-            if ((Length == 0xFF) ||
-                (KeMatrix[ProtocolRow][ProtocolColumn] != RunningColor)) {
+    This routine lets the interrupts held off by HlEnterCriticalSection run
+    again.
 
-                HlpWriteSpiByte(Length);
-                HlpWriteSpiByte((UCHAR)(RunningColor >> 8));
-                HlpWriteSpiByte((UCHAR)RunningColor);
-                HlpInternalStall(32);
-                Length = 1;
-                RunningColor = KeMatrix[ProtocolRow][ProtocolColumn];
+Arguments:
 
-            //
-            // The length is not too long and this pixel agrees with the last
-            // one, so add to the current run.
-            //
+    None.
 
-            } else {
-                Length += 1;
-            }
-        }
-    }
+Return Value:
 
-    //
-    // Send out the last fragment.
-    //
+    None.
 
-    HlpWriteSpiByte(Length);
-    HlpWriteSpiByte((UCHAR)(RunningColor >> 8));
-    HlpWriteSpiByte((UCHAR)RunningColor);
+--*/
 
-    //
-    // Pull the slave select line up to complete the transmission.
-    //
+{
 
-    HlWriteIo(PORTB, PortB | SPI_MATRIX_SLAVE_SELECT);
+    HlEnableInterrupts();
     return;
 }
 
-UCHAR
-HlpWriteSpiByte (
-    UCHAR Byte
+VOID
+HlStartAudioCapture (
+    VOID
     )
 
 /*++
 
 Routine Description:
 
-    This routine writes a byte of data out to the SPI interface.
+    This routine starts sampling the audio input continuously in the
+    background. The other analog inputs keep their last values while the
+    capture is running.
 
 Arguments:
 
-    Byte - Supplies the byte to write.
+    None.
 
 Return Value:
 
-    Returns the byte read from the SPI bus while pushing out the byte.
+    None.
 
 --*/
 
 {
 
-    //
-    // Send the data out.
-    //
-
-    HlWriteIo(SPI_DATA, Byte);
+    UCHAR Index;
 
     //
-    // Wait until the previous transfer has completed.
+    // Stop the background scan, and let any conversion it has going finish
+    // before the ring buffer is reset.
     //
 
-    while ((HlReadIo(SPI_STATUS) & SPI_STATUS_INTERRUPT) == 0) {
+    HlAudioCaptureRunning = TRUE;
+    while ((HlReadIo(ADC_CONTROL_A) & ADC_CONTROL_A_START_CONVERSION) != 0) {
         NOTHING;
     }
 
-    //HlStall(1);
+    for (Index = 0; Index < AUDIO_BUFFER_SIZE; Index += 1) {
+        HlAudioSamples[Index] = 0x80;
+    }
+
+    HlAudioSampleHead = 0;
 
     //
-    // Read and return the data that was shifted in from the transfer.
-    // This also clears the interrupt status bit.
+    // In free running mode a new conversion starts as soon as the last one
+    // finishes, every 13 ADC clocks, which at the slowest prescaler is about
+    // 12kHz. Writing the interrupt flag clears any stale completion.
     //
 
-    return HlReadIo(SPI_DATA);
+    HlpSelectAnalogChannel(ANALOG_INPUT_AUDIO);
+    HlWriteIo(ADC_CONTROL_A,
+              ADC_CONTROL_A_GLOBAL_ENABLE |
+              ADC_CONTROL_A_START_CONVERSION |
+              ADC_CONTROL_A_AUTO_TRIGGER |
+              ADC_CONTROL_A_INTERRUPT_FLAG |
+              ADC_CONTROL_A_INTERRUPT_ENABLE |
+              ADC_CONTROL_A_PRESCALE_128);
+
+    return;
+}
+
+VOID
+HlStopAudioCapture (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops the background audio capture.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // Stop free running and wait for the last conversion to finish. Then
+    // throw its result away and point the ADC back where the background scan
+    // left off.
+    //
+
+    HlWriteIo(ADC_CONTROL_A, ADC_SCAN_CONTROL);
+    while ((HlReadIo(ADC_CONTROL_A) & ADC_CONTROL_A_START_CONVERSION) != 0) {
+        NOTHING;
+    }
+
+    HlWriteIo(ADC_CONTROL_A, ADC_SCAN_CONTROL | ADC_CONTROL_A_INTERRUPT_FLAG);
+    HlpSelectAnalogChannel(ANALOG_INPUT_EXTERNAL_TEMPERATURE +
+                           HlAnalogScanIndex);
+
+    HlAudioCaptureRunning = FALSE;
+    return;
+}
+
+VOID
+HlReadAudioSamples (
+    PUCHAR Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies out the most recent audio samples.
+
+Arguments:
+
+    Buffer - Supplies a pointer where AUDIO_BUFFER_SIZE samples will be
+        returned, oldest first. Samples are unsigned 8-bit values centered
+        around 128.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Count;
+    UCHAR Index;
+
+    //
+    // Start at the oldest sample, since it's the one about to be overwritten.
+    // The copy finishes well within one sample period, so the interrupt can't
+    // catch up to it and interrupts can stay on.
+    //
+
+    Index = HlAudioSampleHead;
+    for (Count = 0; Count < AUDIO_BUFFER_SIZE; Count += 1) {
+        Buffer[Count] = HlAudioSamples[Index];
+        Index = (Index + 1) & (AUDIO_BUFFER_SIZE - 1);
+    }
+
+    return;
+}
+
+VOID
+HlStartSerial (
+    ULONG BaudRate
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns on the serial port. Received bytes are buffered in the
+    background until they are read.
+
+Arguments:
+
+    BaudRate - Supplies the baud rate to run the port at.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT Divisor;
+
+    HlSerialHead = 0;
+    HlSerialTail = 0;
+    HlSerialOverflowed = FALSE;
+
+    //
+    // Run the port at double speed, which divides the clock by 8 rather than
+    // 16 and gets closer to the fast baud rates.
+    //
+
+    Divisor = (PROCESSOR_HZ / 8 / BaudRate) - 1;
+    HlWriteIo(USART_BAUD_RATE_HIGH, (UCHAR)(Divisor >> 8));
+    HlWriteIo(USART_BAUD_RATE_LOW, (UCHAR)Divisor);
+    HlWriteIo(USART_CONTROL_A, USART_CONTROL_A_DOUBLE_SPEED);
+    HlWriteIo(USART_CONTROL_C, USART_CONTROL_C_8_BIT_CHARACTERS);
+    HlWriteIo(USART_CONTROL_B,
+              USART_CONTROL_B_RECEIVE_INTERRUPT_ENABLE |
+              USART_CONTROL_B_RECEIVE_ENABLE |
+              USART_CONTROL_B_TRANSMIT_ENABLE);
+
+    return;
+}
+
+VOID
+HlStopSerial (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns off the serial port and throws away anything received.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // Let the last byte sent finish going out.
+    //
+
+    while ((HlReadIo(USART_CONTROL_A) & USART_CONTROL_A_DATA_EMPTY) == 0) {
+        NOTHING;
+    }
+
+    HlWriteIo(USART_CONTROL_B, 0);
+    HlSerialTail = HlSerialHead;
+    return;
+}
+
+UCHAR
+HlReadSerial (
+    PUCHAR Buffer,
+    UCHAR Size,
+    PUCHAR Overflowed
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads whatever has been received on the serial port, without
+    waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the received bytes will be returned.
+
+    Size - Supplies the size of the buffer in bytes.
+
+    Overflowed - Supplies a pointer where TRUE will be returned if bytes were
+        lost since the last read because nobody read them in time.
+
+Return Value:
+
+    Returns the number of bytes read.
+
+--*/
+
+{
+
+    UCHAR Count;
+    UCHAR Head;
+    UCHAR Tail;
+
+    //
+    // Clear the overflow flag before looking at the head, so that a byte lost
+    // after this point is reported next time rather than not at all.
+    //
+
+    *Overflowed = HlSerialOverflowed;
+    if (*Overflowed != FALSE) {
+        HlSerialOverflowed = FALSE;
+    }
+
+    Head = HlSerialHead;
+    Tail = HlSerialTail;
+    Count = 0;
+    while ((Tail != Head) && (Count < Size)) {
+        Buffer[Count] = HlSerialBuffer[Tail];
+        Tail = (Tail + 1) & (SERIAL_BUFFER_SIZE - 1);
+        Count += 1;
+    }
+
+    HlSerialTail = Tail;
+    return Count;
+}
+
+VOID
+HlWriteSerial (
+    UCHAR Byte
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends a byte out of the serial port, waiting for the
+    previous one to get out of the way first.
+
+Arguments:
+
+    Byte - Supplies the byte to send.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    while ((HlReadIo(USART_CONTROL_A) & USART_CONTROL_A_DATA_EMPTY) == 0) {
+        NOTHING;
+    }
+
+    HlWriteIo(USART_DATA, Byte);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+ISR(TIMER1_COMPARE_A_VECTOR, ISR_BLOCK)
+
+/*++
+
+Routine Description:
+
+    This routine implements the periodic timer interrupt service routine
+    function. This ISR leaves interrupts disabled except while it refreshes
+    the display.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeUpdateTime(PERIODIC_TIMER_RATE * (ULONG)32 / 1000);
+
+    //
+    // Start converting the next analog input in the background scan. The last
+    // conversion finished long ago, and the ADC interrupt moves on to the
+    // next input when this one is done.
+    //
+
+    if (HlAudioCaptureRunning == FALSE) {
+        HlWriteIo(ADC_CONTROL_A,
+                  ADC_SCAN_CONTROL | ADC_CONTROL_A_START_CONVERSION);
+    }
+
+    HlpUpdateLcd();
+
+    //
+    // Pushing out a frame takes several timer periods, so do it with
+    // interrupts enabled to keep time ticking. The nested timer interrupts
+    // see the refresh in progress and leave it alone.
+    //
+
+    if ((KeFramePending != FALSE) && (HlRefreshInProgress == FALSE)) {
+        HlRefreshInProgress = TRUE;
+        HlEnableInterrupts();
+        KeRefreshDisplay();
+        HlDisableInterrupts();
+        HlRefreshInProgress = FALSE;
+    }
+
+    return;
+}
+
+ISR(ADC_VECTOR, ISR_BLOCK)
+
+/*++
+
+Routine Description:
+
+    This routine implements the ADC conversion complete interrupt service
+    routine. While the audio capture is running it stores each audio sample,
+    thousands of times a second, so that path does as little as possible.
+    Otherwise it folds the reading into the background scan's cache and moves
+    on to the next input.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Head;
+    UCHAR Index;
+    USHORT Sample;
+    USHORT Value;
+
+    if (HlAudioCaptureRunning != FALSE) {
+        Head = HlAudioSampleHead;
+        Sample = HlReadIo(ADC_DATA_HIGH);
+        HlAudioSamples[Head] = Sample;
+        HlAudioSampleHead = (Head + 1) & (AUDIO_BUFFER_SIZE - 1);
+        HlRandomState ^= Sample;
+        return;
+    }
+
+    //
+    // The low byte must be read first, which locks the result until the high
+    // byte is read.
+    //
+
+    Sample = HlReadIo(ADC_DATA_LOW);
+    Sample |= (USHORT)HlReadIo(ADC_DATA_HIGH) << 8;
+    HlRandomState ^= Sample >> 6;
+    Index = HlAnalogScanIndex;
+    Value = HlAnalogValues[Index];
+    HlAnalogValues[Index] = Value - (Value >> ANALOG_FILTER_SHIFT) +
+                            (Sample >> ANALOG_FILTER_SHIFT);
+
+    Index += 1;
+    if (Index == ANALOG_SCAN_CHANNELS) {
+        Index = 0;
+    }
+
+    HlAnalogScanIndex = Index;
+    HlpSelectAnalogChannel(ANALOG_INPUT_EXTERNAL_TEMPERATURE + Index);
+    return;
+}
+
+ISR(USART_RECEIVE_VECTOR, ISR_BLOCK)
+
+/*++
+
+Routine Description:
+
+    This routine implements the serial receive interrupt service routine,
+    which moves each received byte into the ring buffer.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Data;
+    UCHAR Head;
+    UCHAR NextHead;
+    UCHAR Status;
+
+    //
+    // The status has to be read before the data, which pops it.
+    //
+
+    Status = HlReadIo(USART_CONTROL_A);
+    Data = HlReadIo(USART_DATA);
+    if ((Status & USART_CONTROL_A_DATA_OVERRUN) != 0) {
+        HlSerialOverflowed = TRUE;
+    }
+
+    Head = HlSerialHead;
+    NextHead = (Head + 1) & (SERIAL_BUFFER_SIZE - 1);
+    if (NextHead == HlSerialTail) {
+        HlSerialOverflowed = TRUE;
+        return;
+    }
+
+    HlSerialBuffer[Head] = Data;
+    HlSerialHead = NextHead;
+    return;
+}
+
+VOID
+HlpSendDisplay (
+    USHORT Tiles
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends the contents of the screen out to the SPI bus, one
+    packet per changed slave's tile.
+
+Arguments:
+
+    Tiles - Supplies the mask of tiles to send. Slaves whose tiles aren't sent
+        keep showing what they last received.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR PortB;
+    UCHAR Tile;
+    USHORT TileMask;
+
+    //
+    // Pull down the slave select line.
+    //
+
+    PortB = HlReadIo(PORTB) & (~SPI_MATRIX_SLAVE_SELECT);
+    HlWriteIo(PORTB, PortB);
+
+    //
+    // If a slave is being renumbered, make the offer before the frame. The
+    // complement guards against a garbled number getting written to EEPROM.
+    //
+
+    Tile = HlSlaveTileRequest;
+    if (Tile != SLAVE_TILE_NONE) {
+        HlpWriteSpiByte(SYNC_BYTE0);
+        HlpWriteSpiByte(SYNC_BYTE1);
+        HlpWriteSpiByte(SYNC_BYTE_ADDRESS);
+        HlpWriteSpiByte(Tile);
+        HlpWriteSpiByte(~Tile);
+    }
+
+    //
+    // Send out the screen.
+    //
+
+    TileMask = 1;
+    for (Tile = 0; Tile < MATRIX_TILE_COUNT; Tile += 1) {
+        if ((Tiles & TileMask) != 0) {
+            HlpSendTile(Tile);
+        }
+
+        TileMask <<= 1;
+    }
+
+    //
+    // Pull the slave select line up to complete the transmission.
+    //
+
+    HlWriteIo(PORTB, PortB | SPI_MATRIX_SLAVE_SELECT);
+    return;
 }
 
-USHORT
-HlpReadAnalogSignal (
-    UCHAR InputChannel
+VOID
+HlpSendTile (
+    UCHAR Tile
     )
 
 /*++
 
 Routine Description:
 
-    This routine returns the value of the Analog to Digital Converter at the
-    given channel.
+    This routine sends one slave's tile of the screen out to the SPI bus as a
+    run length encoded packet. The header carries the number of runs so that
+    the other slaves can skip the packet without decoding it.
 
 Arguments:
 
-    InputChannel - Supplies the input analog channel to sample. Valid values
-        are 0 to 8.
+    Tile - Supplies the tile number to send.
 
 Return Value:
 
-    Returns the sampled analog signal value.
+    None.
 
 --*/
 
 {
 
-    UCHAR DataHigh1;
-    UCHAR DataHigh2;
-    UCHAR DataLow;
+    UCHAR Column;
+    UCHAR ColumnEnd;
+    UCHAR ColumnStart;
+    UCHAR Length;
+    UCHAR Row;
+    UCHAR RowEnd;
+    UCHAR RowStart;
+    UCHAR Runs;
+    USHORT RunningColor;
+
+    RowStart = (Tile / MATRIX_TILES_PER_ROW) * MATRIX_TILE_ROWS;
+    RowEnd = RowStart + MATRIX_TILE_ROWS;
+    ColumnStart = (Tile % MATRIX_TILES_PER_ROW) * MATRIX_TILE_COLUMNS;
+    ColumnEnd = ColumnStart + MATRIX_TILE_COLUMNS;
 
     //
-    // Set up the mux to the desired input pin.
+    // Count up the runs first. A tile has fewer pixels than a run can be long,
+    // so only a change in color ends a run.
     //
 
-    HlWriteIo(ADC_SELECTOR, ADC_SELECTOR_AVCC | InputChannel);
+    RunningColor = KeMatrix[RowStart][ColumnStart];
+    Runs = 1;
+    for (Row = RowStart; Row < RowEnd; Row += 1) {
+        for (Column = ColumnStart; Column < ColumnEnd; Column += 1) {
+            if (KeMatrix[Row][Column] != RunningColor) {
+                Runs += 1;
+                RunningColor = KeMatrix[Row][Column];
+            }
+        }
+    }
 
     //
-    // Set the control and status register to enbaled and the slowest prescaling
-    // value. The reference source is AVcc with a capacitor to ground at AREF.
+    // Write out the packet header.
     //
 
-    HlWriteIo(ADC_CONTROL_A,
-              ADC_CONTROL_A_GLOBAL_ENABLE |
-              ADC_CONTROL_A_START_CONVERSION |
-              ADC_CONTROL_A_PRESCALE_128);
+    HlpWriteSpiByte(SYNC_BYTE0);
+    HlpWriteSpiByte(SYNC_BYTE1);
+    HlpWriteSpiByte(SYNC_BYTE_TILE);
+    HlpWriteSpiByte(Tile);
+    HlpWriteSpiByte(Runs);
 
     //
-    // Wait for the conversion to complete.
+    // Send out the runs.
     //
 
-    while ((HlReadIo(ADC_CONTROL_A) & ADC_CONTROL_A_START_CONVERSION) != 0) {
+    RunningColor = KeMatrix[RowStart][ColumnStart];
+    Length = 0;
+    for (Row = RowStart; Row < RowEnd; Row += 1) {
+        for (Column = ColumnStart; Column < ColumnEnd; Column += 1) {
+
+            //
+            // If the color here doesn't match the current run, send the
+            // current run out.
+            //
+
+            if (KeMatrix[Row][Column] != RunningColor) {
+                HlpWriteSpiByte(Length);
+                HlpWriteSpiByte((UCHAR)(RunningColor >> 8));
+                HlpWriteSpiByte((UCHAR)RunningColor);
+                HlpInternalStall(32);
+                Length = 1;
+                RunningColor = KeMatrix[Row][Column];
+
+            //
+            // This pixel agrees with the last one, so add to the current run.
+            //
+
+            } else {
+                Length += 1;
+            }
+        }
+    }
+
+    //
+    // Send out the last fragment.
+    //
+
+    HlpWriteSpiByte(Length);
+    HlpWriteSpiByte((UCHAR)(RunningColor >> 8));
+    HlpWriteSpiByte((UCHAR)RunningColor);
+    return;
+}
+
+UCHAR
+HlpWriteSpiByte (
+    UCHAR Byte
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes a byte of data out to the SPI interface.
+
+Arguments:
+
+    Byte - Supplies the byte to write.
+
+Return Value:
+
+    Returns the byte read from the SPI bus while pushing out the byte.
+
+--*/
+
+{
+
+    //
+    // Send the data out.
+    //
+
+    HlWriteIo(SPI_DATA, Byte);
+
+    //
+    // Wait until the previous transfer has completed.
+    //
+
+    while ((HlReadIo(SPI_STATUS) & SPI_STATUS_INTERRUPT) == 0) {
         NOTHING;
     }
 
-    do {
-        DataHigh1 = HlReadIo(ADC_DATA_HIGH);
-        DataLow = HlReadIo(ADC_DATA_LOW);
-        DataHigh2 = HlReadIo(ADC_DATA_HIGH);
-    } while (DataHigh1 != DataHigh2);
+    //HlStall(1);
+
+    //
+    // Read and return the data that was shifted in from the transfer.
+    // This also clears the interrupt status bit.
+    //
+
+    return HlReadIo(SPI_DATA);
+}
+
+VOID
+HlpSelectAnalogChannel (
+    UCHAR InputChannel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine points the ADC at the given input for the next conversion.
+    The reference source is AVcc with a capacitor to ground at AREF, and the
+    result is left adjusted so the top 8 bits can be read in one go.
+
+Arguments:
+
+    InputChannel - Supplies the input analog channel to sample. Valid values
+        are 0 to 8.
+
+Return Value:
+
+    None.
 
-    return ((USHORT)DataHigh1 << 8) | DataLow;
+--*/
+
+{
+
+    HlWriteIo(ADC_SELECTOR,
+              ADC_SELECTOR_AVCC | ADC_SELECTOR_LEFT_ADJUST | InputChannel);
+
+    return;
 }
 
 VOID
@@ -1060,11 +1912,17 @@ Return Value:
     HlpWriteLcdCommand(LCD_CONTROL_WRITE, DataValue);
 
     //
-    // Clear the screen and set the cursor address to 0.
+    // Clear the screen and set the cursor address to 0. From here on the
+    // shadow buffers match the screen, and the timer keeps it up to date.
     //
 
+    HlpWriteLcdCommand(LCD_CONTROL_WRITE, LCD_COMMAND_CLEAR_DISPLAY);
+    HlLcdHardwareAddress = LCD_FIRST_LINE;
     HlClearLcdScreen();
-    HlSetLcdAddress(0);
+    for (DataValue = 0; DataValue < LCD_CELLS; DataValue += 1) {
+        HlLcdDisplayed[DataValue] = ' ';
+    }
+
     HlLcdPrintString("HI");
     return;
 }
@@ -1078,8 +1936,9 @@ HlpWriteLcdCharacter (
 
 Routine Description:
 
-    This routine writes a character out to the LCD display at its currently set
-    address.
+    This routine stores a character into the LCD shadow buffer at the current
+    address, and moves the address along. The timer sends it to the LCD
+    later. Characters off the right edge of the screen are dropped.
 
 Arguments:
 
@@ -1093,14 +1952,20 @@ Return Value:
 
 {
 
-    //
-    // Writing to the LCD with the register select control line writes the
-    // given value to CGRAM/DDRAM.
-    //
+    UCHAR Cell;
+    UCHAR Cursor;
+
+    Cursor = HlLcdCursor;
+    Cell = Cursor & LCD_LINE_OFFSET_MASK;
+    if (Cell < LCD_LINE_LENGTH) {
+        if ((Cursor & LCD_SECOND_LINE) != 0) {
+            Cell += LCD_LINE_LENGTH;
+        }
 
-    HlpWriteLcdCommand(LCD_CONTROL_WRITE | LCD_CONTROL_REGISTER_SELECT,
-                       Character);
+        HlLcdContents[Cell] = Character;
+    }
 
+    HlLcdCursor = Cursor + 1;
     return;
 }
 
@@ -1114,7 +1979,44 @@ HlpWriteLcdCommand (
 
 Routine Description:
 
-    This routine writes a value to the LCD module.
+    This routine writes a value to the LCD module and waits long enough for
+    any command to complete. It's only used while the LCD is initialized,
+    everything else goes through the shadow buffer.
+
+Arguments:
+
+    ControlBits - Supplies the control bit values to write. See LCD_CONTROL_*
+        definitions. This value must not have the Enable bit set, nor any other
+        non-control bits.
+
+    Data - Supplies the data byte to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    HlpSendLcdByte(ControlBits, Data);
+    HlpInternalStall(2 * 32);
+    return;
+}
+
+VOID
+HlpSendLcdByte (
+    UCHAR ControlBits,
+    UCHAR Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clocks a value into the LCD module without waiting for it to
+    be processed. The caller must leave the LCD at least 40us (or 1.6ms for
+    the clear and home commands) before sending the next one.
 
 Arguments:
 
@@ -1161,15 +2063,101 @@ Return Value:
     HlWriteIo(PORTC, PortValue);
 
     //
-    // Toggle the enable bit on and off, allowing appropriate stabilization
-    // time after every transition.
+    // Toggle the enable bit on and off. The LCD latches the data on the
+    // falling edge.
     //
 
-    HlpInternalStall(32);
+    HlpNoop(LCD_ENABLE_SPIN_COUNT);
     HlWriteIo(PORTC, PortValue | LCD_CONTROL_ENABLE);
-    HlpInternalStall(32);
+    HlpNoop(LCD_ENABLE_SPIN_COUNT);
     HlWriteIo(PORTC, PortValue);
-    HlpInternalStall(32);
+    return;
+}
+
+VOID
+HlpUpdateLcd (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends at most one command to the LCD to bring it closer to
+    the shadow buffer. It's called from the periodic timer interrupt, whose
+    period is plenty for the LCD to finish one command before the next.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Address;
+    UCHAR Cell;
+    UCHAR Character;
+    UCHAR Count;
+
+    //
+    // Start looking from where the LCD's cursor is, so a run of changed cells
+    // goes out without stopping to set the address for each one.
+    //
+
+    Address = HlLcdHardwareAddress;
+    Cell = Address & LCD_LINE_OFFSET_MASK;
+    if (Cell >= LCD_LINE_LENGTH) {
+        Cell = 0;
+
+    } else if ((Address & LCD_SECOND_LINE) != 0) {
+        Cell += LCD_LINE_LENGTH;
+    }
+
+    for (Count = 0; Count < LCD_CELLS; Count += 1) {
+        if (HlLcdContents[Cell] != HlLcdDisplayed[Cell]) {
+            break;
+        }
+
+        Cell += 1;
+        if (Cell == LCD_CELLS) {
+            Cell = 0;
+        }
+    }
+
+    if (Count == LCD_CELLS) {
+        return;
+    }
+
+    if (Cell < LCD_LINE_LENGTH) {
+        Address = LCD_FIRST_LINE + Cell;
+
+    } else {
+        Address = LCD_SECOND_LINE + Cell - LCD_LINE_LENGTH;
+    }
+
+    //
+    // Move the LCD's cursor over first if needed, and write the character on
+    // the next tick. Remember what was written rather than what's in the
+    // buffer now, in case it changes again in the meantime.
+    //
+
+    if (Address != HlLcdHardwareAddress) {
+        HlpSendLcdByte(LCD_CONTROL_WRITE,
+                       LCD_COMMAND_SET_DDRAM_ADDRESS | Address);
+
+        HlLcdHardwareAddress = Address;
+        return;
+    }
+
+    Character = HlLcdContents[Cell];
+    HlpSendLcdByte(LCD_CONTROL_WRITE | LCD_CONTROL_REGISTER_SELECT, Character);
+    HlLcdDisplayed[Cell] = Character;
+    HlLcdHardwareAddress = Address + 1;
     return;
 }
 
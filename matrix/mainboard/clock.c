@@ -37,6 +37,28 @@ Environment:
 
 #define CLOCK_DISPLAYS 3
 
+//
+// Define the parts of the time and date that the clock faces show. The clock
+// remembers the value of each one as it was last drawn, so that a face only
+// redraws the parts that have changed.
+//
+
+#define CLOCK_ELEMENT_MONTH 0
+#define CLOCK_ELEMENT_DATE 1
+#define CLOCK_ELEMENT_WEEKDAY 2
+#define CLOCK_ELEMENT_HOURS 3
+#define CLOCK_ELEMENT_MINUTES 4
+#define CLOCK_ELEMENT_SECONDS 5
+#define CLOCK_ELEMENT_COLON 6
+#define CLOCK_ELEMENT_TEMPERATURE 7
+#define CLOCK_ELEMENT_COUNT 8
+
+//
+// Define the remembered value of an element that hasn't been drawn yet.
+//
+
+#define CLOCK_NOT_DRAWN 0xFF
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -45,19 +67,24 @@ Environment:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+VOID
+CkpResetFace (
+    PUCHAR Drawn
+    );
+
 VOID
 CkpDisplayDigitalClockDetailed (
-    VOID
+    PUCHAR Drawn
     );
 
 VOID
 CkpDisplayBarGraphClock (
-    VOID
+    PUCHAR Drawn
     );
 
 VOID
 CkpDisplayLargeBinaryClock (
-    VOID
+    PUCHAR Drawn
     );
 
 VOID
@@ -67,6 +94,13 @@ CkpDrawBinaryCodedDecimal (
     USHORT Color
     );
 
+VOID
+CkpDrawBarCell (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    USHORT Pixel
+    );
+
 VOID
 CkpDrawSquare (
     UCHAR XPosition,
@@ -132,29 +166,19 @@ Return Value:
 
     UCHAR ClockChoice;
     UCHAR CurrentHalfSeconds;
+    UCHAR Drawn[CLOCK_ELEMENT_COUNT];
     APPLICATION NextApplication;
 
-    KeClearScreen();
-
     ClockChoice = HlRandom() % CLOCK_DISPLAYS;
-    CurrentHalfSeconds = KeCurrentHalfSeconds;
+    CkpResetFace(Drawn);
     while (TRUE) {
-        while (KeCurrentHalfSeconds == CurrentHalfSeconds) {
-            NextApplication = KeRunMenu();
-            KeStallTenthSecond();
-            if (NextApplication != ApplicationNone) {
-                return NextApplication;
-            }
-        }
-
-        CurrentHalfSeconds = KeCurrentHalfSeconds;
 
         //
         // Up and down change the clock face.
         //
 
         if ((KeInputEdges & INPUT_UP1) != 0) {
-            KeInputEdges &= ~INPUT_UP1;
+            KeAcknowledgeInputEdges(INPUT_UP1);
             if (ClockChoice == CLOCK_DISPLAYS - 1) {
                 ClockChoice = 0;
 
@@ -162,11 +186,11 @@ Return Value:
                 ClockChoice += 1;
             }
 
-            KeClearScreen();
+            CkpResetFace(Drawn);
         }
 
         if ((KeInputEdges & INPUT_DOWN1) != 0) {
-            KeInputEdges &= ~INPUT_DOWN1;
+            KeAcknowledgeInputEdges(INPUT_DOWN1);
             if (ClockChoice == 0) {
                 ClockChoice = CLOCK_DISPLAYS - 1;
 
@@ -174,25 +198,45 @@ Return Value:
                 ClockChoice -= 1;
             }
 
-            KeClearScreen();
+            CkpResetFace(Drawn);
         }
 
+        CurrentHalfSeconds = KeCurrentHalfSeconds;
         switch (ClockChoice) {
         case 0:
-            CkpDisplayDigitalClockDetailed();
+            CkpDisplayDigitalClockDetailed(Drawn);
             break;
 
         case 1:
-            CkpDisplayBarGraphClock();
+            CkpDisplayBarGraphClock(Drawn);
             break;
 
         case 2:
-            CkpDisplayLargeBinaryClock();
+            CkpDisplayLargeBinaryClock(Drawn);
             break;
 
         default:
             break;
         }
+
+        //
+        // Sleep until the time changes or the face is switched. The faces
+        // mark only what they changed as dirty, so nothing goes out to the
+        // slaves in the meantime.
+        //
+
+        while (KeCurrentHalfSeconds == CurrentHalfSeconds) {
+            NextApplication = KeRunMenu();
+            if (NextApplication != ApplicationNone) {
+                return NextApplication;
+            }
+
+            if ((KeInputEdges & (INPUT_UP1 | INPUT_DOWN1)) != 0) {
+                break;
+            }
+
+            HlWaitForInterrupt();
+        }
     }
 
     return ApplicationNone;
@@ -203,24 +247,61 @@ Return Value:
 //
 
 VOID
-CkpDisplayDigitalClockDetailed (
-    VOID
+CkpResetFace (
+    PUCHAR Drawn
     )
 
 /*++
 
 Routine Description:
 
-    This routine displays the current time in a bar-graph format from left to
-    right.
+    This routine clears the screen and forgets everything drawn on it, so that
+    the next face drawn starts from scratch.
 
 Arguments:
 
+    Drawn - Supplies a pointer to the values of each element as they were
+        last drawn.
+
+Return Value:
+
     None.
 
+--*/
+
+{
+
+    UCHAR Element;
+
+    KeClearScreen();
+    for (Element = 0; Element < CLOCK_ELEMENT_COUNT; Element += 1) {
+        Drawn[Element] = CLOCK_NOT_DRAWN;
+    }
+
+    KeDisplayDirty = TRUE;
+    return;
+}
+
+VOID
+CkpDisplayDigitalClockDetailed (
+    PUCHAR Drawn
+    )
+
+/*++
+
+Routine Description:
+
+    This routine displays the current time in digits, with the weekday and
+    temperature above and the date below.
+
+Arguments:
+
+    Drawn - Supplies a pointer to the values of each element as they were
+        last drawn. Only elements that have changed are redrawn.
+
 Return Value:
 
-    Returns the next application that should be run.
+    None.
 
 --*/
 
@@ -229,7 +310,9 @@ Return Value:
     UCHAR Character;
     UCHAR CharacterIndex;
     UCHAR Colon;
+    UCHAR Hours;
     USHORT Pixel;
+    UCHAR RedrawTens;
     UCHAR Temperature;
     UCHAR Value;
 
@@ -240,104 +323,148 @@ Return Value:
     //
 
     Value = KeCurrentWeekday;
-    if ((Value == 0) || (Value == 6)) {
-        Pixel = RGB_PIXEL(0, 0x10, 0);
+    if (Drawn[CLOCK_ELEMENT_WEEKDAY] != Value) {
+        Drawn[CLOCK_ELEMENT_WEEKDAY] = Value;
+        if ((Value == 0) || (Value == 6)) {
+            Pixel = RGB_PIXEL(0, 0x10, 0);
 
-    } else {
-        Pixel = RGB_PIXEL(0x10, 0, 0);
-    }
+        } else {
+            Pixel = RGB_PIXEL(0x10, 0, 0);
+        }
+
+        for (CharacterIndex = 0; CharacterIndex < 3; CharacterIndex += 1) {
+            Character = RtlReadProgramSpace8(
+                                         &(CkWeekday[Value][CharacterIndex]));
+
+            HlPrintText(0,
+                        1 + (3 * CharacterIndex),
+                        1,
+                        Character,
+                        Pixel);
+        }
 
-    for (CharacterIndex = 0; CharacterIndex < 3; CharacterIndex += 1) {
-        Character = RtlReadProgramSpace8(&(CkWeekday[Value][CharacterIndex]));
-        HlPrintText(0,
-                    1 + (3 * CharacterIndex),
-                    1,
-                    Character,
-                    Pixel);
+        KeInvalidateRectangle(1, 1, 9, 5);
     }
 
-    if (Temperature > 90) {
-        Pixel = RGB_PIXEL(0x1F, 0x4, 0x0);
+    if (Drawn[CLOCK_ELEMENT_TEMPERATURE] != Temperature) {
+        Drawn[CLOCK_ELEMENT_TEMPERATURE] = Temperature;
+        if (Temperature > 90) {
+            Pixel = RGB_PIXEL(0x1F, 0x4, 0x0);
 
-    } else if (Temperature > 80) {
-        Pixel = RGB_PIXEL(0x10, 0x4, 0x0);
+        } else if (Temperature > 80) {
+            Pixel = RGB_PIXEL(0x10, 0x4, 0x0);
 
-    } else if (Temperature > 59) {
-        Pixel = RGB_PIXEL(0x0, 0x10, 0x10);
+        } else if (Temperature > 59) {
+            Pixel = RGB_PIXEL(0x0, 0x10, 0x10);
 
-    } else {
-        Pixel = RGB_PIXEL(0x0, 0x10, 0x1F);
-    }
+        } else {
+            Pixel = RGB_PIXEL(0x0, 0x10, 0x1F);
+        }
 
-    HlPrintText(0, 16, 1, '0' + (Temperature / 10), Pixel);
-    HlPrintText(0, 20, 1, '0' + (Temperature % 10), Pixel);
+        HlPrintText(0, 16, 1, '0' + (Temperature / 10), Pixel);
+        HlPrintText(0, 20, 1, '0' + (Temperature % 10), Pixel);
+        KeInvalidateRectangle(16, 1, 7, 5);
+    }
 
     //
-    // Write the current time hours.
+    // Write the current time hours. The colon and minutes are drawn in the
+    // same color, so they get redrawn too when the hours change.
     //
 
-    Value = KeCurrentHours;
+    Hours = KeCurrentHours;
+    Value = Hours;
     Pixel = RGB_PIXEL(0x1F, 0x10, 0);
     if (Value >= 12) {
         Value -= 12;
         Pixel = RGB_PIXEL(0, 0x10, 0x1F);
     }
 
-    if (Value == 0) {
-        HlPrintText(1, 0, 8, '1', Pixel);
-        HlPrintText(1, 5, 8, '2', Pixel);
+    if (Drawn[CLOCK_ELEMENT_HOURS] != Hours) {
+        Drawn[CLOCK_ELEMENT_HOURS] = Hours;
+        Drawn[CLOCK_ELEMENT_COLON] = CLOCK_NOT_DRAWN;
+        Drawn[CLOCK_ELEMENT_MINUTES] = CLOCK_NOT_DRAWN;
+        if (Value == 0) {
+            HlPrintText(1, 0, 8, '1', Pixel);
+            HlPrintText(1, 5, 8, '2', Pixel);
 
-    } else if (Value >= 10) {
-        HlPrintText(1, 0, 8, '1', Pixel);
-        HlPrintText(1, 5, 8, '0' + Value - 10, Pixel);
+        } else if (Value >= 10) {
+            HlPrintText(1, 0, 8, '1', Pixel);
+            HlPrintText(1, 5, 8, '0' + Value - 10, Pixel);
 
-    } else {
-        HlPrintText(1, 0, 8, '1', 0);
-        HlPrintText(1, 5, 8, '0' + Value, Pixel);
+        } else {
+            HlPrintText(1, 0, 8, '1', 0);
+            HlPrintText(1, 5, 8, '0' + Value, Pixel);
+        }
+
+        KeInvalidateRectangle(0, 8, 10, 8);
     }
 
     //
-    // Add a colon on the first half of every second.
+    // Add a colon on the first half of every second. The colon's blank last
+    // column lands on the first column of the minutes, so the tens of minutes
+    // need to be drawn back over it. That column is in the colon's rectangle.
     //
 
+    RedrawTens = FALSE;
     Colon = ' ';
     if ((KeCurrentHalfSeconds & 0x1) == 0) {
         Colon = ':';
-
     }
 
-    HlPrintText(1, 10, 8, Colon, Pixel);
+    if (Drawn[CLOCK_ELEMENT_COLON] != Colon) {
+        Drawn[CLOCK_ELEMENT_COLON] = Colon;
+        HlPrintText(1, 10, 8, Colon, Pixel);
+        KeInvalidateRectangle(10, 8, 5, 8);
+        RedrawTens = TRUE;
+    }
 
     //
     // Write the current time minutes.
     //
 
     Value = KeCurrentMinutes;
-    HlPrintText(1, 14, 8, '0' + (Value / 10), Pixel);
-    HlPrintText(1, 19, 8, '0' + (Value % 10), Pixel);
+    if (Drawn[CLOCK_ELEMENT_MINUTES] != Value) {
+        Drawn[CLOCK_ELEMENT_MINUTES] = Value;
+        HlPrintText(1, 14, 8, '0' + (Value / 10), Pixel);
+        HlPrintText(1, 19, 8, '0' + (Value % 10), Pixel);
+        KeInvalidateRectangle(14, 8, 10, 8);
+
+    } else if (RedrawTens != FALSE) {
+        HlPrintText(1, 14, 8, '0' + (Value / 10), Pixel);
+    }
 
     //
     // Write the date and month.
     //
 
-    Value = KeCurrentDate + 1;
     Pixel = RGB_PIXEL(0x10, 0x10, 0x10);
-    if (Value >= 10) {
-        HlPrintText(0, 3, 18, '0' + (Value / 10), Pixel);
+    Value = KeCurrentDate + 1;
+    if (Drawn[CLOCK_ELEMENT_DATE] != Value) {
+        Drawn[CLOCK_ELEMENT_DATE] = Value;
+        if (Value >= 10) {
+            HlPrintText(0, 3, 18, '0' + (Value / 10), Pixel);
 
-    } else {
-        HlPrintText(0, 3, 18, '0', 0);
+        } else {
+            HlPrintText(0, 3, 18, '0', 0);
+        }
+
+        HlPrintText(0, 7, 18, '0' + (Value % 10), Pixel);
+        KeInvalidateRectangle(3, 18, 7, 5);
     }
 
-    HlPrintText(0, 7, 18, '0' + (Value % 10), Pixel);
     Value = KeCurrentMonth;
-    for (CharacterIndex = 0; CharacterIndex < 3; CharacterIndex += 1) {
-        Character = RtlReadProgramSpace8(&(CkMonth[Value][CharacterIndex]));
-        HlPrintText(0,
-                    12 + (3 * CharacterIndex),
-                    18,
-                    Character,
-                    Pixel);
+    if (Drawn[CLOCK_ELEMENT_MONTH] != Value) {
+        Drawn[CLOCK_ELEMENT_MONTH] = Value;
+        for (CharacterIndex = 0; CharacterIndex < 3; CharacterIndex += 1) {
+            Character = RtlReadProgramSpace8(&(CkMonth[Value][CharacterIndex]));
+            HlPrintText(0,
+                        12 + (3 * CharacterIndex),
+                        18,
+                        Character,
+                        Pixel);
+        }
+
+        KeInvalidateRectangle(12, 18, 9, 5);
     }
 
     return;
@@ -345,7 +472,7 @@ Return Value:
 
 VOID
 CkpDisplayBarGraphClock (
-    VOID
+    PUCHAR Drawn
     )
 
 /*++
@@ -357,46 +484,52 @@ Routine Description:
 
 Arguments:
 
-    None.
+    Drawn - Supplies a pointer to the values of each element as they were
+        last drawn. Only bars that have changed are redrawn, and within them
+        only the cells that changed color.
 
 Return Value:
 
-    Returns the next application that should be run.
+    None.
 
 --*/
 
 {
 
+    USHORT Color;
     UCHAR Index;
     USHORT Pixel;
     USHORT Pixel2;
     USHORT Pixel3;
+    UCHAR Value;
 
     //
     // Display the month.
     //
 
-    for (Index = 0; Index < 12; Index += 1) {
-        if (KeCurrentMonth >= Index) {
-            if ((KeCurrentMonth <= 1) || (KeCurrentMonth == 11)) {
-                Pixel = RGB_PIXEL(0x0, 0x0, 0x10);
+    Value = KeCurrentMonth;
+    if (Drawn[CLOCK_ELEMENT_MONTH] != Value) {
+        Drawn[CLOCK_ELEMENT_MONTH] = Value;
+        if ((Value <= 1) || (Value == 11)) {
+            Color = RGB_PIXEL(0x0, 0x0, 0x10);
 
-            } else if (KeCurrentMonth <= 4) {
-                Pixel = RGB_PIXEL(0x18, 0x1F, 0x1);
+        } else if (Value <= 4) {
+            Color = RGB_PIXEL(0x18, 0x1F, 0x1);
 
-            } else if (KeCurrentMonth <= 7) {
-                Pixel = RGB_PIXEL(0x1F, 0, 0x8);
+        } else if (Value <= 7) {
+            Color = RGB_PIXEL(0x1F, 0, 0x8);
 
-            } else {
-                Pixel = RGB_PIXEL(0x1F, 0x10, 0);
-            }
+        } else {
+            Color = RGB_PIXEL(0x1F, 0x10, 0);
+        }
 
-            KeMatrix[1][Index] = Pixel;
-            KeMatrix[2][Index] = Pixel;
+        for (Index = 0; Index < 12; Index += 1) {
+            Pixel = 0;
+            if (Value >= Index) {
+                Pixel = Color;
+            }
 
-        } else {
-            KeMatrix[1][Index] = 0;
-            KeMatrix[2][Index] = 0;
+            CkpDrawBarCell(Index, 1, Pixel);
         }
     }
 
@@ -404,25 +537,27 @@ Return Value:
     // Display the date.
     //
 
-    Pixel = RGB_PIXEL(0, 0, 0x1F);
-    Pixel2 = RGB_PIXEL(0x1F, 0, 0x1F);
-    Pixel3 = RGB_PIXEL(0x1F, 0x1F, 0x1F);
-    for (Index = 0; Index < 14; Index += 1) {
-        if (KeCurrentDate >= Index + 28) {
-            KeMatrix[5][Index] = Pixel3;
-            KeMatrix[6][Index] = Pixel3;
+    Value = KeCurrentDate;
+    if (Drawn[CLOCK_ELEMENT_DATE] != Value) {
+        Drawn[CLOCK_ELEMENT_DATE] = Value;
+        Pixel = RGB_PIXEL(0, 0, 0x1F);
+        Pixel2 = RGB_PIXEL(0x1F, 0, 0x1F);
+        Pixel3 = RGB_PIXEL(0x1F, 0x1F, 0x1F);
+        for (Index = 0; Index < 14; Index += 1) {
+            if (Value >= Index + 28) {
+                Color = Pixel3;
 
-        } else if (KeCurrentDate >= Index + 14) {
-            KeMatrix[5][Index] = Pixel2;
-            KeMatrix[6][Index] = Pixel2;
+            } else if (Value >= Index + 14) {
+                Color = Pixel2;
 
-        } else if (KeCurrentDate >= Index) {
-            KeMatrix[5][Index] = Pixel;
-            KeMatrix[6][Index] = Pixel;
+            } else if (Value >= Index) {
+                Color = Pixel;
 
-        } else {
-            KeMatrix[5][Index] = 0;
-            KeMatrix[6][Index] = 0;
+            } else {
+                Color = 0;
+            }
+
+            CkpDrawBarCell(Index, 5, Color);
         }
     }
 
@@ -430,22 +565,25 @@ Return Value:
     // Display the weekday.
     //
 
-    Pixel = RGB_PIXEL(0x1F, 0, 0);
-    Pixel2 = RGB_PIXEL(0, 0x1F, 0);
-    for (Index = 0; Index < 7; Index += 1) {
-        if (KeCurrentWeekday >= Index) {
-            if ((Index == 0) || (Index == 6)) {
-                KeMatrix[9][Index] = Pixel2;
-                KeMatrix[10][Index] = Pixel2;
+    Value = KeCurrentWeekday;
+    if (Drawn[CLOCK_ELEMENT_WEEKDAY] != Value) {
+        Drawn[CLOCK_ELEMENT_WEEKDAY] = Value;
+        Pixel = RGB_PIXEL(0x1F, 0, 0);
+        Pixel2 = RGB_PIXEL(0, 0x1F, 0);
+        for (Index = 0; Index < 7; Index += 1) {
+            if (Value >= Index) {
+                if ((Index == 0) || (Index == 6)) {
+                    Color = Pixel2;
+
+                } else {
+                    Color = Pixel;
+                }
 
             } else {
-                KeMatrix[9][Index] = Pixel;
-                KeMatrix[10][Index] = Pixel;
+                Color = 0;
             }
 
-        } else {
-            KeMatrix[9][Index] = 0;
-            KeMatrix[10][Index] = 0;
+            CkpDrawBarCell(Index, 9, Color);
         }
     }
 
@@ -453,20 +591,23 @@ Return Value:
     // Display the hours.
     //
 
-    Pixel = RGB_PIXEL(0x18, 0x8, 0);
-    Pixel2 = RGB_PIXEL(0, 0x8, 0x18);
-    for (Index = 0; Index < 12; Index += 1) {
-        if (KeCurrentHours >= Index + 12) {
-            KeMatrix[13][Index] = Pixel2;
-            KeMatrix[14][Index] = Pixel2;
+    Value = KeCurrentHours;
+    if (Drawn[CLOCK_ELEMENT_HOURS] != Value) {
+        Drawn[CLOCK_ELEMENT_HOURS] = Value;
+        Pixel = RGB_PIXEL(0x18, 0x8, 0);
+        Pixel2 = RGB_PIXEL(0, 0x8, 0x18);
+        for (Index = 0; Index < 12; Index += 1) {
+            if (Value >= Index + 12) {
+                Color = Pixel2;
+
+            } else if (Value >= Index) {
+                Color = Pixel;
 
-        } else if (KeCurrentHours >= Index) {
-            KeMatrix[13][Index] = Pixel;
-            KeMatrix[14][Index] = Pixel;
+            } else {
+                Color = 0;
+            }
 
-        } else {
-            KeMatrix[13][Index] = 0;
-            KeMatrix[14][Index] = 0;
+            CkpDrawBarCell(Index, 13, Color);
         }
     }
 
@@ -474,25 +615,27 @@ Return Value:
     // Display the minutes.
     //
 
-    Pixel = RGB_PIXEL(0, 0x1F, 0);
-    Pixel2 = RGB_PIXEL(0x18, 0x8, 0);
-    Pixel3 = RGB_PIXEL(0, 0x1F, 0x18);
-    for (Index = 0; Index < 20; Index += 1) {
-        if (KeCurrentMinutes > Index + 40) {
-            KeMatrix[17][Index] = Pixel3;
-            KeMatrix[18][Index] = Pixel3;
+    Value = KeCurrentMinutes;
+    if (Drawn[CLOCK_ELEMENT_MINUTES] != Value) {
+        Drawn[CLOCK_ELEMENT_MINUTES] = Value;
+        Pixel = RGB_PIXEL(0, 0x1F, 0);
+        Pixel2 = RGB_PIXEL(0x18, 0x8, 0);
+        Pixel3 = RGB_PIXEL(0, 0x1F, 0x18);
+        for (Index = 0; Index < 20; Index += 1) {
+            if (Value > Index + 40) {
+                Color = Pixel3;
 
-        } else if (KeCurrentMinutes > Index + 20) {
-            KeMatrix[17][Index] = Pixel2;
-            KeMatrix[18][Index] = Pixel2;
+            } else if (Value > Index + 20) {
+                Color = Pixel2;
 
-        } else if (KeCurrentMinutes > Index) {
-            KeMatrix[17][Index] = Pixel;
-            KeMatrix[18][Index] = Pixel;
+            } else if (Value > Index) {
+                Color = Pixel;
 
-        } else {
-            KeMatrix[17][Index] = 0;
-            KeMatrix[18][Index] = 0;
+            } else {
+                Color = 0;
+            }
+
+            CkpDrawBarCell(Index, 17, Color);
         }
     }
 
@@ -500,25 +643,27 @@ Return Value:
     // Display the seconds.
     //
 
-    Pixel = RGB_PIXEL(0x18, 0, 0x8);
-    Pixel2 = RGB_PIXEL(0x1F, 0x1F, 0);
-    Pixel3 = RGB_PIXEL(0x1F, 0x1F, 0x1F);
-    for (Index = 0; Index < 20; Index += 1) {
-        if ((KeCurrentHalfSeconds >> 1) > Index + 40) {
-            KeMatrix[21][Index] = Pixel3;
-            KeMatrix[22][Index] = Pixel3;
+    Value = KeCurrentHalfSeconds >> 1;
+    if (Drawn[CLOCK_ELEMENT_SECONDS] != Value) {
+        Drawn[CLOCK_ELEMENT_SECONDS] = Value;
+        Pixel = RGB_PIXEL(0x18, 0, 0x8);
+        Pixel2 = RGB_PIXEL(0x1F, 0x1F, 0);
+        Pixel3 = RGB_PIXEL(0x1F, 0x1F, 0x1F);
+        for (Index = 0; Index < 20; Index += 1) {
+            if (Value > Index + 40) {
+                Color = Pixel3;
 
-        } else if ((KeCurrentHalfSeconds >> 1) > Index + 20) {
-            KeMatrix[21][Index] = Pixel2;
-            KeMatrix[22][Index] = Pixel2;
+            } else if (Value > Index + 20) {
+                Color = Pixel2;
 
-        } else if ((KeCurrentHalfSeconds >> 1) > Index) {
-            KeMatrix[21][Index] = Pixel;
-            KeMatrix[22][Index] = Pixel;
+            } else if (Value > Index) {
+                Color = Pixel;
 
-        } else {
-            KeMatrix[21][Index] = 0;
-            KeMatrix[22][Index] = 0;
+            } else {
+                Color = 0;
+            }
+
+            CkpDrawBarCell(Index, 21, Color);
         }
     }
 
@@ -527,7 +672,7 @@ Return Value:
 
 VOID
 CkpDisplayLargeBinaryClock (
-    VOID
+    PUCHAR Drawn
     )
 
 /*++
@@ -538,7 +683,8 @@ Routine Description:
 
 Arguments:
 
-    None.
+    Drawn - Supplies a pointer to the values of each element as they were
+        last drawn. Only digits that have changed are redrawn.
 
 Return Value:
 
@@ -550,42 +696,55 @@ Return Value:
 
     UCHAR Hours;
     USHORT Pixel;
+    UCHAR Value;
 
     //
     // Display the hours.
     //
 
     Hours = KeCurrentHours;
-    Pixel = RGB_PIXEL(0x1F, 0x9, 0);
-    if (Hours >= 12) {
-        Hours -= 12;
-        Pixel = RGB_PIXEL(0x0, 0x9, 0x1F);
-    }
+    if (Drawn[CLOCK_ELEMENT_HOURS] != Hours) {
+        Drawn[CLOCK_ELEMENT_HOURS] = Hours;
+        Pixel = RGB_PIXEL(0x1F, 0x9, 0);
+        if (Hours >= 12) {
+            Hours -= 12;
+            Pixel = RGB_PIXEL(0x0, 0x9, 0x1F);
+        }
 
-    if (Hours >= 9) {
-        CkpDrawBinaryCodedDecimal(1, 0, Pixel);
-        CkpDrawBinaryCodedDecimal(Hours + 1 - 10, 3, Pixel);
+        if (Hours >= 9) {
+            CkpDrawBinaryCodedDecimal(1, 0, Pixel);
+            CkpDrawBinaryCodedDecimal(Hours + 1 - 10, 3, Pixel);
 
-    } else {
-        CkpDrawBinaryCodedDecimal(0, 0, Pixel);
-        CkpDrawBinaryCodedDecimal(Hours + 1, 3, Pixel);
+        } else {
+            CkpDrawBinaryCodedDecimal(0, 0, Pixel);
+            CkpDrawBinaryCodedDecimal(Hours + 1, 3, Pixel);
+        }
     }
 
     //
     // Display the minutes.
     //
 
-    Pixel = RGB_PIXEL(0x1F, 0x1F, 0x1F);
-    CkpDrawBinaryCodedDecimal(KeCurrentMinutes / 10, 9, Pixel);
-    CkpDrawBinaryCodedDecimal(KeCurrentMinutes % 10, 12, Pixel);
+    Value = KeCurrentMinutes;
+    if (Drawn[CLOCK_ELEMENT_MINUTES] != Value) {
+        Drawn[CLOCK_ELEMENT_MINUTES] = Value;
+        Pixel = RGB_PIXEL(0x1F, 0x1F, 0x1F);
+        CkpDrawBinaryCodedDecimal(Value / 10, 9, Pixel);
+        CkpDrawBinaryCodedDecimal(Value % 10, 12, Pixel);
+    }
 
     //
     // Display the seconds.
     //
 
-    Pixel = RGB_PIXEL(0x0, 0x1F, 0x0);
-    CkpDrawBinaryCodedDecimal((KeCurrentHalfSeconds >> 1) / 10, 18, Pixel);
-    CkpDrawBinaryCodedDecimal((KeCurrentHalfSeconds >> 1) % 10, 21, Pixel);
+    Value = KeCurrentHalfSeconds >> 1;
+    if (Drawn[CLOCK_ELEMENT_SECONDS] != Value) {
+        Drawn[CLOCK_ELEMENT_SECONDS] = Value;
+        Pixel = RGB_PIXEL(0x0, 0x1F, 0x0);
+        CkpDrawBinaryCodedDecimal(Value / 10, 18, Pixel);
+        CkpDrawBinaryCodedDecimal(Value % 10, 21, Pixel);
+    }
+
     return;
 }
 
@@ -649,6 +808,45 @@ Return Value:
     return;
 }
 
+VOID
+CkpDrawBarCell (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    USHORT Pixel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine draws one cell of a bar graph, which is two pixels stacked
+    on top of each other. Nothing is drawn if the cell is already that color.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the cell.
+
+    YPosition - Supplies the Y coordinate of the top of the cell.
+
+    Pixel - Supplies the value to color the cell with.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (KeMatrix[YPosition][XPosition] != Pixel) {
+        KeMatrix[YPosition][XPosition] = Pixel;
+        KeMatrix[YPosition + 1][XPosition] = Pixel;
+        KeInvalidateRectangle(XPosition, YPosition, 1, 2);
+    }
+
+    return;
+}
+
 VOID
 CkpDrawSquare (
     UCHAR XPosition,
@@ -661,7 +859,8 @@ CkpDrawSquare (
 Routine Description:
 
     This routine draws a 2x2 square on the matrix whose upper left corner starts
-    at the given position.
+    at the given position. Nothing is drawn if the square is already that
+    color.
 
 Arguments:
 
@@ -679,9 +878,10 @@ Return Value:
 
 {
 
-    KeMatrix[YPosition][XPosition] = Pixel;
-    KeMatrix[YPosition + 1][XPosition] = Pixel;
-    KeMatrix[YPosition][XPosition + 1] = Pixel;
-    KeMatrix[YPosition + 1][XPosition + 1] = Pixel;
+    if (KeMatrix[YPosition][XPosition] != Pixel) {
+        GrFillRectangle(XPosition, YPosition, 2, 2, Pixel);
+        KeInvalidateRectangle(XPosition, YPosition, 2, 2);
+    }
+
     return;
 }
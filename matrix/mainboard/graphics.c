@@ -0,0 +1,828 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    graphics.c
+
+Abstract:
+
+    This module implements simple block drawing and scrolling text routines on
+    the matrix framebuffer, shared by the applications.
+
+Author:
+
+    Evan Green 27-Nov-2010
+
+Environment:
+
+    x86/AVR
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "mainboard.h"
+#include "fontdata.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+UCHAR
+GrpClipRectangle (
+    PUCHAR XPosition,
+    PUCHAR YPosition,
+    PUCHAR Width,
+    PUCHAR Height
+    );
+
+VOID
+GrpRenderCharacter (
+    PMARQUEE Marquee,
+    UCHAR Size,
+    UCHAR Character
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+VOID
+GrFillRectangle (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    USHORT Pixel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a rectangle of the matrix with a single value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Pixel - Supplies the value to fill the rectangle with.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Column;
+    volatile USHORT *Destination;
+
+    if (GrpClipRectangle(&XPosition, &YPosition, &Width, &Height) == FALSE) {
+        return;
+    }
+
+    //
+    // Walk a pointer down the rows rather than indexing the two dimensional
+    // array, which would cost a multiply for every pixel on the AVR.
+    //
+
+    Destination = &(KeMatrix[YPosition][XPosition]);
+    while (Height != 0) {
+        for (Column = Width; Column != 0; Column -= 1) {
+            *Destination = Pixel;
+            Destination += 1;
+        }
+
+        Destination += MATRIX_WIDTH - Width;
+        Height -= 1;
+    }
+
+    return;
+}
+
+VOID
+GrScrollRows (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    SHORT Distance,
+    USHORT Fill
+    )
+
+/*++
+
+Routine Description:
+
+    This routine shifts the contents of a rectangle of the matrix up or down.
+    Pixels shifted out of the rectangle are lost, and rows shifted in are
+    filled with the given value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Distance - Supplies the number of rows to shift by. Positive values shift
+        the contents down, negative values shift the contents up.
+
+    Fill - Supplies the value to fill the vacated rows with.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Column;
+    volatile USHORT *Destination;
+    USHORT Magnitude;
+    UCHAR Row;
+    volatile USHORT *Source;
+
+    if ((Distance == 0) ||
+        (GrpClipRectangle(&XPosition, &YPosition, &Width, &Height) == FALSE)) {
+
+        return;
+    }
+
+    Magnitude = Distance;
+    if (Distance < 0) {
+        Magnitude = -Distance;
+    }
+
+    if (Magnitude >= Height) {
+        GrFillRectangle(XPosition, YPosition, Width, Height, Fill);
+        return;
+    }
+
+    //
+    // When shifting down, copy from the bottom up so that source rows are
+    // read before they are overwritten. The opposite holds when shifting up.
+    //
+
+    if (Distance > 0) {
+        Destination = &(KeMatrix[YPosition + Height - 1][XPosition]);
+        Source = Destination - ((USHORT)Magnitude * MATRIX_WIDTH);
+        for (Row = Height - Magnitude; Row != 0; Row -= 1) {
+            for (Column = Width; Column != 0; Column -= 1) {
+                *Destination = *Source;
+                Destination += 1;
+                Source += 1;
+            }
+
+            Destination -= MATRIX_WIDTH + Width;
+            Source -= MATRIX_WIDTH + Width;
+        }
+
+        GrFillRectangle(XPosition, YPosition, Width, Magnitude, Fill);
+
+    } else {
+        Destination = &(KeMatrix[YPosition][XPosition]);
+        Source = Destination + ((USHORT)Magnitude * MATRIX_WIDTH);
+        for (Row = Height - Magnitude; Row != 0; Row -= 1) {
+            for (Column = Width; Column != 0; Column -= 1) {
+                *Destination = *Source;
+                Destination += 1;
+                Source += 1;
+            }
+
+            Destination += MATRIX_WIDTH - Width;
+            Source += MATRIX_WIDTH - Width;
+        }
+
+        GrFillRectangle(XPosition,
+                        YPosition + Height - Magnitude,
+                        Width,
+                        Magnitude,
+                        Fill);
+    }
+
+    return;
+}
+
+VOID
+GrScrollColumns (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    SHORT Distance,
+    USHORT Fill
+    )
+
+/*++
+
+Routine Description:
+
+    This routine shifts the contents of a rectangle of the matrix left or
+    right. Pixels shifted out of the rectangle are lost, and columns shifted in
+    are filled with the given value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Distance - Supplies the number of columns to shift by. Positive values
+        shift the contents right, negative values shift the contents left.
+
+    Fill - Supplies the value to fill the vacated columns with.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Column;
+    volatile USHORT *Destination;
+    USHORT Magnitude;
+    UCHAR Row;
+    volatile USHORT *Source;
+
+    if ((Distance == 0) ||
+        (GrpClipRectangle(&XPosition, &YPosition, &Width, &Height) == FALSE)) {
+
+        return;
+    }
+
+    Magnitude = Distance;
+    if (Distance < 0) {
+        Magnitude = -Distance;
+    }
+
+    if (Magnitude >= Width) {
+        GrFillRectangle(XPosition, YPosition, Width, Height, Fill);
+        return;
+    }
+
+    for (Row = YPosition; Row < YPosition + Height; Row += 1) {
+
+        //
+        // Shifting right walks each row from the right edge so that pixels
+        // are read before they are overwritten.
+        //
+
+        if (Distance > 0) {
+            Destination = &(KeMatrix[Row][XPosition + Width - 1]);
+            Source = Destination - Magnitude;
+            for (Column = Width - Magnitude; Column != 0; Column -= 1) {
+                *Destination = *Source;
+                Destination -= 1;
+                Source -= 1;
+            }
+
+            for (Column = Magnitude; Column != 0; Column -= 1) {
+                *Destination = Fill;
+                Destination -= 1;
+            }
+
+        } else {
+            Destination = &(KeMatrix[Row][XPosition]);
+            Source = Destination + Magnitude;
+            for (Column = Width - Magnitude; Column != 0; Column -= 1) {
+                *Destination = *Source;
+                Destination += 1;
+                Source += 1;
+            }
+
+            for (Column = Magnitude; Column != 0; Column -= 1) {
+                *Destination = Fill;
+                Destination += 1;
+            }
+        }
+    }
+
+    return;
+}
+
+VOID
+GrBlitMaskedSprite (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    PPGM Data,
+    USHORT Color
+    )
+
+/*++
+
+Routine Description:
+
+    This routine draws a one bit per pixel sprite stored in program space onto
+    the matrix. Set bits are painted with the given color, and clear bits leave
+    the matrix untouched.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        sprite.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        sprite.
+
+    Width - Supplies the width of the sprite in pixels.
+
+    Height - Supplies the height of the sprite in pixels.
+
+    Data - Supplies a pointer into program space of the sprite bits. Pixels are
+        packed as a continuous stream in row order, least significant bit
+        first, without padding at the end of a row.
+
+    Color - Supplies the value to paint set pixels with.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Byte;
+    UCHAR Column;
+    volatile USHORT *Destination;
+    UCHAR Mask;
+    UCHAR Row;
+
+    Byte = 0;
+    Mask = 0;
+    for (Row = 0; Row < Height; Row += 1) {
+        if (YPosition + Row >= MATRIX_HEIGHT) {
+            break;
+        }
+
+        Destination = &(KeMatrix[YPosition + Row][XPosition]);
+        for (Column = 0; Column < Width; Column += 1) {
+
+            //
+            // Fetch a new byte from flash only once every eight pixels.
+            //
+
+            if (Mask == 0) {
+                Byte = RtlReadProgramSpace8(Data);
+                Data += 1;
+                Mask = 0x01;
+            }
+
+            if (((Byte & Mask) != 0) && (XPosition + Column < MATRIX_WIDTH)) {
+
+                *Destination = Color;
+            }
+
+            Destination += 1;
+            Mask <<= 1;
+        }
+    }
+
+    return;
+}
+
+VOID
+GrBlitPaletteSprite (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    PPGM Data,
+    PUSHORT Palette
+    )
+
+/*++
+
+Routine Description:
+
+    This routine draws a two bit per pixel palette indexed sprite stored in
+    program space onto the matrix.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        sprite.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        sprite.
+
+    Width - Supplies the width of the sprite in pixels.
+
+    Height - Supplies the height of the sprite in pixels.
+
+    Data - Supplies a pointer into program space of the sprite data. Pixels are
+        packed four to a byte as a continuous stream in row order, starting
+        with the least significant bits, without padding at the end of a row.
+
+    Palette - Supplies a pointer to an array of GRAPHICS_PALETTE_SIZE pixel
+        values that the two bit indices select from.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Byte;
+    UCHAR Column;
+    volatile USHORT *Destination;
+    UCHAR PixelsLeft;
+    UCHAR Row;
+
+    Byte = 0;
+    PixelsLeft = 0;
+    for (Row = 0; Row < Height; Row += 1) {
+        if (YPosition + Row >= MATRIX_HEIGHT) {
+            break;
+        }
+
+        Destination = &(KeMatrix[YPosition + Row][XPosition]);
+        for (Column = 0; Column < Width; Column += 1) {
+            if (PixelsLeft == 0) {
+                Byte = RtlReadProgramSpace8(Data);
+                Data += 1;
+                PixelsLeft = 4;
+            }
+
+            if (XPosition + Column < MATRIX_WIDTH) {
+                *Destination = Palette[Byte & 0x3];
+            }
+
+            Destination += 1;
+            Byte >>= 2;
+            PixelsLeft -= 1;
+        }
+    }
+
+    return;
+}
+
+VOID
+GrInitializeMarquee (
+    PMARQUEE Marquee,
+    UCHAR Size,
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    PPGM Message,
+    USHORT Color
+    )
+
+/*++
+
+Routine Description:
+
+    This routine renders a message into a marquee and blanks the marquee's
+    window on the matrix. The font is only read once here, so stepping the
+    marquee afterwards is just a shift of the window and one column of drawing.
+
+Arguments:
+
+    Marquee - Supplies a pointer to the marquee to initialize.
+
+    Size - Supplies the size of the font to use. Valid values are the same as
+        for HlPrintText.
+
+    XPosition - Supplies the X coordinate of the left edge of the window.
+
+    YPosition - Supplies the Y coordinate of the top edge of the window.
+
+    Width - Supplies the width of the window in pixels.
+
+    Message - Supplies a pointer to the null terminated message, in flash.
+        Messages that are too long are truncated.
+
+    Color - Supplies the color to draw the message in.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Character;
+
+    Marquee->ColumnCount = 0;
+    Marquee->NextColumn = 0;
+    Marquee->Color = Color;
+    Marquee->Height = 7;
+    if (Size == 0) {
+        Marquee->Height = 5;
+    }
+
+    while (TRUE) {
+        Character = RtlReadProgramSpace8(Message);
+        if (Character == '\0') {
+            break;
+        }
+
+        GrpRenderCharacter(Marquee, Size, Character);
+        Message += 1;
+    }
+
+    //
+    // Clip the window up front so that stepping never has to.
+    //
+
+    if (GrpClipRectangle(&XPosition,
+                         &YPosition,
+                         &Width,
+                         &(Marquee->Height)) == FALSE) {
+
+        Width = 0;
+    }
+
+    Marquee->XPosition = XPosition;
+    Marquee->YPosition = YPosition;
+    Marquee->Width = Width;
+    if (Width != 0) {
+        GrFillRectangle(XPosition, YPosition, Width, Marquee->Height, 0);
+    }
+
+    return;
+}
+
+UCHAR
+GrStepMarquee (
+    PMARQUEE Marquee
+    )
+
+/*++
+
+Routine Description:
+
+    This routine scrolls a marquee one column to the left.
+
+Arguments:
+
+    Marquee - Supplies a pointer to the marquee to advance.
+
+Return Value:
+
+    TRUE if the message has just scrolled entirely out of the window. The next
+    step starts the message over again.
+
+    FALSE if the message is still on its way through the window.
+
+--*/
+
+{
+
+    UCHAR Bits;
+    volatile USHORT *Destination;
+    UCHAR Row;
+
+    if (Marquee->Width == 0) {
+        return TRUE;
+    }
+
+    GrScrollColumns(Marquee->XPosition,
+                    Marquee->YPosition,
+                    Marquee->Width,
+                    Marquee->Height,
+                    -1,
+                    0);
+
+    //
+    // Draw the newly exposed column on the right edge from the cache. Past the
+    // end of the message the column was already blanked by the scroll.
+    //
+
+    if (Marquee->NextColumn < Marquee->ColumnCount) {
+        Bits = Marquee->Columns[Marquee->NextColumn];
+        Destination = &(KeMatrix[Marquee->YPosition]
+                                [Marquee->XPosition + Marquee->Width - 1]);
+
+        for (Row = Marquee->Height; Row != 0; Row -= 1) {
+            if ((Bits & 0x1) != 0) {
+                *Destination = Marquee->Color;
+            }
+
+            Bits >>= 1;
+            Destination += MATRIX_WIDTH;
+        }
+    }
+
+    Marquee->NextColumn += 1;
+    if (Marquee->NextColumn ==
+        (USHORT)Marquee->ColumnCount + Marquee->Width) {
+
+        Marquee->NextColumn = 0;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+UCHAR
+GrpClipRectangle (
+    PUCHAR XPosition,
+    PUCHAR YPosition,
+    PUCHAR Width,
+    PUCHAR Height
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clips a rectangle to the bounds of the matrix.
+
+Arguments:
+
+    XPosition - Supplies a pointer to the X coordinate of the rectangle.
+
+    YPosition - Supplies a pointer to the Y coordinate of the rectangle.
+
+    Width - Supplies a pointer to the width of the rectangle. On output,
+        contains the clipped width.
+
+    Height - Supplies a pointer to the height of the rectangle. On output,
+        contains the clipped height.
+
+Return Value:
+
+    TRUE if any part of the rectangle is on the matrix.
+
+    FALSE if the rectangle is entirely off of the matrix or empty.
+
+--*/
+
+{
+
+    if ((*XPosition >= MATRIX_WIDTH) || (*YPosition >= MATRIX_HEIGHT)) {
+        return FALSE;
+    }
+
+    if (*Width > MATRIX_WIDTH - *XPosition) {
+        *Width = MATRIX_WIDTH - *XPosition;
+    }
+
+    if (*Height > MATRIX_HEIGHT - *YPosition) {
+        *Height = MATRIX_HEIGHT - *YPosition;
+    }
+
+    if ((*Width == 0) || (*Height == 0)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID
+GrpRenderCharacter (
+    PMARQUEE Marquee,
+    UCHAR Size,
+    UCHAR Character
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends the columns of a single character, followed by a blank
+    spacing column, to a marquee.
+
+Arguments:
+
+    Marquee - Supplies a pointer to the marquee to render into.
+
+    Size - Supplies the size of the font to use. See HlPrintText.
+
+    Character - Supplies the character to render.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Bits;
+    UCHAR Column;
+    USHORT EncodedData;
+    UCHAR GlyphWidth;
+    UCHAR Row;
+
+    GlyphWidth = 5;
+    EncodedData = 0;
+    if (Size == 0) {
+        GlyphWidth = 3;
+        if ((Character >= '0') && (Character <= '9')) {
+            Character = FONT_3X5_NUMERIC_OFFSET + (Character - '0');
+
+        } else if (Character == ':') {
+            Character = FONT_3X5_COLON_OFFSET;
+
+        } else if (Character == '=') {
+            Character = FONT_3X5_EQUALS_OFFSET;
+
+        } else if ((Character >= 'a') && (Character <= 'z')) {
+            Character = FONT_3X5_ALPHA_OFFSET + Character - 'a';
+
+        } else if ((Character >= 'A') && (Character <= 'Z')) {
+            Character = FONT_3X5_ALPHA_OFFSET + Character - 'A';
+
+        } else {
+            Character = FONT_3X5_SPACE_OFFSET;
+        }
+
+        //
+        // The 3x5 glyphs are a continuous stream of fifteen bits, column by
+        // column and row by row, starting at the high bit of the first byte.
+        //
+
+        EncodedData =
+                (USHORT)RtlReadProgramSpace8(&(KeFontData3x5[Character][0])) <<
+                8;
+
+        EncodedData |= RtlReadProgramSpace8(&(KeFontData3x5[Character][1]));
+    }
+
+    for (Column = 0; Column <= GlyphWidth; Column += 1) {
+        if (Marquee->ColumnCount == GRAPHICS_MARQUEE_COLUMNS) {
+            break;
+        }
+
+        //
+        // The final column is blank to space the characters apart. The 5x7
+        // glyphs are already stored in columns with the top row in the low
+        // bit, and the 3x5 glyphs are rotated into that form here.
+        //
+
+        Bits = 0;
+        if (Column != GlyphWidth) {
+            if (Size == 0) {
+                for (Row = 0; Row < 5; Row += 1) {
+                    if ((EncodedData & 0x8000) != 0) {
+                        Bits |= 1 << Row;
+                    }
+
+                    EncodedData <<= 1;
+                }
+
+            } else {
+                Bits = RtlReadProgramSpace8(
+                                        &(KeFontData5x7[Character][Column]));
+            }
+        }
+
+        Marquee->Columns[Marquee->ColumnCount] = Bits;
+        Marquee->ColumnCount += 1;
+    }
+
+    return;
+}
@@ -54,10 +54,57 @@ Environment:
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure stores the state of a game of life.
+
+Members:
+
+    GenerationTimer - Stores the timer that brings about each new generation.
+
+    GameTime - Stores how long the current game has been running, in ms/32.
+
+    UpdateInterval - Stores the time between generations, in ms/32.
+
+    OnPixel - Stores the color of the original culture.
+
+    CursorX - Stores the X coordinate of trackball 1's paint cursor.
+
+    CursorY - Stores the Y coordinate of trackball 1's paint cursor.
+
+--*/
+
+typedef struct _LIFE_GAME {
+    TIMER GenerationTimer;
+    ULONG GameTime;
+    ULONG UpdateInterval;
+    USHORT OnPixel;
+    UCHAR CursorX;
+    UCHAR CursorY;
+} LIFE_GAME, *PLIFE_GAME;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+VOID
+LifepStartGame (
+    PLIFE_GAME Game
+    );
+
+VOID
+LifepRunGeneration (
+    PVOID Context
+    );
+
+VOID
+LifepHandleInput (
+    USHORT Inputs,
+    PVOID Context
+    );
+
 UCHAR
 LifepGetNeighborCount (
     UCHAR XPixel,
@@ -96,219 +143,299 @@ Return Value:
 
 {
 
-    UCHAR CursorMoved;
-    UCHAR CursorX;
-    UCHAR CursorY;
-    ULONG GameTime;
-    UCHAR Neighbors;
-    ULONG NextUpdateTime;
-    APPLICATION NextApplication;
+    LIFE_GAME Game;
+
+    Game.UpdateInterval = DEFAULT_UPDATE_INTERVAL;
+    KeInitializeTimer(&(Game.GenerationTimer));
+    LifepStartGame(&Game);
+    KeSetInputHandler(INPUT_LEFT1 | INPUT_RIGHT1 | INPUT_UP1 | INPUT_DOWN1 |
+                      INPUT_UP2 | INPUT_DOWN2 | INPUT_BUTTON1 | INPUT_BUTTON2,
+                      LifepHandleInput,
+                      &Game);
+
+    return KeRunEventLoop();
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+LifepStartGame (
+    PLIFE_GAME Game
+    )
+
+/*++
+
+Routine Description:
+
+    This routine seeds the board with a new random culture and schedules its
+    first generation.
+
+Arguments:
+
+    Game - Supplies a pointer to the game state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
     USHORT OnPixel;
-    ULONG UpdateInterval;
     UCHAR XPixel;
     UCHAR YPixel;
 
-    NextApplication = ApplicationNone;
-    UpdateInterval = DEFAULT_UPDATE_INTERVAL;
-    while (TRUE) {
-        CursorX = MATRIX_WIDTH / 2;
-        CursorY = MATRIX_HEIGHT / 2;
+    Game->CursorX = MATRIX_WIDTH / 2;
+    Game->CursorY = MATRIX_HEIGHT / 2;
+
+    //
+    // Decide the ethnicity of today's culture.
+    //
 
-        //
-        // Decide the ethnicity of today's culture.
-        //
+    OnPixel = RGB_PIXEL(HlRandom() & 0x1F,
+                        HlRandom() & 0x1F,
+                        HlRandom() & 0x1F);
 
-        OnPixel = RGB_PIXEL(HlRandom() & 0x1F,
-                            HlRandom() & 0x1F,
-                            HlRandom() & 0x1F);
+    if (OnPixel == 0) {
+        OnPixel = RGB_PIXEL(0x1F, 0x1F, 0x1F);
+    }
 
-        if (OnPixel == 0) {
-            OnPixel = RGB_PIXEL(0x1F, 0x1F, 0x1F);
-        }
+    Game->OnPixel = OnPixel;
 
-        //
-        // Fill the board randomly. Shoot to fill about a quarter of the pixels.
-        //
+    //
+    // Fill the board randomly. Shoot to fill about a quarter of the pixels.
+    //
 
-        for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
-            for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
-                if ((HlRandom() & 0x3) == 0) {
-                    KeMatrix[YPixel][XPixel] = OnPixel | PIXEL_USER_BIT;
+    for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
+        for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
+            if ((HlRandom() & 0x3) == 0) {
+                KeMatrix[YPixel][XPixel] = OnPixel | PIXEL_USER_BIT;
 
-                } else {
-                    KeMatrix[YPixel][XPixel] = 0;
-                }
+            } else {
+                KeMatrix[YPixel][XPixel] = 0;
             }
         }
+    }
 
-        GameTime = 0;
-        while (GameTime < GAME_DURATION) {
+    Game->GameTime = 0;
+    KeQueueTimer(&(Game->GenerationTimer),
+                 Game->UpdateInterval,
+                 0,
+                 LifepRunGeneration,
+                 Game);
 
-            //
-            // Stall for a bit. This is the meaning of life.
-            //
+    return;
+}
 
-            NextUpdateTime = KeRawTime + UpdateInterval;
-            if (NextUpdateTime < KeRawTime) {
-                NextUpdateTime = 0xFFFFFFFFULL;
-            }
+VOID
+LifepRunGeneration (
+    PVOID Context
+    )
 
-            while (KeRawTime < NextUpdateTime) {
-                KeStall(32 * 10);
+/*++
 
-                //
-                // Process any inputs. The inputs are kind of fun. Trackball 1
-                // paints red live cells as it tracks.
-                //
+Routine Description:
 
-                CursorMoved = FALSE;
-                if ((KeInputEdges & INPUT_LEFT1) != 0) {
-                    KeInputEdges &= ~INPUT_LEFT1;
-                    CursorMoved = TRUE;
-                    CursorX -= 1;
-                    if (CursorX == 0xFF) {
-                        CursorX = MATRIX_WIDTH - 1;
-                    }
-                }
+    This routine processes the board to get the next generation of pixels. It
+    is called by the generation timer. This is the meaning of life.
 
-                if ((KeInputEdges & INPUT_RIGHT1) != 0) {
-                    KeInputEdges &= ~INPUT_RIGHT1;
-                    CursorMoved = TRUE;
-                    CursorX += 1;
-                    if (CursorX == MATRIX_WIDTH) {
-                        CursorX = 0;
-                    }
-                }
+Arguments:
 
-                if ((KeInputEdges & INPUT_UP1) != 0) {
-                    KeInputEdges &= ~INPUT_UP1;
-                    CursorMoved = TRUE;
-                    CursorY -= 1;
-                    if (CursorY == 0xFF) {
-                        CursorY = MATRIX_HEIGHT - 1;
-                    }
-                }
+    Context - Supplies a pointer to the game state.
 
-                if ((KeInputEdges & INPUT_DOWN1) != 0) {
-                    KeInputEdges &= ~INPUT_DOWN1;
-                    CursorMoved = TRUE;
-                    CursorY += 1;
-                    if (CursorY == MATRIX_HEIGHT) {
-                        CursorY = 0;
-                    }
-                }
+Return Value:
 
-                if (CursorMoved != FALSE) {
-                    KeMatrix[CursorY][CursorX] = RED_PIXEL(0x1F);
-                }
+    None.
+
+--*/
+
+{
+
+    PLIFE_GAME Game;
+    UCHAR Neighbors;
+    USHORT OnPixel;
+    UCHAR XPixel;
+    UCHAR YPixel;
+
+    Game = Context;
+    OnPixel = Game->OnPixel;
+
+    //
+    // Update total game time.
+    //
+
+    Game->GameTime += Game->UpdateInterval;
+
+    //
+    // Process the board to get the next generation of pixels.
+    //
+
+    for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
+        for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
+            Neighbors = LifepGetNeighborCount(XPixel, YPixel, &OnPixel);
+
+            //
+            // Handle a pixel that was alive.
+            //
+
+            if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
 
                 //
-                // Did the user get bored?
+                // Any pixel with fewer than two neighbors dies from lack of
+                // love. Any pixel with more than three neighbors dies from
+                // overcrowding.
                 //
 
-                NextApplication = KeRunMenu();
-                if (NextApplication != ApplicationNone) {
-                    return NextApplication;
+                if ((Neighbors < 2) || (Neighbors > 3)) {
+                    KeMatrix[YPixel][XPixel] &= PIXEL_USER_BIT;
                 }
 
+            //
+            // This pixel was dead.
+            //
+
+            } else {
+
                 //
-                // Trackball 2 controls the update speed.
+                // A dead pixel with exactly three neighbors spawns life.
                 //
 
-                if ((KeInputEdges & INPUT_UP2) != 0) {
-                    KeInputEdges &= ~INPUT_UP2;
-                    if (UpdateInterval > UPDATE_INCREMENT) {
-                        UpdateInterval -= UPDATE_INCREMENT;
-                    }
-                }
-
-                if ((KeInputEdges & INPUT_DOWN2) != 0) {
-                    KeInputEdges &= ~INPUT_DOWN2;
-                    UpdateInterval += UPDATE_INCREMENT;
+                if (Neighbors == 3) {
+                    KeMatrix[YPixel][XPixel] |= OnPixel;
                 }
             }
+        }
+    }
 
-            //
-            // Clicking either trackball resets to a new game.
-            //
+    //
+    // Now that the next iteration of the board has been calculated, update the
+    // "previous state" bit.
+    //
+
+    for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
+        for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
+            if ((KeMatrix[YPixel][XPixel] & (~PIXEL_USER_BIT)) != 0) {
+                KeMatrix[YPixel][XPixel] |= PIXEL_USER_BIT;
 
-            if ((KeInputEdges & (INPUT_BUTTON1 | INPUT_BUTTON2)) != 0) {
-                KeInputEdges &= ~(INPUT_BUTTON1 | INPUT_BUTTON2);
-                break;
+            } else {
+                KeMatrix[YPixel][XPixel] &= ~PIXEL_USER_BIT;
             }
+        }
+    }
 
-            //
-            // Update total game time.
-            //
+    Game->OnPixel = OnPixel;
 
-            GameTime += UpdateInterval;
+    //
+    // Start over once the game has run its course, otherwise wait for the next
+    // generation. The interval is read each time so speed changes from
+    // trackball 2 take effect right away.
+    //
 
-            //
-            // Process the board to get the next generation of pixels.
-            //
+    if (Game->GameTime >= GAME_DURATION) {
+        LifepStartGame(Game);
 
-            for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
-                for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
-                    Neighbors = LifepGetNeighborCount(XPixel, YPixel, &OnPixel);
+    } else {
+        KeQueueTimer(&(Game->GenerationTimer),
+                     Game->UpdateInterval,
+                     0,
+                     LifepRunGeneration,
+                     Game);
+    }
 
-                    //
-                    // Handle a pixel that was alive.
-                    //
+    return;
+}
 
-                    if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
+VOID
+LifepHandleInput (
+    USHORT Inputs,
+    PVOID Context
+    )
 
-                        //
-                        // Any pixel with fewer than two neighbors dies from
-                        // lack of love. Any pixel with more than three
-                        // neighbors dies from overcrowding.
-                        //
+/*++
 
-                        if ((Neighbors < 2) || (Neighbors > 3)) {
-                            KeMatrix[YPixel][XPixel] &= PIXEL_USER_BIT;
-                        }
+Routine Description:
 
-                    //
-                    // This pixel was dead.
-                    //
+    This routine handles trackball input for the game of life. The inputs are
+    kind of fun. Trackball 1 paints red live cells as it tracks, trackball 2
+    controls the update speed, and clicking either trackball resets to a new
+    game.
 
-                    } else {
+Arguments:
 
-                        //
-                        // A dead pixel with exactly three neighbors spawns
-                        // life.
-                        //
+    Inputs - Supplies the input edges that fired.
 
-                        if (Neighbors == 3) {
-                            KeMatrix[YPixel][XPixel] |= OnPixel;
-                        }
-                    }
-                }
-            }
+    Context - Supplies a pointer to the game state.
 
-            //
-            // Now that the next iteration of the board has been calculated,
-            // update the "previous state" bit.
-            //
+Return Value:
 
-            for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
-                for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
-                    if ((KeMatrix[YPixel][XPixel] & (~PIXEL_USER_BIT)) != 0) {
-                        KeMatrix[YPixel][XPixel] |= PIXEL_USER_BIT;
+    None.
 
-                    } else {
-                        KeMatrix[YPixel][XPixel] &= ~PIXEL_USER_BIT;
-                    }
-                }
-            }
+--*/
+
+{
+
+    UCHAR CursorMoved;
+    PLIFE_GAME Game;
+
+    Game = Context;
+    if ((Inputs & (INPUT_BUTTON1 | INPUT_BUTTON2)) != 0) {
+        LifepStartGame(Game);
+        return;
+    }
+
+    CursorMoved = FALSE;
+    if ((Inputs & INPUT_LEFT1) != 0) {
+        CursorMoved = TRUE;
+        Game->CursorX -= 1;
+        if (Game->CursorX == 0xFF) {
+            Game->CursorX = MATRIX_WIDTH - 1;
+        }
+    }
+
+    if ((Inputs & INPUT_RIGHT1) != 0) {
+        CursorMoved = TRUE;
+        Game->CursorX += 1;
+        if (Game->CursorX == MATRIX_WIDTH) {
+            Game->CursorX = 0;
+        }
+    }
+
+    if ((Inputs & INPUT_UP1) != 0) {
+        CursorMoved = TRUE;
+        Game->CursorY -= 1;
+        if (Game->CursorY == 0xFF) {
+            Game->CursorY = MATRIX_HEIGHT - 1;
+        }
+    }
+
+    if ((Inputs & INPUT_DOWN1) != 0) {
+        CursorMoved = TRUE;
+        Game->CursorY += 1;
+        if (Game->CursorY == MATRIX_HEIGHT) {
+            Game->CursorY = 0;
         }
     }
 
-    return NextApplication;
+    if (CursorMoved != FALSE) {
+        KeMatrix[Game->CursorY][Game->CursorX] = RED_PIXEL(0x1F);
+    }
+
+    if ((Inputs & INPUT_UP2) != 0) {
+        if (Game->UpdateInterval > UPDATE_INCREMENT) {
+            Game->UpdateInterval -= UPDATE_INCREMENT;
+        }
+    }
+
+    if ((Inputs & INPUT_DOWN2) != 0) {
+        Game->UpdateInterval += UPDATE_INCREMENT;
+    }
+
+    return;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
 
 UCHAR
 LifepGetNeighborCount (
@@ -31,7 +31,7 @@ Environment:
 // ---------------------------------------------------------------- Definitions
 //
 
-#define APPLICATION_COUNT 4
+#define APPLICATION_COUNT 7
 
 //
 // ----------------------------------------------- Internal Function Prototypes
@@ -42,6 +42,18 @@ KepRunStandby (
     VOID
     );
 
+VOID
+KepResetFrameStatistics (
+    VOID
+    );
+
+VOID
+KepPrintFrameStatistics (
+    USHORT Minimum,
+    USHORT Average,
+    USHORT Maximum
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -80,6 +92,41 @@ volatile UCHAR KeCurrentMonth;
 volatile USHORT KeRawInputs;
 volatile USHORT KeInputEdges;
 
+//
+// Define the input event queue. The hardware layer is the only producer and
+// only ever moves the head, the application is the only consumer and only
+// ever moves the tail. One entry is always left empty to tell a full queue
+// from an empty one. The indices are single bytes so they're read and written
+// atomically without disabling interrupts.
+//
+
+volatile INPUT_EVENT KeInputEvents[INPUT_EVENT_QUEUE_SIZE];
+volatile UCHAR KeInputEventHead;
+volatile UCHAR KeInputEventTail;
+volatile USHORT KeDroppedInputEvents;
+
+//
+// Define the display refresh state. The frame timer counts up the time since
+// the last frame was due.
+//
+
+volatile UCHAR KeDisplayDirty;
+volatile USHORT KeDirtyTiles;
+volatile UCHAR KeFramePending;
+volatile UCHAR KeDisplayHeld;
+volatile UCHAR KeFrameCount;
+volatile USHORT KeFrameTimer;
+volatile ULONG KeLastFrameTime;
+
+//
+// Define the frame time statistics, in ms/32. The average is a running
+// average that weighs the newest frame at one eighth.
+//
+
+volatile USHORT KeFrameTimeMinimum;
+volatile USHORT KeFrameTimeAverage;
+volatile USHORT KeFrameTimeMaximum;
+
 //
 // Define the application names, in flash memory.
 //
@@ -88,13 +135,19 @@ const CHAR KeGameOfLifeName[] PROGMEM = "Game of Life";
 const CHAR KeSokobanName[] PROGMEM = "Sokoban";
 const CHAR KeTetrisName[] PROGMEM = "Tetris";
 const CHAR KeClockName[] PROGMEM = "Clock";
+const CHAR KeSpectrumName[] PROGMEM = "Spectrum";
+const CHAR KeStreamName[] PROGMEM = "Video Stream";
+const CHAR KeTileSetupName[] PROGMEM = "Tile Setup";
 const CHAR KeBlankString[] PROGMEM = "";
 
 PPGM KeApplicationNames[APPLICATION_COUNT] PROGMEM = {
     KeGameOfLifeName,
     KeSokobanName,
     KeTetrisName,
-    KeClockName
+    KeClockName,
+    KeSpectrumName,
+    KeStreamName,
+    KeTileSetupName
 };
 
 const PVOID KeApplicationEntryPoint[APPLICATION_COUNT] PROGMEM = {
@@ -102,6 +155,9 @@ const PVOID KeApplicationEntryPoint[APPLICATION_COUNT] PROGMEM = {
     SokobanEntry,
     TetrisEntry,
     ClockEntry,
+    SpectrumEntry,
+    StreamEntry,
+    TileSetupEntry,
 };
 
 //
@@ -138,6 +194,8 @@ Return Value:
     UCHAR Application;
     PAPPLICATION_ENTRY ApplicationEntry;
     UCHAR LoopCount;
+    MARQUEE Marquee;
+    PPGM NamePointer;
 
     //
     // Initialize the hardware.
@@ -173,7 +231,29 @@ Return Value:
         }
 
         HlClearLcdScreen();
-        KeStall(32 * 1000UL * 2);
+
+        //
+        // Scroll the application's name across the matrix before starting it.
+        //
+
+        NamePointer =
+             RtlReadProgramSpacePointer(&(KeApplicationNames[Application - 1]));
+
+        GrInitializeMarquee(&Marquee,
+                            1,
+                            0,
+                            (MATRIX_HEIGHT - 7) / 2,
+                            MATRIX_WIDTH,
+                            NamePointer,
+                            RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, 0));
+
+        while (GrStepMarquee(&Marquee) == FALSE) {
+            KeStall(32 * 20);
+        }
+
+        KeClearScreen();
+        KeFlushInputEvents();
+        KepResetFrameStatistics();
         ApplicationEntry = RtlReadProgramSpacePointer(
                                   &(KeApplicationEntryPoint[Application - 1]));
 
@@ -215,6 +295,9 @@ Return Value:
 
 {
 
+    USHORT FrameTimeAverage;
+    USHORT FrameTimeMaximum;
+    USHORT FrameTimeMinimum;
     USHORT InterestingInputs;
     PPGM NamePointer;
     USHORT OldTrackball1;
@@ -230,7 +313,7 @@ Return Value:
     //
 
     if ((KeInputEdges & INPUT_STANDBY) != 0) {
-        KeInputEdges &= ~INPUT_STANDBY;
+        KeAcknowledgeInputEdges(INPUT_STANDBY);
         KepRunStandby();
     }
 
@@ -246,7 +329,16 @@ Return Value:
     // Acknowledge the menu button and light up trackball 2.
     //
 
-    KeInputEdges &= ~INPUT_MENU;
+    KeAcknowledgeInputEdges(INPUT_MENU);
+
+    //
+    // Grab the application's frame times before the menu's own frames get
+    // mixed in.
+    //
+
+    FrameTimeMinimum = KeFrameTimeMinimum;
+    FrameTimeAverage = KeFrameTimeAverage;
+    FrameTimeMaximum = KeFrameTimeMaximum;
     OldWhiteLeds = KeWhiteLeds;
     OldTrackball1 = KeTrackball1;
     OldTrackball2 = KeTrackball2;
@@ -261,6 +353,10 @@ Return Value:
                RtlReadProgramSpacePointer(&(KeApplicationNames[Selection - 1]));
 
         HlLcdPrintStringFromFlash(NamePointer);
+        HlSetLcdAddress(LCD_SECOND_LINE);
+        KepPrintFrameStatistics(FrameTimeMinimum,
+                                FrameTimeAverage,
+                                FrameTimeMaximum);
 
         //
         // Spin while nothing is happening.
@@ -276,7 +372,7 @@ Return Value:
         //
 
         if ((KeInputEdges & INPUT_STANDBY) != 0) {
-            KeInputEdges &= ~INPUT_STANDBY;
+            KeAcknowledgeInputEdges(INPUT_STANDBY);
             KepRunStandby();
         }
 
@@ -285,7 +381,7 @@ Return Value:
         //
 
         if ((KeInputEdges & INPUT_MENU) != 0) {
-            KeInputEdges &= ~INPUT_MENU;
+            KeAcknowledgeInputEdges(INPUT_MENU);
             Selection = ApplicationNone;
             break;
         }
@@ -295,7 +391,7 @@ Return Value:
         //
 
         if ((KeInputEdges & INPUT_BUTTON2) != 0) {
-            KeInputEdges &= ~INPUT_BUTTON2;
+            KeAcknowledgeInputEdges(INPUT_BUTTON2);
             break;
         }
 
@@ -304,20 +400,27 @@ Return Value:
         //
 
         if ((KeInputEdges & INPUT_UP2) != 0) {
-            KeInputEdges &= ~INPUT_UP2;
+            KeAcknowledgeInputEdges(INPUT_UP2);
             if (Selection > 1) {
                 Selection -= 1;
             }
         }
 
         if ((KeInputEdges & INPUT_DOWN2) != 0) {
-            KeInputEdges &= ~INPUT_DOWN2;
+            KeAcknowledgeInputEdges(INPUT_DOWN2);
             if (Selection < APPLICATION_COUNT) {
                 Selection += 1;
             }
         }
     }
 
+    //
+    // Whatever the user did while the menu was up was meant for the menu, not
+    // the application.
+    //
+
+    KeFlushInputEvents();
+
     //
     // Restore the trackballs and white LEDs.
     //
@@ -355,6 +458,17 @@ Return Value:
     UCHAR MonthChanging;
 
     KeRawTime += TimePassed;
+
+    //
+    // Let the hardware layer know when it's time for another frame.
+    //
+
+    KeFrameTimer += TimePassed;
+    if (KeFrameTimer >= DISPLAY_FRAME_INTERVAL) {
+        KeFrameTimer = 0;
+        KeFramePending = TRUE;
+    }
+
     MonthChanging = FALSE;
     KeCurrentTime += TimePassed;
     while (KeCurrentTime >= 32 * 500) {
@@ -423,6 +537,279 @@ Return Value:
     return;
 }
 
+VOID
+KeRefreshDisplay (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called by the hardware layer from the periodic timer
+    interrupt once a frame is pending. It pushes the dirty parts of the matrix
+    out if it is not held, samples the inputs, and updates the frame time
+    statistics.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG CurrentTime;
+    ULONG FrameTime;
+    USHORT Tiles;
+
+    KeFramePending = FALSE;
+    if (((KeDisplayDirty == FALSE) && (KeDirtyTiles == 0)) ||
+        (KeDisplayHeld != FALSE)) {
+
+        HlUpdateInputs();
+        return;
+    }
+
+    //
+    // Clear the dirty state first so that changes made while the matrix is
+    // going out get picked up next frame. The dirty flag means anything may
+    // have changed, so it sends out every tile.
+    //
+
+    Tiles = KeDirtyTiles;
+    KeDirtyTiles = 0;
+    if (KeDisplayDirty != FALSE) {
+        Tiles = DISPLAY_ALL_TILES;
+    }
+
+    KeDisplayDirty = FALSE;
+    HlUpdateDisplay(Tiles);
+    KeFrameCount += 1;
+
+    //
+    // The frame time is how long it took the application to come up with
+    // this frame since the last one. An application that keeps up sees the
+    // frame interval, one that overruns its budget sees more.
+    //
+
+    CurrentTime = KeRawTime;
+    FrameTime = CurrentTime - KeLastFrameTime;
+    KeLastFrameTime = CurrentTime;
+    if (FrameTime > MAX_USHORT) {
+        FrameTime = MAX_USHORT;
+    }
+
+    if (FrameTime < KeFrameTimeMinimum) {
+        KeFrameTimeMinimum = FrameTime;
+    }
+
+    if (FrameTime > KeFrameTimeMaximum) {
+        KeFrameTimeMaximum = FrameTime;
+    }
+
+    KeFrameTimeAverage = KeFrameTimeAverage - (KeFrameTimeAverage >> 3) +
+                         (FrameTime >> 3);
+
+    return;
+}
+
+PCHAR
+KeFormatDecimal (
+    PCHAR Buffer,
+    USHORT Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes out a number in decimal.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the digits will be written. No null
+        terminator is written.
+
+    Value - Supplies the value to write. Leading zeroes are stripped.
+
+Return Value:
+
+    Returns a pointer just after the last digit written.
+
+--*/
+
+{
+
+    USHORT Divisor;
+    UCHAR Started;
+
+    Started = FALSE;
+    for (Divisor = 10000; Divisor != 0; Divisor /= 10) {
+        if ((Value >= Divisor) || (Started != FALSE) || (Divisor == 1)) {
+            *Buffer = '0' + (Value / Divisor);
+            Buffer += 1;
+            Value %= Divisor;
+            Started = TRUE;
+        }
+    }
+
+    return Buffer;
+}
+
+VOID
+KeQueueInputEvent (
+    USHORT Inputs
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds an entry to the input event queue, stamped with the
+    current time. It is called by the hardware layer each time it samples the
+    inputs, and is the only producer for the queue.
+
+Arguments:
+
+    Inputs - Supplies the inputs that turned on since the previous sample.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Head;
+    UCHAR NextHead;
+
+    Head = KeInputEventHead;
+    NextHead = (Head + 1) & (INPUT_EVENT_QUEUE_SIZE - 1);
+    if (NextHead == KeInputEventTail) {
+        KeDroppedInputEvents += 1;
+        return;
+    }
+
+    //
+    // Fill in the entry before publishing it by moving the head.
+    //
+
+    KeInputEvents[Head].Time = KeRawTime;
+    KeInputEvents[Head].Inputs = Inputs;
+    KeInputEventHead = NextHead;
+    return;
+}
+
+UCHAR
+KeGetInputEvent (
+    PINPUT_EVENT Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the oldest entry from the input event queue. Only
+    the running application (or the event loop on its behalf) may call this
+    routine.
+
+Arguments:
+
+    Event - Supplies a pointer where the event will be returned.
+
+Return Value:
+
+    TRUE if an event was returned.
+
+    FALSE if the queue is empty.
+
+--*/
+
+{
+
+    UCHAR Tail;
+
+    Tail = KeInputEventTail;
+    if (Tail == KeInputEventHead) {
+        return FALSE;
+    }
+
+    //
+    // Copy the entry out before handing the slot back to the producer.
+    //
+
+    Event->Time = KeInputEvents[Tail].Time;
+    Event->Inputs = KeInputEvents[Tail].Inputs;
+    KeInputEventTail = (Tail + 1) & (INPUT_EVENT_QUEUE_SIZE - 1);
+    return TRUE;
+}
+
+VOID
+KeFlushInputEvents (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine throws away every entry in the input event queue. Like
+    KeGetInputEvent, only the consumer may call it.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeInputEventTail = KeInputEventHead;
+    return;
+}
+
+VOID
+KeAcknowledgeInputEdges (
+    USHORT Inputs
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clears the given inputs out of the input edges. The
+    interrupt that samples the inputs ORs new edges in, so applications must
+    clear them here rather than writing KeInputEdges directly, or an edge
+    arriving in the middle of the update is lost.
+
+Arguments:
+
+    Inputs - Supplies the mask of inputs to clear.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    HlEnterCriticalSection();
+    KeInputEdges &= ~Inputs;
+    HlLeaveCriticalSection();
+    return;
+}
+
 VOID
 KeStallTenthSecond (
     VOID
@@ -478,21 +865,27 @@ Return Value:
 
     StartTime = KeRawTime;
     EndTime = StartTime + StallTime;
-    HlUpdateDisplay();
+
+    //
+    // Whatever the application drew before stalling goes out with the next
+    // frame.
+    //
+
+    KeDisplayDirty = TRUE;
 
     //
     // If the ending time wraps around, wait for the current time to wrap
-    // around.
+    // around. Idle the processor between timer ticks rather than spinning.
     //
 
     if (EndTime < StartTime) {
         while (KeRawTime >= StartTime) {
-            NOTHING;
+            HlWaitForInterrupt();
         }
     }
 
     while (KeRawTime < EndTime) {
-        NOTHING;
+        HlWaitForInterrupt();
     }
 
     return;
@@ -521,16 +914,84 @@ Return Value:
 
 {
 
-    UCHAR XPixel;
-    UCHAR YPixel;
+    HlClearScreen();
+    return;
+}
+
+VOID
+KeInvalidateRectangle (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height
+    )
+
+/*++
+
+Routine Description:
+
+    This routine marks the slave tiles covering a rectangle of the matrix as
+    dirty, so that they alone go out with the next frame.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left of the rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left of the rectangle.
+
+    Width - Supplies the width of the rectangle.
+
+    Height - Supplies the height of the rectangle.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Column;
+    UCHAR ColumnEnd;
+    UCHAR Row;
+    UCHAR RowEnd;
+    USHORT Tiles;
 
-    for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
-        for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
-            KeMatrix[YPixel][XPixel] = 0;
+    if ((Width == 0) || (Height == 0) ||
+        (XPosition >= MATRIX_WIDTH) || (YPosition >= MATRIX_HEIGHT)) {
+
+        return;
+    }
+
+    ColumnEnd = XPosition + Width - 1;
+    if (ColumnEnd >= MATRIX_WIDTH) {
+        ColumnEnd = MATRIX_WIDTH - 1;
+    }
+
+    RowEnd = YPosition + Height - 1;
+    if (RowEnd >= MATRIX_HEIGHT) {
+        RowEnd = MATRIX_HEIGHT - 1;
+    }
+
+    ColumnEnd /= MATRIX_TILE_COLUMNS;
+    RowEnd /= MATRIX_TILE_ROWS;
+    Tiles = 0;
+    for (Row = YPosition / MATRIX_TILE_ROWS; Row <= RowEnd; Row += 1) {
+        for (Column = XPosition / MATRIX_TILE_COLUMNS;
+             Column <= ColumnEnd;
+             Column += 1) {
+
+            Tiles |= 1 << ((Row * MATRIX_TILES_PER_ROW) + Column);
         }
     }
 
-    HlClearScreen();
+    //
+    // The frame interrupt may send and clear the mask partway through this
+    // update. At worst that leaves a tile that already went out marked dirty
+    // again, which costs one extra packet but never loses a change.
+    //
+
+    KeDirtyTiles |= Tiles;
     return;
 }
 
@@ -603,8 +1064,95 @@ Return Value:
     // Pretend like none of the other button pushes etc were noticed.
     //
 
-    KeInputEdges = 0;
+    KeAcknowledgeInputEdges(0xFFFF);
     KeWhiteLeds = OldWhiteLeds;
     return;
 }
 
+VOID
+KepResetFrameStatistics (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts the frame time statistics over, for a new application.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeLastFrameTime = KeRawTime;
+    KeFrameTimeMinimum = MAX_USHORT;
+    KeFrameTimeAverage = DISPLAY_FRAME_INTERVAL;
+    KeFrameTimeMaximum = 0;
+    return;
+}
+
+VOID
+KepPrintFrameStatistics (
+    USHORT Minimum,
+    USHORT Average,
+    USHORT Maximum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the frame times in milliseconds to the LCD, in the
+    form "Frame min/avg/max".
+
+Arguments:
+
+    Minimum - Supplies the shortest frame time, in ms/32.
+
+    Average - Supplies the average frame time, in ms/32.
+
+    Maximum - Supplies the longest frame time, in ms/32.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCHAR End;
+    CHAR Line[LCD_LINE_LENGTH + 8];
+
+    //
+    // Before the first frame, the minimum is still at its starting value.
+    //
+
+    if (Minimum > Maximum) {
+        Minimum = 0;
+    }
+
+    Line[0] = 'F';
+    Line[1] = 'r';
+    Line[2] = 'a';
+    Line[3] = 'm';
+    Line[4] = 'e';
+    Line[5] = ' ';
+    End = KeFormatDecimal(&(Line[6]), Minimum / 32);
+    *End = '/';
+    End = KeFormatDecimal(End + 1, Average / 32);
+    *End = '/';
+    End = KeFormatDecimal(End + 1, Maximum / 32);
+    *End = '\0';
+    HlLcdPrintString(Line);
+    return;
+}
+
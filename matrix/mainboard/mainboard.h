@@ -27,6 +27,12 @@ Author:
 #define MATRIX_HEIGHT 24
 #define MATRIX_WIDTH 24
 
+//
+// Define the dirty tile mask that covers the whole matrix.
+//
+
+#define DISPLAY_ALL_TILES ((1 << MATRIX_TILE_COUNT) - 1)
+
 //
 // Defines masks for pixel bitfields. The pixel user bit is ignored by hardware
 // and can be used by applications.
@@ -77,6 +83,56 @@ Author:
 #define ANALOG_INPUT_ALCOHOL 7
 #define ANALOG_INPUT_INTERNAL_TEMPERATURE 8
 
+//
+// Define the number of entries in a palette indexed sprite's palette.
+//
+
+#define GRAPHICS_PALETTE_SIZE 4
+
+//
+// Define the maximum number of columns a scrolling marquee message can render
+// to, including the blank column after each character.
+//
+
+#define GRAPHICS_MARQUEE_COLUMNS 80
+
+//
+// Define the number of entries in the input event queue, which must be a
+// power of two.
+//
+
+#define INPUT_EVENT_QUEUE_SIZE 16
+
+//
+// Define the number of slots in the timer wheel, which must be a power of two,
+// and the width of each slot as a shift of the raw time (ms/32).
+//
+
+#define TIMER_WHEEL_SIZE 8
+#define TIMER_WHEEL_SHIFT 5
+
+//
+// Define how often the periodic timer interrupt pushes out the display and
+// samples the inputs, in ms/32.
+//
+
+#define DISPLAY_FRAME_INTERVAL (32 * 10)
+
+//
+// Define the number of audio samples the hardware layer keeps, which must be
+// a power of two, and roughly how many it captures each second.
+//
+
+#define AUDIO_BUFFER_SIZE 64
+#define AUDIO_SAMPLE_RATE 12019
+
+//
+// Define the value that means no tile number is being offered to the matrix
+// slaves.
+//
+
+#define SLAVE_TILE_NONE 0xFF
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -109,6 +165,148 @@ Return Value:
 
 --*/
 
+typedef
+VOID
+(*PTIMER_ROUTINE) (
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called by the event loop when a timer expires.
+
+Arguments:
+
+    Context - Supplies the context pointer supplied when the timer was queued.
+
+Return Value:
+
+    None.
+
+--*/
+
+typedef
+VOID
+(*PINPUT_ROUTINE) (
+    USHORT Inputs,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called by the event loop when inputs an application is
+    interested in have been pressed.
+
+Arguments:
+
+    Inputs - Supplies the input edges that fired. These have already been
+        cleared from the global input edges.
+
+    Context - Supplies the context pointer supplied when the handler was set.
+
+Return Value:
+
+    None.
+
+--*/
+
+typedef struct _INPUT_EVENT {
+    ULONG Time;
+    USHORT Inputs;
+} INPUT_EVENT, *PINPUT_EVENT;
+
+/*++
+
+Structure Description:
+
+    This structure stores one entry in the input event queue.
+
+Members:
+
+    Time - Stores the raw time the inputs were sampled at, in ms/32.
+
+    Inputs - Stores the inputs that turned on since the previous sample.
+
+--*/
+
+typedef struct _TIMER {
+    struct _TIMER *Next;
+    ULONG DueTime;
+    ULONG Period;
+    PTIMER_ROUTINE Routine;
+    PVOID Context;
+    UCHAR Queued;
+} TIMER, *PTIMER;
+
+/*++
+
+Structure Description:
+
+    This structure stores a one-shot or periodic timer. The storage is owned
+    by the caller, and must stay valid while the timer is queued.
+
+Members:
+
+    Next - Stores a pointer to the next timer in the same timer wheel slot.
+
+    DueTime - Stores the raw time the timer expires at, in ms/32.
+
+    Period - Stores the interval to requeue the timer at once it expires, in
+        ms/32. Zero makes this a one-shot timer.
+
+    Routine - Stores the function to call when the timer expires.
+
+    Context - Stores the pointer to pass to the routine.
+
+    Queued - Stores a boolean indicating if the timer is in the timer wheel.
+
+--*/
+
+typedef struct _MARQUEE {
+    UCHAR Columns[GRAPHICS_MARQUEE_COLUMNS];
+    UCHAR ColumnCount;
+    UCHAR NextColumn;
+    UCHAR XPosition;
+    UCHAR YPosition;
+    UCHAR Width;
+    UCHAR Height;
+    USHORT Color;
+} MARQUEE, *PMARQUEE;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of a message scrolling across a window of
+    the matrix.
+
+Members:
+
+    Columns - Stores the rendered message, one byte per column with the top row
+        in the least significant bit.
+
+    ColumnCount - Stores the number of valid entries in the columns array.
+
+    NextColumn - Stores the index of the next column to scroll into the window.
+        Indices beyond the column count are blank, which lets the message
+        scroll completely off before wrapping.
+
+    XPosition - Stores the X coordinate of the left edge of the window.
+
+    YPosition - Stores the Y coordinate of the top edge of the window.
+
+    Width - Stores the width of the window in pixels.
+
+    Height - Stores the number of rows of the font in use.
+
+    Color - Stores the color to draw the message in.
+
+--*/
+
 //
 // --------------------------------------------------------------------- Macros
 //
@@ -173,6 +371,47 @@ extern volatile USHORT KeWhiteLeds;
 extern volatile USHORT KeRawInputs;
 extern volatile USHORT KeInputEdges;
 
+//
+// Define the number of input events thrown away because the queue was full.
+//
+
+extern volatile USHORT KeDroppedInputEvents;
+
+//
+// Define the display refresh state. Applications set the dirty flag after
+// changing the matrix, and the periodic timer pushes it out when the next
+// frame is due.
+//
+
+extern volatile UCHAR KeDisplayDirty;
+extern volatile UCHAR KeFramePending;
+
+//
+// Define the mask of slave tiles that have changed. An application that keeps
+// track of what it changed marks tiles dirty with KeInvalidateRectangle rather
+// than setting the dirty flag, and only those tiles get sent out.
+//
+
+extern volatile USHORT KeDirtyTiles;
+
+//
+// Define the display hold flag. An application that builds up a frame over
+// several callbacks sets it so that a half finished frame never goes out.
+// The frame count goes up by one, wrapping around, with every frame pushed
+// out.
+//
+
+extern volatile UCHAR KeDisplayHeld;
+extern volatile UCHAR KeFrameCount;
+
+//
+// Define the time between frames that were pushed out, in ms/32.
+//
+
+extern volatile USHORT KeFrameTimeMinimum;
+extern volatile USHORT KeFrameTimeAverage;
+extern volatile USHORT KeFrameTimeMaximum;
+
 //
 // Define the current time variables.
 //
@@ -190,6 +429,13 @@ extern volatile UCHAR KeCurrentMonth;
 // -------------------------------------------------------- Function Prototypes
 //
 
+//
+// Host programs that link in parts of the firmware, like the Tetris benchmark,
+// define MATRIX_HOST_PROGRAM and bring a main routine of their own.
+//
+
+#ifndef MATRIX_HOST_PROGRAM
+
 INT
 main (
     VOID
@@ -211,6 +457,8 @@ Return Value:
 
 --*/
 
+#endif
+
 //
 // Executive Layer Functions
 //
@@ -264,7 +512,7 @@ Return Value:
 --*/
 
 VOID
-KeStallTenthSecond (
+KeRefreshDisplay (
     VOID
     );
 
@@ -272,7 +520,9 @@ KeStallTenthSecond (
 
 Routine Description:
 
-    This routine stalls execution for 0.1 seconds.
+    This routine is called by the hardware layer from the periodic timer
+    interrupt once a frame is pending. It pushes the matrix out if it is
+    dirty, samples the inputs, and updates the frame time statistics.
 
 Arguments:
 
@@ -284,42 +534,47 @@ Return Value:
 
 --*/
 
-VOID
-KeStall (
-    ULONG StallTime
+PCHAR
+KeFormatDecimal (
+    PCHAR Buffer,
+    USHORT Value
     );
 
 /*++
 
 Routine Description:
 
-    This routine stalls execution for the desired amount of time.
+    This routine writes out a number in decimal.
 
 Arguments:
 
-    StallTime - Supplies the amount of time to stall, in 32nds of a millisecond
-        (ms/32).
+    Buffer - Supplies a pointer where the digits will be written. No null
+        terminator is written.
+
+    Value - Supplies the value to write. Leading zeroes are stripped.
 
 Return Value:
 
-    None.
+    Returns a pointer just after the last digit written.
 
 --*/
 
 VOID
-KeClearScreen (
-    VOID
+KeQueueInputEvent (
+    USHORT Inputs
     );
 
 /*++
 
 Routine Description:
 
-    This routine blanks the output matrix.
+    This routine adds an entry to the input event queue, stamped with the
+    current time. It is called by the hardware layer each time it samples the
+    inputs, and is the only producer for the queue.
 
 Arguments:
 
-    None.
+    Inputs - Supplies the inputs that turned on since the previous sample.
 
 Return Value:
 
@@ -327,33 +582,33 @@ Return Value:
 
 --*/
 
-//
-// Hardware Layer Functions
-//
-
-VOID
-HlInitialize (
-    VOID
+UCHAR
+KeGetInputEvent (
+    PINPUT_EVENT Event
     );
 
 /*++
 
 Routine Description:
 
-    This routine initializes the hardware abstraction layer.
+    This routine removes the oldest entry from the input event queue. Only
+    the running application (or the event loop on its behalf) may call this
+    routine.
 
 Arguments:
 
-    None.
+    Event - Supplies a pointer where the event will be returned.
 
 Return Value:
 
-    None.
+    TRUE if an event was returned.
+
+    FALSE if the queue is empty.
 
 --*/
 
-USHORT
-HlRandom (
+VOID
+KeFlushInputEvents (
     VOID
     );
 
@@ -361,7 +616,8 @@ HlRandom (
 
 Routine Description:
 
-    This routine returns a random number between 0 and 65535.
+    This routine throws away every entry in the input event queue. Like
+    KeGetInputEvent, only the consumer may call it.
 
 Arguments:
 
@@ -369,43 +625,27 @@ Arguments:
 
 Return Value:
 
-    Returns a random number between 0 and 65535.
+    None.
 
 --*/
 
 VOID
-HlPrintText (
-    UCHAR Size,
-    UCHAR XPosition,
-    UCHAR YPosition,
-    UCHAR Character,
-    USHORT Color
+KeAcknowledgeInputEdges (
+    USHORT Inputs
     );
 
 /*++
 
 Routine Description:
 
-    This routine prints a character onto the matrix.
+    This routine clears the given inputs out of the input edges. The
+    interrupt that samples the inputs ORs new edges in, so applications must
+    clear them here rather than writing KeInputEdges directly, or an edge
+    arriving in the middle of the update is lost.
 
 Arguments:
 
-    Size - Supplies the size of the character to print. Valid values are as
-        follows:
-
-        0 - Prints a 3 x 5 character.
-
-        1 - Prints a 5 x 7 character.
-
-    XPosition - Supplies the X coordinate of the upper left corner of the
-        letter.
-
-    YPosition - Supplies the Y coordinate of the upper left corner of the
-        letter.
-
-    Character - Supplies the character to print,
-
-    Color - Supplies the color to print the character.
+    Inputs - Supplies the mask of inputs to clear.
 
 Return Value:
 
@@ -414,7 +654,7 @@ Return Value:
 --*/
 
 VOID
-HlClearScreen (
+KeStallTenthSecond (
     VOID
     );
 
@@ -422,7 +662,7 @@ HlClearScreen (
 
 Routine Description:
 
-    This routine clears the entire screen, turning off all LEDs.
+    This routine stalls execution for 0.1 seconds.
 
 Arguments:
 
@@ -435,19 +675,20 @@ Return Value:
 --*/
 
 VOID
-HlClearLcdScreen (
-    VOID
+KeStall (
+    ULONG StallTime
     );
 
 /*++
 
 Routine Description:
 
-    This routine clears the LCD screen.
+    This routine stalls execution for the desired amount of time.
 
 Arguments:
 
-    None.
+    StallTime - Supplies the amount of time to stall, in 32nds of a millisecond
+        (ms/32).
 
 Return Value:
 
@@ -456,20 +697,19 @@ Return Value:
 --*/
 
 VOID
-HlSetLcdAddress (
-    UCHAR Address
+KeClearScreen (
+    VOID
     );
 
 /*++
 
 Routine Description:
 
-    This routine sets the address of the next character to be written to the
-    LCD screen.
+    This routine blanks the output matrix.
 
 Arguments:
 
-    Address - Supplies the address to write.
+    None.
 
 Return Value:
 
@@ -478,21 +718,29 @@ Return Value:
 --*/
 
 VOID
-HlLcdPrintStringFromFlash (
-    PPGM String
+KeInvalidateRectangle (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height
     );
 
 /*++
 
 Routine Description:
 
-    This routine prints a string at the current LCD address. Wrapping to the
-    next line is not accounted for.
+    This routine marks the slave tiles covering a rectangle of the matrix as
+    dirty, so that they alone go out with the next frame.
 
 Arguments:
 
-    String - Supplies a pointer to an address in code space of the string to
-        print.
+    XPosition - Supplies the X coordinate of the upper left of the rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left of the rectangle.
+
+    Width - Supplies the width of the rectangle.
+
+    Height - Supplies the height of the rectangle.
 
 Return Value:
 
@@ -501,21 +749,19 @@ Return Value:
 --*/
 
 VOID
-HlLcdPrintString (
-    PCHAR String
+KeInitializeTimer (
+    PTIMER Timer
     );
 
 /*++
 
 Routine Description:
 
-    This routine prints a string at the current LCD address. Wrapping to the
-    next line is not accounted for.
+    This routine initializes a timer so that it can be queued.
 
 Arguments:
 
-    String - Supplies a pointer to an address in data space of the string to
-        print.
+    Timer - Supplies a pointer to the timer storage.
 
 Return Value:
 
@@ -523,42 +769,46 @@ Return Value:
 
 --*/
 
-VOID
-HlLcdPrintHexInteger (
-    ULONG Value
+APPLICATION
+KeRunEventLoop (
+    VOID
     );
 
 /*++
 
 Routine Description:
 
-    This routine prints a hexadecimal integer at the current LCD location. Line
-    wrapping is not handled.
+    This routine runs the cooperative event loop for an application. It calls
+    the input handler and expired timers as they come due, marks the display
+    dirty after each, and sleeps the processor in between. When the loop
+    exits, every timer is cancelled and the input handler is cleared.
 
 Arguments:
 
-    Value - Supplies the value to write. Leading zeroes are stripped.
+    None.
 
 Return Value:
 
-    None.
+    Returns the next application to run, either from the menu or from
+    KeExitEventLoop.
 
 --*/
 
 VOID
-HlUpdateDisplay (
-    VOID
+KeExitEventLoop (
+    APPLICATION NextApplication
     );
 
 /*++
 
 Routine Description:
 
-    This routine allows the hardware layer to update the matrix display.
+    This routine asks the event loop to return once the current callback is
+    finished.
 
 Arguments:
 
-    None.
+    NextApplication - Supplies the value the event loop should return.
 
 Return Value:
 
@@ -566,33 +816,926 @@ Return Value:
 
 --*/
 
-//
-// Application Entry Points
-//
-
-APPLICATION
-LifeEntry (
-    VOID
+VOID
+KeQueueTimer (
+    PTIMER Timer,
+    ULONG DueTime,
+    ULONG Period,
+    PTIMER_ROUTINE Routine,
+    PVOID Context
     );
 
 /*++
 
 Routine Description:
 
-    This routine is the entry point for Conway's Game of Life.
+    This routine queues a timer in the timer wheel. If the timer is already
+    queued, it is moved to the new due time.
 
 Arguments:
 
-    None.
+    Timer - Supplies a pointer to the timer storage.
 
-Return Value:
+    DueTime - Supplies the time from now until the timer expires, in ms/32.
 
-    Returns the index of the next application to launch.
+    Period - Supplies the interval to requeue the timer at after it expires,
+        in ms/32. Supply zero for a one-shot timer.
 
---*/
+    Routine - Supplies the routine to call when the timer expires.
 
-APPLICATION
-SokobanEntry (
+    Context - Supplies a pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+KeCancelTimer (
+    PTIMER Timer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a timer from the timer wheel if it is queued.
+
+Arguments:
+
+    Timer - Supplies a pointer to the timer to cancel.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+KeSetInputHandler (
+    USHORT Inputs,
+    PINPUT_ROUTINE Routine,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the routine the event loop calls when inputs are
+    pressed. Only one handler is active at a time.
+
+Arguments:
+
+    Inputs - Supplies the mask of input edges the handler wants. The menu and
+        standby inputs are always handled by the event loop.
+
+    Routine - Supplies the routine to call, or NULL to remove the handler.
+
+    Context - Supplies a pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+//
+// Graphics Functions
+//
+
+VOID
+GrFillRectangle (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    USHORT Pixel
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills a rectangle of the matrix with a single value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Pixel - Supplies the value to fill the rectangle with.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+GrScrollRows (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    SHORT Distance,
+    USHORT Fill
+    );
+
+/*++
+
+Routine Description:
+
+    This routine shifts the contents of a rectangle of the matrix up or down.
+    Pixels shifted out of the rectangle are lost, and rows shifted in are
+    filled with the given value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Distance - Supplies the number of rows to shift by. Positive values shift
+        the contents down, negative values shift the contents up.
+
+    Fill - Supplies the value to fill the vacated rows with.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+GrScrollColumns (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    SHORT Distance,
+    USHORT Fill
+    );
+
+/*++
+
+Routine Description:
+
+    This routine shifts the contents of a rectangle of the matrix left or
+    right. Pixels shifted out of the rectangle are lost, and columns shifted in
+    are filled with the given value.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        rectangle.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        rectangle.
+
+    Width - Supplies the width of the rectangle in pixels.
+
+    Height - Supplies the height of the rectangle in pixels.
+
+    Distance - Supplies the number of columns to shift by. Positive values
+        shift the contents right, negative values shift the contents left.
+
+    Fill - Supplies the value to fill the vacated columns with.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+GrBlitMaskedSprite (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    PPGM Data,
+    USHORT Color
+    );
+
+/*++
+
+Routine Description:
+
+    This routine draws a one bit per pixel sprite stored in program space onto
+    the matrix. Set bits are painted with the given color, and clear bits leave
+    the matrix untouched.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        sprite.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        sprite.
+
+    Width - Supplies the width of the sprite in pixels.
+
+    Height - Supplies the height of the sprite in pixels.
+
+    Data - Supplies a pointer into program space of the sprite bits. Pixels are
+        packed as a continuous stream in row order, least significant bit
+        first, without padding at the end of a row.
+
+    Color - Supplies the value to paint set pixels with.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+GrBlitPaletteSprite (
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    UCHAR Height,
+    PPGM Data,
+    PUSHORT Palette
+    );
+
+/*++
+
+Routine Description:
+
+    This routine draws a two bit per pixel palette indexed sprite stored in
+    program space onto the matrix.
+
+Arguments:
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        sprite.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        sprite.
+
+    Width - Supplies the width of the sprite in pixels.
+
+    Height - Supplies the height of the sprite in pixels.
+
+    Data - Supplies a pointer into program space of the sprite data. Pixels are
+        packed four to a byte as a continuous stream in row order, starting
+        with the least significant bits, without padding at the end of a row.
+
+    Palette - Supplies a pointer to an array of GRAPHICS_PALETTE_SIZE pixel
+        values that the two bit indices select from.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+GrInitializeMarquee (
+    PMARQUEE Marquee,
+    UCHAR Size,
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Width,
+    PPGM Message,
+    USHORT Color
+    );
+
+/*++
+
+Routine Description:
+
+    This routine renders a message into a marquee and blanks the marquee's
+    window on the matrix. The font is only read once here, so stepping the
+    marquee afterwards is just a shift of the window and one column of drawing.
+
+Arguments:
+
+    Marquee - Supplies a pointer to the marquee to initialize.
+
+    Size - Supplies the size of the font to use. Valid values are the same as
+        for HlPrintText.
+
+    XPosition - Supplies the X coordinate of the left edge of the window.
+
+    YPosition - Supplies the Y coordinate of the top edge of the window.
+
+    Width - Supplies the width of the window in pixels.
+
+    Message - Supplies a pointer to the null terminated message, in flash.
+        Messages that are too long are truncated.
+
+    Color - Supplies the color to draw the message in.
+
+Return Value:
+
+    None.
+
+--*/
+
+UCHAR
+GrStepMarquee (
+    PMARQUEE Marquee
+    );
+
+/*++
+
+Routine Description:
+
+    This routine scrolls a marquee one column to the left.
+
+Arguments:
+
+    Marquee - Supplies a pointer to the marquee to advance.
+
+Return Value:
+
+    TRUE if the message has just scrolled entirely out of the window. The next
+    step starts the message over again.
+
+    FALSE if the message is still on its way through the window.
+
+--*/
+
+//
+// Hardware Layer Functions
+//
+
+VOID
+HlInitialize (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes the hardware abstraction layer.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+USHORT
+HlRandom (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns a random number between 0 and 65535.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a random number between 0 and 65535.
+
+--*/
+
+USHORT
+HlReadAnalogInput (
+    UCHAR Input
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the latest filtered value of an analog input. The
+    inputs are sampled in the background, so this never waits on the ADC.
+
+Arguments:
+
+    Input - Supplies the analog input to read. See ANALOG_INPUT_*
+        definitions.
+
+Return Value:
+
+    Returns the 10-bit value of the input.
+
+--*/
+
+VOID
+HlPrintText (
+    UCHAR Size,
+    UCHAR XPosition,
+    UCHAR YPosition,
+    UCHAR Character,
+    USHORT Color
+    );
+
+/*++
+
+Routine Description:
+
+    This routine prints a character onto the matrix.
+
+Arguments:
+
+    Size - Supplies the size of the character to print. Valid values are as
+        follows:
+
+        0 - Prints a 3 x 5 character.
+
+        1 - Prints a 5 x 7 character.
+
+    XPosition - Supplies the X coordinate of the upper left corner of the
+        letter.
+
+    YPosition - Supplies the Y coordinate of the upper left corner of the
+        letter.
+
+    Character - Supplies the character to print,
+
+    Color - Supplies the color to print the character.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlClearScreen (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine clears the entire screen, turning off all LEDs.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlClearLcdScreen (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine clears the LCD screen.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlSetLcdAddress (
+    UCHAR Address
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the address of the next character to be written to the
+    LCD screen.
+
+Arguments:
+
+    Address - Supplies the address to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlLcdPrintStringFromFlash (
+    PPGM String
+    );
+
+/*++
+
+Routine Description:
+
+    This routine prints a string at the current LCD address. Wrapping to the
+    next line is not accounted for.
+
+Arguments:
+
+    String - Supplies a pointer to an address in code space of the string to
+        print.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlLcdPrintString (
+    PCHAR String
+    );
+
+/*++
+
+Routine Description:
+
+    This routine prints a string at the current LCD address. Wrapping to the
+    next line is not accounted for.
+
+Arguments:
+
+    String - Supplies a pointer to an address in data space of the string to
+        print.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlLcdPrintHexInteger (
+    ULONG Value
+    );
+
+/*++
+
+Routine Description:
+
+    This routine prints a hexadecimal integer at the current LCD location. Line
+    wrapping is not handled.
+
+Arguments:
+
+    Value - Supplies the value to write. Leading zeroes are stripped.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlUpdateDisplay (
+    USHORT Tiles
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends out the matrix and samples the inputs. It is called by
+    the executive from the periodic timer interrupt, applications should set
+    KeDisplayDirty instead.
+
+Arguments:
+
+    Tiles - Supplies the mask of slave tiles to send out.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlUpdateInputs (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine samples the inputs without sending out the matrix.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlWaitForInterrupt (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine idles the processor until the next interrupt, which is at
+    most one periodic timer tick away.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlEnterCriticalSection (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine holds off the periodic timer and input interrupts, so that
+    state they share with the application can be updated atomically. It
+    must not be called from an interrupt.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlLeaveCriticalSection (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine lets the interrupts held off by HlEnterCriticalSection run
+    again.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlStartAudioCapture (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine starts sampling the audio input continuously in the
+    background. The other analog inputs keep their last values while the
+    capture is running.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlStopAudioCapture (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine stops the background audio capture.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlReadAudioSamples (
+    PUCHAR Buffer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine copies out the most recent audio samples.
+
+Arguments:
+
+    Buffer - Supplies a pointer where AUDIO_BUFFER_SIZE samples will be
+        returned, oldest first. Samples are unsigned 8-bit values centered
+        around 128.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlRequestSlaveTile (
+    UCHAR Tile
+    );
+
+/*++
+
+Routine Description:
+
+    This routine offers a tile number to the matrix slaves with every frame
+    sent out, until it is called again. A slave takes the number if its button
+    is held down, and keeps it across power cycles.
+
+Arguments:
+
+    Tile - Supplies the tile number to offer, or SLAVE_TILE_NONE to stop.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlStartSerial (
+    ULONG BaudRate
+    );
+
+/*++
+
+Routine Description:
+
+    This routine turns on the serial port. Received bytes are buffered in the
+    background until they are read.
+
+Arguments:
+
+    BaudRate - Supplies the baud rate to run the port at.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+HlStopSerial (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine turns off the serial port and throws away anything received.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+UCHAR
+HlReadSerial (
+    PUCHAR Buffer,
+    UCHAR Size,
+    PUCHAR Overflowed
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads whatever has been received on the serial port, without
+    waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the received bytes will be returned.
+
+    Size - Supplies the size of the buffer in bytes.
+
+    Overflowed - Supplies a pointer where TRUE will be returned if bytes were
+        lost since the last read because nobody read them in time.
+
+Return Value:
+
+    Returns the number of bytes read.
+
+--*/
+
+VOID
+HlWriteSerial (
+    UCHAR Byte
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends a byte out of the serial port, waiting for the
+    previous one to get out of the way first.
+
+Arguments:
+
+    Byte - Supplies the byte to send.
+
+Return Value:
+
+    None.
+
+--*/
+
+//
+// Application Entry Points
+//
+
+APPLICATION
+LifeEntry (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for Conway's Game of Life.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the index of the next application to launch.
+
+--*/
+
+APPLICATION
+SokobanEntry (
     VOID
     );
 
@@ -654,3 +1797,68 @@ Return Value:
 
 --*/
 
+APPLICATION
+SpectrumEntry (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the spectrum display.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
+APPLICATION
+StreamEntry (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the video stream app, which shows
+    frames sent from a PC over the serial port.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
+APPLICATION
+TileSetupEntry (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the tile setup app, which numbers the
+    matrix slaves according to where they sit in the wall.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
@@ -0,0 +1,2673 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    makeasset.c
+
+Abstract:
+
+    This module implements the program responsible for creating the
+    assetdata.c source file, which holds every font, Sokoban level and sprite
+    built into the firmware, along with the assets.h manifest describing them.
+
+Author:
+
+    Evan Green 14-Nov-2010
+
+Environment:
+
+    Build
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "sokoban.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define USAGE_STRING \
+    "MakeAsset takes in a list of assets and creates an output C file " \
+    "containing the encoded font, level and sprite data, along with a " \
+    "manifest header describing it.\n\n" \
+    "Usage: MakeAsset [-p] [-s] [-j <Threads>] [-b <Budget>] " \
+    "-o <OutputFile> -m <ManifestFile> <AssetList>\n\n" \
+    "Options:\n" \
+    "    -p  Solve the levels, and write their pars out to the par file. " \
+    "Without\n        this, the pars are read from the par file.\n" \
+    "    -s  Order the levels by their par number of pushes, once every " \
+    "level\n        has one.\n" \
+    "    -j  Solve levels with the given number of threads.\n" \
+    "    -b  Fail if the assets take more than the given number of bytes of " \
+    "flash.\n\n" \
+    "Each line of the asset list is one of the following:\n" \
+    "    font <Symbol> <Width>x<Height> packed|columns <File>\n" \
+    "    levels <File> <ParFile>\n" \
+    "    sprite <Symbol> masked|palette <File>\n\n"
+
+//
+// Define the number of threads used to solve levels if not specified.
+//
+
+#define DEFAULT_SOLVER_THREADS 4
+
+//
+// Define the size of the flash on the mainboard, which the budget report is
+// measured against.
+//
+
+#define FLASH_SIZE 32768
+
+//
+// Define the limits of the asset compiler.
+//
+
+#define MAX_ASSETS 32
+#define MAX_LINE_LENGTH 256
+#define MAX_TOKEN_LENGTH 64
+#define MAX_SPRITE_DIMENSION 255
+#define MAX_SPRITE_DATA 16384
+
+#define OUTPUT_BOILERPLATE \
+    "/*++\n\n" \
+    "Copyright (c) 2010 Evan Green\n\n" \
+    "Module Name:\n\n" \
+    "    assetdata.c\n\n" \
+    "Abstract:\n\n" \
+    "    This module contains the encoded fonts, Sokoban levels and " \
+    "sprites.\n" \
+    "    WARNING: THIS FILE IS AUTOGENERATED. DO NOT ALTER OR CHECK IN " \
+    "DIRECTLY!!\n\n" \
+    "Author:\n\n" \
+    "    Evan Green 14-Nov-2010\n\n"\
+    "Environment:\n\n" \
+    "    x86/AVR\n\n" \
+    "--*/\n\n" \
+    "//\n" \
+    "// -----------------------------------------------------------------" \
+    "-- Includes\n" \
+    "//\n\n" \
+    "#include \"types.h\"\n" \
+    "#include \"fontdata.h\"\n" \
+    "#include \"sokoban.h\"\n" \
+    "#include \"assets.h\"\n\n" \
+    "//\n" \
+    "// ------------------------------------------------------------------" \
+    "-- Globals\n" \
+    "//\n\n" \
+
+#define MANIFEST_BOILERPLATE \
+    "/*++\n\n" \
+    "Copyright (c) 2010 Evan Green\n\n" \
+    "Module Name:\n\n" \
+    "    assets.h\n\n" \
+    "Abstract:\n\n" \
+    "    This header contains the manifest of the assets in assetdata.c.\n" \
+    "    WARNING: THIS FILE IS AUTOGENERATED. DO NOT ALTER OR CHECK IN " \
+    "DIRECTLY!!\n\n" \
+    "Author:\n\n" \
+    "    Evan Green 14-Nov-2010\n\n"\
+    "--*/\n\n" \
+    "//\n" \
+    "// --------------------------------------------------------------" \
+    "-- Definitions\n" \
+    "//\n\n" \
+
+#define MANIFEST_GLOBALS \
+    "//\n" \
+    "// ------------------------------------------------------------------" \
+    "-- Globals\n" \
+    "//\n\n" \
+    "//\n" \
+    "// Define a global containing every sprite, encoded for the graphics " \
+    "blit\n" \
+    "// routines. Sprites that share their data are stored once.\n" \
+    "//\n\n" \
+    "extern const UCHAR KeSpriteData[] PROGMEM;\n\n"
+
+#define SOKOBAN_DATA_VARIABLE \
+    "const UCHAR SokobanData[] PROGMEM = {"
+
+#define SOKOBAN_OFFSET_VARIABLE \
+    "const USHORT SokobanLevelOffset[SOKOBAN_LEVELS + 1] PROGMEM = {"
+
+#define SOKOBAN_PAR_VARIABLE \
+    "const USHORT SokobanParPushes[SOKOBAN_LEVELS] PROGMEM = {"
+
+#define SOKOBAN_PAR_DEFINITION \
+    "#define SOKOBAN_HAS_PARS\n\n"
+
+#define SOKOBAN_ORIGIN_VARIABLE \
+    "const USHORT SokobanStartingPosition[SOKOBAN_LEVELS] PROGMEM = {"
+
+#define SPRITE_DATA_VARIABLE \
+    "const UCHAR KeSpriteData[] PROGMEM = {"
+
+#define ASSET_DATA_BEGIN "\n    "
+#define ASSET_VARIABLE_END "};\n\n"
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef unsigned char BOOL;
+
+/*++
+
+Structure Description:
+
+    This structure stores the sizes of a single asset for the flash budget
+    report.
+
+Members:
+
+    Name - Stores the name of the asset.
+
+    RawSize - Stores the size of the asset at one byte per pixel or cell.
+
+    EncodedSize - Stores the size of the asset once encoded.
+
+    StoredSize - Stores the number of bytes of flash the asset actually added,
+        which is less than the encoded size if some of it was shared with
+        another asset.
+
+--*/
+
+typedef struct _ASSET_REPORT {
+    CHAR Name[MAX_TOKEN_LENGTH];
+    ULONG RawSize;
+    ULONG EncodedSize;
+    ULONG StoredSize;
+} ASSET_REPORT, *PASSET_REPORT;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+BOOL
+ReadAssetFile (
+    PCHAR Filename,
+    PUCHAR *Buffer,
+    PULONG FileSize
+    );
+
+LONG
+GetFileSize (
+    FILE *File
+    );
+
+BOOL
+GetNextLine (
+    PCHAR *Input,
+    PCHAR InputEnd,
+    PCHAR Line
+    );
+
+BOOL
+CompileAssetList (
+    PCHAR Input,
+    ULONG InputSize,
+    ULONG ThreadCount,
+    BOOL SortLevels,
+    FILE *OutputFile,
+    FILE *ManifestFile
+    );
+
+BOOL
+CompileFont (
+    PCHAR Symbol,
+    PCHAR Size,
+    PCHAR Encoding,
+    PCHAR Filename,
+    FILE *OutputFile
+    );
+
+BOOL
+CompileSprite (
+    PCHAR Symbol,
+    PCHAR Encoding,
+    PCHAR Filename,
+    FILE *ManifestFile
+    );
+
+BOOL
+CompileSokobanLevels (
+    PCHAR Filename,
+    PCHAR ParFilename,
+    ULONG ThreadCount,
+    BOOL SortLevels,
+    FILE *OutputFile,
+    FILE *ManifestFile
+    );
+
+BOOL
+CheckSokobanLevel (
+    ULONG Level,
+    ULONG PlayerCount
+    );
+
+BOOL
+ReadSokobanPars (
+    PCHAR ParFilename
+    );
+
+BOOL
+WriteSokobanPars (
+    PCHAR Filename,
+    PCHAR ParFilename
+    );
+
+ULONG
+ChecksumSokobanLevel (
+    ULONG Level
+    );
+
+VOID
+SortSokobanLevels (
+    VOID
+    );
+
+BOOL
+CompressSokobanLevel (
+    ULONG Level,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PUCHAR Output,
+    PULONG Size
+    );
+
+VOID
+AppendBits (
+    PUCHAR Output,
+    PULONG BitCount,
+    ULONG Value,
+    ULONG Length
+    );
+
+ULONG
+StoreSpriteData (
+    PUCHAR Data,
+    ULONG Size,
+    PULONG BytesAdded
+    );
+
+BOOL
+AddAssetReport (
+    PCHAR Name,
+    ULONG RawSize,
+    ULONG EncodedSize,
+    ULONG StoredSize
+    );
+
+ULONG
+PrintAssetReport (
+    VOID
+    );
+
+BOOL
+WriteArray (
+    FILE *OutputFile,
+    PCHAR Header,
+    PVOID Array,
+    ULONG ElementSize,
+    ULONG ElementCount
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Define a global containing the uncompressed level maps, one cell per byte.
+//
+
+UCHAR GeneratedSokobanLevels[SOKOBAN_LEVELS][SOKOBAN_LEVEL_CELLS];
+
+//
+// Define a global containing the compressed level maps. No level can compress
+// to more than one byte per cell.
+//
+
+UCHAR GeneratedSokobanData[SOKOBAN_LEVELS * SOKOBAN_LEVEL_CELLS];
+
+//
+// Define a global containing the offset of each level in the compressed data.
+//
+
+USHORT GeneratedSokobanLevelOffset[SOKOBAN_LEVELS + 1];
+
+//
+// Define a global containing the initial user starting position.
+//
+
+USHORT GeneratedSokobanStartingPosition[SOKOBAN_LEVELS];
+
+//
+// Define a global containing the optimal number of pushes for each level.
+//
+
+USHORT GeneratedSokobanParPushes[SOKOBAN_LEVELS];
+
+//
+// Define a global containing every sprite's encoded data, back to back.
+//
+
+UCHAR GeneratedSpriteData[MAX_SPRITE_DATA];
+ULONG GeneratedSpriteDataSize;
+
+//
+// Define a global containing the sizes of each asset compiled so far.
+//
+
+ASSET_REPORT AssetReport[MAX_ASSETS];
+ULONG AssetReportCount;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INT
+main (
+    INT argc,
+    CHAR **argv
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the program. It collects the
+    options passed to it, and creates the output files.
+
+Arguments:
+
+    argc - Supplies the number of command line arguments the program was invoked
+           with.
+
+    argv - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
+{
+
+    PCHAR Argument;
+    ULONG Budget;
+    PUCHAR InputFile;
+    ULONG InputFileSize;
+    PCHAR InputImage;
+    FILE *ManifestFile;
+    PCHAR ManifestImage;
+    FILE *OutputFile;
+    PCHAR OutputImage;
+    BOOL Result;
+    BOOL SolveLevels;
+    BOOL SortLevels;
+    ULONG ThreadCount;
+    ULONG TotalSize;
+
+    //
+    // Process the command line options
+    //
+
+    Budget = 0;
+    InputFile = NULL;
+    InputImage = NULL;
+    ManifestFile = NULL;
+    ManifestImage = NULL;
+    OutputFile = NULL;
+    OutputImage = NULL;
+    SolveLevels = FALSE;
+    SortLevels = FALSE;
+    ThreadCount = DEFAULT_SOLVER_THREADS;
+    while ((argc > 1) && (argv[1][0] == '-')) {
+        Argument = &(argv[1][1]);
+        if (strcmp(Argument, "o") == 0) {
+            argc -= 1;
+            argv += 1;
+            OutputImage = argv[1];
+
+        } else if (strcmp(Argument, "m") == 0) {
+            argc -= 1;
+            argv += 1;
+            ManifestImage = argv[1];
+
+        } else if ((strcmp(Argument, "j") == 0) ||
+                   (strcmp(Argument, "b") == 0)) {
+
+            argc -= 1;
+            argv += 1;
+            if (argv[1] == NULL) {
+                fprintf(stderr, USAGE_STRING);
+                return 1;
+            }
+
+            if (*Argument == 'j') {
+                ThreadCount = strtoul(argv[1], NULL, 10);
+
+            } else {
+                Budget = strtoul(argv[1], NULL, 10);
+            }
+
+        } else if (strcmp(Argument, "p") == 0) {
+            SolveLevels = TRUE;
+
+        } else if (strcmp(Argument, "s") == 0) {
+            SortLevels = TRUE;
+
+        } else {
+            fprintf(stderr, "%s: Invalid option\n\n%s", Argument, USAGE_STRING);
+            return 1;
+        }
+
+        argc -= 1;
+        argv += 1;
+    }
+
+    InputImage = argv[1];
+    if ((argc < 2) || (InputImage == NULL) || (OutputImage == NULL) ||
+        (ManifestImage == NULL)) {
+
+        fprintf(stderr, USAGE_STRING);
+        return 1;
+    }
+
+    if ((SolveLevels != FALSE) && (ThreadCount == 0)) {
+        fprintf(stderr, USAGE_STRING);
+        return 1;
+    }
+
+    //
+    // A thread count of zero tells the level compiler to read the pars from
+    // the par file rather than solving for them.
+    //
+
+    if (SolveLevels == FALSE) {
+        ThreadCount = 0;
+    }
+
+    //
+    // Start by opening the output files.
+    //
+
+    OutputFile = fopen(OutputImage, "wb+");
+    if (OutputFile == NULL) {
+        fprintf(stderr, "Unable to open output file \"%s\" for write.\n",
+                OutputImage);
+
+        Result = FALSE;
+        goto MainEnd;
+    }
+
+    ManifestFile = fopen(ManifestImage, "wb+");
+    if (ManifestFile == NULL) {
+        fprintf(stderr, "Unable to open manifest file \"%s\" for write.\n",
+                ManifestImage);
+
+        Result = FALSE;
+        goto MainEnd;
+    }
+
+    Result = ReadAssetFile(InputImage, &InputFile, &InputFileSize);
+    if (Result == FALSE) {
+        fprintf(stderr, "Error: Unable to read asset list.\n");
+        goto MainEnd;
+    }
+
+    Result = CompileAssetList((PCHAR)InputFile,
+                              InputFileSize,
+                              ThreadCount,
+                              SortLevels,
+                              OutputFile,
+                              ManifestFile);
+
+    if (Result == FALSE) {
+        fprintf(stderr, "Error creating data.\n");
+        goto MainEnd;
+    }
+
+    //
+    // Report where the flash went, and fail the build if the assets have
+    // outgrown their budget.
+    //
+
+    TotalSize = PrintAssetReport();
+    if ((Budget != 0) && (TotalSize > Budget)) {
+        fprintf(stderr,
+                "Error: Assets take %d bytes, over the budget of %d.\n",
+                (INT)TotalSize,
+                (INT)Budget);
+
+        Result = FALSE;
+        goto MainEnd;
+    }
+
+    Result = TRUE;
+
+MainEnd:
+    if (InputFile != NULL) {
+        free(InputFile);
+    }
+
+    if (OutputFile != NULL) {
+        fclose(OutputFile);
+    }
+
+    if (ManifestFile != NULL) {
+        fclose(ManifestFile);
+    }
+
+    if (Result == FALSE) {
+        if (OutputImage != NULL) {
+            remove(OutputImage);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+BOOL
+CompileAssetList (
+    PCHAR Input,
+    ULONG InputSize,
+    ULONG ThreadCount,
+    BOOL SortLevels,
+    FILE *OutputFile,
+    FILE *ManifestFile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compiles every asset named in the asset list.
+
+Arguments:
+
+    Input - Supplies a pointer to the contents of the asset list.
+
+    InputSize - Supplies the size of the asset list in bytes.
+
+    ThreadCount - Supplies the number of threads to solve the levels with, or
+        zero to read their pars from the par file instead.
+
+    SortLevels - Supplies a boolean indicating whether or not to order the
+        levels by their par number of pushes.
+
+    OutputFile - Supplies an open file handle where the asset data is to be
+        printed.
+
+    ManifestFile - Supplies an open file handle where the manifest header is
+        to be printed.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    PCHAR InputEnd;
+    CHAR Kind[MAX_TOKEN_LENGTH];
+    CHAR Line[MAX_LINE_LENGTH];
+    ULONG LineNumber;
+    BOOL Result;
+    INT TokenCount;
+    CHAR Tokens[4][MAX_TOKEN_LENGTH];
+
+    if ((fputs(OUTPUT_BOILERPLATE, OutputFile) < 0) ||
+        (fputs(MANIFEST_BOILERPLATE, ManifestFile) < 0)) {
+
+        fprintf(stderr, "Error: Unable to print boilerplate.\n");
+        Result = FALSE;
+        goto CompileAssetListEnd;
+    }
+
+    InputEnd = Input + InputSize;
+    LineNumber = 0;
+    while (GetNextLine(&Input, InputEnd, Line) != FALSE) {
+        LineNumber += 1;
+        if (Line[0] == ';') {
+            continue;
+        }
+
+        //
+        // The field widths here must stay one less than MAX_TOKEN_LENGTH.
+        //
+
+        TokenCount = sscanf(Line,
+                            "%63s %63s %63s %63s %63s",
+                            Kind,
+                            Tokens[0],
+                            Tokens[1],
+                            Tokens[2],
+                            Tokens[3]);
+
+        if (TokenCount <= 0) {
+            continue;
+        }
+
+        if ((strcmp(Kind, "font") == 0) && (TokenCount == 5)) {
+            Result = CompileFont(Tokens[0],
+                                 Tokens[1],
+                                 Tokens[2],
+                                 Tokens[3],
+                                 OutputFile);
+
+        } else if ((strcmp(Kind, "levels") == 0) && (TokenCount == 3)) {
+            Result = CompileSokobanLevels(Tokens[0],
+                                          Tokens[1],
+                                          ThreadCount,
+                                          SortLevels,
+                                          OutputFile,
+                                          ManifestFile);
+
+        } else if ((strcmp(Kind, "sprite") == 0) && (TokenCount == 4)) {
+            Result = CompileSprite(Tokens[0],
+                                   Tokens[1],
+                                   Tokens[2],
+                                   ManifestFile);
+
+        } else {
+            fprintf(stderr,
+                    "Error: Line %d of the asset list isn't understood.\n",
+                    (INT)LineNumber);
+
+            Result = FALSE;
+        }
+
+        if (Result == FALSE) {
+            goto CompileAssetListEnd;
+        }
+    }
+
+    //
+    // All the sprites go out together, since they may share data.
+    //
+
+    if (GeneratedSpriteDataSize != 0) {
+        Result = WriteArray(OutputFile,
+                            SPRITE_DATA_VARIABLE,
+                            GeneratedSpriteData,
+                            sizeof(UCHAR),
+                            GeneratedSpriteDataSize);
+
+        if (Result == FALSE) {
+            fprintf(stderr, "Error: Unable to write sprite data.\n");
+            goto CompileAssetListEnd;
+        }
+    }
+
+    if (fputs(MANIFEST_GLOBALS, ManifestFile) < 0) {
+        fprintf(stderr, "Error: Unable to write manifest.\n");
+        Result = FALSE;
+        goto CompileAssetListEnd;
+    }
+
+    Result = TRUE;
+
+CompileAssetListEnd:
+    return Result;
+}
+
+BOOL
+CompileFont (
+    PCHAR Symbol,
+    PCHAR Size,
+    PCHAR Encoding,
+    PCHAR Filename,
+    FILE *OutputFile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compiles a font into an array with a fixed number of bytes
+    per glyph, so that the firmware can index straight to any character. The
+    source file holds each glyph as rows of # and . characters, and a comment
+    line before a glyph names it.
+
+Arguments:
+
+    Symbol - Supplies the name of the array to create.
+
+    Size - Supplies the size of each glyph, in the form <Width>x<Height>.
+
+    Encoding - Supplies how each glyph is encoded. "packed" glyphs are a
+        continuous stream of bits, column by column and row by row, starting at
+        the high bit of the first byte. "columns" glyphs take one byte per
+        column, with the top row in the low bit.
+
+    Filename - Supplies the name of the font source file.
+
+    OutputFile - Supplies an open file handle where the font is to be printed.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    ULONG Bit;
+    ULONG ByteCount;
+    UCHAR Bytes[8];
+    ULONG Column;
+    PCHAR FontEnd;
+    PUCHAR FontFile;
+    ULONG FontFileSize;
+    ULONG GlyphCount;
+    INT Height;
+    PCHAR Input;
+    CHAR Label[MAX_LINE_LENGTH];
+    CHAR Line[MAX_LINE_LENGTH];
+    ULONG LineNumber;
+    BOOL Packed;
+    BOOL Result;
+    ULONG Row;
+    INT Width;
+
+    FontFile = NULL;
+    if ((sscanf(Size, "%dx%d", &Width, &Height) != 2) ||
+        (Width <= 0) || (Height <= 0)) {
+
+        fprintf(stderr, "Error: Invalid font size \"%s\".\n", Size);
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    if (strcmp(Encoding, "packed") == 0) {
+        Packed = TRUE;
+        ByteCount = ((Width * Height) + 7) / 8;
+
+    } else if ((strcmp(Encoding, "columns") == 0) && (Height <= 8)) {
+        Packed = FALSE;
+        ByteCount = Width;
+
+    } else {
+        fprintf(stderr,
+                "Error: Font %s can't be encoded as \"%s\".\n",
+                Symbol,
+                Encoding);
+
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    if (ByteCount > sizeof(Bytes)) {
+        fprintf(stderr, "Error: Font %s glyphs are too big.\n", Symbol);
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    Result = ReadAssetFile(Filename, &FontFile, &FontFileSize);
+    if (Result == FALSE) {
+        goto CompileFontEnd;
+    }
+
+    if (fprintf(OutputFile,
+                "UCHAR %s[][%d] PROGMEM = {\n",
+                Symbol,
+                (INT)ByteCount) < 0) {
+
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    Input = (PCHAR)FontFile;
+    FontEnd = Input + FontFileSize;
+    GlyphCount = 0;
+    Label[0] = '\0';
+    LineNumber = 0;
+    memset(Bytes, 0, sizeof(Bytes));
+    Row = 0;
+    while (GetNextLine(&Input, FontEnd, Line) != FALSE) {
+        LineNumber += 1;
+        if (Line[0] == ';') {
+            Bit = 1;
+            while (Line[Bit] == ' ') {
+                Bit += 1;
+            }
+
+            strcpy(Label, &(Line[Bit]));
+            continue;
+        }
+
+        if (Line[0] == '\0') {
+            continue;
+        }
+
+        if (strlen(Line) != Width) {
+            fprintf(stderr,
+                    "Error: %s line %d should be %d pixels wide.\n",
+                    Filename,
+                    (INT)LineNumber,
+                    Width);
+
+            Result = FALSE;
+            goto CompileFontEnd;
+        }
+
+        for (Column = 0; Column < Width; Column += 1) {
+            if (Line[Column] == '#') {
+                if (Packed != FALSE) {
+                    Bit = (Column * Height) + Row;
+                    Bytes[Bit / 8] |= 0x80 >> (Bit % 8);
+
+                } else {
+                    Bytes[Column] |= 1 << Row;
+                }
+
+            } else if (Line[Column] != '.') {
+                fprintf(stderr,
+                        "Error: %s line %d has an invalid pixel.\n",
+                        Filename,
+                        (INT)LineNumber);
+
+                Result = FALSE;
+                goto CompileFontEnd;
+            }
+        }
+
+        Row += 1;
+        if (Row != Height) {
+            continue;
+        }
+
+        //
+        // The glyph is complete, so write it out.
+        //
+
+        fprintf(OutputFile, "    {");
+        for (Column = 0; Column < ByteCount; Column += 1) {
+            if (Column != 0) {
+                fprintf(OutputFile, ", ");
+            }
+
+            fprintf(OutputFile, "0x%02x", Bytes[Column]);
+        }
+
+        if (Label[0] != '\0') {
+            Result = fprintf(OutputFile, "}, // %s\n", Label);
+
+        } else {
+            Result = fprintf(OutputFile, "},\n");
+        }
+
+        if (Result < 0) {
+            Result = FALSE;
+            goto CompileFontEnd;
+        }
+
+        GlyphCount += 1;
+        Label[0] = '\0';
+        memset(Bytes, 0, sizeof(Bytes));
+        Row = 0;
+    }
+
+    if ((Row != 0) || (GlyphCount == 0)) {
+        fprintf(stderr, "Error: %s ends partway through a glyph.\n", Filename);
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    if (fputs(ASSET_VARIABLE_END, OutputFile) < 0) {
+        Result = FALSE;
+        goto CompileFontEnd;
+    }
+
+    Result = AddAssetReport(Symbol,
+                            GlyphCount * Width * Height,
+                            GlyphCount * ByteCount,
+                            GlyphCount * ByteCount);
+
+CompileFontEnd:
+    if (FontFile != NULL) {
+        free(FontFile);
+    }
+
+    return Result;
+}
+
+BOOL
+CompileSprite (
+    PCHAR Symbol,
+    PCHAR Encoding,
+    PCHAR Filename,
+    FILE *ManifestFile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compiles a sprite into the shared sprite data and describes
+    it in the manifest. The source file holds the sprite as rows of pixels.
+    Masked sprites use # for painted pixels and . for clear ones, and palette
+    sprites use . or 0 through 3 for the palette index of each pixel.
+
+Arguments:
+
+    Symbol - Supplies the name of the sprite. The manifest defines this name
+        as a pointer to the sprite data, and defines its width and height with
+        _WIDTH and _HEIGHT appended.
+
+    Encoding - Supplies either "masked" for a sprite drawn with
+        GrBlitMaskedSprite or "palette" for a sprite drawn with
+        GrBlitPaletteSprite.
+
+    Filename - Supplies the name of the sprite source file.
+
+    ManifestFile - Supplies an open file handle where the manifest is being
+        printed.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    ULONG BytesAdded;
+    ULONG Column;
+    PUCHAR Encoded;
+    ULONG EncodedSize;
+    ULONG Height;
+    PCHAR Input;
+    CHAR Line[MAX_LINE_LENGTH];
+    BOOL Masked;
+    ULONG Offset;
+    ULONG Pixel;
+    ULONG PixelCount;
+    BOOL Result;
+    PCHAR SpriteEnd;
+    PUCHAR SpriteFile;
+    ULONG SpriteFileSize;
+    UCHAR Value;
+    ULONG Width;
+
+    Encoded = NULL;
+    SpriteFile = NULL;
+    if (strcmp(Encoding, "masked") == 0) {
+        Masked = TRUE;
+
+    } else if (strcmp(Encoding, "palette") == 0) {
+        Masked = FALSE;
+
+    } else {
+        fprintf(stderr, "Error: Unknown sprite encoding \"%s\".\n", Encoding);
+        Result = FALSE;
+        goto CompileSpriteEnd;
+    }
+
+    Result = ReadAssetFile(Filename, &SpriteFile, &SpriteFileSize);
+    if (Result == FALSE) {
+        goto CompileSpriteEnd;
+    }
+
+    Encoded = calloc(MAX_SPRITE_DATA, 1);
+    if (Encoded == NULL) {
+        Result = FALSE;
+        goto CompileSpriteEnd;
+    }
+
+    Input = (PCHAR)SpriteFile;
+    SpriteEnd = Input + SpriteFileSize;
+    Height = 0;
+    PixelCount = 0;
+    Width = 0;
+    while (GetNextLine(&Input, SpriteEnd, Line) != FALSE) {
+        if ((Line[0] == ';') || (Line[0] == '\0')) {
+            continue;
+        }
+
+        if (Width == 0) {
+            Width = strlen(Line);
+        }
+
+        if ((strlen(Line) != Width) || (Width > MAX_SPRITE_DIMENSION) ||
+            (Height == MAX_SPRITE_DIMENSION)) {
+
+            fprintf(stderr,
+                    "Error: Sprite %s isn't a valid rectangle.\n",
+                    Symbol);
+
+            Result = FALSE;
+            goto CompileSpriteEnd;
+        }
+
+        for (Column = 0; Column < Width; Column += 1) {
+            Pixel = PixelCount + Column;
+            if (Masked != FALSE) {
+                if (Line[Column] == '#') {
+                    Encoded[Pixel / 8] |= 1 << (Pixel % 8);
+
+                } else if (Line[Column] != '.') {
+                    Result = FALSE;
+                }
+
+            } else {
+                Value = 0;
+                if ((Line[Column] >= '0') && (Line[Column] <= '3')) {
+                    Value = Line[Column] - '0';
+
+                } else if (Line[Column] != '.') {
+                    Result = FALSE;
+                }
+
+                Encoded[Pixel / 4] |= Value << ((Pixel % 4) * 2);
+            }
+        }
+
+        if (Result == FALSE) {
+            fprintf(stderr,
+                    "Error: Sprite %s has an invalid pixel in row %d.\n",
+                    Symbol,
+                    (INT)Height);
+
+            goto CompileSpriteEnd;
+        }
+
+        PixelCount += Width;
+        Height += 1;
+    }
+
+    if (PixelCount == 0) {
+        fprintf(stderr, "Error: Sprite %s has no pixels.\n", Symbol);
+        Result = FALSE;
+        goto CompileSpriteEnd;
+    }
+
+    if (Masked != FALSE) {
+        EncodedSize = (PixelCount + 7) / 8;
+
+    } else {
+        EncodedSize = (PixelCount + 3) / 4;
+    }
+
+    if (GeneratedSpriteDataSize + EncodedSize > MAX_SPRITE_DATA) {
+        fprintf(stderr, "Error: Out of room for sprite %s.\n", Symbol);
+        Result = FALSE;
+        goto CompileSpriteEnd;
+    }
+
+    Offset = StoreSpriteData(Encoded, EncodedSize, &BytesAdded);
+    if (fprintf(ManifestFile,
+                "#define %s_WIDTH %d\n"
+                "#define %s_HEIGHT %d\n"
+                "#define %s (&(KeSpriteData[%d]))\n\n",
+                Symbol,
+                (INT)Width,
+                Symbol,
+                (INT)Height,
+                Symbol,
+                (INT)Offset) < 0) {
+
+        Result = FALSE;
+        goto CompileSpriteEnd;
+    }
+
+    Result = AddAssetReport(Symbol, PixelCount, EncodedSize, BytesAdded);
+
+CompileSpriteEnd:
+    if (Encoded != NULL) {
+        free(Encoded);
+    }
+
+    if (SpriteFile != NULL) {
+        free(SpriteFile);
+    }
+
+    return Result;
+}
+
+BOOL
+CompileSokobanLevels (
+    PCHAR Filename,
+    PCHAR ParFilename,
+    ULONG ThreadCount,
+    BOOL SortLevels,
+    FILE *OutputFile,
+    FILE *ManifestFile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the sokoban data given a level map. The pars only go
+    into the data, and the manifest only defines SOKOBAN_HAS_PARS, once every
+    level has one.
+
+Arguments:
+
+    Filename - Supplies the name of the file containing the level maps.
+
+    ParFilename - Supplies the name of the file holding the par for each
+        level. This is read, or written out if the levels are being solved.
+
+    ThreadCount - Supplies the number of threads to solve the levels with, or
+        zero to read their pars from the par file instead.
+
+    SortLevels - Supplies a boolean indicating whether or not to order the
+        levels by their par number of pushes. This fails unless every level
+        has a par.
+
+    OutputFile - Supplies an open file handle where the result is to be printed.
+
+    ManifestFile - Supplies an open file handle where the manifest is being
+        written.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    ULONG BytesRead;
+    UCHAR Character;
+    ULONG CompressedSize;
+    ULONG CurrentCell;
+    ULONG CurrentLevel;
+    BOOL EmptyLine;
+    BOOL HavePars;
+    PCHAR Input;
+    PUCHAR InputFile;
+    ULONG InputSize;
+    ULONG LevelSize;
+    ULONG LineNumber;
+    ULONG PlayerCount[SOKOBAN_LEVELS];
+    BOOL Result;
+    ULONG TableSize;
+    UCHAR ThisCell;
+
+    Result = ReadAssetFile(Filename, &InputFile, &InputSize);
+    if (Result == FALSE) {
+        goto CompileSokobanLevelsEnd;
+    }
+
+    //
+    // Consume the input file and create the data.
+    //
+
+    memset(PlayerCount, 0, sizeof(PlayerCount));
+    BytesRead = 0;
+    EmptyLine = TRUE;
+    CurrentCell = 0;
+    CurrentLevel = 0;
+    LineNumber = 1;
+    Input = (PCHAR)InputFile;
+    while (BytesRead < InputSize) {
+        Character = *Input;
+        BytesRead += 1;
+        Input += 1;
+
+        //
+        // Ignore comments.
+        //
+
+        if (Character == ';') {
+            while (Character != '\n') {
+                Character = *Input;
+                BytesRead += 1;
+                Input += 1;
+            }
+
+            LineNumber += 1;
+            EmptyLine = TRUE;
+            continue;
+        }
+
+        //
+        // Ignore \r characters.
+        //
+
+        if (Character == '\r') {
+            continue;
+        }
+
+        //
+        // Anything else that isn't part of a level means the file is broken,
+        // so don't guess at what it was supposed to be.
+        //
+
+        if ((Character == '\0') || (strchr(" #.$@*+\n", Character) == NULL)) {
+            fprintf(stderr,
+                    "Error: Line %d of %s has an unknown character 0x%02X.\n",
+                    (INT)LineNumber,
+                    Filename,
+                    Character);
+
+            Result = FALSE;
+            goto CompileSokobanLevelsEnd;
+        }
+
+        //
+        // Handle an object such as a free space, wall, bean, or goal. A '*' is
+        // a bean already on a goal, and a '+' is the player standing on one.
+        //
+
+        if ((Character == ' ') ||
+            (Character == '#') ||
+            (Character == '.') ||
+            (Character == '$') ||
+            (Character == '@') ||
+            (Character == '*') ||
+            (Character == '+')) {
+
+            EmptyLine = FALSE;
+            ThisCell = 0;
+            if ((Character == ' ') || (Character == '@')) {
+                ThisCell = SOKOBAN_CELL_FREE;
+            }
+
+            if (Character == '#') {
+                ThisCell = SOKOBAN_CELL_WALL;
+            }
+
+            if (Character == '$') {
+                ThisCell = SOKOBAN_CELL_BEAN;
+            }
+
+            if ((Character == '.') || (Character == '+')) {
+                ThisCell = SOKOBAN_CELL_GOAL;
+            }
+
+            if (Character == '*') {
+                ThisCell = SOKOBAN_CELL_BEAN_ON_GOAL;
+            }
+
+            if (CurrentCell >= (SOKOBAN_HEIGHT * SOKOBAN_WIDTH)) {
+                fprintf(stderr,
+                        "Error: Level %d is too large, doesn't fit in %dx%d!\n",
+                        (INT)CurrentLevel,
+                        SOKOBAN_WIDTH,
+                        SOKOBAN_HEIGHT);
+
+                Result = FALSE;
+                goto CompileSokobanLevelsEnd;
+            }
+
+            if (CurrentLevel >= SOKOBAN_LEVELS) {
+                fprintf(stderr,
+                        "Warning: Ignoring levels after %d.\n",
+                        SOKOBAN_LEVELS);
+
+                break;
+            }
+
+            GeneratedSokobanLevels[CurrentLevel][CurrentCell] = ThisCell;
+
+            //
+            // Handle an origin.
+            //
+
+            if ((Character == '@') || (Character == '+')) {
+                PlayerCount[CurrentLevel] += 1;
+                GeneratedSokobanStartingPosition[CurrentLevel] =
+                       (CurrentCell / SOKOBAN_WIDTH) << SOKOBAN_ORIGIN_Y_SHIFT;
+
+                GeneratedSokobanStartingPosition[CurrentLevel] |=
+                                                   CurrentCell % SOKOBAN_WIDTH;
+            }
+
+            CurrentCell += 1;
+        }
+
+        //
+        // Handle a newline. A newline completely by itself signals a new level.
+        // Otherwise, it signals that the rest of the cells on this line are
+        // filled with blanks.
+        //
+
+        if (Character == '\n') {
+            LineNumber += 1;
+
+            //
+            // Ignore the newline if no cells have been defined for this level.
+            //
+
+            if (CurrentCell == 0) {
+                EmptyLine = TRUE;
+                continue;
+            }
+
+            //
+            // Round up the current cell to a multiple of the game width.
+            //
+
+            while ((CurrentCell % SOKOBAN_WIDTH) != 0) {
+                CurrentCell += 1;
+            }
+
+            //
+            // If this was an empty line, start a new level.
+            //
+
+            if (EmptyLine != FALSE) {
+                CurrentLevel += 1;
+                CurrentCell = 0;
+            }
+
+            EmptyLine = TRUE;
+        }
+    }
+
+    for (CurrentLevel = 0; CurrentLevel < SOKOBAN_LEVELS; CurrentLevel += 1) {
+        Result = CheckSokobanLevel(CurrentLevel, PlayerCount[CurrentLevel]);
+        if (Result == FALSE) {
+            goto CompileSokobanLevelsEnd;
+        }
+    }
+
+    //
+    // Find the par for each level, and put them in order if requested.
+    // Solving can take hours, so normally the pars saved in the par file the
+    // last time the levels were solved are used.
+    //
+
+    if (ThreadCount != 0) {
+        Result = SolveSokobanLevels(GeneratedSokobanLevels[0],
+                                    GeneratedSokobanStartingPosition,
+                                    SOKOBAN_LEVELS,
+                                    ThreadCount,
+                                    GeneratedSokobanParPushes);
+
+        if (Result == FALSE) {
+            fprintf(stderr, "Error: Unable to solve levels.\n");
+            goto CompileSokobanLevelsEnd;
+        }
+
+        Result = WriteSokobanPars(Filename, ParFilename);
+
+    } else {
+        Result = ReadSokobanPars(ParFilename);
+    }
+
+    if (Result == FALSE) {
+        goto CompileSokobanLevelsEnd;
+    }
+
+    //
+    // A par of zero means the solver gave up on that level. Leave the pars out
+    // entirely unless every level has one, rather than showing a par on some
+    // levels and ordering the rest arbitrarily.
+    //
+
+    HavePars = TRUE;
+    for (CurrentLevel = 0; CurrentLevel < SOKOBAN_LEVELS; CurrentLevel += 1) {
+        if (GeneratedSokobanParPushes[CurrentLevel] == 0) {
+            HavePars = FALSE;
+            break;
+        }
+    }
+
+    if (SortLevels != FALSE) {
+        if (HavePars == FALSE) {
+            fprintf(stderr,
+                    "Error: Level %d has no par, so the levels can't be "
+                    "ordered by par.\n",
+                    (INT)CurrentLevel + 1);
+
+            Result = FALSE;
+            goto CompileSokobanLevelsEnd;
+        }
+
+        SortSokobanLevels();
+    }
+
+    //
+    // Compress each level, recording where it starts.
+    //
+
+    CompressedSize = 0;
+    for (CurrentLevel = 0; CurrentLevel < SOKOBAN_LEVELS; CurrentLevel += 1) {
+        GeneratedSokobanLevelOffset[CurrentLevel] = CompressedSize;
+        Result = CompressSokobanLevel(
+                              CurrentLevel,
+                              GeneratedSokobanLevels[CurrentLevel],
+                              GeneratedSokobanStartingPosition[CurrentLevel],
+                              &(GeneratedSokobanData[CompressedSize]),
+                              &LevelSize);
+
+        if (Result == FALSE) {
+            goto CompileSokobanLevelsEnd;
+        }
+
+        CompressedSize += LevelSize;
+    }
+
+    GeneratedSokobanLevelOffset[SOKOBAN_LEVELS] = CompressedSize;
+
+    TableSize = ((SOKOBAN_LEVELS * 2) + 1) * sizeof(USHORT);
+    if (HavePars != FALSE) {
+        TableSize += SOKOBAN_LEVELS * sizeof(USHORT);
+    }
+
+    Result = AddAssetReport("Sokoban levels",
+                            SOKOBAN_LEVELS * SOKOBAN_LEVEL_CELLS,
+                            CompressedSize + TableSize,
+                            CompressedSize + TableSize);
+
+    if (Result == FALSE) {
+        goto CompileSokobanLevelsEnd;
+    }
+
+    //
+    // Output the level data, the offsets, the origins, and the pars.
+    //
+
+    Result = WriteArray(OutputFile,
+                               SOKOBAN_DATA_VARIABLE,
+                               GeneratedSokobanData,
+                               sizeof(UCHAR),
+                               CompressedSize);
+
+    if (Result == FALSE) {
+        fprintf(stderr, "Error: Unable to write level data.\n");
+        goto CompileSokobanLevelsEnd;
+    }
+
+    Result = WriteArray(OutputFile,
+                               SOKOBAN_OFFSET_VARIABLE,
+                               GeneratedSokobanLevelOffset,
+                               sizeof(USHORT),
+                               SOKOBAN_LEVELS + 1);
+
+    if (Result == FALSE) {
+        fprintf(stderr, "Error: Unable to write level offsets.\n");
+        goto CompileSokobanLevelsEnd;
+    }
+
+    Result = WriteArray(OutputFile,
+                               SOKOBAN_ORIGIN_VARIABLE,
+                               GeneratedSokobanStartingPosition,
+                               sizeof(USHORT),
+                               SOKOBAN_LEVELS);
+
+    if (Result == FALSE) {
+        fprintf(stderr, "Error: Unable to write origin data.\n");
+        goto CompileSokobanLevelsEnd;
+    }
+
+    if (HavePars != FALSE) {
+        Result = WriteArray(OutputFile,
+                            SOKOBAN_PAR_VARIABLE,
+                            GeneratedSokobanParPushes,
+                            sizeof(USHORT),
+                            SOKOBAN_LEVELS);
+
+        if ((Result == FALSE) ||
+            (fputs(SOKOBAN_PAR_DEFINITION, ManifestFile) < 0)) {
+
+            fprintf(stderr, "Error: Unable to write par data.\n");
+            Result = FALSE;
+            goto CompileSokobanLevelsEnd;
+        }
+    }
+
+    Result = TRUE;
+
+CompileSokobanLevelsEnd:
+    if (InputFile != NULL) {
+        free(InputFile);
+    }
+
+    return Result;
+}
+
+BOOL
+CheckSokobanLevel (
+    ULONG Level,
+    ULONG PlayerCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine makes sure a level read from the level file is playable. A
+    level left empty because the file ran out of levels is fine.
+
+Arguments:
+
+    Level - Supplies the level to check.
+
+    PlayerCount - Supplies the number of players found in the level.
+
+Return Value:
+
+    TRUE if the level is playable or empty.
+
+    FALSE if the level is malformed.
+
+--*/
+
+{
+
+    ULONG BeanCount;
+    ULONG Cell;
+    PUCHAR Cells;
+    ULONG GoalCount;
+    ULONG WallCount;
+
+    BeanCount = 0;
+    GoalCount = 0;
+    WallCount = 0;
+    Cells = GeneratedSokobanLevels[Level];
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        switch (Cells[Cell]) {
+        case SOKOBAN_CELL_WALL:
+            WallCount += 1;
+            break;
+
+        case SOKOBAN_CELL_BEAN:
+            BeanCount += 1;
+            break;
+
+        case SOKOBAN_CELL_GOAL:
+            GoalCount += 1;
+            break;
+
+        case SOKOBAN_CELL_BEAN_ON_GOAL:
+            BeanCount += 1;
+            GoalCount += 1;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if ((PlayerCount == 0) && (WallCount == 0) && (BeanCount == 0) &&
+        (GoalCount == 0)) {
+
+        return TRUE;
+    }
+
+    if (PlayerCount != 1) {
+        fprintf(stderr,
+                "Error: Level %d has %d players instead of one.\n",
+                (INT)Level + 1,
+                (INT)PlayerCount);
+
+        return FALSE;
+    }
+
+    if ((BeanCount == 0) || (BeanCount != GoalCount)) {
+        fprintf(stderr,
+                "Error: Level %d has %d beans and %d goals.\n",
+                (INT)Level + 1,
+                (INT)BeanCount,
+                (INT)GoalCount);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+ReadSokobanPars (
+    PCHAR ParFilename
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the par for each level out of the par file written the
+    last time the levels were solved. Each par is checked against the level
+    it was found for, so that changing a level without solving it again fails
+    the build rather than showing a wrong par.
+
+Arguments:
+
+    ParFilename - Supplies the name of the par file.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    ULONG Checksum;
+    BOOL Found[SOKOBAN_LEVELS];
+    PCHAR Input;
+    PCHAR InputEnd;
+    PUCHAR InputFile;
+    ULONG InputSize;
+    ULONG Level;
+    CHAR Line[MAX_LINE_LENGTH];
+    ULONG LineNumber;
+    ULONG Par;
+    BOOL Result;
+
+    Result = ReadAssetFile(ParFilename, &InputFile, &InputSize);
+    if (Result == FALSE) {
+        fprintf(stderr,
+                "Error: Unable to read pars. Run makeasset -p to solve the "
+                "levels.\n");
+
+        return FALSE;
+    }
+
+    memset(Found, FALSE, sizeof(Found));
+    Input = (PCHAR)InputFile;
+    InputEnd = Input + InputSize;
+    LineNumber = 0;
+    while (GetNextLine(&Input, InputEnd, Line) != FALSE) {
+        LineNumber += 1;
+        if ((Line[0] == ';') || (Line[0] == '\0')) {
+            continue;
+        }
+
+        if ((sscanf(Line, "%lu %lu %lx", &Level, &Par, &Checksum) != 3) ||
+            (Level == 0) || (Level > SOKOBAN_LEVELS) || (Par > 0xFFFF)) {
+
+            fprintf(stderr,
+                    "Error: Line %d of %s isn't understood.\n",
+                    (INT)LineNumber,
+                    ParFilename);
+
+            Result = FALSE;
+            goto ReadSokobanParsEnd;
+        }
+
+        Level -= 1;
+        if (Checksum != ChecksumSokobanLevel(Level)) {
+            fprintf(stderr,
+                    "Error: Level %d has changed since it was solved. Run "
+                    "makeasset -p to solve the levels again.\n",
+                    (INT)Level + 1);
+
+            Result = FALSE;
+            goto ReadSokobanParsEnd;
+        }
+
+        GeneratedSokobanParPushes[Level] = Par;
+        Found[Level] = TRUE;
+    }
+
+    for (Level = 0; Level < SOKOBAN_LEVELS; Level += 1) {
+        if (Found[Level] == FALSE) {
+            fprintf(stderr,
+                    "Error: %s has no par for level %d. Run makeasset -p to "
+                    "solve the levels again.\n",
+                    ParFilename,
+                    (INT)Level + 1);
+
+            Result = FALSE;
+            goto ReadSokobanParsEnd;
+        }
+    }
+
+    Result = TRUE;
+
+ReadSokobanParsEnd:
+    free(InputFile);
+    return Result;
+}
+
+BOOL
+WriteSokobanPars (
+    PCHAR Filename,
+    PCHAR ParFilename
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes the par for each level out to the par file, along
+    with a checksum of the level it was found for.
+
+Arguments:
+
+    Filename - Supplies the name of the level file, for the file's comment.
+
+    ParFilename - Supplies the name of the par file to write.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    FILE *File;
+    ULONG Level;
+    BOOL Result;
+
+    File = fopen(ParFilename, "w");
+    if (File == NULL) {
+        fprintf(stderr,
+                "Error: Unable to open par file \"%s\" for write.\n",
+                ParFilename);
+
+        return FALSE;
+    }
+
+    Result = TRUE;
+    if (fprintf(File,
+                ";\n"
+                "; Par pushes for the levels in %s, written by makeasset -p.\n"
+                "; Solving can take hours, so the build reads the pars from "
+                "here instead. Each\n"
+                "; line is a level number, the fewest pushes that solve it "
+                "(0 if the solver\n"
+                "; gave up), and a checksum of the level the par was found "
+                "for.\n"
+                ";\n\n",
+                Filename) < 0) {
+
+        Result = FALSE;
+    }
+
+    for (Level = 0; Level < SOKOBAN_LEVELS; Level += 1) {
+        if (fprintf(File,
+                    "%d %d %08lX\n",
+                    (INT)Level + 1,
+                    (INT)GeneratedSokobanParPushes[Level],
+                    ChecksumSokobanLevel(Level)) < 0) {
+
+            Result = FALSE;
+        }
+    }
+
+    if (fclose(File) != 0) {
+        Result = FALSE;
+    }
+
+    if (Result == FALSE) {
+        fprintf(stderr, "Error: Unable to write pars.\n");
+    }
+
+    return Result;
+}
+
+ULONG
+ChecksumSokobanLevel (
+    ULONG Level
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes a 32-bit FNV-1a hash of a level's cells and starting
+    position.
+
+Arguments:
+
+    Level - Supplies the level to checksum.
+
+Return Value:
+
+    Returns the checksum.
+
+--*/
+
+{
+
+    ULONG Cell;
+    ULONG Checksum;
+    USHORT StartingPosition;
+
+    Checksum = 2166136261UL;
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        Checksum = ((Checksum ^ GeneratedSokobanLevels[Level][Cell]) *
+                    16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    StartingPosition = GeneratedSokobanStartingPosition[Level];
+    Checksum = ((Checksum ^ (StartingPosition & 0xFF)) * 16777619UL) &
+               0xFFFFFFFFUL;
+
+    Checksum = ((Checksum ^ (StartingPosition >> 8)) * 16777619UL) &
+               0xFFFFFFFFUL;
+
+    return Checksum;
+}
+
+VOID
+SortSokobanLevels (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine orders the generated levels from fewest to most pushes needed
+    to solve them. Levels with the same par keep their original order. Every
+    level must have a par.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Cells[SOKOBAN_LEVEL_CELLS];
+    ULONG Insert;
+    ULONG Level;
+    USHORT Par;
+    USHORT StartingPosition;
+
+    for (Level = 1; Level < SOKOBAN_LEVELS; Level += 1) {
+        Par = GeneratedSokobanParPushes[Level];
+        memcpy(Cells, GeneratedSokobanLevels[Level], SOKOBAN_LEVEL_CELLS);
+        StartingPosition = GeneratedSokobanStartingPosition[Level];
+        Insert = Level;
+        while ((Insert != 0) &&
+               (GeneratedSokobanParPushes[Insert - 1] > Par)) {
+
+            memcpy(GeneratedSokobanLevels[Insert],
+                   GeneratedSokobanLevels[Insert - 1],
+                   SOKOBAN_LEVEL_CELLS);
+
+            GeneratedSokobanStartingPosition[Insert] =
+                                   GeneratedSokobanStartingPosition[Insert - 1];
+
+            GeneratedSokobanParPushes[Insert] =
+                                          GeneratedSokobanParPushes[Insert - 1];
+
+            Insert -= 1;
+        }
+
+        memcpy(GeneratedSokobanLevels[Insert], Cells, SOKOBAN_LEVEL_CELLS);
+        GeneratedSokobanStartingPosition[Insert] = StartingPosition;
+        GeneratedSokobanParPushes[Insert] = Par;
+    }
+
+    return;
+}
+
+BOOL
+CompressSokobanLevel (
+    ULONG Level,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PUCHAR Output,
+    PULONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compresses a single level. See sokoban.h for a description of
+    the format.
+
+Arguments:
+
+    Level - Supplies the number of the level, for error messages.
+
+    Cells - Supplies a pointer to the level's cells, one per byte.
+
+    StartingPosition - Supplies the player's starting position, encoded the
+        same way as SokobanStartingPosition.
+
+    Output - Supplies a pointer where the compressed level will be written.
+        This buffer must be at least SOKOBAN_LEVEL_CELLS bytes.
+
+    Size - Supplies a pointer where the size of the compressed level in bytes
+        will be returned.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the level can't be coded, because its floor isn't closed in by
+    walls.
+
+--*/
+
+{
+
+    ULONG BitCount;
+    ULONG Cell;
+    ULONG CellCount;
+    UCHAR Floor[SOKOBAN_LEVEL_CELLS];
+    ULONG Length;
+    ULONG NeighborCell;
+    LONG NeighborX;
+    LONG NeighborY;
+    ULONG Previous;
+    ULONG Rank;
+    UCHAR Run[SOKOBAN_LEVEL_CELLS];
+    ULONG Stack[SOKOBAN_LEVEL_CELLS];
+    ULONG StackSize;
+    BOOL Touching;
+    LONG X;
+    LONG Y;
+
+    memset(Output, 0, SOKOBAN_LEVEL_CELLS);
+    *Size = 0;
+
+    //
+    // Levels left empty because the level file ran out compress to nothing.
+    //
+
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        if (Cells[Cell] != SOKOBAN_CELL_FREE) {
+            break;
+        }
+    }
+
+    if (Cell == SOKOBAN_LEVEL_CELLS) {
+        return TRUE;
+    }
+
+    //
+    // Find the floor, which is everything the player can reach along with
+    // every bean and goal.
+    //
+
+    memset(Floor, FALSE, SOKOBAN_LEVEL_CELLS);
+    StackSize = 0;
+    Cell = ((StartingPosition >> SOKOBAN_ORIGIN_Y_SHIFT) * SOKOBAN_WIDTH) +
+           (StartingPosition & SOKOBAN_ORIGIN_MASK);
+
+    if ((Cell < SOKOBAN_LEVEL_CELLS) && (Cells[Cell] != SOKOBAN_CELL_WALL)) {
+        Floor[Cell] = TRUE;
+        Stack[0] = Cell;
+        StackSize = 1;
+    }
+
+    while (StackSize != 0) {
+        StackSize -= 1;
+        Cell = Stack[StackSize];
+        X = Cell % SOKOBAN_WIDTH;
+        Y = Cell / SOKOBAN_WIDTH;
+        for (NeighborY = Y - 1; NeighborY <= Y + 1; NeighborY += 1) {
+            for (NeighborX = X - 1; NeighborX <= X + 1; NeighborX += 1) {
+                if (((NeighborX != X) && (NeighborY != Y)) ||
+                    (NeighborX < 0) || (NeighborX >= SOKOBAN_WIDTH) ||
+                    (NeighborY < 0) || (NeighborY >= SOKOBAN_HEIGHT)) {
+
+                    continue;
+                }
+
+                NeighborCell = (NeighborY * SOKOBAN_WIDTH) + NeighborX;
+                if ((Cells[NeighborCell] != SOKOBAN_CELL_WALL) &&
+                    (Floor[NeighborCell] == FALSE)) {
+
+                    Floor[NeighborCell] = TRUE;
+                    Stack[StackSize] = NeighborCell;
+                    StackSize += 1;
+                }
+            }
+        }
+    }
+
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        if ((Cells[Cell] == SOKOBAN_CELL_BEAN) ||
+            (Cells[Cell] == SOKOBAN_CELL_GOAL) ||
+            (Cells[Cell] == SOKOBAN_CELL_BEAN_ON_GOAL)) {
+
+            Floor[Cell] = TRUE;
+        }
+    }
+
+    //
+    // Work out the run type of every cell. The game makes walls out of the
+    // cells around the floor, so the floor can't reach the edge of the
+    // playing field, and every cell around it has to really be a wall.
+    //
+
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        X = Cell % SOKOBAN_WIDTH;
+        Y = Cell / SOKOBAN_WIDTH;
+        if (Floor[Cell] != FALSE) {
+            if ((X == 0) || (X == SOKOBAN_WIDTH - 1) ||
+                (Y == 0) || (Y == SOKOBAN_HEIGHT - 1)) {
+
+                fprintf(stderr,
+                        "Error: Level %d isn't closed in by walls.\n",
+                        (INT)Level + 1);
+
+                return FALSE;
+            }
+
+            switch (Cells[Cell]) {
+            case SOKOBAN_CELL_BEAN:
+                Run[Cell] = SOKOBAN_RUN_BEAN;
+                break;
+
+            case SOKOBAN_CELL_GOAL:
+                Run[Cell] = SOKOBAN_RUN_GOAL;
+                break;
+
+            case SOKOBAN_CELL_BEAN_ON_GOAL:
+                Run[Cell] = SOKOBAN_RUN_BEAN_ON_GOAL;
+                break;
+
+            default:
+                Run[Cell] = SOKOBAN_RUN_FLOOR;
+                break;
+            }
+
+            continue;
+        }
+
+        Touching = FALSE;
+        for (NeighborY = Y - 1; NeighborY <= Y + 1; NeighborY += 1) {
+            for (NeighborX = X - 1; NeighborX <= X + 1; NeighborX += 1) {
+                if ((NeighborX >= 0) && (NeighborX < SOKOBAN_WIDTH) &&
+                    (NeighborY >= 0) && (NeighborY < SOKOBAN_HEIGHT) &&
+                    (Floor[(NeighborY * SOKOBAN_WIDTH) + NeighborX] != FALSE)) {
+
+                    Touching = TRUE;
+                }
+            }
+        }
+
+        Run[Cell] = SOKOBAN_RUN_OUTSIDE;
+        if (Cells[Cell] == SOKOBAN_CELL_WALL) {
+            if (Touching == FALSE) {
+                Run[Cell] = SOKOBAN_RUN_WALL;
+            }
+
+        } else if (Touching != FALSE) {
+            fprintf(stderr,
+                    "Error: Level %d has empty space touching the floor at a "
+                    "corner.\n",
+                    (INT)Level + 1);
+
+            return FALSE;
+        }
+    }
+
+    //
+    // Cells outside the floor at the end of the level are implied, so don't
+    // bother encoding them.
+    //
+
+    CellCount = SOKOBAN_LEVEL_CELLS;
+    while (Run[CellCount - 1] == SOKOBAN_RUN_OUTSIDE) {
+        CellCount -= 1;
+    }
+
+    //
+    // Write out each run as its type, leaving out the previous run's type,
+    // and an Elias gamma coded length.
+    //
+
+    BitCount = 0;
+    Previous = SOKOBAN_RUN_FLOOR;
+    Cell = 0;
+    while (Cell < CellCount) {
+        Length = 1;
+        while ((Cell + Length < CellCount) &&
+               (Run[Cell + Length] == Run[Cell])) {
+
+            Length += 1;
+        }
+
+        Rank = Run[Cell];
+        if (Rank > Previous) {
+            Rank -= 1;
+        }
+
+        Previous = Run[Cell];
+        if (Rank < SOKOBAN_RUN_TYPES - 2) {
+            AppendBits(Output, &BitCount, ((1 << Rank) - 1) << 1, Rank + 1);
+
+        } else {
+            AppendBits(Output, &BitCount, (1 << Rank) - 1, Rank);
+        }
+
+        X = 0;
+        while ((Length >> (X + 1)) != 0) {
+            X += 1;
+        }
+
+        AppendBits(Output, &BitCount, 0, X);
+        AppendBits(Output, &BitCount, Length, X + 1);
+        Cell += Length;
+    }
+
+    *Size = (BitCount + 7) / 8;
+    return TRUE;
+}
+
+VOID
+AppendBits (
+    PUCHAR Output,
+    PULONG BitCount,
+    ULONG Value,
+    ULONG Length
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends bits to a stream, most significant bit first.
+
+Arguments:
+
+    Output - Supplies a pointer to the zeroed buffer holding the stream.
+
+    BitCount - Supplies a pointer to the number of bits in the stream so far.
+        This is updated to include the new bits.
+
+    Value - Supplies the bits to append, in the low bits of the value.
+
+    Length - Supplies the number of bits to append.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    while (Length != 0) {
+        Length -= 1;
+        if ((Value & (1 << Length)) != 0) {
+            Output[*BitCount / 8] |= 0x80 >> (*BitCount % 8);
+        }
+
+        *BitCount += 1;
+    }
+
+    return;
+}
+
+ULONG
+StoreSpriteData (
+    PUCHAR Data,
+    ULONG Size,
+    PULONG BytesAdded
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds an encoded sprite to the shared sprite data. If the same
+    bytes are already there, they're shared rather than stored again. Failing
+    that, the sprite is overlapped with the end of the data as far as it can
+    be. The caller must make sure there is room for the whole sprite.
+
+Arguments:
+
+    Data - Supplies a pointer to the encoded sprite.
+
+    Size - Supplies the size of the encoded sprite in bytes.
+
+    BytesAdded - Supplies a pointer where the number of bytes the shared data
+        grew by will be returned.
+
+Return Value:
+
+    Returns the offset of the sprite within the shared sprite data.
+
+--*/
+
+{
+
+    ULONG Offset;
+    ULONG Overlap;
+
+    for (Offset = 0;
+         Offset + Size <= GeneratedSpriteDataSize;
+         Offset += 1) {
+
+        if (memcmp(&(GeneratedSpriteData[Offset]), Data, Size) == 0) {
+            *BytesAdded = 0;
+            return Offset;
+        }
+    }
+
+    Overlap = Size - 1;
+    if (Overlap > GeneratedSpriteDataSize) {
+        Overlap = GeneratedSpriteDataSize;
+    }
+
+    while (Overlap != 0) {
+        if (memcmp(&(GeneratedSpriteData[GeneratedSpriteDataSize - Overlap]),
+                   Data,
+                   Overlap) == 0) {
+
+            break;
+        }
+
+        Overlap -= 1;
+    }
+
+    Offset = GeneratedSpriteDataSize - Overlap;
+    memcpy(&(GeneratedSpriteData[GeneratedSpriteDataSize]),
+           Data + Overlap,
+           Size - Overlap);
+
+    GeneratedSpriteDataSize += Size - Overlap;
+    *BytesAdded = Size - Overlap;
+    return Offset;
+}
+
+BOOL
+AddAssetReport (
+    PCHAR Name,
+    ULONG RawSize,
+    ULONG EncodedSize,
+    ULONG StoredSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the sizes of a compiled asset for the flash budget
+    report.
+
+Arguments:
+
+    Name - Supplies the name of the asset.
+
+    RawSize - Supplies the size of the asset at one byte per pixel or cell.
+
+    EncodedSize - Supplies the size of the asset once encoded.
+
+    StoredSize - Supplies the number of bytes of flash the asset added.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if there are too many assets.
+
+--*/
+
+{
+
+    PASSET_REPORT Report;
+
+    if (AssetReportCount == MAX_ASSETS) {
+        fprintf(stderr, "Error: Too many assets.\n");
+        return FALSE;
+    }
+
+    Report = &(AssetReport[AssetReportCount]);
+    strncpy(Report->Name, Name, MAX_TOKEN_LENGTH - 1);
+    Report->RawSize = RawSize;
+    Report->EncodedSize = EncodedSize;
+    Report->StoredSize = StoredSize;
+    AssetReportCount += 1;
+    return TRUE;
+}
+
+ULONG
+PrintAssetReport (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints how much flash each asset takes, and how much they
+    take altogether.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the total number of bytes of flash the assets take.
+
+--*/
+
+{
+
+    ULONG Index;
+    PASSET_REPORT Report;
+    ULONG Saved;
+    ULONG Total;
+
+    Saved = 0;
+    Total = 0;
+    printf("MakeAsset: %-24s %8s %8s %8s\n",
+           "Asset",
+           "Raw",
+           "Encoded",
+           "Stored");
+
+    for (Index = 0; Index < AssetReportCount; Index += 1) {
+        Report = &(AssetReport[Index]);
+        printf("MakeAsset: %-24s %8d %8d %8d\n",
+               Report->Name,
+               (INT)Report->RawSize,
+               (INT)Report->EncodedSize,
+               (INT)Report->StoredSize);
+
+        Saved += Report->EncodedSize - Report->StoredSize;
+        Total += Report->StoredSize;
+    }
+
+    printf("MakeAsset: %d bytes of assets, %d.%d%% of the %d byte flash. "
+           "%d bytes were shared.\n",
+           (INT)Total,
+           (INT)((Total * 1000 / FLASH_SIZE) / 10),
+           (INT)((Total * 1000 / FLASH_SIZE) % 10),
+           FLASH_SIZE,
+           (INT)Saved);
+
+    return Total;
+}
+
+BOOL
+WriteArray (
+    FILE *OutputFile,
+    PCHAR Header,
+    PVOID Array,
+    ULONG ElementSize,
+    ULONG ElementCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes out an array variable definition.
+
+Arguments:
+
+    OutputFile - Supplies an open file handle where the array is to be printed.
+
+    Header - Supplies the declaration of the variable, up to and including the
+        opening curly brace.
+
+    Array - Supplies a pointer to the array elements.
+
+    ElementSize - Supplies the size of each element. Valid values are the size
+        of a UCHAR and the size of a USHORT.
+
+    ElementCount - Supplies the number of elements in the array.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    ULONG Element;
+    ULONG ElementsPerLine;
+    INT Result;
+
+    ElementsPerLine = 12;
+    if (ElementSize == sizeof(USHORT)) {
+        ElementsPerLine = 8;
+    }
+
+    if (fputs(Header, OutputFile) < 0) {
+        return FALSE;
+    }
+
+    for (Element = 0; Element < ElementCount; Element += 1) {
+        if ((Element % ElementsPerLine) == 0) {
+            if (fputs(ASSET_DATA_BEGIN, OutputFile) < 0) {
+                return FALSE;
+            }
+        }
+
+        if (ElementSize == sizeof(USHORT)) {
+            Result = fprintf(OutputFile, "0x%04x, ", ((PUSHORT)Array)[Element]);
+
+        } else {
+            Result = fprintf(OutputFile, "0x%02x, ", ((PUCHAR)Array)[Element]);
+        }
+
+        if (Result < 0) {
+            return FALSE;
+        }
+    }
+
+    if (fputs("\n" ASSET_VARIABLE_END, OutputFile) < 0) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+ReadAssetFile (
+    PCHAR Filename,
+    PUCHAR *Buffer,
+    PULONG FileSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads an entire file into memory.
+
+Arguments:
+
+    Filename - Supplies the name of the file to read.
+
+    Buffer - Supplies a pointer to where the newly allocated buffer will be
+        returned. It is the caller's responsibility to free this buffer.
+
+    FileSize - Supplies pointer to the integer that receives the file size.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    LONG BytesRead;
+    FILE *File;
+    PUCHAR MappedFile;
+    BOOL Result;
+
+    MappedFile = NULL;
+    Result = FALSE;
+
+    *Buffer = NULL;
+    *FileSize = 0;
+    File = fopen(Filename, "rb");
+    if (File == NULL) {
+        printf("Unable to open file \"%s\" for read.\n", Filename);
+        goto ReadAssetFileEnd;
+
+    }
+
+    *FileSize = GetFileSize(File);
+    if (*FileSize <= 0) {
+        printf("Unable to get file size of file \"%s\"!\n", Filename);
+        goto ReadAssetFileEnd;
+    }
+
+    MappedFile = malloc(*FileSize);
+    if (MappedFile == NULL) {
+        goto ReadAssetFileEnd;
+    }
+
+    BytesRead = fread(MappedFile, 1, *FileSize, File);
+    if (BytesRead != *FileSize) {
+        printf("Unable to read %d bytes, actually read %d.\n",
+               (INT)*FileSize,
+               (INT)BytesRead);
+
+        goto ReadAssetFileEnd;
+    }
+
+    Result = TRUE;
+
+ReadAssetFileEnd:
+    if (File != NULL) {
+        fclose(File);
+    }
+
+    if (Result == FALSE) {
+        if (MappedFile != NULL) {
+            free(MappedFile);
+        }
+
+    } else {
+        *Buffer = MappedFile;
+    }
+
+    return Result;
+}
+
+LONG
+GetFileSize (
+    FILE *File
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines the file size in bytes of the given file.
+
+Arguments:
+
+    File - Supplies a handle to the file opened for at least read in binary
+        mode.
+
+Return Value:
+
+    Returns the file size in bytes.
+
+--*/
+
+{
+
+    LONG FileSize;
+
+    fseek(File, 0, SEEK_END);
+    FileSize = ftell(File);
+    fseek(File, 0, SEEK_SET);
+    return FileSize;
+}
+
+
+BOOL
+GetNextLine (
+    PCHAR *Input,
+    PCHAR InputEnd,
+    PCHAR Line
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies the next line out of a file, without its line ending
+    or trailing whitespace. Lines longer than MAX_LINE_LENGTH are truncated.
+
+Arguments:
+
+    Input - Supplies a pointer to the current position in the file. On
+        return, this is advanced to the start of the next line.
+
+    InputEnd - Supplies a pointer to the end of the file.
+
+    Line - Supplies a pointer to a buffer of MAX_LINE_LENGTH characters where
+        the line will be returned.
+
+Return Value:
+
+    TRUE if a line was returned.
+
+    FALSE if the end of the file was reached.
+
+--*/
+
+{
+
+    CHAR Character;
+    ULONG Length;
+
+    if (*Input == InputEnd) {
+        return FALSE;
+    }
+
+    Length = 0;
+    while (*Input != InputEnd) {
+        Character = **Input;
+        *Input += 1;
+        if (Character == '\n') {
+            break;
+        }
+
+        if ((Character != '\r') && (Length != MAX_LINE_LENGTH - 1)) {
+            Line[Length] = Character;
+            Length += 1;
+        }
+    }
+
+    while ((Length != 0) &&
+           ((Line[Length - 1] == ' ') || (Line[Length - 1] == '\t'))) {
+
+        Length -= 1;
+    }
+
+    Line[Length] = '\0';
+    return TRUE;
+}
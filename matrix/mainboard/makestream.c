@@ -0,0 +1,587 @@
+/*++
+
+Copyright (c) 2011 Evan Green
+
+Module Name:
+
+    makestream.c
+
+Abstract:
+
+    This module implements the program that converts a sequence of images
+    into the video stream the matrix's video stream app plays.
+
+Author:
+
+    Evan Green 22-Jan-2011
+
+Environment:
+
+    Build
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define USAGE_STRING \
+    "MakeStream takes in a sequence of binary PPM images and writes out a " \
+    "compressed video stream for the matrix. Images of any size are scaled " \
+    "down to fit.\n\n" \
+    "Usage: MakeStream [-f] [-o <Output>] [<InputFile>]\n\n" \
+    "Options:\n" \
+    "    -f  Wait for the matrix to ask for each frame. The output must be " \
+    "the\n        serial port the matrix is on, already set to %d baud.\n" \
+    "    -o  Write the stream to the given file instead of standard output." \
+    "\n\nThe images are read from standard input if no input file is given." \
+    " For\nexample, to play a video:\n\n" \
+    "    ffmpeg -re -i Video.mp4 -vf scale=24:24 -f image2pipe -vcodec ppm - " \
+    "|\n        MakeStream -f -o /dev/ttyUSB0\n\n"
+
+//
+// Define the number of pixels in a frame.
+//
+
+#define FRAME_PIXELS (MATRIX_PROTOCOL_ROWS * MATRIX_PROTOCOL_COLUMNS)
+
+//
+// Define the largest value of a color in a pixel, and how to build a pixel.
+//
+
+#define COLOR_MAX 0x1F
+#define RGB_PIXEL(_Red, _Green, _Blue) \
+    (USHORT)(((_Red) << 10) | ((_Green) << 5) | (_Blue))
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef unsigned char BOOL;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+BOOL
+ReadPpmFrame (
+    FILE *Input,
+    PUSHORT Frame
+    );
+
+BOOL
+ReadPpmNumber (
+    FILE *Input,
+    PULONG Value
+    );
+
+ULONG
+EncodeFrame (
+    PUSHORT Frame,
+    PUCHAR Output
+    );
+
+BOOL
+WaitForReady (
+    FILE *Port
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INT
+main (
+    INT argc,
+    CHAR **argv
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the program. It collects the
+    options passed to it, and converts every image in the input.
+
+Arguments:
+
+    argc - Supplies the number of command line arguments the program was invoked
+           with.
+
+    argv - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
+{
+
+    PCHAR Argument;
+    BOOL FlowControl;
+    USHORT Frame[FRAME_PIXELS];
+    ULONG FrameCount;
+    ULONG FrameSize;
+    FILE *Input;
+    PCHAR InputName;
+    FILE *Output;
+    PCHAR OutputName;
+    BOOL Result;
+    UCHAR Stream[STREAM_MAX_FRAME_SIZE];
+    ULONG TotalSize;
+
+    //
+    // Process the command line options
+    //
+
+    FlowControl = FALSE;
+    InputName = NULL;
+    OutputName = NULL;
+    while ((argc > 1) && (argv[1][0] == '-')) {
+        Argument = &(argv[1][1]);
+        if (strcmp(Argument, "o") == 0) {
+            argc -= 1;
+            argv += 1;
+            OutputName = argv[1];
+            if (OutputName == NULL) {
+                fprintf(stderr, USAGE_STRING, STREAM_BAUD_RATE);
+                return 1;
+            }
+
+        } else if (strcmp(Argument, "f") == 0) {
+            FlowControl = TRUE;
+
+        } else {
+            fprintf(stderr, "%s: Invalid option\n\n", Argument);
+            fprintf(stderr, USAGE_STRING, STREAM_BAUD_RATE);
+            return 1;
+        }
+
+        argc -= 1;
+        argv += 1;
+    }
+
+    if (argc > 1) {
+        InputName = argv[1];
+    }
+
+    if ((FlowControl != FALSE) && (OutputName == NULL)) {
+        fprintf(stderr, "Error: Flow control needs an output port.\n\n");
+        fprintf(stderr, USAGE_STRING, STREAM_BAUD_RATE);
+        return 1;
+    }
+
+    Input = stdin;
+    Output = stdout;
+    Result = FALSE;
+    if (InputName != NULL) {
+        Input = fopen(InputName, "rb");
+        if (Input == NULL) {
+            fprintf(stderr,
+                    "Unable to open input file \"%s\" for read.\n",
+                    InputName);
+
+            goto MainEnd;
+        }
+    }
+
+    //
+    // The matrix's ready bytes come back on the same port the stream goes
+    // out of, so open it for both.
+    //
+
+    if (OutputName != NULL) {
+        if (FlowControl != FALSE) {
+            Output = fopen(OutputName, "r+b");
+
+        } else {
+            Output = fopen(OutputName, "wb");
+        }
+
+        if (Output == NULL) {
+            fprintf(stderr,
+                    "Unable to open output file \"%s\" for write.\n",
+                    OutputName);
+
+            goto MainEnd;
+        }
+    }
+
+    //
+    // Convert images until the input runs out.
+    //
+
+    FrameCount = 0;
+    TotalSize = 0;
+    while (ReadPpmFrame(Input, Frame) != FALSE) {
+        FrameSize = EncodeFrame(Frame, Stream);
+        if (FlowControl != FALSE) {
+            if (WaitForReady(Output) == FALSE) {
+                fprintf(stderr, "Error: The matrix stopped answering.\n");
+                goto MainEnd;
+            }
+        }
+
+        if (fwrite(Stream, 1, FrameSize, Output) != FrameSize) {
+            fprintf(stderr, "Error: Unable to write frame %lu.\n", FrameCount);
+            goto MainEnd;
+        }
+
+        fflush(Output);
+        FrameCount += 1;
+        TotalSize += FrameSize;
+    }
+
+    if (FrameCount != 0) {
+        fprintf(stderr,
+                "%lu frames, %lu bytes, %lu bytes per frame on average.\n",
+                FrameCount,
+                TotalSize,
+                TotalSize / FrameCount);
+    }
+
+    Result = TRUE;
+
+MainEnd:
+    if ((Input != NULL) && (Input != stdin)) {
+        fclose(Input);
+    }
+
+    if ((Output != NULL) && (Output != stdout)) {
+        fclose(Output);
+    }
+
+    if (Result == FALSE) {
+        return 1;
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+BOOL
+ReadPpmFrame (
+    FILE *Input,
+    PUSHORT Frame
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the next binary PPM image from the input and scales it
+    down to the size of the matrix. Each matrix pixel is the average of the
+    image pixels it covers.
+
+Arguments:
+
+    Input - Supplies the file to read the image from.
+
+    Frame - Supplies a pointer where the matrix pixels will be returned, row
+        by row.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the input ran out or the image could not be read.
+
+--*/
+
+{
+
+    ULONG Color;
+    ULONG Column;
+    ULONG ColumnEnd;
+    ULONG ColumnStart;
+    ULONG Height;
+    ULONG ImageColumn;
+    ULONG ImageRow;
+    PUCHAR Image;
+    ULONG ImageSize;
+    ULONG MaxValue;
+    PUCHAR Pixel;
+    BOOL Result;
+    ULONG Row;
+    ULONG RowEnd;
+    ULONG RowStart;
+    ULONG Samples;
+    ULONG Sum[3];
+    ULONG Width;
+
+    Image = NULL;
+    Result = FALSE;
+    if ((fgetc(Input) != 'P') || (fgetc(Input) != '6')) {
+        goto ReadPpmFrameEnd;
+    }
+
+    if ((ReadPpmNumber(Input, &Width) == FALSE) ||
+        (ReadPpmNumber(Input, &Height) == FALSE) ||
+        (ReadPpmNumber(Input, &MaxValue) == FALSE)) {
+
+        fprintf(stderr, "Error: Bad PPM header.\n");
+        goto ReadPpmFrameEnd;
+    }
+
+    //
+    // Only one byte per color is supported.
+    //
+
+    if ((Width == 0) || (Height == 0) || (MaxValue == 0) ||
+        (MaxValue > 255)) {
+
+        fprintf(stderr,
+                "Error: Unsupported %lux%lu PPM with a maximum of %lu.\n",
+                Width,
+                Height,
+                MaxValue);
+
+        goto ReadPpmFrameEnd;
+    }
+
+    ImageSize = Width * Height * 3;
+    Image = malloc(ImageSize);
+    if (Image == NULL) {
+        fprintf(stderr, "Error: Unable to allocate %lu bytes.\n", ImageSize);
+        goto ReadPpmFrameEnd;
+    }
+
+    if (fread(Image, 1, ImageSize, Input) != ImageSize) {
+        fprintf(stderr, "Error: The last image was cut short.\n");
+        goto ReadPpmFrameEnd;
+    }
+
+    for (Row = 0; Row < MATRIX_PROTOCOL_ROWS; Row += 1) {
+        RowStart = Row * Height / MATRIX_PROTOCOL_ROWS;
+        RowEnd = (Row + 1) * Height / MATRIX_PROTOCOL_ROWS;
+        if (RowEnd == RowStart) {
+            RowEnd = RowStart + 1;
+        }
+
+        for (Column = 0; Column < MATRIX_PROTOCOL_COLUMNS; Column += 1) {
+            ColumnStart = Column * Width / MATRIX_PROTOCOL_COLUMNS;
+            ColumnEnd = (Column + 1) * Width / MATRIX_PROTOCOL_COLUMNS;
+            if (ColumnEnd == ColumnStart) {
+                ColumnEnd = ColumnStart + 1;
+            }
+
+            Sum[0] = 0;
+            Sum[1] = 0;
+            Sum[2] = 0;
+            for (ImageRow = RowStart; ImageRow < RowEnd; ImageRow += 1) {
+                Pixel = &(Image[((ImageRow * Width) + ColumnStart) * 3]);
+                for (ImageColumn = ColumnStart;
+                     ImageColumn < ColumnEnd;
+                     ImageColumn += 1) {
+
+                    Sum[0] += Pixel[0];
+                    Sum[1] += Pixel[1];
+                    Sum[2] += Pixel[2];
+                    Pixel += 3;
+                }
+            }
+
+            //
+            // Scale each average down to the matrix's 5 bits per color.
+            //
+
+            Samples = (RowEnd - RowStart) * (ColumnEnd - ColumnStart);
+            for (Color = 0; Color < 3; Color += 1) {
+                Sum[Color] = (Sum[Color] * COLOR_MAX +
+                              (Samples * MaxValue / 2)) /
+                             (Samples * MaxValue);
+            }
+
+            Frame[(Row * MATRIX_PROTOCOL_COLUMNS) + Column] =
+                                          RGB_PIXEL(Sum[0], Sum[1], Sum[2]);
+        }
+    }
+
+    Result = TRUE;
+
+ReadPpmFrameEnd:
+    if (Image != NULL) {
+        free(Image);
+    }
+
+    return Result;
+}
+
+BOOL
+ReadPpmNumber (
+    FILE *Input,
+    PULONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads a decimal number out of a PPM header, skipping the
+    whitespace and comments in front of it. The single whitespace character
+    after the number is consumed too.
+
+Arguments:
+
+    Input - Supplies the file to read from.
+
+    Value - Supplies a pointer where the number will be returned.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if no number was found.
+
+--*/
+
+{
+
+    INT Character;
+    BOOL Found;
+
+    do {
+        Character = fgetc(Input);
+        if (Character == '#') {
+            while ((Character != '\n') && (Character != EOF)) {
+                Character = fgetc(Input);
+            }
+        }
+
+    } while ((Character == ' ') || (Character == '\t') ||
+             (Character == '\r') || (Character == '\n'));
+
+    Found = FALSE;
+    *Value = 0;
+    while ((Character >= '0') && (Character <= '9')) {
+        Found = TRUE;
+        *Value = (*Value * 10) + (Character - '0');
+        Character = fgetc(Input);
+    }
+
+    return Found;
+}
+
+ULONG
+EncodeFrame (
+    PUSHORT Frame,
+    PUCHAR Output
+    )
+
+/*++
+
+Routine Description:
+
+    This routine run length encodes a frame the way the matrix expects it.
+
+Arguments:
+
+    Frame - Supplies a pointer to the matrix pixels, row by row.
+
+    Output - Supplies a pointer where the encoded frame will be returned. It
+        must be at least STREAM_MAX_FRAME_SIZE bytes.
+
+Return Value:
+
+    Returns the size of the encoded frame in bytes.
+
+--*/
+
+{
+
+    ULONG Index;
+    UCHAR Length;
+    ULONG Size;
+    USHORT RunningColor;
+
+    Output[0] = SYNC_BYTE0;
+    Output[1] = SYNC_BYTE1;
+    Output[2] = SYNC_BYTE2;
+    Size = 3;
+    RunningColor = Frame[0];
+    Length = 0;
+    for (Index = 0; Index < FRAME_PIXELS; Index += 1) {
+        if ((Length == 0xFF) || (Frame[Index] != RunningColor)) {
+            Output[Size] = Length;
+            Output[Size + 1] = (UCHAR)(RunningColor >> 8);
+            Output[Size + 2] = (UCHAR)RunningColor;
+            Size += 3;
+            Length = 1;
+            RunningColor = Frame[Index];
+
+        } else {
+            Length += 1;
+        }
+    }
+
+    Output[Size] = Length;
+    Output[Size + 1] = (UCHAR)(RunningColor >> 8);
+    Output[Size + 2] = (UCHAR)RunningColor;
+    Size += 3;
+    return Size;
+}
+
+BOOL
+WaitForReady (
+    FILE *Port
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for the matrix to ask for the next frame.
+
+Arguments:
+
+    Port - Supplies the serial port the matrix is on.
+
+Return Value:
+
+    TRUE once the matrix is ready.
+
+    FALSE if the port was closed.
+
+--*/
+
+{
+
+    INT Character;
+
+    //
+    // Anything else the matrix sends is ignored. A stream opened for both
+    // reading and writing has to be repositioned between the two, which does
+    // nothing on a serial port other than satisfy the C library.
+    //
+
+    do {
+        Character = fgetc(Port);
+    } while ((Character != STREAM_READY) && (Character != EOF));
+
+    fseek(Port, 0, SEEK_CUR);
+    if (Character == EOF) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
@@ -0,0 +1,497 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    schedule.c
+
+Abstract:
+
+    This module implements the cooperative event loop, which lets applications
+    register timers and an input handler rather than spinning in stall loops.
+
+Author:
+
+    Evan Green 2-Dec-2010
+
+Environment:
+
+    AVR/WIN32
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "mainboard.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// This macro returns the timer wheel slot that the given raw time falls in.
+//
+
+#define TIMER_WHEEL_SLOT(_Time) \
+    (((_Time) >> TIMER_WHEEL_SHIFT) & (TIMER_WHEEL_SIZE - 1))
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+KepExpireTimers (
+    ULONG CurrentTime
+    );
+
+VOID
+KepInsertTimer (
+    PTIMER Timer
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the timer wheel. Each slot holds the timers whose due time falls in it,
+// in no particular order. Timers more than one turn of the wheel away simply
+// stay in their slot until the wheel comes around far enough.
+//
+
+PTIMER KeTimerWheel[TIMER_WHEEL_SIZE];
+
+//
+// Store the raw time up to which the timer wheel has been processed.
+//
+
+ULONG KeTimerWheelTime;
+
+//
+// Store the application's input handler.
+//
+
+PINPUT_ROUTINE KeInputRoutine;
+PVOID KeInputContext;
+USHORT KeInputMask;
+
+//
+// Store the state of the event loop.
+//
+
+UCHAR KeEventLoopRunning;
+APPLICATION KeEventLoopResult;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+APPLICATION
+KeRunEventLoop (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs the cooperative event loop for an application. It calls
+    the input handler and expired timers as they come due, marks the display
+    dirty after each, and sleeps the processor in between. When the loop
+    exits, every timer is cancelled and the input handler is cleared.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to run, either from the menu or from
+    KeExitEventLoop.
+
+--*/
+
+{
+
+    INPUT_EVENT Event;
+    USHORT Inputs;
+    UCHAR Slot;
+
+    KeEventLoopRunning = TRUE;
+    KeEventLoopResult = ApplicationNone;
+    KeTimerWheelTime = KeRawTime;
+    while (KeEventLoopRunning != FALSE) {
+        KeEventLoopResult = KeRunMenu();
+        if (KeEventLoopResult != ApplicationNone) {
+            break;
+        }
+
+        //
+        // Hand any interesting inputs to the application, one sample at a
+        // time so that quick repeated presses all get through. The edge bits
+        // for those inputs are spoken for by the queue.
+        //
+
+        while (KeGetInputEvent(&Event) != FALSE) {
+            Inputs = Event.Inputs & KeInputMask;
+            if ((Inputs != 0) && (KeInputRoutine != NULL)) {
+                KeInputRoutine(Inputs, KeInputContext);
+                KeDisplayDirty = TRUE;
+                if (KeEventLoopRunning == FALSE) {
+                    break;
+                }
+            }
+        }
+
+        KeAcknowledgeInputEdges(KeInputMask);
+        if (KeEventLoopRunning == FALSE) {
+            break;
+        }
+
+        KepExpireTimers(KeRawTime);
+        if (KeEventLoopRunning == FALSE) {
+            break;
+        }
+
+        //
+        // Nothing more can happen until the next timer tick.
+        //
+
+        HlWaitForInterrupt();
+    }
+
+    //
+    // Tear down everything the application registered.
+    //
+
+    for (Slot = 0; Slot < TIMER_WHEEL_SIZE; Slot += 1) {
+        while (KeTimerWheel[Slot] != NULL) {
+            KeCancelTimer(KeTimerWheel[Slot]);
+        }
+    }
+
+    KeSetInputHandler(0, NULL, NULL);
+    KeEventLoopRunning = FALSE;
+    return KeEventLoopResult;
+}
+
+VOID
+KeExitEventLoop (
+    APPLICATION NextApplication
+    )
+
+/*++
+
+Routine Description:
+
+    This routine asks the event loop to return once the current callback is
+    finished.
+
+Arguments:
+
+    NextApplication - Supplies the value the event loop should return.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeEventLoopResult = NextApplication;
+    KeEventLoopRunning = FALSE;
+    return;
+}
+
+VOID
+KeInitializeTimer (
+    PTIMER Timer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes a timer so that it can be queued.
+
+Arguments:
+
+    Timer - Supplies a pointer to the timer storage.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Timer->Next = NULL;
+    Timer->Queued = FALSE;
+    return;
+}
+
+VOID
+KeQueueTimer (
+    PTIMER Timer,
+    ULONG DueTime,
+    ULONG Period,
+    PTIMER_ROUTINE Routine,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues a timer in the timer wheel. If the timer is already
+    queued, it is moved to the new due time.
+
+Arguments:
+
+    Timer - Supplies a pointer to the timer storage.
+
+    DueTime - Supplies the time from now until the timer expires, in ms/32.
+
+    Period - Supplies the interval to requeue the timer at after it expires,
+        in ms/32. Supply zero for a one-shot timer.
+
+    Routine - Supplies the routine to call when the timer expires.
+
+    Context - Supplies a pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeCancelTimer(Timer);
+    Timer->DueTime = KeRawTime + DueTime;
+    Timer->Period = Period;
+    Timer->Routine = Routine;
+    Timer->Context = Context;
+    KepInsertTimer(Timer);
+    return;
+}
+
+VOID
+KeCancelTimer (
+    PTIMER Timer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a timer from the timer wheel if it is queued.
+
+Arguments:
+
+    Timer - Supplies a pointer to the timer to cancel.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTIMER *Link;
+
+    if (Timer->Queued == FALSE) {
+        return;
+    }
+
+    Link = &(KeTimerWheel[TIMER_WHEEL_SLOT(Timer->DueTime)]);
+    while (*Link != Timer) {
+        Link = &((*Link)->Next);
+    }
+
+    *Link = Timer->Next;
+    Timer->Next = NULL;
+    Timer->Queued = FALSE;
+    return;
+}
+
+VOID
+KeSetInputHandler (
+    USHORT Inputs,
+    PINPUT_ROUTINE Routine,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the routine the event loop calls when inputs are
+    pressed. Only one handler is active at a time.
+
+Arguments:
+
+    Inputs - Supplies the mask of input edges the handler wants. The menu and
+        standby inputs are always handled by the event loop.
+
+    Routine - Supplies the routine to call, or NULL to remove the handler.
+
+    Context - Supplies a pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeInputMask = Inputs & ~(INPUT_MENU | INPUT_STANDBY);
+    KeInputRoutine = Routine;
+    KeInputContext = Context;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+KepExpireTimers (
+    ULONG CurrentTime
+    )
+
+/*++
+
+Routine Description:
+
+    This routine calls every timer that has come due, walking the timer wheel
+    slots between the last time it was processed and now.
+
+Arguments:
+
+    CurrentTime - Supplies the current raw time.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTIMER Next;
+    UCHAR Slot;
+    ULONG Steps;
+    PTIMER Timer;
+
+    //
+    // If it's been longer than a whole turn of the wheel, just visit every
+    // slot once.
+    //
+
+    Steps = (CurrentTime >> TIMER_WHEEL_SHIFT) -
+            (KeTimerWheelTime >> TIMER_WHEEL_SHIFT);
+
+    if (Steps >= TIMER_WHEEL_SIZE) {
+        Steps = TIMER_WHEEL_SIZE - 1;
+    }
+
+    Slot = TIMER_WHEEL_SLOT(KeTimerWheelTime);
+    KeTimerWheelTime = CurrentTime;
+    while (TRUE) {
+        Timer = KeTimerWheel[Slot];
+        while (Timer != NULL) {
+            Next = Timer->Next;
+
+            //
+            // Skip timers in this slot that are due on a later turn of the
+            // wheel. The subtraction keeps this working when the time wraps.
+            //
+
+            if ((LONG)(CurrentTime - Timer->DueTime) < 0) {
+                Timer = Next;
+                continue;
+            }
+
+            //
+            // Requeue periodic timers before calling them so the routine can
+            // cancel or change them. If the loop fell a whole period behind,
+            // don't try to catch up with a burst of calls.
+            //
+
+            KeCancelTimer(Timer);
+            if (Timer->Period != 0) {
+                Timer->DueTime += Timer->Period;
+                if ((LONG)(CurrentTime - Timer->DueTime) >= 0) {
+                    Timer->DueTime = CurrentTime + Timer->Period;
+                }
+
+                KepInsertTimer(Timer);
+            }
+
+            Timer->Routine(Timer->Context);
+            KeDisplayDirty = TRUE;
+            if (KeEventLoopRunning == FALSE) {
+                return;
+            }
+
+            //
+            // The routine may have changed anything in the wheel, so start
+            // this slot over. Timers that already ran are now in the future
+            // and will be skipped.
+            //
+
+            Timer = KeTimerWheel[Slot];
+        }
+
+        if (Steps == 0) {
+            break;
+        }
+
+        Steps -= 1;
+        Slot = (Slot + 1) & (TIMER_WHEEL_SIZE - 1);
+    }
+
+    return;
+}
+
+VOID
+KepInsertTimer (
+    PTIMER Timer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine links a timer into the slot for its due time.
+
+Arguments:
+
+    Timer - Supplies a pointer to the timer, with its due time filled in.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Slot;
+
+    Slot = TIMER_WHEEL_SLOT(Timer->DueTime);
+    Timer->Next = KeTimerWheel[Slot];
+    KeTimerWheel[Slot] = Timer;
+    Timer->Queued = TRUE;
+    return;
+}
+
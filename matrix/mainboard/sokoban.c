@@ -27,6 +27,7 @@ Environment:
 #include "types.h"
 #include "mainboard.h"
 #include "sokoban.h"
+#include "assets.h"
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -39,6 +40,14 @@ Environment:
 #define SOKOBAN_LEVEL_METER_Y 23
 #define SOKOBAN_LEVEL_METER_X 2
 
+//
+// Define the number of levels shown on the level meter at once. When there
+// are more levels than this, the meter shows the group the current level is
+// in.
+//
+
+#define SOKOBAN_LEVEL_METER_WIDTH 20
+
 //
 // Define the location on the screen to draw the main map.
 //
@@ -46,6 +55,13 @@ Environment:
 #define SOKOBAN_LEVEL_X 2
 #define SOKOBAN_LEVEL_Y 5
 
+//
+// Define the location on the screen of the icon above the map.
+//
+
+#define SOKOBAN_ICON_X SOKOBAN_LEVEL_X
+#define SOKOBAN_ICON_Y 0
+
 //
 // Define the color of our hero.
 //
@@ -56,43 +72,93 @@ Environment:
 #define SOKOBAN_BEAN RGB_PIXEL(0x1F, 0x0, 0x0)
 #define SOKOBAN_GOAL RGB_PIXEL(0x0, 0x0, 0x1F)
 
+//
+// Define the value that marks cells outside the floor while a level is being
+// painted, until the floor next to them makes them walls. It can't appear in
+// a painted level, and shows up black in the meantime.
+//
+
+#define SOKOBAN_UNDECIDED PIXEL_USER_BIT
+
+//
+// Define the value returned when a level's compressed data runs out.
+//
+
+#define SOKOBAN_END_OF_LEVEL 2
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure stores the position within a compressed level as it is
+    read out of flash.
+
+Members:
+
+    Offset - Stores the offset of the next byte to read in the level data.
+
+    OffsetEnd - Stores the offset just past the end of the level's data.
+
+    Bits - Stores the bits of the current byte not yet read, shifted up to the
+        most significant bit.
+
+    BitsLeft - Stores the number of bits of the current byte not yet read.
+
+--*/
+
+typedef struct _SOKOBAN_READER {
+    USHORT Offset;
+    USHORT OffsetEnd;
+    UCHAR Bits;
+    UCHAR BitsLeft;
+} SOKOBAN_READER, *PSOKOBAN_READER;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
 VOID
 SkpPaintLevelIndicator (
-    UCHAR CurrentLevel
+    USHORT CurrentLevel
     );
 
 VOID
 SkpPaintLevel (
-    UCHAR Level,
+    USHORT Level,
     PUCHAR CharacterX,
     PUCHAR CharacterY
     );
 
+UCHAR
+SkpReadBit (
+    PSOKOBAN_READER Reader
+    );
+
 UCHAR
 SkpIsLevelComplete (
     VOID
     );
 
+VOID
+SkpPrintPushes (
+    USHORT Level,
+    USHORT Pushes
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 //
-// Store a global representing the completed levels. This persists across
-// application runs so that the user won't lose his or her progress. The first
-// one is levels 1-16, the second is levels 16-20.
+// Store a global bitmap representing the completed levels. This persists
+// across application runs so that the user won't lose his or her progress.
 //
 
-USHORT SokobanCompletedLevels1;
-UCHAR SokobanCompletedLevels2;
+UCHAR SokobanCompletedLevels[SOKOBAN_COMPLETED_SIZE];
 
 //
 // ------------------------------------------------------------------ Functions
@@ -123,8 +189,7 @@ Return Value:
 
     UCHAR CharacterX;
     UCHAR CharacterY;
-    USHORT CompletedLevels;
-    UCHAR CurrentLevel;
+    USHORT CurrentLevel;
     UCHAR LevelComplete;
     USHORT OldValue;
     APPLICATION NextApplication;
@@ -133,21 +198,28 @@ Return Value:
     USHORT NextSpace;
     UCHAR NextX;
     UCHAR NextY;
+    USHORT Palette[GRAPHICS_PALETTE_SIZE];
+    USHORT Pushes;
+
+    //
+    // The icon is drawn in the same colors as the game pieces.
+    //
+
+    Palette[0] = SOKOBAN_FREE;
+    Palette[1] = SOKOBAN_HERO;
+    Palette[2] = SOKOBAN_BEAN;
+    Palette[3] = SOKOBAN_GOAL;
 
     //
     // Determine the current level.
     //
 
     CurrentLevel = 0;
-    CompletedLevels = SokobanCompletedLevels1;
-    if (CompletedLevels == 0xFFFF) {
-        CompletedLevels = SokobanCompletedLevels2;
-        CurrentLevel = 15;
-    }
+    while ((CurrentLevel < SOKOBAN_LEVELS) &&
+           ((SokobanCompletedLevels[CurrentLevel / 8] &
+             (1 << (CurrentLevel % 8))) != 0)) {
 
-    while ((CompletedLevels & 0x1) != 0) {
         CurrentLevel += 1;
-        CompletedLevels = CompletedLevels >> 1;
     }
 
     if (CurrentLevel > (SOKOBAN_LEVELS - 1)) {
@@ -163,9 +235,16 @@ Return Value:
         KeClearScreen();
 
         //
-        // Paint the level indicator.
+        // Paint the icon and the level indicator.
         //
 
+        GrBlitPaletteSprite(SOKOBAN_ICON_X,
+                            SOKOBAN_ICON_Y,
+                            SokobanIcon_WIDTH,
+                            SokobanIcon_HEIGHT,
+                            (PPGM)SokobanIcon,
+                            Palette);
+
         SkpPaintLevelIndicator(CurrentLevel);
 
         //
@@ -173,6 +252,8 @@ Return Value:
         //
 
         SkpPaintLevel(CurrentLevel, &CharacterX, &CharacterY);
+        Pushes = 0;
+        SkpPrintPushes(CurrentLevel, Pushes);
 
         //
         // Accept input.
@@ -198,22 +279,22 @@ Return Value:
             NextY = CharacterY;
             NextNextY = CharacterY;
             if ((KeInputEdges & INPUT_LEFT2) != 0) {
-                KeInputEdges &= ~INPUT_LEFT2;
+                KeAcknowledgeInputEdges(INPUT_LEFT2);
                 NextX -= 1;
                 NextNextX -= 2;
 
             } else if ((KeInputEdges & INPUT_RIGHT2) != 0) {
-                KeInputEdges &= ~INPUT_RIGHT2;
+                KeAcknowledgeInputEdges(INPUT_RIGHT2);
                 NextX += 1;
                 NextNextX += 2;
 
             } else if ((KeInputEdges & INPUT_UP2) != 0) {
-                KeInputEdges &= ~INPUT_UP2;
+                KeAcknowledgeInputEdges(INPUT_UP2);
                 NextY -= 1;
                 NextNextY -= 2;
 
             } else if ((KeInputEdges & INPUT_DOWN2) != 0) {
-                KeInputEdges &= ~INPUT_DOWN2;
+                KeAcknowledgeInputEdges(INPUT_DOWN2);
                 NextY += 1;
                 NextNextY += 2;
             }
@@ -250,6 +331,9 @@ Return Value:
                     OldValue = KeMatrix[NextY][NextX];
                     KeMatrix[NextY][NextX] =
                                     (OldValue & PIXEL_USER_BIT) | SOKOBAN_HERO;
+
+                    Pushes += 1;
+                    SkpPrintPushes(CurrentLevel, Pushes);
                 }
 
             //
@@ -287,12 +371,8 @@ Return Value:
 
             LevelComplete = SkpIsLevelComplete();
             if (LevelComplete != FALSE) {
-                if (CurrentLevel < 16) {
-                    SokobanCompletedLevels1 |= 1 << CurrentLevel;
-
-                } else {
-                    SokobanCompletedLevels2 |= 1 << (CurrentLevel - 16);
-                }
+                SokobanCompletedLevels[CurrentLevel / 8] |=
+                                                     1 << (CurrentLevel % 8);
 
                 KeTrackball1 = RGB_PIXEL(0x0, 0x1F, 0x0);
 
@@ -302,7 +382,7 @@ Return Value:
                 //
 
                 if ((KeInputEdges & (INPUT_BUTTON1 | INPUT_BUTTON2)) != 0) {
-                    KeInputEdges &= ~(INPUT_BUTTON1 | INPUT_BUTTON2);
+                    KeAcknowledgeInputEdges(INPUT_BUTTON1 | INPUT_BUTTON2);
                     CurrentLevel += 1;
                     if (CurrentLevel == SOKOBAN_LEVELS) {
                         CurrentLevel = 0;
@@ -324,7 +404,7 @@ Return Value:
                 //
 
                 if ((KeInputEdges & INPUT_BUTTON1) != 0) {
-                    KeInputEdges &= ~INPUT_BUTTON1;
+                    KeAcknowledgeInputEdges(INPUT_BUTTON1);
                     break;
                 }
             }
@@ -335,7 +415,7 @@ Return Value:
             //
 
             if ((KeInputEdges & INPUT_UP1) != 0) {
-                KeInputEdges &= ~INPUT_UP1;
+                KeAcknowledgeInputEdges(INPUT_UP1);
                 if ((KeRawInputs & INPUT_BUTTON2) != 0) {
                     CurrentLevel += 1;
                     if (CurrentLevel == SOKOBAN_LEVELS) {
@@ -347,13 +427,14 @@ Return Value:
             }
 
             if ((KeInputEdges & INPUT_DOWN1) != 0) {
-                KeInputEdges &= ~INPUT_DOWN1;
+                KeAcknowledgeInputEdges(INPUT_DOWN1);
                 if ((KeRawInputs & INPUT_BUTTON2) != 0) {
-                    CurrentLevel -= 1;
-                    if (CurrentLevel == 0xFF) {
-                        CurrentLevel = SOKOBAN_LEVELS - 1;
+                    if (CurrentLevel == 0) {
+                        CurrentLevel = SOKOBAN_LEVELS;
                     }
 
+                    CurrentLevel -= 1;
+
                     break;
                 }
             }
@@ -366,8 +447,13 @@ Return Value:
             if (((KeRawInputs & INPUT_BUTTON1) != 0) &&
                 ((KeRawInputs & INPUT_BUTTON2) != 0)) {
 
-                SokobanCompletedLevels1 = 0;
-                SokobanCompletedLevels2 = 0;
+                for (CurrentLevel = 0;
+                     CurrentLevel < SOKOBAN_COMPLETED_SIZE;
+                     CurrentLevel += 1) {
+
+                    SokobanCompletedLevels[CurrentLevel] = 0;
+                }
+
                 CurrentLevel = 0;
                 break;
             }
@@ -389,7 +475,7 @@ Return Value:
 
 VOID
 SkpPaintLevelIndicator (
-    UCHAR CurrentLevel
+    USHORT CurrentLevel
     )
 
 /*++
@@ -411,40 +497,29 @@ Return Value:
 
 {
 
-    USHORT CompletedLevels;
-    UCHAR Level;
+    UCHAR Index;
+    USHORT Level;
     USHORT Pixel;
 
-    CompletedLevels = SokobanCompletedLevels1;
-    for (Level = 0; Level < 16; Level += 1) {
-        if (Level == CurrentLevel) {
-            Pixel = RGB_PIXEL(0x10, 0x10, 0x10);
-
-        } else if ((CompletedLevels & 0x1) != 0) {
-            Pixel = RGB_PIXEL(0x0, 0x10, 0x0);
-
-        } else {
-            Pixel = RGB_PIXEL(0x10, 0x0, 0x0);
-        }
-
-        KeMatrix[SOKOBAN_LEVEL_METER_Y][SOKOBAN_LEVEL_METER_X + Level] = Pixel;
-        CompletedLevels = CompletedLevels >> 1;
-    }
+    Level = CurrentLevel - (CurrentLevel % SOKOBAN_LEVEL_METER_WIDTH);
+    for (Index = 0; Index < SOKOBAN_LEVEL_METER_WIDTH; Index += 1) {
+        if (Level >= SOKOBAN_LEVELS) {
+            Pixel = 0;
 
-    CompletedLevels = SokobanCompletedLevels2;
-    for (Level = 16; Level < SOKOBAN_LEVELS; Level += 1) {
-        if (Level == CurrentLevel) {
+        } else if (Level == CurrentLevel) {
             Pixel = RGB_PIXEL(0x10, 0x10, 0x10);
 
-        } else if ((CompletedLevels & 0x1) != 0) {
+        } else if ((SokobanCompletedLevels[Level / 8] &
+                    (1 << (Level % 8))) != 0) {
+
             Pixel = RGB_PIXEL(0x0, 0x10, 0x0);
 
         } else {
             Pixel = RGB_PIXEL(0x10, 0x0, 0x0);
         }
 
-        KeMatrix[SOKOBAN_LEVEL_METER_Y][SOKOBAN_LEVEL_METER_X + Level] = Pixel;
-        CompletedLevels = CompletedLevels >> 1;
+        KeMatrix[SOKOBAN_LEVEL_METER_Y][SOKOBAN_LEVEL_METER_X + Index] = Pixel;
+        Level += 1;
     }
 
     return;
@@ -452,7 +527,7 @@ Return Value:
 
 VOID
 SkpPaintLevel (
-    UCHAR Level,
+    USHORT Level,
     PUCHAR CharacterX,
     PUCHAR CharacterY
     )
@@ -461,7 +536,8 @@ SkpPaintLevel (
 
 Routine Description:
 
-    This routine paints the level map onto the matrix.
+    This routine paints the level map onto the matrix, decompressing it
+    straight out of flash.
 
 Arguments:
 
@@ -481,41 +557,159 @@ Return Value:
 
 {
 
-    UCHAR Byte;
-    UCHAR ByteIndex;
-    UCHAR PixelIndex;
+    UCHAR Bit;
+    USHORT Length;
+    UCHAR NeighborX;
+    UCHAR NeighborY;
+    USHORT Pixel;
+    UCHAR Previous;
+    SOKOBAN_READER Reader;
     USHORT StartingPosition;
+    UCHAR Type;
     UCHAR XPixel;
     UCHAR YPixel;
+    UCHAR Zeros;
 
+    //
+    // Everything starts out undecided. Cells outside the floor stay that way
+    // unless some floor next to them makes them a wall.
+    //
+
+    GrFillRectangle(SOKOBAN_LEVEL_X,
+                    SOKOBAN_LEVEL_Y,
+                    SOKOBAN_WIDTH,
+                    SOKOBAN_HEIGHT,
+                    SOKOBAN_UNDECIDED);
+
+    Reader.Offset = RtlReadProgramSpace16(&(SokobanLevelOffset[Level]));
+    Reader.OffsetEnd = RtlReadProgramSpace16(&(SokobanLevelOffset[Level + 1]));
+    Reader.Bits = 0;
+    Reader.BitsLeft = 0;
+    Previous = SOKOBAN_RUN_FLOOR;
     XPixel = SOKOBAN_LEVEL_X;
     YPixel = SOKOBAN_LEVEL_Y;
-    for (ByteIndex = 0; ByteIndex < SOKOBAN_LEVEL_SIZE; ByteIndex += 1) {
-        Byte = RtlReadProgramSpace8(&(SokobanData[Level][ByteIndex]));
-        for (PixelIndex = 0; PixelIndex < 4; PixelIndex += 1) {
-            switch ((Byte >> (2 * PixelIndex)) & 0x3) {
-            case SOKOBAN_CELL_FREE:
-                KeMatrix[YPixel][XPixel] = SOKOBAN_FREE;
-                break;
+    while (YPixel < (SOKOBAN_LEVEL_Y + SOKOBAN_HEIGHT)) {
 
-            case SOKOBAN_CELL_WALL:
-                KeMatrix[YPixel][XPixel] = SOKOBAN_WALL;
-                break;
+        //
+        // Read the run type, which leaves out the previous run's type.
+        //
 
-            case SOKOBAN_CELL_BEAN:
-                KeMatrix[YPixel][XPixel] = SOKOBAN_BEAN;
+        Type = 0;
+        do {
+            Bit = SkpReadBit(&Reader);
+            if (Bit != 1) {
                 break;
+            }
+
+            Type += 1;
+
+        } while (Type < (SOKOBAN_RUN_TYPES - 2));
+
+        if (Bit == SOKOBAN_END_OF_LEVEL) {
+            break;
+        }
+
+        if (Type >= Previous) {
+            Type += 1;
+        }
+
+        Previous = Type;
 
-            case SOKOBAN_CELL_GOAL:
-                KeMatrix[YPixel][XPixel] = SOKOBAN_GOAL | PIXEL_USER_BIT;
+        //
+        // Read the run length. Running out of data here means the padding at
+        // the end of the level was reached.
+        //
+
+        Zeros = 0;
+        while (TRUE) {
+            Bit = SkpReadBit(&Reader);
+            if (Bit != 0) {
                 break;
             }
 
+            Zeros += 1;
+        }
+
+        if (Bit == SOKOBAN_END_OF_LEVEL) {
+            break;
+        }
+
+        Length = 1;
+        while (Zeros != 0) {
+            Length = (Length << 1) | SkpReadBit(&Reader);
+            Zeros -= 1;
+        }
+
+        Pixel = SOKOBAN_FREE;
+        if (Type == SOKOBAN_RUN_BEAN) {
+            Pixel = SOKOBAN_BEAN;
+
+        } else if (Type == SOKOBAN_RUN_GOAL) {
+            Pixel = SOKOBAN_GOAL | PIXEL_USER_BIT;
+
+        } else if (Type == SOKOBAN_RUN_BEAN_ON_GOAL) {
+            Pixel = SOKOBAN_BEAN | SOKOBAN_GOAL | PIXEL_USER_BIT;
+
+        } else if (Type == SOKOBAN_RUN_WALL) {
+            Pixel = SOKOBAN_WALL;
+        }
+
+        //
+        // Paint the run. Floor cells turn any undecided cells around them into
+        // walls. The compiler never puts floor on the edge of the playing
+        // field, so the neighbors are always on it.
+        //
+
+        while ((Length != 0) &&
+               (YPixel < (SOKOBAN_LEVEL_Y + SOKOBAN_HEIGHT))) {
+
+            if (Type == SOKOBAN_RUN_WALL) {
+                KeMatrix[YPixel][XPixel] = Pixel;
+
+            } else if (Type != SOKOBAN_RUN_OUTSIDE) {
+                KeMatrix[YPixel][XPixel] = Pixel;
+                for (NeighborY = YPixel - 1;
+                     NeighborY <= YPixel + 1;
+                     NeighborY += 1) {
+
+                    for (NeighborX = XPixel - 1;
+                         NeighborX <= XPixel + 1;
+                         NeighborX += 1) {
+
+                        if (KeMatrix[NeighborY][NeighborX] ==
+                            SOKOBAN_UNDECIDED) {
+
+                            KeMatrix[NeighborY][NeighborX] = SOKOBAN_WALL;
+                        }
+                    }
+                }
+            }
+
             XPixel += 1;
             if (XPixel == (SOKOBAN_LEVEL_X + SOKOBAN_WIDTH)) {
                 XPixel = SOKOBAN_LEVEL_X;
                 YPixel += 1;
             }
+
+            Length -= 1;
+        }
+    }
+
+    //
+    // Whatever is still undecided is empty space.
+    //
+
+    for (YPixel = SOKOBAN_LEVEL_Y;
+         YPixel < (SOKOBAN_LEVEL_Y + SOKOBAN_HEIGHT);
+         YPixel += 1) {
+
+        for (XPixel = SOKOBAN_LEVEL_X;
+             XPixel < (SOKOBAN_LEVEL_X + SOKOBAN_WIDTH);
+             XPixel += 1) {
+
+            if (KeMatrix[YPixel][XPixel] == SOKOBAN_UNDECIDED) {
+                KeMatrix[YPixel][XPixel] = SOKOBAN_FREE;
+            }
         }
     }
 
@@ -525,15 +719,60 @@ Return Value:
                    SOKOBAN_ORIGIN_MASK) + SOKOBAN_LEVEL_Y;
 
     //
-    // Paint our hero.
+    // Paint our hero, keeping the mark of a goal underneath.
     //
 
     XPixel = *CharacterX;
     YPixel = *CharacterY;
-    KeMatrix[YPixel][XPixel] = SOKOBAN_HERO;
+    KeMatrix[YPixel][XPixel] = (KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) |
+                               SOKOBAN_HERO;
+
     return;
 }
 
+UCHAR
+SkpReadBit (
+    PSOKOBAN_READER Reader
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the next bit of a compressed level out of flash.
+
+Arguments:
+
+    Reader - Supplies a pointer to the position within the level.
+
+Return Value:
+
+    Returns the next bit, 0 or 1.
+
+    Returns SOKOBAN_END_OF_LEVEL if the level's data has run out.
+
+--*/
+
+{
+
+    UCHAR Bit;
+
+    if (Reader->BitsLeft == 0) {
+        if (Reader->Offset == Reader->OffsetEnd) {
+            return SOKOBAN_END_OF_LEVEL;
+        }
+
+        Reader->Bits = RtlReadProgramSpace8(&(SokobanData[Reader->Offset]));
+        Reader->Offset += 1;
+        Reader->BitsLeft = 8;
+    }
+
+    Bit = Reader->Bits >> 7;
+    Reader->Bits <<= 1;
+    Reader->BitsLeft -= 1;
+    return Bit;
+}
+
 UCHAR
 SkpIsLevelComplete (
     VOID
@@ -595,3 +834,68 @@ Return Value:
     return TRUE;
 }
 
+VOID
+SkpPrintPushes (
+    USHORT Level,
+    USHORT Pushes
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the level's par, if the levels have pars, and the
+    number of pushes made so far onto the LCD.
+
+Arguments:
+
+    Level - Supplies the current level.
+
+    Pushes - Supplies the number of pushes made so far in this level.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCHAR End;
+    CHAR Line[LCD_LINE_LENGTH + 1];
+
+    HlClearLcdScreen();
+
+    //
+    // The level compiler only generates the pars once it has solved every
+    // level.
+    //
+
+#ifdef SOKOBAN_HAS_PARS
+
+    HlSetLcdAddress(LCD_FIRST_LINE);
+    Line[0] = 'P';
+    Line[1] = 'a';
+    Line[2] = 'r';
+    Line[3] = ' ';
+    End = KeFormatDecimal(&(Line[4]),
+                          RtlReadProgramSpace16(&(SokobanParPushes[Level])));
+
+    *End = '\0';
+    HlLcdPrintString(Line);
+
+#endif
+
+    HlSetLcdAddress(LCD_SECOND_LINE);
+    Line[0] = 'P';
+    Line[1] = 'u';
+    Line[2] = 's';
+    Line[3] = 'h';
+    Line[4] = 'e';
+    Line[5] = 's';
+    Line[6] = ' ';
+    End = KeFormatDecimal(&(Line[7]), Pushes);
+    *End = '\0';
+    HlLcdPrintString(Line);
+    return;
+}
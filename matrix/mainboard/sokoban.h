@@ -32,16 +32,61 @@ Author:
 #define SOKOBAN_HEIGHT 16
 
 //
-// Define the number of levels in the game.
+// Define the number of levels in the game. Each level costs about 40 bytes of
+// compressed data in flash, plus 6 bytes in the offset, starting position
+// and par tables.
 //
 
 #define SOKOBAN_LEVELS 20
 
 //
-// Define the size, in bytes, of one level.
+// Define the number of cells in one level.
 //
 
-#define SOKOBAN_LEVEL_SIZE (SOKOBAN_WIDTH * SOKOBAN_HEIGHT * 2 / 8)
+#define SOKOBAN_LEVEL_CELLS (SOKOBAN_WIDTH * SOKOBAN_HEIGHT)
+
+//
+// Define the size, in bytes, of the bitmap tracking completed levels.
+//
+
+#define SOKOBAN_COMPLETED_SIZE ((SOKOBAN_LEVELS + 7) / 8)
+
+//
+// Define how levels are compressed. Only the floor is coded: every cell the
+// player can reach from the starting position, along with every bean and
+// goal. The walls are implied, as any other cell touching the floor (even at
+// a corner) is a wall, and the rest are empty. The playing field is coded in
+// row order as a series of runs, each a run type followed by a length, as a
+// stream of bits packed most significant bit first.
+//
+// The run type is its position in the list below, leaving out the type of the
+// previous run (two runs in a row never have the same type), coded as 0, 10,
+// 110, 1110 or 1111. The first run is coded as if it came after a floor run.
+// The length is an Elias gamma code: N zero bits followed by the N + 1 bits of
+// the length, starting with its leading one.
+//
+// A level ends when its bytes (as given by the offset table) are used up, and
+// any cells not yet covered are outside the floor. The zero bits padding out
+// the last byte run out in the middle of a length, so they decode harmlessly.
+//
+//     0 - Floor
+//     1 - Outside the floor, a wall or empty as implied
+//     2 - Bean
+//     3 - Goal
+//     4 - Bean on a goal
+//     5 - Wall that doesn't touch the floor
+//
+// The player's starting position is stored separately. The cell under the
+// player is coded as floor, or as a goal if the player starts on one.
+//
+
+#define SOKOBAN_RUN_FLOOR 0
+#define SOKOBAN_RUN_OUTSIDE 1
+#define SOKOBAN_RUN_BEAN 2
+#define SOKOBAN_RUN_GOAL 3
+#define SOKOBAN_RUN_BEAN_ON_GOAL 4
+#define SOKOBAN_RUN_WALL 5
+#define SOKOBAN_RUN_TYPES 6
 
 //
 // Define the types of cells.
@@ -51,6 +96,7 @@ Author:
 #define SOKOBAN_CELL_WALL 1
 #define SOKOBAN_CELL_BEAN 2
 #define SOKOBAN_CELL_GOAL 3
+#define SOKOBAN_CELL_BEAN_ON_GOAL 4
 
 //
 // Define how the origin is encoded.
@@ -68,10 +114,17 @@ Author:
 //
 
 //
-// Define a global containing the packed level maps.
+// Define a global containing the compressed level maps, back to back.
+//
+
+extern const UCHAR SokobanData[] PROGMEM;
+
+//
+// Define a global containing the offset of each level's data within the
+// level maps. The extra entry at the end marks the end of the last level.
 //
 
-extern const UCHAR SokobanData[SOKOBAN_LEVELS][SOKOBAN_LEVEL_SIZE] PROGMEM;
+extern const USHORT SokobanLevelOffset[SOKOBAN_LEVELS + 1] PROGMEM;
 
 //
 // Define a global containing the initial user starting position.
@@ -79,6 +132,60 @@ extern const UCHAR SokobanData[SOKOBAN_LEVELS][SOKOBAN_LEVEL_SIZE] PROGMEM;
 
 extern const USHORT SokobanStartingPosition[SOKOBAN_LEVELS] PROGMEM;
 
+//
+// Define a global containing the optimal number of pushes for each level. The
+// level compiler only generates this, and defines SOKOBAN_HAS_PARS in
+// assets.h, once it has solved every level.
+//
+
+extern const USHORT SokobanParPushes[SOKOBAN_LEVELS] PROGMEM;
+
 //
 // -------------------------------------------------------- Function Prototypes
 //
+
+//
+// Level Compiler Functions
+//
+
+UCHAR
+SolveSokobanLevels (
+    PUCHAR Levels,
+    PUSHORT StartingPositions,
+    ULONG LevelCount,
+    ULONG ThreadCount,
+    PUSHORT ParPushes
+    );
+
+/*++
+
+Routine Description:
+
+    This routine finds the optimal number of pushes for a set of levels. The
+    levels are solved one after another, with every thread sharing each
+    level's search. It is only available to the host build tools.
+
+Arguments:
+
+    Levels - Supplies a pointer to the uncompressed levels, one cell per byte
+        and SOKOBAN_LEVEL_CELLS bytes per level.
+
+    StartingPositions - Supplies a pointer to the player's starting position in
+        each level, encoded the same way as SokobanStartingPosition.
+
+    LevelCount - Supplies the number of levels.
+
+    ThreadCount - Supplies the number of threads to solve with.
+
+    ParPushes - Supplies a pointer where the optimal number of pushes for each
+        level will be returned. Levels that could not be solved within the
+        solver's limits get zero.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver's memory or threads could not be allocated.
+
+--*/
+
@@ -0,0 +1,3039 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    sokosolv.c
+
+Abstract:
+
+    This module implements a Sokoban solver used by the level compiler to find
+    the optimal number of pushes for each level.
+
+Author:
+
+    Evan Green 28-Nov-2010
+
+Environment:
+
+    Build
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "sokoban.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the largest number of floor cells (cells the player can reach if
+// there were no beans) a level can have and still be solved.
+//
+
+#define SOLVER_MAX_FLOOR 256
+#define SOLVER_BOX_WORDS (SOLVER_MAX_FLOOR / 64)
+
+//
+// Define the largest number of goals a level can have and still be solved.
+//
+
+#define SOLVER_MAX_GOALS 32
+
+//
+// Define how much memory one level's search may use before the solver gives
+// up on it. It is split evenly between the threads. Each state costs its
+// packed size plus about twenty bytes of hash and queue space, so a typical
+// level gets tens of millions of states.
+//
+
+#define SOLVER_MAX_MEMORY (2ULL << 30)
+
+//
+// Define the fewest states per thread the solver will settle for if it can't
+// get the full budget, as on a 32-bit host.
+//
+
+#define SOLVER_MIN_STATES (1UL << 16)
+
+//
+// Define the most threads that can share one search.
+//
+
+#define SOLVER_MAX_THREADS 64
+
+//
+// Define the number of states batched up for another thread before they are
+// handed over. Whatever is batched is handed over after each state is
+// expanded anyway.
+//
+
+#define SOLVER_BATCH_SIZE 256
+
+//
+// Define the largest estimated solution length the open list can hold.
+//
+
+#define SOLVER_MAX_COST 1024
+
+//
+// Define the value used for a floor cell that doesn't exist.
+//
+
+#define SOLVER_NO_CELL 0xFFFF
+
+//
+// Define the value used to mark an invalid distance.
+//
+
+#define SOLVER_INFINITE_DISTANCE 0xFFFF
+
+//
+// Define the value used for a cell not in any area.
+//
+
+#define SOLVER_NO_AREA 0xFF
+
+//
+// Define the four directions. Opposite directions differ only in the low bit.
+//
+
+#define SOLVER_LEFT 0
+#define SOLVER_RIGHT 1
+#define SOLVER_UP 2
+#define SOLVER_DOWN 3
+#define SOLVER_DIRECTIONS 4
+#define SOLVER_OPPOSITE(_Direction) ((_Direction) ^ 0x1)
+
+//
+// Define the state flags.
+//
+
+#define SOLVER_STATE_EXPANDED 0x1
+
+//
+// Define the value used for a state that isn't in the hash table.
+//
+
+#define SOLVER_NO_STATE 0xFFFFFFFF
+
+//
+// Define the corral flags.
+//
+
+#define SOLVER_CORRAL_OFF_GOAL 0x1
+#define SOLVER_CORRAL_OPEN 0x2
+
+//
+// Define the size of a packed state with no beans, and the largest packed
+// state.
+//
+
+#define SOLVER_RECORD_HEADER_SIZE offsetof(SOLVER_RECORD, Boxes)
+#define SOLVER_MAX_RECORD_SIZE \
+    ALIGN_RANGE_UP(SOLVER_RECORD_HEADER_SIZE + (SOLVER_MAX_FLOOR / 8), \
+                   sizeof(ULONGLONG))
+
+//
+// This macro returns the packed state at the given index.
+//
+
+#define SOLVER_RECORD_AT(_Context, _Index) \
+    ((PSOLVER_RECORD)((_Context)->Records + \
+                      ((ULONGLONG)(_Index) * (_Context)->RecordSize)))
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef unsigned char BOOL, *PBOOL;
+
+typedef struct _SOLVER_STATE {
+    ULONGLONG Boxes[SOLVER_BOX_WORDS];
+    USHORT Player;
+    USHORT Pushes;
+    USHORT Estimate;
+    USHORT Flags;
+} SOLVER_STATE, *PSOLVER_STATE;
+
+/*++
+
+Structure Description:
+
+    This structure stores the position being worked on, normalized so that
+    positions differing only in where the player stands within the same area
+    compare equal. States are only kept this way while they're worked on;
+    they're stored packed.
+
+Members:
+
+    Boxes - Stores a bitmap of the floor cells that have beans on them.
+
+    Player - Stores the lowest numbered floor cell the player can reach, which
+        identifies the area the player is in.
+
+    Pushes - Stores the fewest pushes found so far to reach this state.
+
+    Estimate - Stores the lower bound on the pushes left to solve the level.
+
+    Flags - Stores a bitfield of flags. See SOLVER_STATE_* definitions.
+
+--*/
+
+typedef struct _SOLVER_RECORD {
+    USHORT Pushes;
+    USHORT Estimate;
+    UCHAR Flags;
+    UCHAR Player;
+    UCHAR Boxes[ANYSIZE_ARRAY];
+} SOLVER_RECORD, *PSOLVER_RECORD;
+
+/*++
+
+Structure Description:
+
+    This structure stores a packed state. The player and beans together form
+    the key the state is found by, and the bean bitmap only has as many bytes
+    as the level needs.
+
+Members:
+
+    Pushes - Stores the fewest pushes found so far to reach this state.
+
+    Estimate - Stores the lower bound on the pushes left to solve the level.
+
+    Flags - Stores a bitfield of flags. See SOLVER_STATE_* definitions.
+
+    Player - Stores the lowest numbered floor cell the player can reach.
+
+    Boxes - Stores a bitmap of the floor cells that have beans on them, eight
+        cells per byte.
+
+--*/
+
+typedef struct _SOLVER_QUEUE_ENTRY {
+    ULONG State;
+    ULONG Next;
+} SOLVER_QUEUE_ENTRY, *PSOLVER_QUEUE_ENTRY;
+
+/*++
+
+Structure Description:
+
+    This structure stores an entry on the open list. A state can be on the list
+    more than once if a shorter path to it is found; the stale entries are
+    skipped when they come up.
+
+Members:
+
+    State - Stores the index of the state.
+
+    Next - Stores the index of the next entry in the same bucket, plus one.
+
+--*/
+
+typedef struct _SOLVER_SEARCH SOLVER_SEARCH, *PSOLVER_SEARCH;
+
+typedef struct _SOLVER_CONTEXT {
+    PSOLVER_SEARCH Search;
+    ULONG ThreadIndex;
+    ULONG FloorCount;
+    USHORT FloorOfCell[SOKOBAN_LEVEL_CELLS];
+    USHORT Neighbor[SOLVER_MAX_FLOOR][SOLVER_DIRECTIONS];
+    UCHAR Goal[SOLVER_MAX_FLOOR];
+    UCHAR Dead[SOLVER_MAX_FLOOR];
+    ULONG GoalCount;
+    USHORT GoalFloor[SOLVER_MAX_GOALS];
+    USHORT Distance[SOLVER_MAX_GOALS][SOLVER_MAX_FLOOR][SOLVER_DIRECTIONS];
+    UCHAR Area[SOLVER_MAX_FLOOR][SOLVER_MAX_FLOOR];
+    ULONG Reachable[SOLVER_MAX_FLOOR];
+    ULONG ReachableStamp;
+    ULONG Stamp[SOLVER_MAX_FLOOR];
+    ULONG CurrentStamp;
+    USHORT Work[SOLVER_MAX_FLOOR];
+    UCHAR FrozenWall[SOLVER_MAX_FLOOR];
+    USHORT Corral[SOLVER_MAX_FLOOR];
+    USHORT CorralPushes[SOLVER_MAX_FLOOR];
+    UCHAR CorralFlags[SOLVER_MAX_FLOOR];
+    ULONG BoxBytes;
+    ULONG KeySize;
+    ULONG RecordSize;
+    PUCHAR Records;
+    ULONG StateCount;
+    ULONG MaxStates;
+    PULONG Hash;
+    ULONG HashSize;
+    PSOLVER_QUEUE_ENTRY Queue;
+    ULONG QueueCount;
+    ULONG MaxQueue;
+    PUCHAR Outbox;
+    ULONG OutboxCount[SOLVER_MAX_THREADS];
+    USHORT OutboxEstimate;
+    PUCHAR Inbox;
+    ULONG InboxCount;
+    ULONG InboxCapacity;
+    PUCHAR Incoming;
+    ULONG IncomingCapacity;
+    ULONG Pending[SOLVER_MAX_COST];
+    ULONG Bucket[SOLVER_MAX_COST][SOLVER_MAX_COST];
+} SOLVER_CONTEXT, *PSOLVER_CONTEXT;
+
+/*++
+
+Structure Description:
+
+    This structure stores everything one thread needs to work on its share of
+    a level's search. Each state is owned by one thread, picked by its hash,
+    and only that thread stores, looks up, and expands it.
+
+Members:
+
+    Search - Stores a pointer to the search the thread is part of.
+
+    ThreadIndex - Stores the index of this thread within the search.
+
+    FloorCount - Stores the number of floor cells in the level.
+
+    FloorOfCell - Stores the floor index of each cell in the level, or
+        SOLVER_NO_CELL for cells the player can never reach.
+
+    Neighbor - Stores the floor index of each floor cell's neighbor in each
+        direction, or SOLVER_NO_CELL if there is none.
+
+    Goal - Stores whether or not each floor cell is a goal.
+
+    Dead - Stores whether or not a bean on each floor cell can never be pushed
+        to any goal.
+
+    GoalCount - Stores the number of goals in the level.
+
+    GoalFloor - Stores the floor cell of each goal.
+
+    Distance - Stores the fewest pushes it takes a lone bean to get from each
+        floor cell to each goal, starting with the player on each side of it.
+
+    Area - Stores, for a bean on each floor cell, which of the areas around it
+        each other floor cell is in. The player can only get to the sides of
+        the bean in its own area without pushing it.
+
+    Reachable - Stores the cells the player can walk to in the state being
+        expanded, marked with the reachable stamp.
+
+    ReachableStamp - Stores the value in the reachable array meaning the
+        player can walk there.
+
+    Stamp - Stores scratch space used to mark visited cells without clearing.
+
+    CurrentStamp - Stores the value in the stamp array meaning visited.
+
+    Work - Stores scratch space used as a search queue.
+
+    FrozenWall - Stores scratch space marking beans treated as walls by the
+        frozen bean check.
+
+    Corral - Stores the corral each cell the player can't reach belongs to,
+        in the state being expanded. Corrals are numbered from zero.
+
+    CorralPushes - Stores the number of pushes into each corral.
+
+    CorralFlags - Stores a bitfield of flags for each corral. See
+        SOLVER_CORRAL_* definitions.
+
+    BoxBytes - Stores the number of bytes in a packed bean bitmap.
+
+    KeySize - Stores the number of bytes of a packed state that identify it,
+        starting at the player.
+
+    RecordSize - Stores the size of a packed state.
+
+    Records - Stores the array of packed states this thread owns.
+
+    StateCount - Stores the number of valid entries in the records array.
+
+    MaxStates - Stores the number of entries the records array can hold.
+
+    Hash - Stores the open addressed hash table of states, holding state
+        indices plus one.
+
+    HashSize - Stores the number of slots in the hash table.
+
+    Queue - Stores the array of open list entries.
+
+    QueueCount - Stores the number of entries allocated from the queue array.
+
+    MaxQueue - Stores the number of entries the queue array can hold.
+
+    Outbox - Stores a batch of packed states for each other thread, waiting to
+        be handed over.
+
+    OutboxCount - Stores the number of states in each thread's batch.
+
+    OutboxEstimate - Stores the lowest estimate any of the batched states can
+        have, one less than the estimate of the state being expanded.
+
+    Inbox - Stores the packed states other threads have handed over. This is
+        protected by the search lock.
+
+    InboxCount - Stores the number of states in the inbox.
+
+    InboxCapacity - Stores the number of states the inbox can hold.
+
+    Incoming - Stores the previous inbox, which the thread works through
+        without holding the lock.
+
+    IncomingCapacity - Stores the number of states the incoming array can
+        hold.
+
+    Pending - Stores the number of open list entries at each estimated total
+        solution length.
+
+    Bucket - Stores the head of the open list (plus one) for each estimated
+        total solution length and estimated number of pushes left. Among
+        states with the same total, the ones closest to done are expanded
+        first.
+
+--*/
+
+struct _SOLVER_SEARCH {
+    pthread_mutex_t Lock;
+    pthread_cond_t Condition;
+    PSOLVER_CONTEXT Contexts[SOLVER_MAX_THREADS];
+    ULONG ThreadCount;
+    ULONG Running;
+    ULONG Cost;
+    ULONG NextCost;
+    ULONG Outstanding;
+    ULONG Arrived;
+    ULONG Generation;
+    BOOL LayerDone;
+    volatile BOOL Stop;
+    USHORT Result;
+    volatile USHORT Lowest[SOLVER_MAX_THREADS];
+};
+
+/*++
+
+Structure Description:
+
+    This structure stores the state shared by the threads working on one
+    level. The threads expand every state of one estimated total solution
+    length together, then agree on the next length. Since the estimate never
+    drops by more than one per push, the first solution found is optimal no
+    matter which thread finds it.
+
+Members:
+
+    Lock - Stores the lock protecting the rest of the search and every
+        thread's inbox.
+
+    Condition - Stores the condition signaled when states are handed over or
+        the search moves on.
+
+    Contexts - Stores a pointer to each thread's context.
+
+    ThreadCount - Stores the number of threads the states are divided between.
+
+    Running - Stores the number of threads actually working on the search.
+
+    Cost - Stores the estimated total solution length being expanded.
+
+    NextCost - Stores the lowest estimated total above the current one any
+        thread has waiting, while the threads are moving on.
+
+    Outstanding - Stores the number of threads still busy plus the number of
+        states handed over and not yet taken. Once this drops to zero every
+        state of the current length has been expanded.
+
+    Arrived - Stores the number of threads waiting to move on.
+
+    Generation - Stores a counter bumped each time the threads move on.
+
+    LayerDone - Stores whether or not every state of the current length has
+        been expanded.
+
+    Stop - Stores whether or not the search is over.
+
+    Result - Stores the optimal number of pushes, or zero if no solution was
+        found.
+
+    Lowest - Stores the lowest estimated number of pushes left among the
+        states each thread has waiting at the current length, or
+        SOLVER_INFINITE_DISTANCE if it has none.
+
+--*/
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+USHORT
+SolveSokobanLevel (
+    PSOLVER_SEARCH Search,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PULONG StatesExplored
+    );
+
+BOOL
+SolverAllocateTables (
+    PSOLVER_CONTEXT Context,
+    ULONG ThreadCount
+    );
+
+VOID
+SolverFreeTables (
+    PSOLVER_CONTEXT Context
+    );
+
+PVOID
+SolverSearchThread (
+    PVOID Parameter
+    );
+
+VOID
+SolverSearchLayer (
+    PSOLVER_CONTEXT Context
+    );
+
+BOOL
+SolverWaitForThreads (
+    PSOLVER_CONTEXT Context
+    );
+
+VOID
+SolverStopSearch (
+    PSOLVER_CONTEXT Context,
+    USHORT Pushes
+    );
+
+BOOL
+SolverExpandState (
+    PSOLVER_CONTEXT Context,
+    ULONG StateIndex
+    );
+
+BOOL
+SolverDispatchState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record
+    );
+
+BOOL
+SolverSendStates (
+    PSOLVER_CONTEXT Context,
+    ULONG Destination
+    );
+
+BOOL
+SolverReceiveStates (
+    PSOLVER_CONTEXT Context
+    );
+
+BOOL
+SolverReceiveState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Hash
+    );
+
+BOOL
+SolverInitializeLevel (
+    PSOLVER_CONTEXT Context,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PSOLVER_STATE Start
+    );
+
+VOID
+SolverComputeDistances (
+    PSOLVER_CONTEXT Context
+    );
+
+USHORT
+SolverEstimate (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State
+    );
+
+USHORT
+SolverNormalizePlayer (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Player
+    );
+
+BOOL
+SolverIsFrozen (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Box,
+    PBOOL OffGoal
+    );
+
+BOOL
+SolverIsBlocked (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Box,
+    ULONG Direction,
+    PBOOL OffGoal
+    );
+
+USHORT
+SolverFindCorral (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State
+    );
+
+VOID
+SolverPackState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    PSOLVER_RECORD Record
+    );
+
+VOID
+SolverUnpackState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    PSOLVER_STATE State
+    );
+
+ULONG
+SolverFindState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Hash,
+    PULONG Slot
+    );
+
+BOOL
+SolverAddState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Slot
+    );
+
+BOOL
+SolverQueueState (
+    PSOLVER_CONTEXT Context,
+    ULONG StateIndex
+    );
+
+USHORT
+SolverPeekState (
+    PSOLVER_CONTEXT Context,
+    ULONG Cost
+    );
+
+ULONG
+SolverPopState (
+    PSOLVER_CONTEXT Context,
+    ULONG Cost
+    );
+
+ULONG
+SolverHashKey (
+    PUCHAR Key,
+    ULONG Size
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+UCHAR
+SolveSokobanLevels (
+    PUCHAR Levels,
+    PUSHORT StartingPositions,
+    ULONG LevelCount,
+    ULONG ThreadCount,
+    PUSHORT ParPushes
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the optimal number of pushes for a set of levels. The
+    levels are solved one after another, with every thread sharing each
+    level's search.
+
+Arguments:
+
+    Levels - Supplies a pointer to the uncompressed levels, one cell per byte
+        and SOKOBAN_LEVEL_CELLS bytes per level.
+
+    StartingPositions - Supplies a pointer to the player's starting position in
+        each level, encoded the same way as SokobanStartingPosition.
+
+    LevelCount - Supplies the number of levels.
+
+    ThreadCount - Supplies the number of threads to solve with.
+
+    ParPushes - Supplies a pointer where the optimal number of pushes for each
+        level will be returned. Levels that could not be solved within the
+        solver's limits get zero.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver's memory or threads could not be allocated.
+
+--*/
+
+{
+
+    ULONG Level;
+    BOOL Result;
+    SOLVER_SEARCH Search;
+    ULONG StatesExplored;
+    ULONG ThreadIndex;
+
+    memset(ParPushes, 0, LevelCount * sizeof(USHORT));
+    if (ThreadCount == 0) {
+        ThreadCount = 1;
+    }
+
+    if (ThreadCount > SOLVER_MAX_THREADS) {
+        ThreadCount = SOLVER_MAX_THREADS;
+    }
+
+    memset(&Search, 0, sizeof(SOLVER_SEARCH));
+    pthread_mutex_init(&(Search.Lock), NULL);
+    pthread_cond_init(&(Search.Condition), NULL);
+    Search.ThreadCount = ThreadCount;
+    Result = TRUE;
+    for (ThreadIndex = 0; ThreadIndex < ThreadCount; ThreadIndex += 1) {
+        Search.Contexts[ThreadIndex] = calloc(1, sizeof(SOLVER_CONTEXT));
+        if (Search.Contexts[ThreadIndex] == NULL) {
+            fprintf(stderr, "Error: Unable to allocate solver context.\n");
+            Result = FALSE;
+            goto SolveSokobanLevelsEnd;
+        }
+
+        Search.Contexts[ThreadIndex]->Search = &Search;
+        Search.Contexts[ThreadIndex]->ThreadIndex = ThreadIndex;
+    }
+
+    for (Level = 0; Level < LevelCount; Level += 1) {
+        ParPushes[Level] = SolveSokobanLevel(
+                                       &Search,
+                                       Levels + (Level * SOKOBAN_LEVEL_CELLS),
+                                       StartingPositions[Level],
+                                       &StatesExplored);
+
+        if (Search.Running != ThreadCount) {
+            Result = FALSE;
+            break;
+        }
+
+        if (ParPushes[Level] != 0) {
+            printf("MakeSoko: Level %d solved in %d pushes (%d states).\n",
+                   (INT)Level + 1,
+                   (INT)ParPushes[Level],
+                   (INT)StatesExplored);
+
+        } else if (StatesExplored != 0) {
+            printf("MakeSoko: Level %d not solved (%d states).\n",
+                   (INT)Level + 1,
+                   (INT)StatesExplored);
+        }
+    }
+
+SolveSokobanLevelsEnd:
+    for (ThreadIndex = 0; ThreadIndex < ThreadCount; ThreadIndex += 1) {
+        free(Search.Contexts[ThreadIndex]);
+    }
+
+    pthread_cond_destroy(&(Search.Condition));
+    pthread_mutex_destroy(&(Search.Lock));
+    return Result;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+USHORT
+SolveSokobanLevel (
+    PSOLVER_SEARCH Search,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PULONG StatesExplored
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the optimal number of pushes for a single level. It runs
+    an A* search over bean positions, where each push is one step and the
+    estimate is the lower bound from SolverEstimate. Since that estimate never
+    drops by more than one per push, the first solution found is optimal. Pushes
+    that can't lead anywhere, or that can wait until a corral is dealt with,
+    are left out without losing that. The states are divided between the
+    threads by hash, and each thread expands its own.
+
+Arguments:
+
+    Search - Supplies a pointer to the search, with its thread contexts
+        allocated.
+
+    Cells - Supplies a pointer to the level's cells, one per byte.
+
+    StartingPosition - Supplies the player's starting position.
+
+    StatesExplored - Supplies a pointer where the number of states discovered
+        will be returned.
+
+Return Value:
+
+    Returns the optimal number of pushes.
+
+    0 if the level could not be solved within the solver's limits, or doesn't
+    need any pushes.
+
+--*/
+
+{
+
+    ULONG Hash;
+    ULONG Owner;
+    ULONGLONG Packed[SOLVER_MAX_RECORD_SIZE / sizeof(ULONGLONG)];
+    PSOLVER_RECORD Record;
+    USHORT Result;
+    ULONG Slot;
+    SOLVER_STATE Start;
+    pthread_t Threads[SOLVER_MAX_THREADS];
+    ULONG ThreadIndex;
+
+    Result = 0;
+    *StatesExplored = 0;
+    Search->Running = Search->ThreadCount;
+
+    //
+    // Quietly skip empty levels, which are left over when the level file has
+    // fewer levels than the game.
+    //
+
+    if ((memchr(Cells, SOKOBAN_CELL_BEAN, SOKOBAN_LEVEL_CELLS) == NULL) &&
+        (memchr(Cells, SOKOBAN_CELL_BEAN_ON_GOAL, SOKOBAN_LEVEL_CELLS) ==
+         NULL)) {
+
+        return Result;
+    }
+
+    //
+    // Every thread needs its own copy of the level's tables. The first one
+    // complains if the level is too big, and the rest can't fail after it.
+    //
+
+    if (SolverInitializeLevel(Search->Contexts[0],
+                              Cells,
+                              StartingPosition,
+                              &Start) == FALSE) {
+
+        return Result;
+    }
+
+    if (Start.Estimate == 0) {
+        return Result;
+    }
+
+    if (Start.Estimate == SOLVER_INFINITE_DISTANCE) {
+        fprintf(stderr,
+                "Warning: A level can't be solved from where it starts.\n");
+
+        return Result;
+    }
+
+    for (ThreadIndex = 1; ThreadIndex < Search->ThreadCount; ThreadIndex += 1) {
+        SolverInitializeLevel(Search->Contexts[ThreadIndex],
+                              Cells,
+                              StartingPosition,
+                              &Start);
+    }
+
+    for (ThreadIndex = 0; ThreadIndex < Search->ThreadCount; ThreadIndex += 1) {
+        if (SolverAllocateTables(Search->Contexts[ThreadIndex],
+                                 Search->ThreadCount) == FALSE) {
+
+            fprintf(stderr, "Error: Unable to allocate solver tables.\n");
+            Search->Running = 0;
+            goto SolveSokobanLevelEnd;
+        }
+    }
+
+    Search->Cost = Start.Estimate;
+    Search->NextCost = SOLVER_MAX_COST;
+    Search->Outstanding = Search->ThreadCount;
+    Search->Arrived = 0;
+    Search->LayerDone = FALSE;
+    Search->Stop = FALSE;
+    Search->Result = 0;
+    for (ThreadIndex = 0; ThreadIndex < Search->ThreadCount; ThreadIndex += 1) {
+        Search->Lowest[ThreadIndex] = SOLVER_INFINITE_DISTANCE;
+    }
+
+    Record = (PSOLVER_RECORD)Packed;
+    SolverPackState(Search->Contexts[0], &Start, Record);
+    Hash = SolverHashKey(&(Record->Player), Search->Contexts[0]->KeySize);
+    Owner = Hash % Search->ThreadCount;
+    SolverFindState(Search->Contexts[Owner], Record, Hash, &Slot);
+    SolverAddState(Search->Contexts[Owner], Record, Slot);
+
+    //
+    // Start up the other threads and do this one's share here. If a thread
+    // can't be created, the ones that were stop right away, as nobody would
+    // take their states.
+    //
+
+    for (ThreadIndex = 1; ThreadIndex < Search->ThreadCount; ThreadIndex += 1) {
+        if (pthread_create(&(Threads[ThreadIndex]),
+                           NULL,
+                           SolverSearchThread,
+                           Search->Contexts[ThreadIndex]) != 0) {
+
+            fprintf(stderr, "Error: Unable to create solver thread.\n");
+            pthread_mutex_lock(&(Search->Lock));
+            Search->Running = ThreadIndex;
+            Search->Stop = TRUE;
+            pthread_cond_broadcast(&(Search->Condition));
+            pthread_mutex_unlock(&(Search->Lock));
+            break;
+        }
+    }
+
+    SolverSearchThread(Search->Contexts[0]);
+    for (ThreadIndex = 1; ThreadIndex < Search->Running; ThreadIndex += 1) {
+        pthread_join(Threads[ThreadIndex], NULL);
+    }
+
+    Result = Search->Result;
+
+SolveSokobanLevelEnd:
+    for (ThreadIndex = 0; ThreadIndex < Search->ThreadCount; ThreadIndex += 1) {
+        *StatesExplored += Search->Contexts[ThreadIndex]->StateCount;
+        SolverFreeTables(Search->Contexts[ThreadIndex]);
+    }
+
+    return Result;
+}
+
+BOOL
+SolverAllocateTables (
+    PSOLVER_CONTEXT Context,
+    ULONG ThreadCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates a thread's share of the search tables, sized for the
+    level's packed states. If there isn't that much memory, it settles for
+    fewer states.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context, with the level
+        initialized.
+
+    ThreadCount - Supplies the number of threads sharing the search.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure.
+
+--*/
+
+{
+
+    ULONGLONG MaxStates;
+    ULONG StateSize;
+
+    StateSize = Context->RecordSize + (2 * sizeof(ULONG)) +
+                sizeof(SOLVER_QUEUE_ENTRY) +
+                (sizeof(SOLVER_QUEUE_ENTRY) / 4);
+
+    MaxStates = (SOLVER_MAX_MEMORY / ThreadCount) / StateSize;
+    if (MaxStates > MAX_ULONG / 2) {
+        MaxStates = MAX_ULONG / 2;
+    }
+
+    Context->StateCount = 0;
+    Context->QueueCount = 0;
+    Context->InboxCount = 0;
+    memset(Context->OutboxCount, 0, sizeof(Context->OutboxCount));
+    memset(Context->Pending, 0, sizeof(Context->Pending));
+    memset(Context->Bucket, 0, sizeof(Context->Bucket));
+    while (MaxStates >= SOLVER_MIN_STATES) {
+        Context->MaxStates = MaxStates;
+        Context->HashSize = Context->MaxStates * 2;
+        Context->MaxQueue = Context->MaxStates + (Context->MaxStates / 4);
+
+        //
+        // The hash table comes from calloc so that pages a small search never
+        // touches are never cleared.
+        //
+
+        Context->Records = malloc((size_t)MaxStates * Context->RecordSize);
+        Context->Hash = calloc(Context->HashSize, sizeof(ULONG));
+        Context->Queue = malloc((size_t)Context->MaxQueue *
+                                sizeof(SOLVER_QUEUE_ENTRY));
+
+        Context->Outbox = malloc(ThreadCount * SOLVER_BATCH_SIZE *
+                                 Context->RecordSize);
+
+        if ((Context->Records != NULL) &&
+            (Context->Hash != NULL) &&
+            (Context->Queue != NULL) &&
+            (Context->Outbox != NULL)) {
+
+            return TRUE;
+        }
+
+        SolverFreeTables(Context);
+        MaxStates /= 2;
+    }
+
+    return FALSE;
+}
+
+VOID
+SolverFreeTables (
+    PSOLVER_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees a thread's share of the search tables.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    free(Context->Records);
+    free(Context->Hash);
+    free(Context->Queue);
+    free(Context->Outbox);
+    free(Context->Inbox);
+    free(Context->Incoming);
+    Context->Records = NULL;
+    Context->Hash = NULL;
+    Context->Queue = NULL;
+    Context->Outbox = NULL;
+    Context->Inbox = NULL;
+    Context->InboxCapacity = 0;
+    Context->Incoming = NULL;
+    Context->IncomingCapacity = 0;
+    return;
+}
+
+PVOID
+SolverSearchThread (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements a solver thread, which expands its share of each
+    estimated total solution length in turn until the search is over.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the thread's solver context.
+
+Return Value:
+
+    NULL always.
+
+--*/
+
+{
+
+    PSOLVER_CONTEXT Context;
+
+    Context = Parameter;
+    do {
+        SolverSearchLayer(Context);
+
+    } while (SolverWaitForThreads(Context) != FALSE);
+
+    return NULL;
+}
+
+VOID
+SolverSearchLayer (
+    PSOLVER_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine expands every state the thread owns at the current estimated
+    total solution length, including the ones other threads hand over while
+    it works, until no thread has any left.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Destination;
+    USHORT Estimate;
+    ULONG Index;
+    PSOLVER_SEARCH Search;
+    ULONG ThreadIndex;
+
+    Search = Context->Search;
+    while (Search->Stop == FALSE) {
+        if (Search->ThreadCount > 1) {
+            if (SolverReceiveStates(Context) == FALSE) {
+                SolverStopSearch(Context, 0);
+                break;
+            }
+
+            //
+            // Let whichever thread has the state closest to done go first, so
+            // the threads head for a solution together the way one thread
+            // would. States tied for closest are still expanded at the same
+            // time.
+            //
+
+            Estimate = SolverPeekState(Context, Search->Cost);
+            Search->Lowest[Context->ThreadIndex] = Estimate;
+            if (Estimate != SOLVER_INFINITE_DISTANCE) {
+                for (ThreadIndex = 0;
+                     ThreadIndex < Search->ThreadCount;
+                     ThreadIndex += 1) {
+
+                    if (Search->Lowest[ThreadIndex] < Estimate) {
+                        break;
+                    }
+                }
+
+                if (ThreadIndex != Search->ThreadCount) {
+                    sched_yield();
+                    continue;
+                }
+            }
+        }
+
+        Index = SolverPopState(Context, Search->Cost);
+        if ((Index != SOLVER_NO_STATE) &&
+            (SolverExpandState(Context, Index) == FALSE)) {
+
+            SolverStopSearch(Context, 0);
+            break;
+        }
+
+        if (Search->ThreadCount == 1) {
+            if (Index == SOLVER_NO_STATE) {
+                break;
+            }
+
+            continue;
+        }
+
+        //
+        // Hand over the new states right away rather than waiting for full
+        // batches. The search heads for a solution through the states closest
+        // to done, and the next one of those usually belongs to another
+        // thread.
+        //
+
+        for (Destination = 0;
+             Destination < Search->ThreadCount;
+             Destination += 1) {
+
+            if (SolverSendStates(Context, Destination) == FALSE) {
+                SolverStopSearch(Context, 0);
+                return;
+            }
+        }
+
+        if (Index != SOLVER_NO_STATE) {
+            continue;
+        }
+
+        //
+        // Wait for more states, or for every other thread to run out too.
+        //
+
+        Search->Lowest[Context->ThreadIndex] = SOLVER_INFINITE_DISTANCE;
+        pthread_mutex_lock(&(Search->Lock));
+        Search->Outstanding -= 1;
+        if (Search->Outstanding == 0) {
+            Search->LayerDone = TRUE;
+            pthread_cond_broadcast(&(Search->Condition));
+        }
+
+        while ((Search->LayerDone == FALSE) &&
+               (Search->Stop == FALSE) &&
+               (Context->InboxCount == 0)) {
+
+            pthread_cond_wait(&(Search->Condition), &(Search->Lock));
+        }
+
+        if ((Search->LayerDone != FALSE) || (Search->Stop != FALSE)) {
+            pthread_mutex_unlock(&(Search->Lock));
+            break;
+        }
+
+        Search->Outstanding += 1;
+        pthread_mutex_unlock(&(Search->Lock));
+    }
+
+    return;
+}
+
+BOOL
+SolverWaitForThreads (
+    PSOLVER_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for every thread to finish the current estimated total
+    solution length, and moves the search on to the next one.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+Return Value:
+
+    TRUE if the search goes on.
+
+    FALSE if the search is over.
+
+--*/
+
+{
+
+    ULONG Cost;
+    BOOL Continue;
+    ULONG Generation;
+    PSOLVER_SEARCH Search;
+    ULONG ThreadIndex;
+
+    Search = Context->Search;
+    for (Cost = Search->Cost + 1; Cost < SOLVER_MAX_COST; Cost += 1) {
+        if (Context->Pending[Cost] != 0) {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&(Search->Lock));
+    if (Cost < Search->NextCost) {
+        Search->NextCost = Cost;
+    }
+
+    Search->Arrived += 1;
+    if (Search->Arrived == Search->Running) {
+        if (Search->NextCost >= SOLVER_MAX_COST) {
+            Search->Stop = TRUE;
+        }
+
+        Search->Cost = Search->NextCost;
+        Search->NextCost = SOLVER_MAX_COST;
+        Search->Outstanding = Search->Running;
+        Search->Arrived = 0;
+        Search->LayerDone = FALSE;
+        Search->Generation += 1;
+        for (ThreadIndex = 0; ThreadIndex < Search->Running; ThreadIndex += 1) {
+            Search->Lowest[ThreadIndex] = SOLVER_INFINITE_DISTANCE;
+        }
+
+        pthread_cond_broadcast(&(Search->Condition));
+
+    } else {
+        Generation = Search->Generation;
+        while (Search->Generation == Generation) {
+            pthread_cond_wait(&(Search->Condition), &(Search->Lock));
+        }
+    }
+
+    Continue = TRUE;
+    if (Search->Stop != FALSE) {
+        Continue = FALSE;
+    }
+
+    pthread_mutex_unlock(&(Search->Lock));
+    return Continue;
+}
+
+VOID
+SolverStopSearch (
+    PSOLVER_CONTEXT Context,
+    USHORT Pushes
+    )
+
+/*++
+
+Routine Description:
+
+    This routine ends the search, unless another thread already has.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Pushes - Supplies the optimal number of pushes, or zero if the solver ran
+        out of room.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PSOLVER_SEARCH Search;
+
+    Search = Context->Search;
+    pthread_mutex_lock(&(Search->Lock));
+    if (Search->Stop == FALSE) {
+        Search->Stop = TRUE;
+        Search->Result = Pushes;
+    }
+
+    pthread_cond_broadcast(&(Search->Condition));
+    pthread_mutex_unlock(&(Search->Lock));
+    return;
+}
+
+BOOL
+SolverExpandState (
+    PSOLVER_CONTEXT Context,
+    ULONG StateIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine tries every push from a state, and hands each new state to
+    the thread that owns it.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    StateIndex - Supplies the index of the state to expand.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    USHORT Box;
+    ULONG BoxWord;
+    ULONGLONG Boxes;
+    USHORT Corral;
+    SOLVER_STATE Current;
+    ULONG Direction;
+    USHORT From;
+    ULONG Head;
+    SOLVER_STATE Next;
+    BOOL OffGoal;
+    ULONGLONG Packed[SOLVER_MAX_RECORD_SIZE / sizeof(ULONGLONG)];
+    PSOLVER_RECORD Record;
+    USHORT Target;
+    ULONG Tail;
+    USHORT Unvisited;
+
+    SolverUnpackState(Context, SOLVER_RECORD_AT(Context, StateIndex), &Current);
+    Context->OutboxEstimate = Current.Estimate - 1;
+    Record = (PSOLVER_RECORD)Packed;
+
+    //
+    // Find everywhere the player can walk without pushing anything.
+    //
+
+    Context->ReachableStamp += 1;
+    Context->Reachable[Current.Player] = Context->ReachableStamp;
+    Context->Work[0] = Current.Player;
+    Head = 0;
+    Tail = 1;
+    while (Head < Tail) {
+        From = Context->Work[Head];
+        Head += 1;
+        for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+            Unvisited = Context->Neighbor[From][Direction];
+            if ((Unvisited == SOLVER_NO_CELL) ||
+                (Context->Reachable[Unvisited] == Context->ReachableStamp) ||
+                ((Current.Boxes[Unvisited / 64] &
+                  (1ULL << (Unvisited % 64))) != 0)) {
+
+                continue;
+            }
+
+            Context->Reachable[Unvisited] = Context->ReachableStamp;
+            Context->Work[Tail] = Unvisited;
+            Tail += 1;
+        }
+    }
+
+    //
+    // Try every push of every bean, or only the pushes into a corral if one
+    // has to be dealt with first.
+    //
+
+    Corral = SolverFindCorral(Context, &Current);
+    for (BoxWord = 0; BoxWord < SOLVER_BOX_WORDS; BoxWord += 1) {
+        Boxes = Current.Boxes[BoxWord];
+        while (Boxes != 0) {
+            Box = (BoxWord * 64) + __builtin_ctzll(Boxes);
+            Boxes &= Boxes - 1;
+            if ((Corral != SOLVER_NO_CELL) &&
+                (Context->Corral[Box] != Corral)) {
+
+                continue;
+            }
+
+            for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+                From = Context->Neighbor[Box][SOLVER_OPPOSITE(Direction)];
+                Target = Context->Neighbor[Box][Direction];
+                if ((From == SOLVER_NO_CELL) ||
+                    (Target == SOLVER_NO_CELL) ||
+                    (Context->Reachable[From] != Context->ReachableStamp) ||
+                    (Context->Dead[Target] != FALSE) ||
+                    ((Current.Boxes[Target / 64] &
+                      (1ULL << (Target % 64))) != 0)) {
+
+                    continue;
+                }
+
+                memcpy(Next.Boxes, Current.Boxes, sizeof(Next.Boxes));
+                Next.Boxes[Box / 64] &= ~(1ULL << (Box % 64));
+                Next.Boxes[Target / 64] |= 1ULL << (Target % 64);
+                Next.Pushes = Current.Pushes + 1;
+                Next.Estimate = 0;
+                Next.Flags = 0;
+                OffGoal = FALSE;
+                memset(Context->FrozenWall, 0, Context->FloorCount);
+                if ((SolverIsFrozen(Context, &Next, Target, &OffGoal) !=
+                     FALSE) &&
+                    (OffGoal != FALSE)) {
+
+                    continue;
+                }
+
+                Next.Player = SolverNormalizePlayer(Context, &Next, Box);
+                SolverPackState(Context, &Next, Record);
+                if (SolverDispatchState(Context, Record) == FALSE) {
+                    return FALSE;
+                }
+
+                if (Context->Search->Stop != FALSE) {
+                    return TRUE;
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL
+SolverDispatchState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes in a new state if this thread owns it, or batches it up
+    for the thread that does.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Record - Supplies a pointer to the packed state, without its estimate.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    ULONG Count;
+    ULONG Hash;
+    ULONG Owner;
+    PSOLVER_SEARCH Search;
+
+    Search = Context->Search;
+    Hash = SolverHashKey(&(Record->Player), Context->KeySize);
+    Owner = Hash % Search->ThreadCount;
+    if (Owner == Context->ThreadIndex) {
+        return SolverReceiveState(Context, Record, Hash);
+    }
+
+    Count = Context->OutboxCount[Owner];
+    memcpy(Context->Outbox +
+           (((Owner * SOLVER_BATCH_SIZE) + Count) * Context->RecordSize),
+           Record,
+           Context->RecordSize);
+
+    Context->OutboxCount[Owner] = Count + 1;
+    if (Context->OutboxCount[Owner] == SOLVER_BATCH_SIZE) {
+        return SolverSendStates(Context, Owner);
+    }
+
+    return TRUE;
+}
+
+BOOL
+SolverSendStates (
+    PSOLVER_CONTEXT Context,
+    ULONG Destination
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hands the states batched up for another thread over to its
+    inbox.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Destination - Supplies the index of the thread to hand the states to.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the inbox could not be grown.
+
+--*/
+
+{
+
+    ULONG Capacity;
+    ULONG Count;
+    PUCHAR Inbox;
+    PSOLVER_SEARCH Search;
+    PSOLVER_CONTEXT Target;
+
+    Count = Context->OutboxCount[Destination];
+    if (Count == 0) {
+        return TRUE;
+    }
+
+    Search = Context->Search;
+    Target = Search->Contexts[Destination];
+    pthread_mutex_lock(&(Search->Lock));
+    if (Target->InboxCount + Count > Target->InboxCapacity) {
+        Capacity = Target->InboxCapacity * 2;
+        if (Capacity < Target->InboxCount + Count) {
+            Capacity = Target->InboxCount + Count;
+        }
+
+        Inbox = realloc(Target->Inbox, (size_t)Capacity * Context->RecordSize);
+        if (Inbox == NULL) {
+            pthread_mutex_unlock(&(Search->Lock));
+            return FALSE;
+        }
+
+        Target->Inbox = Inbox;
+        Target->InboxCapacity = Capacity;
+    }
+
+    memcpy(Target->Inbox + (Target->InboxCount * Context->RecordSize),
+           Context->Outbox +
+           (Destination * SOLVER_BATCH_SIZE * Context->RecordSize),
+           Count * Context->RecordSize);
+
+    //
+    // The states haven't been estimated yet, so assume the best. Otherwise
+    // this thread would go on with its own states until the other one got
+    // around to estimating these.
+    //
+
+    Target->InboxCount += Count;
+    Search->Outstanding += Count;
+    if (Search->Lowest[Destination] > Context->OutboxEstimate) {
+        Search->Lowest[Destination] = Context->OutboxEstimate;
+    }
+
+    pthread_cond_broadcast(&(Search->Condition));
+    pthread_mutex_unlock(&(Search->Lock));
+    Context->OutboxCount[Destination] = 0;
+    return TRUE;
+}
+
+BOOL
+SolverReceiveStates (
+    PSOLVER_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes in every state other threads have handed over.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    ULONG Capacity;
+    ULONG Count;
+    PUCHAR Incoming;
+    ULONG Index;
+    PSOLVER_RECORD Record;
+    PSOLVER_SEARCH Search;
+
+    if (Context->InboxCount == 0) {
+        return TRUE;
+    }
+
+    //
+    // Swap the inbox out so other threads can keep handing states over while
+    // this one works through them.
+    //
+
+    Search = Context->Search;
+    pthread_mutex_lock(&(Search->Lock));
+    Incoming = Context->Inbox;
+    Capacity = Context->InboxCapacity;
+    Count = Context->InboxCount;
+    Context->Inbox = Context->Incoming;
+    Context->InboxCapacity = Context->IncomingCapacity;
+    Context->InboxCount = 0;
+    Context->Incoming = Incoming;
+    Context->IncomingCapacity = Capacity;
+    Search->Outstanding -= Count;
+    pthread_mutex_unlock(&(Search->Lock));
+    for (Index = 0; Index < Count; Index += 1) {
+        Record = (PSOLVER_RECORD)(Incoming + (Index * Context->RecordSize));
+        if (SolverReceiveState(
+                        Context,
+                        Record,
+                        SolverHashKey(&(Record->Player), Context->KeySize)) ==
+            FALSE) {
+
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL
+SolverReceiveState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Hash
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes in a state this thread owns. New states are estimated
+    and put on the open list, and states already seen are reopened if this
+    path to them is shorter.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Record - Supplies a pointer to the packed state, without its estimate.
+
+    Hash - Supplies the hash of the state's key.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    PSOLVER_RECORD Existing;
+    ULONG Index;
+    ULONG Slot;
+    SOLVER_STATE State;
+
+    //
+    // Only work out the estimate for new states, as it's the most expensive
+    // part of a push.
+    //
+
+    Index = SolverFindState(Context, Record, Hash, &Slot);
+    if (Index != SOLVER_NO_STATE) {
+        Existing = SOLVER_RECORD_AT(Context, Index);
+        if ((Record->Pushes < Existing->Pushes) &&
+            (Existing->Estimate != SOLVER_INFINITE_DISTANCE)) {
+
+            Existing->Pushes = Record->Pushes;
+            Existing->Flags &= ~SOLVER_STATE_EXPANDED;
+            return SolverQueueState(Context, Index);
+        }
+
+        return TRUE;
+    }
+
+    SolverUnpackState(Context, Record, &State);
+    Record->Estimate = SolverEstimate(Context, &State);
+    Record->Flags = 0;
+    if (Record->Estimate == 0) {
+        SolverStopSearch(Context, Record->Pushes);
+        return TRUE;
+    }
+
+    //
+    // Remember deadlocked states too, so they aren't estimated again, but
+    // never expand them.
+    //
+
+    if (Record->Estimate == SOLVER_INFINITE_DISTANCE) {
+        Record->Flags = SOLVER_STATE_EXPANDED;
+    }
+
+    return SolverAddState(Context, Record, Slot);
+}
+
+BOOL
+SolverInitializeLevel (
+    PSOLVER_CONTEXT Context,
+    PUCHAR Cells,
+    USHORT StartingPosition,
+    PSOLVER_STATE Start
+    )
+
+/*++
+
+Routine Description:
+
+    This routine builds the floor map of a level and its starting state.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Cells - Supplies a pointer to the level's cells, one per byte.
+
+    StartingPosition - Supplies the player's starting position.
+
+    Start - Supplies a pointer where the starting state will be returned.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the level is too big for the solver.
+
+--*/
+
+{
+
+    ULONG Cell;
+    USHORT CellOfFloor[SOLVER_MAX_FLOOR];
+    ULONG Direction;
+    USHORT Floor;
+    ULONG Head;
+    LONG NeighborCell;
+    USHORT Player;
+    ULONG Tail;
+    LONG X;
+    LONG Y;
+
+    memset(Start, 0, sizeof(SOLVER_STATE));
+    for (Cell = 0; Cell < SOKOBAN_LEVEL_CELLS; Cell += 1) {
+        Context->FloorOfCell[Cell] = SOLVER_NO_CELL;
+    }
+
+    //
+    // Number the floor cells in the order they're found from the player.
+    //
+
+    Cell = ((StartingPosition >> SOKOBAN_ORIGIN_Y_SHIFT) * SOKOBAN_WIDTH) +
+           (StartingPosition & SOKOBAN_ORIGIN_MASK);
+
+    if (Cell >= SOKOBAN_LEVEL_CELLS) {
+        return FALSE;
+    }
+
+    Context->FloorOfCell[Cell] = 0;
+    CellOfFloor[0] = Cell;
+    Head = 0;
+    Tail = 1;
+    while (Head < Tail) {
+        Cell = CellOfFloor[Head];
+        Head += 1;
+        X = Cell % SOKOBAN_WIDTH;
+        Y = Cell / SOKOBAN_WIDTH;
+        for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+            NeighborCell = -1;
+            if ((Direction == SOLVER_LEFT) && (X != 0)) {
+                NeighborCell = Cell - 1;
+
+            } else if ((Direction == SOLVER_RIGHT) &&
+                       (X != SOKOBAN_WIDTH - 1)) {
+
+                NeighborCell = Cell + 1;
+
+            } else if ((Direction == SOLVER_UP) && (Y != 0)) {
+                NeighborCell = Cell - SOKOBAN_WIDTH;
+
+            } else if ((Direction == SOLVER_DOWN) &&
+                       (Y != SOKOBAN_HEIGHT - 1)) {
+
+                NeighborCell = Cell + SOKOBAN_WIDTH;
+            }
+
+            if ((NeighborCell < 0) ||
+                (Cells[NeighborCell] == SOKOBAN_CELL_WALL) ||
+                (Context->FloorOfCell[NeighborCell] != SOLVER_NO_CELL)) {
+
+                continue;
+            }
+
+            if (Tail == SOLVER_MAX_FLOOR) {
+                fprintf(stderr, "Warning: Level too big to solve.\n");
+                return FALSE;
+            }
+
+            Context->FloorOfCell[NeighborCell] = Tail;
+            CellOfFloor[Tail] = NeighborCell;
+            Tail += 1;
+        }
+    }
+
+    Context->FloorCount = Tail;
+    Context->BoxBytes = (Tail + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    Context->KeySize = sizeof(UCHAR) + Context->BoxBytes;
+    Context->RecordSize = ALIGN_RANGE_UP(SOLVER_RECORD_HEADER_SIZE +
+                                         Context->BoxBytes,
+                                         sizeof(USHORT));
+
+    Context->GoalCount = 0;
+
+    //
+    // Link up the neighbors and note the goals and beans.
+    //
+
+    for (Floor = 0; Floor < Context->FloorCount; Floor += 1) {
+        Cell = CellOfFloor[Floor];
+        X = Cell % SOKOBAN_WIDTH;
+        Y = Cell / SOKOBAN_WIDTH;
+        Context->Neighbor[Floor][SOLVER_LEFT] = SOLVER_NO_CELL;
+        Context->Neighbor[Floor][SOLVER_RIGHT] = SOLVER_NO_CELL;
+        Context->Neighbor[Floor][SOLVER_UP] = SOLVER_NO_CELL;
+        Context->Neighbor[Floor][SOLVER_DOWN] = SOLVER_NO_CELL;
+        if (X != 0) {
+            Context->Neighbor[Floor][SOLVER_LEFT] =
+                                              Context->FloorOfCell[Cell - 1];
+        }
+
+        if (X != SOKOBAN_WIDTH - 1) {
+            Context->Neighbor[Floor][SOLVER_RIGHT] =
+                                              Context->FloorOfCell[Cell + 1];
+        }
+
+        if (Y != 0) {
+            Context->Neighbor[Floor][SOLVER_UP] =
+                                  Context->FloorOfCell[Cell - SOKOBAN_WIDTH];
+        }
+
+        if (Y != SOKOBAN_HEIGHT - 1) {
+            Context->Neighbor[Floor][SOLVER_DOWN] =
+                                  Context->FloorOfCell[Cell + SOKOBAN_WIDTH];
+        }
+
+        Context->Goal[Floor] = FALSE;
+        if ((Cells[Cell] == SOKOBAN_CELL_GOAL) ||
+            (Cells[Cell] == SOKOBAN_CELL_BEAN_ON_GOAL)) {
+
+            if (Context->GoalCount == SOLVER_MAX_GOALS) {
+                fprintf(stderr,
+                        "Warning: Level has too many goals to solve.\n");
+
+                return FALSE;
+            }
+
+            Context->Goal[Floor] = TRUE;
+            Context->GoalFloor[Context->GoalCount] = Floor;
+            Context->GoalCount += 1;
+        }
+
+        if ((Cells[Cell] == SOKOBAN_CELL_BEAN) ||
+            (Cells[Cell] == SOKOBAN_CELL_BEAN_ON_GOAL)) {
+
+            Start->Boxes[Floor / 64] |= 1ULL << (Floor % 64);
+        }
+    }
+
+    SolverComputeDistances(Context);
+    Player = 0;
+    Start->Player = SolverNormalizePlayer(Context, Start, Player);
+    Start->Estimate = SolverEstimate(Context, Start);
+    return TRUE;
+}
+
+VOID
+SolverComputeDistances (
+    PSOLVER_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes how far a lone bean on each floor cell is from each
+    goal, for each side of the bean the player might be on. The bean is pulled
+    backwards away from the goal, and after each pull the player may walk
+    around to any side of the bean it can reach without going through it.
+    Cells no pull from any goal can reach are dead.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT Box;
+    ULONG Direction;
+    PUSHORT Distance;
+    USHORT Floor;
+    USHORT From;
+    ULONG Goal;
+    ULONG Head;
+    USHORT Neighbor;
+    USHORT Player;
+    USHORT Pushed;
+    USHORT Queue[SOLVER_MAX_FLOOR * SOLVER_DIRECTIONS];
+    ULONG Side;
+    ULONG Tail;
+    UCHAR ThisArea;
+
+    //
+    // Number the areas the player can be in around each cell when there's a
+    // bean on it.
+    //
+
+    for (Box = 0; Box < Context->FloorCount; Box += 1) {
+        memset(Context->Area[Box], SOLVER_NO_AREA, Context->FloorCount);
+        ThisArea = 0;
+        for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+            Floor = Context->Neighbor[Box][Direction];
+            if ((Floor == SOLVER_NO_CELL) ||
+                (Context->Area[Box][Floor] != SOLVER_NO_AREA)) {
+
+                continue;
+            }
+
+            Context->Area[Box][Floor] = ThisArea;
+            Context->Work[0] = Floor;
+            Head = 0;
+            Tail = 1;
+            while (Head < Tail) {
+                From = Context->Work[Head];
+                Head += 1;
+                for (Side = 0; Side < SOLVER_DIRECTIONS; Side += 1) {
+                    Neighbor = Context->Neighbor[From][Side];
+                    if ((Neighbor == SOLVER_NO_CELL) || (Neighbor == Box) ||
+                        (Context->Area[Box][Neighbor] != SOLVER_NO_AREA)) {
+
+                        continue;
+                    }
+
+                    Context->Area[Box][Neighbor] = ThisArea;
+                    Context->Work[Tail] = Neighbor;
+                    Tail += 1;
+                }
+            }
+
+            ThisArea += 1;
+        }
+    }
+
+    for (Floor = 0; Floor < Context->FloorCount; Floor += 1) {
+        Context->Dead[Floor] = TRUE;
+    }
+
+    for (Goal = 0; Goal < Context->GoalCount; Goal += 1) {
+        Distance = Context->Distance[Goal][0];
+        for (Floor = 0;
+             Floor < Context->FloorCount * SOLVER_DIRECTIONS;
+             Floor += 1) {
+
+            Distance[Floor] = SOLVER_INFINITE_DISTANCE;
+        }
+
+        Floor = Context->GoalFloor[Goal];
+        Context->Dead[Floor] = FALSE;
+        Tail = 0;
+        for (Side = 0; Side < SOLVER_DIRECTIONS; Side += 1) {
+            if (Context->Neighbor[Floor][Side] != SOLVER_NO_CELL) {
+                Context->Distance[Goal][Floor][Side] = 0;
+                Queue[Tail] = (Floor * SOLVER_DIRECTIONS) + Side;
+                Tail += 1;
+            }
+        }
+
+        //
+        // A bean pushed onto a cell leaves the player standing where the bean
+        // was, so the pull goes back that way, and needs room behind for the
+        // player.
+        //
+
+        Head = 0;
+        while (Head < Tail) {
+            Pushed = Queue[Head] / SOLVER_DIRECTIONS;
+            Direction = Queue[Head] % SOLVER_DIRECTIONS;
+            Head += 1;
+            Box = Context->Neighbor[Pushed][Direction];
+            if (Box == SOLVER_NO_CELL) {
+                continue;
+            }
+
+            Player = Context->Neighbor[Box][Direction];
+            if (Player == SOLVER_NO_CELL) {
+                continue;
+            }
+
+            ThisArea = Context->Area[Box][Player];
+            for (Side = 0; Side < SOLVER_DIRECTIONS; Side += 1) {
+                Neighbor = Context->Neighbor[Box][Side];
+                if ((Neighbor == SOLVER_NO_CELL) ||
+                    (Context->Area[Box][Neighbor] != ThisArea) ||
+                    (Context->Distance[Goal][Box][Side] !=
+                     SOLVER_INFINITE_DISTANCE)) {
+
+                    continue;
+                }
+
+                Context->Distance[Goal][Box][Side] =
+                              Context->Distance[Goal][Pushed][Direction] + 1;
+
+                Context->Dead[Box] = FALSE;
+                Queue[Tail] = (Box * SOLVER_DIRECTIONS) + Side;
+                Tail += 1;
+            }
+        }
+    }
+
+    return;
+}
+
+USHORT
+SolverEstimate (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes a lower bound on the pushes needed to solve the
+    level from the given state: the cheapest way of assigning each bean its
+    own goal, where each bean's distance depends on which sides of it the
+    player can get to. This is found with the Hungarian method. A push only
+    moves one bean one cell, and the player never crosses another bean to
+    make it, so the bound never drops by more than one per push.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    State - Supplies a pointer to the state, with the player's position
+        filled in.
+
+Return Value:
+
+    Returns the lower bound.
+
+    SOLVER_INFINITE_DISTANCE if there is no way to give each bean a goal, in
+    which case the state is a deadlock.
+
+--*/
+
+{
+
+    UCHAR BoxArea;
+    ULONG BoxCount;
+    ULONG BoxWord;
+    ULONGLONG Boxes;
+    LONG Cost;
+    LONG Costs[SOLVER_MAX_GOALS + 1][SOLVER_MAX_GOALS + 1];
+    LONG Delta;
+    ULONG Direction;
+    LONG Distance;
+    USHORT Floor;
+    ULONG Goal;
+    ULONG GoalCount;
+    ULONG Match[SOLVER_MAX_GOALS + 1];
+    LONG Minimum[SOLVER_MAX_GOALS + 1];
+    ULONG NextGoal;
+    LONG PotentialBox[SOLVER_MAX_GOALS + 1];
+    LONG PotentialGoal[SOLVER_MAX_GOALS + 1];
+    ULONG Row;
+    UCHAR Used[SOLVER_MAX_GOALS + 1];
+    ULONG Way[SOLVER_MAX_GOALS + 1];
+    ULONG CurrentGoal;
+
+    //
+    // Gather each bean's distance to each goal, one based to suit the
+    // algorithm below. Goals a bean can't reach cost more than any real
+    // assignment could, so an assignment using one shows up as too
+    // expensive.
+    //
+
+    GoalCount = Context->GoalCount;
+    BoxCount = 0;
+    for (BoxWord = 0; BoxWord < SOLVER_BOX_WORDS; BoxWord += 1) {
+        Boxes = State->Boxes[BoxWord];
+        while (Boxes != 0) {
+            if (BoxCount == GoalCount) {
+                return SOLVER_INFINITE_DISTANCE;
+            }
+
+            BoxCount += 1;
+            Floor = (BoxWord * 64) + __builtin_ctzll(Boxes);
+            Boxes &= Boxes - 1;
+            BoxArea = Context->Area[Floor][State->Player];
+            for (Goal = 1; Goal <= GoalCount; Goal += 1) {
+                Cost = SOLVER_MAX_COST;
+                for (Direction = 0;
+                     Direction < SOLVER_DIRECTIONS;
+                     Direction += 1) {
+
+                    Distance = Context->Distance[Goal - 1][Floor][Direction];
+                    if ((Distance < Cost) &&
+                        (Context->Area[Floor][
+                            Context->Neighbor[Floor][Direction]] == BoxArea)) {
+
+                        Cost = Distance;
+                    }
+                }
+
+                Costs[BoxCount][Goal] = Cost;
+            }
+        }
+    }
+
+    for (Goal = 0; Goal <= GoalCount; Goal += 1) {
+        PotentialGoal[Goal] = 0;
+        Match[Goal] = 0;
+    }
+
+    for (Row = 0; Row <= BoxCount; Row += 1) {
+        PotentialBox[Row] = 0;
+    }
+
+    for (Row = 1; Row <= BoxCount; Row += 1) {
+        Match[0] = Row;
+        CurrentGoal = 0;
+        for (Goal = 0; Goal <= GoalCount; Goal += 1) {
+            Minimum[Goal] = MAX_LONG;
+            Used[Goal] = FALSE;
+        }
+
+        do {
+            Used[CurrentGoal] = TRUE;
+            Delta = MAX_LONG;
+            NextGoal = 0;
+            for (Goal = 1; Goal <= GoalCount; Goal += 1) {
+                if (Used[Goal] != FALSE) {
+                    continue;
+                }
+
+                Cost = Costs[Match[CurrentGoal]][Goal] -
+                       PotentialBox[Match[CurrentGoal]] - PotentialGoal[Goal];
+
+                if (Cost < Minimum[Goal]) {
+                    Minimum[Goal] = Cost;
+                    Way[Goal] = CurrentGoal;
+                }
+
+                if (Minimum[Goal] < Delta) {
+                    Delta = Minimum[Goal];
+                    NextGoal = Goal;
+                }
+            }
+
+            for (Goal = 0; Goal <= GoalCount; Goal += 1) {
+                if (Used[Goal] != FALSE) {
+                    PotentialBox[Match[Goal]] += Delta;
+                    PotentialGoal[Goal] -= Delta;
+
+                } else {
+                    Minimum[Goal] -= Delta;
+                }
+            }
+
+            CurrentGoal = NextGoal;
+
+        } while (Match[CurrentGoal] != 0);
+
+        do {
+            NextGoal = Way[CurrentGoal];
+            Match[CurrentGoal] = Match[NextGoal];
+            CurrentGoal = NextGoal;
+
+        } while (CurrentGoal != 0);
+    }
+
+    Cost = 0;
+    for (Goal = 1; Goal <= GoalCount; Goal += 1) {
+        if (Match[Goal] != 0) {
+            if (Costs[Match[Goal]][Goal] == SOLVER_MAX_COST) {
+                return SOLVER_INFINITE_DISTANCE;
+            }
+
+            Cost += Costs[Match[Goal]][Goal];
+        }
+    }
+
+    return Cost;
+}
+
+USHORT
+SolverNormalizePlayer (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Player
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the lowest numbered floor cell the player can walk to.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    State - Supplies a pointer to the state, whose beans are in place.
+
+    Player - Supplies the floor cell the player is standing on.
+
+Return Value:
+
+    Returns the lowest numbered reachable floor cell.
+
+--*/
+
+{
+
+    ULONG Direction;
+    USHORT From;
+    ULONG Head;
+    USHORT Lowest;
+    USHORT Neighbor;
+    ULONG Tail;
+
+    Context->CurrentStamp += 1;
+    Context->Stamp[Player] = Context->CurrentStamp;
+    Context->Work[0] = Player;
+    Lowest = Player;
+    Head = 0;
+    Tail = 1;
+    while (Head < Tail) {
+        From = Context->Work[Head];
+        Head += 1;
+        if (From < Lowest) {
+            Lowest = From;
+        }
+
+        for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+            Neighbor = Context->Neighbor[From][Direction];
+            if ((Neighbor == SOLVER_NO_CELL) ||
+                (Context->Stamp[Neighbor] == Context->CurrentStamp) ||
+                ((State->Boxes[Neighbor / 64] &
+                  (1ULL << (Neighbor % 64))) != 0)) {
+
+                continue;
+            }
+
+            Context->Stamp[Neighbor] = Context->CurrentStamp;
+            Context->Work[Tail] = Neighbor;
+            Tail += 1;
+        }
+    }
+
+    return Lowest;
+}
+
+BOOL
+SolverIsFrozen (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Box,
+    PBOOL OffGoal
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether a bean can never be moved again, because it
+    is blocked both horizontally and vertically by walls, dead cells, or other
+    frozen beans.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context. The frozen wall array
+        must be cleared before the first call.
+
+    State - Supplies a pointer to the state.
+
+    Box - Supplies the floor cell of the bean to check.
+
+    OffGoal - Supplies a pointer that is set to TRUE if this bean or any bean
+        found frozen along with it is not on a goal.
+
+Return Value:
+
+    TRUE if the bean is frozen.
+
+    FALSE if the bean might still move.
+
+--*/
+
+{
+
+    BOOL Frozen;
+
+    //
+    // Treat this bean as a wall while checking its neighbors so that two
+    // beans next to each other don't recurse forever.
+    //
+
+    Context->FrozenWall[Box] = TRUE;
+    Frozen = FALSE;
+    if ((SolverIsBlocked(Context, State, Box, SOLVER_LEFT, OffGoal) != FALSE) &&
+        (SolverIsBlocked(Context, State, Box, SOLVER_UP, OffGoal) != FALSE)) {
+
+        Frozen = TRUE;
+        if (Context->Goal[Box] == FALSE) {
+            *OffGoal = TRUE;
+        }
+    }
+
+    Context->FrozenWall[Box] = FALSE;
+    return Frozen;
+}
+
+BOOL
+SolverIsBlocked (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    USHORT Box,
+    ULONG Direction,
+    PBOOL OffGoal
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether a bean is blocked along one axis.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    State - Supplies a pointer to the state.
+
+    Box - Supplies the floor cell of the bean to check.
+
+    Direction - Supplies either direction along the axis to check.
+
+    OffGoal - Supplies a pointer that is set to TRUE if a neighboring bean
+        found frozen is not on a goal.
+
+Return Value:
+
+    TRUE if the bean cannot move along the axis.
+
+    FALSE if the bean might still move along the axis.
+
+--*/
+
+{
+
+    USHORT First;
+    ULONG Index;
+    USHORT Neighbor;
+    USHORT Second;
+
+    First = Context->Neighbor[Box][Direction];
+    Second = Context->Neighbor[Box][SOLVER_OPPOSITE(Direction)];
+
+    //
+    // A wall on either side blocks the axis, as do dead cells on both sides.
+    //
+
+    if ((First == SOLVER_NO_CELL) || (Second == SOLVER_NO_CELL) ||
+        (Context->FrozenWall[First] != FALSE) ||
+        (Context->FrozenWall[Second] != FALSE)) {
+
+        return TRUE;
+    }
+
+    if ((Context->Dead[First] != FALSE) && (Context->Dead[Second] != FALSE)) {
+        return TRUE;
+    }
+
+    //
+    // A frozen bean on either side blocks the axis too.
+    //
+
+    for (Index = 0; Index < 2; Index += 1) {
+        Neighbor = First;
+        if (Index != 0) {
+            Neighbor = Second;
+        }
+
+        if (((State->Boxes[Neighbor / 64] & (1ULL << (Neighbor % 64))) != 0) &&
+            (SolverIsFrozen(Context, State, Neighbor, OffGoal) != FALSE)) {
+
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+USHORT
+SolverFindCorral (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks for a corral that has to be dealt with before anything
+    else. A corral is an area the player can't reach, along with the beans
+    fencing it in. If a corral holds a bean that isn't on a goal, one of its
+    beans has to be pushed at some point. If, in addition, no bean in the
+    corral can be pushed out of it from where the player is, nothing done
+    elsewhere can change the corral until one of its beans is pushed in. So
+    the first push into the corral in any solution could just as well be done
+    now, and the other pushes don't need to be tried. Since the number of
+    pushes doesn't change, the solution stays optimal. A corral like that with
+    no pushes into it at all is a deadlock.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context, with the cells the
+        player can reach in the state marked.
+
+    State - Supplies a pointer to the state being expanded.
+
+Return Value:
+
+    Returns the number of the corral with the fewest pushes into it. The
+    corral each bean belongs to is stored in the context.
+
+    SOLVER_NO_CELL if there is no such corral.
+
+--*/
+
+{
+
+    USHORT Best;
+    USHORT Box;
+    ULONG BoxWord;
+    ULONGLONG Boxes;
+    USHORT CorralCount;
+    ULONG Direction;
+    USHORT Floor;
+    USHORT From;
+    ULONG Head;
+    USHORT Neighbor;
+    ULONG Tail;
+    USHORT Target;
+
+    //
+    // Number the areas the player can't reach, beans included. Beans next to
+    // each other join their areas into one corral.
+    //
+
+    CorralCount = 0;
+    Context->CurrentStamp += 1;
+    for (Floor = 0; Floor < Context->FloorCount; Floor += 1) {
+        if ((Context->Reachable[Floor] == Context->ReachableStamp) ||
+            (Context->Stamp[Floor] == Context->CurrentStamp)) {
+
+            continue;
+        }
+
+        Context->CorralPushes[CorralCount] = 0;
+        Context->CorralFlags[CorralCount] = 0;
+        Context->Stamp[Floor] = Context->CurrentStamp;
+        Context->Work[0] = Floor;
+        Head = 0;
+        Tail = 1;
+        while (Head < Tail) {
+            From = Context->Work[Head];
+            Head += 1;
+            Context->Corral[From] = CorralCount;
+            if (((State->Boxes[From / 64] & (1ULL << (From % 64))) != 0) &&
+                (Context->Goal[From] == FALSE)) {
+
+                Context->CorralFlags[CorralCount] |= SOLVER_CORRAL_OFF_GOAL;
+            }
+
+            for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+                Neighbor = Context->Neighbor[From][Direction];
+                if ((Neighbor == SOLVER_NO_CELL) ||
+                    (Context->Reachable[Neighbor] ==
+                     Context->ReachableStamp) ||
+                    (Context->Stamp[Neighbor] == Context->CurrentStamp)) {
+
+                    continue;
+                }
+
+                Context->Stamp[Neighbor] = Context->CurrentStamp;
+                Context->Work[Tail] = Neighbor;
+                Tail += 1;
+            }
+        }
+
+        CorralCount += 1;
+    }
+
+    //
+    // Look at every push the player could make of each corral's beans. Pushes
+    // onto dead cells are never made, so they don't count.
+    //
+
+    for (BoxWord = 0; BoxWord < SOLVER_BOX_WORDS; BoxWord += 1) {
+        Boxes = State->Boxes[BoxWord];
+        while (Boxes != 0) {
+            Box = (BoxWord * 64) + __builtin_ctzll(Boxes);
+            Boxes &= Boxes - 1;
+            for (Direction = 0; Direction < SOLVER_DIRECTIONS; Direction += 1) {
+                From = Context->Neighbor[Box][SOLVER_OPPOSITE(Direction)];
+                Target = Context->Neighbor[Box][Direction];
+                if ((From == SOLVER_NO_CELL) ||
+                    (Target == SOLVER_NO_CELL) ||
+                    (Context->Reachable[From] != Context->ReachableStamp) ||
+                    (Context->Dead[Target] != FALSE)) {
+
+                    continue;
+                }
+
+                if (Context->Reachable[Target] == Context->ReachableStamp) {
+                    Context->CorralFlags[Context->Corral[Box]] |=
+                                                            SOLVER_CORRAL_OPEN;
+
+                } else if ((State->Boxes[Target / 64] &
+                            (1ULL << (Target % 64))) == 0) {
+
+                    Context->CorralPushes[Context->Corral[Box]] += 1;
+                }
+            }
+        }
+    }
+
+    Best = SOLVER_NO_CELL;
+    for (Floor = 0; Floor < CorralCount; Floor += 1) {
+        if ((Context->CorralFlags[Floor] == SOLVER_CORRAL_OFF_GOAL) &&
+            ((Best == SOLVER_NO_CELL) ||
+             (Context->CorralPushes[Floor] < Context->CorralPushes[Best]))) {
+
+            Best = Floor;
+        }
+    }
+
+    return Best;
+}
+
+VOID
+SolverPackState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_STATE State,
+    PSOLVER_RECORD Record
+    )
+
+/*++
+
+Routine Description:
+
+    This routine packs a state for storage.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    State - Supplies a pointer to the state to pack.
+
+    Record - Supplies a pointer where the packed state will be returned. It
+        must hold the context's record size.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Byte;
+
+    Record->Pushes = State->Pushes;
+    Record->Estimate = State->Estimate;
+    Record->Flags = State->Flags;
+    Record->Player = State->Player;
+    for (Byte = 0; Byte < Context->BoxBytes; Byte += 1) {
+        Record->Boxes[Byte] = (UCHAR)(State->Boxes[Byte / 8] >>
+                                      ((Byte % 8) * BITS_PER_BYTE));
+    }
+
+    return;
+}
+
+VOID
+SolverUnpackState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    PSOLVER_STATE State
+    )
+
+/*++
+
+Routine Description:
+
+    This routine unpacks a stored state to work on.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Record - Supplies a pointer to the packed state.
+
+    State - Supplies a pointer where the state will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Byte;
+
+    memset(State->Boxes, 0, sizeof(State->Boxes));
+    for (Byte = 0; Byte < Context->BoxBytes; Byte += 1) {
+        State->Boxes[Byte / 8] |= (ULONGLONG)Record->Boxes[Byte] <<
+                                  ((Byte % 8) * BITS_PER_BYTE);
+    }
+
+    State->Player = Record->Player;
+    State->Pushes = Record->Pushes;
+    State->Estimate = Record->Estimate;
+    State->Flags = Record->Flags;
+    return;
+}
+
+ULONG
+SolverFindState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Hash,
+    PULONG Slot
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks up a state in the hash table.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Record - Supplies a pointer to the packed state to look for.
+
+    Hash - Supplies the hash of the state's key.
+
+    Slot - Supplies a pointer where the hash table slot the state belongs in
+        will be returned, for adding it if it wasn't found.
+
+Return Value:
+
+    Returns the index of the state if it has been seen before.
+
+    SOLVER_NO_STATE if the state is new.
+
+--*/
+
+{
+
+    PSOLVER_RECORD Existing;
+    ULONG Index;
+
+    //
+    // Scale the hash to the table rather than masking it, as the table size
+    // follows the memory budget and isn't a power of two.
+    //
+
+    *Slot = ((ULONGLONG)Hash * Context->HashSize) >> 32;
+    while (Context->Hash[*Slot] != 0) {
+        Index = Context->Hash[*Slot] - 1;
+        Existing = SOLVER_RECORD_AT(Context, Index);
+        if (memcmp(&(Existing->Player), &(Record->Player), Context->KeySize) ==
+            0) {
+
+            return Index;
+        }
+
+        *Slot += 1;
+        if (*Slot == Context->HashSize) {
+            *Slot = 0;
+        }
+    }
+
+    return SOLVER_NO_STATE;
+}
+
+BOOL
+SolverAddState (
+    PSOLVER_CONTEXT Context,
+    PSOLVER_RECORD Record,
+    ULONG Slot
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a new state, and puts it on the open list unless it is
+    already marked expanded.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Record - Supplies a pointer to the packed state to add.
+
+    Slot - Supplies the empty hash table slot returned when the state wasn't
+        found.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    ULONG Index;
+
+    if (Context->StateCount == Context->MaxStates) {
+        return FALSE;
+    }
+
+    Index = Context->StateCount;
+    Context->StateCount += 1;
+    memcpy(SOLVER_RECORD_AT(Context, Index), Record, Context->RecordSize);
+    Context->Hash[Slot] = Index + 1;
+    if ((Record->Flags & SOLVER_STATE_EXPANDED) != 0) {
+        return TRUE;
+    }
+
+    return SolverQueueState(Context, Index);
+}
+
+BOOL
+SolverQueueState (
+    PSOLVER_CONTEXT Context,
+    ULONG StateIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts a state on the open list.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    StateIndex - Supplies the index of the state to queue.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the solver ran out of room.
+
+--*/
+
+{
+
+    ULONG Cost;
+    PSOLVER_QUEUE_ENTRY Entry;
+    PSOLVER_RECORD Record;
+
+    Record = SOLVER_RECORD_AT(Context, StateIndex);
+    Cost = Record->Pushes + Record->Estimate;
+    if ((Cost >= SOLVER_MAX_COST) ||
+        (Context->QueueCount == Context->MaxQueue)) {
+
+        return FALSE;
+    }
+
+    Entry = &(Context->Queue[Context->QueueCount]);
+    Context->QueueCount += 1;
+    Entry->State = StateIndex;
+    Entry->Next = Context->Bucket[Cost][Record->Estimate];
+    Context->Bucket[Cost][Record->Estimate] = Context->QueueCount;
+    Context->Pending[Cost] += 1;
+    return TRUE;
+}
+
+USHORT
+SolverPeekState (
+    PSOLVER_CONTEXT Context,
+    ULONG Cost
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the estimate of the next state that would be taken off
+    the open list, dropping stale entries on the way.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Cost - Supplies the estimated total solution length being expanded.
+
+Return Value:
+
+    Returns the estimated number of pushes left from the next state.
+
+    SOLVER_INFINITE_DISTANCE if there are no states left at the given length.
+
+--*/
+
+{
+
+    ULONG Entry;
+    ULONG Estimate;
+    PSOLVER_RECORD Record;
+
+    for (Estimate = 0; Estimate <= Cost; Estimate += 1) {
+        while (Context->Bucket[Cost][Estimate] != 0) {
+            Entry = Context->Bucket[Cost][Estimate];
+            Record = SOLVER_RECORD_AT(Context, Context->Queue[Entry - 1].State);
+            if (((Record->Flags & SOLVER_STATE_EXPANDED) == 0) &&
+                (Record->Pushes + Record->Estimate == Cost)) {
+
+                return Estimate;
+            }
+
+            Context->Bucket[Cost][Estimate] = Context->Queue[Entry - 1].Next;
+            Context->Pending[Cost] -= 1;
+        }
+    }
+
+    return SOLVER_INFINITE_DISTANCE;
+}
+
+ULONG
+SolverPopState (
+    PSOLVER_CONTEXT Context,
+    ULONG Cost
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes the next state to expand off the open list and marks it
+    expanded.
+
+Arguments:
+
+    Context - Supplies a pointer to the solver context.
+
+    Cost - Supplies the estimated total solution length being expanded.
+
+Return Value:
+
+    Returns the index of the state to expand.
+
+    SOLVER_NO_STATE if there are no states left at the given length.
+
+--*/
+
+{
+
+    ULONG Entry;
+    ULONG Estimate;
+    ULONG Index;
+    PSOLVER_RECORD Record;
+
+    for (Estimate = 0; Estimate <= Cost; Estimate += 1) {
+        while (Context->Bucket[Cost][Estimate] != 0) {
+            Entry = Context->Bucket[Cost][Estimate];
+            Context->Bucket[Cost][Estimate] = Context->Queue[Entry - 1].Next;
+            Context->Pending[Cost] -= 1;
+            Index = Context->Queue[Entry - 1].State;
+            Record = SOLVER_RECORD_AT(Context, Index);
+
+            //
+            // Skip entries left behind when a shorter path to the state was
+            // found.
+            //
+
+            if (((Record->Flags & SOLVER_STATE_EXPANDED) != 0) ||
+                (Record->Pushes + Record->Estimate != Cost)) {
+
+                continue;
+            }
+
+            Record->Flags |= SOLVER_STATE_EXPANDED;
+            return Index;
+        }
+    }
+
+    return SOLVER_NO_STATE;
+}
+
+ULONG
+SolverHashKey (
+    PUCHAR Key,
+    ULONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hashes a packed state's player and beans.
+
+Arguments:
+
+    Key - Supplies a pointer to the key.
+
+    Size - Supplies the size of the key in bytes.
+
+Return Value:
+
+    Returns a 32-bit hash value.
+
+--*/
+
+{
+
+    ULONGLONG Hash;
+    ULONG Offset;
+    ULONGLONG Word;
+
+    Hash = Size;
+    for (Offset = 0; Offset < Size; Offset += sizeof(ULONGLONG)) {
+        Word = 0;
+        if (Size - Offset >= sizeof(ULONGLONG)) {
+            memcpy(&Word, Key + Offset, sizeof(ULONGLONG));
+
+        } else {
+            memcpy(&Word, Key + Offset, Size - Offset);
+        }
+
+        Hash = (Hash ^ Word) * 0x9E3779B97F4A7C15ULL;
+        Hash ^= Hash >> 29;
+    }
+
+    Hash *= 0xBF58476D1CE4E5B9ULL;
+    Hash ^= Hash >> 32;
+    return (ULONG)(Hash & MAX_ULONG);
+}
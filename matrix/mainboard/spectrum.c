@@ -0,0 +1,612 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    spectrum.c
+
+Abstract:
+
+    This module implements a matrix app that shows the spectrum of the audio
+    input as a bar graph with falling peaks.
+
+Author:
+
+    Evan Green 4-Dec-2010
+
+Environment:
+
+    x86/AVR
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "mainboard.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the size of the transform, which is one buffer of audio samples, and
+// the number of radix-2 passes it takes.
+//
+
+#define SPECTRUM_FFT_SIZE AUDIO_BUFFER_SIZE
+#define SPECTRUM_FFT_STAGES 6
+
+//
+// Define the number of bands on the screen, one per column, and the height of
+// the tallest bar.
+//
+
+#define SPECTRUM_BANDS MATRIX_WIDTH
+#define SPECTRUM_ROWS MATRIX_HEIGHT
+
+//
+// Define how often a new spectrum is drawn, in ms/32. This works out to 40
+// frames per second.
+//
+
+#define SPECTRUM_FRAME_INTERVAL (32 * 25)
+
+//
+// Define how far samples are shifted up going into the transform. Each pass
+// halves its outputs so nothing can overflow, which costs one bit per pass.
+// Starting from at most 14 bits of magnitude leaves one bit of headroom for
+// the butterfly sums.
+//
+
+#define SPECTRUM_INPUT_SHIFT 6
+
+//
+// Define how many frames a peak hangs at its highest point, and how many
+// frames it then takes to fall each row.
+//
+
+#define SPECTRUM_PEAK_HOLD_FRAMES 20
+#define SPECTRUM_PEAK_FALL_FRAMES 2
+
+#define SPECTRUM_PEAK_COLOR RGB_PIXEL(31, 31, 31)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the spectrum display.
+
+Members:
+
+    FrameTimer - Stores the timer that draws each frame.
+
+    Real - Stores the real parts of the transform, worked on in place.
+
+    Imaginary - Stores the imaginary parts of the transform. Before the
+        transform starts, its storage is borrowed to hold the raw samples.
+
+    Peak - Stores the height of each band's falling peak marker.
+
+    PeakAge - Stores the number of frames since each peak last moved.
+
+    BarColor - Stores the color of each row of the bars, from the bottom up.
+
+--*/
+
+typedef struct _SPECTRUM {
+    TIMER FrameTimer;
+    SHORT Real[SPECTRUM_FFT_SIZE];
+    SHORT Imaginary[SPECTRUM_FFT_SIZE];
+    UCHAR Peak[SPECTRUM_BANDS];
+    UCHAR PeakAge[SPECTRUM_BANDS];
+    USHORT BarColor[SPECTRUM_ROWS];
+} SPECTRUM, *PSPECTRUM;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+SppDrawFrame (
+    PVOID Context
+    );
+
+VOID
+SppLoadSamples (
+    PSPECTRUM Spectrum
+    );
+
+VOID
+SppTransform (
+    PSPECTRUM Spectrum
+    );
+
+UCHAR
+SppGetBandHeight (
+    PSPECTRUM Spectrum,
+    UCHAR Band
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Define the sine of each twiddle angle, 2 * pi * k / 64, in signed 1.15 fixed
+// point. The table runs three quarters of the way around so the cosine can be
+// read from a quarter turn further along.
+//
+
+const SHORT SpectrumSine[SPECTRUM_FFT_SIZE * 3 / 4] PROGMEM = {
+    0, 3212, 6393, 9512, 12539, 15446, 18204, 20787,
+    23170, 25329, 27245, 28898, 30273, 31356, 32137, 32609,
+    32767, 32609, 32137, 31356, 30273, 28898, 27245, 25329,
+    23170, 20787, 18204, 15446, 12539, 9512, 6393, 3212,
+    0, -3212, -6393, -9512, -12539, -15446, -18204, -20787,
+    -23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609
+};
+
+//
+// Define the first half of a Hann window in 0.8 fixed point. The second half
+// is its mirror image. Windowing keeps a loud tone from smearing across every
+// band.
+//
+
+const UCHAR SpectrumWindow[SPECTRUM_FFT_SIZE / 2] PROGMEM = {
+    0, 1, 3, 6, 10, 16, 22, 30,
+    38, 48, 58, 69, 81, 93, 105, 118,
+    131, 143, 156, 168, 180, 191, 202, 212,
+    221, 229, 236, 242, 247, 251, 254, 255
+};
+
+//
+// Define where each sample lands in the transform's input, which is its index
+// with the bits reversed.
+//
+
+const UCHAR SpectrumBitReverse[SPECTRUM_FFT_SIZE] PROGMEM = {
+    0, 32, 16, 48, 8, 40, 24, 56, 4, 36, 20, 52, 12, 44, 28, 60,
+    2, 34, 18, 50, 10, 42, 26, 58, 6, 38, 22, 54, 14, 46, 30, 62,
+    1, 33, 17, 49, 9, 41, 25, 57, 5, 37, 21, 53, 13, 45, 29, 61,
+    3, 35, 19, 51, 11, 43, 27, 59, 7, 39, 23, 55, 15, 47, 31, 63
+};
+
+//
+// Define the first frequency bin of each band, plus one past the end. The
+// transform only has 31 useful bins, so the low bands get one each and the
+// high bands, where a bin means less to the ear, share.
+//
+
+const UCHAR SpectrumBandStart[SPECTRUM_BANDS + 1] PROGMEM = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+    19, 21, 23, 25, 27, 29, 32
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+APPLICATION
+SpectrumEntry (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the spectrum display.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
+{
+
+    UCHAR Band;
+    UCHAR Green;
+    APPLICATION NextApplication;
+    UCHAR Red;
+    UCHAR Row;
+    SPECTRUM Spectrum;
+
+    //
+    // Fade the bars from green at the bottom through yellow to red at the top.
+    //
+
+    for (Row = 0; Row < SPECTRUM_ROWS; Row += 1) {
+        Red = Row * 3;
+        if (Red > MAX_INTENSITY) {
+            Red = MAX_INTENSITY;
+        }
+
+        Green = (SPECTRUM_ROWS - 1 - Row) * 3;
+        if (Green > MAX_INTENSITY) {
+            Green = MAX_INTENSITY;
+        }
+
+        Spectrum.BarColor[Row] = RGB_PIXEL(Red, Green, 0);
+    }
+
+    for (Band = 0; Band < SPECTRUM_BANDS; Band += 1) {
+        Spectrum.Peak[Band] = 0;
+        Spectrum.PeakAge[Band] = 0;
+    }
+
+    HlClearScreen();
+    HlStartAudioCapture();
+    KeInitializeTimer(&(Spectrum.FrameTimer));
+    KeQueueTimer(&(Spectrum.FrameTimer),
+                 SPECTRUM_FRAME_INTERVAL,
+                 SPECTRUM_FRAME_INTERVAL,
+                 SppDrawFrame,
+                 &Spectrum);
+
+    NextApplication = KeRunEventLoop();
+    HlStopAudioCapture();
+    return NextApplication;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+SppDrawFrame (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine transforms the latest audio samples and draws the spectrum.
+
+Arguments:
+
+    Context - Supplies a pointer to the spectrum state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Band;
+    UCHAR Height;
+    UCHAR Peak;
+    UCHAR Row;
+    PSPECTRUM Spectrum;
+    UCHAR YPixel;
+
+    Spectrum = Context;
+    SppLoadSamples(Spectrum);
+    SppTransform(Spectrum);
+    for (Band = 0; Band < SPECTRUM_BANDS; Band += 1) {
+        Height = SppGetBandHeight(Spectrum, Band);
+
+        //
+        // Bump the peak up to the bar, or let it hang for a while before it
+        // starts to fall.
+        //
+
+        Peak = Spectrum->Peak[Band];
+        if (Height >= Peak) {
+            Peak = Height;
+            Spectrum->PeakAge[Band] = 0;
+
+        } else {
+            Spectrum->PeakAge[Band] += 1;
+            if (Spectrum->PeakAge[Band] >= SPECTRUM_PEAK_HOLD_FRAMES) {
+                Peak -= 1;
+                Spectrum->PeakAge[Band] = SPECTRUM_PEAK_HOLD_FRAMES -
+                                          SPECTRUM_PEAK_FALL_FRAMES;
+            }
+        }
+
+        Spectrum->Peak[Band] = Peak;
+
+        //
+        // Draw the column from the bottom up.
+        //
+
+        YPixel = MATRIX_HEIGHT - 1;
+        for (Row = 0; Row < SPECTRUM_ROWS; Row += 1) {
+            if (Row < Height) {
+                KeMatrix[YPixel][Band] = Spectrum->BarColor[Row];
+
+            } else if (Row + 1 == Peak) {
+                KeMatrix[YPixel][Band] = SPECTRUM_PEAK_COLOR;
+
+            } else {
+                KeMatrix[YPixel][Band] = 0;
+            }
+
+            YPixel -= 1;
+        }
+    }
+
+    return;
+}
+
+VOID
+SppLoadSamples (
+    PSPECTRUM Spectrum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies the latest audio samples into the transform's input
+    with the DC offset removed, the window applied, and the order shuffled for
+    an in-place transform.
+
+Arguments:
+
+    Spectrum - Supplies a pointer to the spectrum state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Index;
+    UCHAR Mean;
+    SHORT Sample;
+    PUCHAR Samples;
+    USHORT Sum;
+    UCHAR Window;
+
+    //
+    // The imaginary parts are all zero going in, so borrow their storage for
+    // the raw samples until the real parts have been filled in.
+    //
+
+    Samples = (PUCHAR)(Spectrum->Imaginary);
+    HlReadAudioSamples(Samples);
+    Sum = 0;
+    for (Index = 0; Index < SPECTRUM_FFT_SIZE; Index += 1) {
+        Sum += Samples[Index];
+    }
+
+    Mean = Sum / SPECTRUM_FFT_SIZE;
+    for (Index = 0; Index < SPECTRUM_FFT_SIZE; Index += 1) {
+        Sample = (SHORT)Samples[Index] - Mean;
+        if (Sample > MAX_CHAR) {
+            Sample = MAX_CHAR;
+
+        } else if (Sample < MIN_CHAR) {
+            Sample = MIN_CHAR;
+        }
+
+        if (Index < SPECTRUM_FFT_SIZE / 2) {
+            Window = RtlReadProgramSpace8(&(SpectrumWindow[Index]));
+
+        } else {
+            Window = RtlReadProgramSpace8(
+                         &(SpectrumWindow[SPECTRUM_FFT_SIZE - 1 - Index]));
+        }
+
+        Spectrum->Real[RtlReadProgramSpace8(&(SpectrumBitReverse[Index]))] =
+                   (Sample * Window) >> (BITS_PER_BYTE - SPECTRUM_INPUT_SHIFT);
+    }
+
+    for (Index = 0; Index < SPECTRUM_FFT_SIZE; Index += 1) {
+        Spectrum->Imaginary[Index] = 0;
+    }
+
+    return;
+}
+
+VOID
+SppTransform (
+    PSPECTRUM Spectrum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs a decimation in time radix-2 FFT over the spectrum's
+    bit-reversed input. Each pass halves its results, so the output is the
+    true transform divided by the transform size.
+
+Arguments:
+
+    Spectrum - Supplies a pointer to the spectrum state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Bottom;
+    SHORT Cosine;
+    UCHAR Group;
+    UCHAR Half;
+    SHORT Sine;
+    UCHAR Stage;
+    SHORT TemporaryImaginary;
+    SHORT TemporaryReal;
+    UCHAR Top;
+    UCHAR Twiddle;
+    UCHAR TwiddleStep;
+
+    Half = 1;
+    TwiddleStep = SPECTRUM_FFT_SIZE / 2;
+    for (Stage = 0; Stage < SPECTRUM_FFT_STAGES; Stage += 1) {
+
+        //
+        // Every butterfly in a group shares a twiddle factor, so only fetch
+        // it from flash once per group.
+        //
+
+        Twiddle = 0;
+        for (Group = 0; Group < Half; Group += 1) {
+            Sine = RtlReadProgramSpace16(&(SpectrumSine[Twiddle]));
+            Cosine = RtlReadProgramSpace16(
+                             &(SpectrumSine[Twiddle + SPECTRUM_FFT_SIZE / 4]));
+
+            for (Top = Group; Top < SPECTRUM_FFT_SIZE; Top += Half * 2) {
+                Bottom = Top + Half;
+
+                //
+                // Multiply the bottom input by the twiddle factor, which is
+                // cos - i * sin of the angle.
+                //
+
+                TemporaryReal =
+                          (((LONG)Cosine * Spectrum->Real[Bottom]) +
+                           ((LONG)Sine * Spectrum->Imaginary[Bottom])) >> 15;
+
+                TemporaryImaginary =
+                          (((LONG)Cosine * Spectrum->Imaginary[Bottom]) -
+                           ((LONG)Sine * Spectrum->Real[Bottom])) >> 15;
+
+                Spectrum->Real[Bottom] =
+                              (Spectrum->Real[Top] - TemporaryReal) >> 1;
+
+                Spectrum->Imaginary[Bottom] =
+                         (Spectrum->Imaginary[Top] - TemporaryImaginary) >> 1;
+
+                Spectrum->Real[Top] =
+                              (Spectrum->Real[Top] + TemporaryReal) >> 1;
+
+                Spectrum->Imaginary[Top] =
+                         (Spectrum->Imaginary[Top] + TemporaryImaginary) >> 1;
+            }
+
+            Twiddle += TwiddleStep;
+        }
+
+        Half *= 2;
+        TwiddleStep /= 2;
+    }
+
+    return;
+}
+
+UCHAR
+SppGetBandHeight (
+    PSPECTRUM Spectrum,
+    UCHAR Band
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines how tall a band's bar should be. The loudest bin
+    in the band sets the height, on a log scale of two rows per doubling, or
+    about 3dB per row.
+
+Arguments:
+
+    Spectrum - Supplies a pointer to the spectrum state, with the transform
+        complete.
+
+    Band - Supplies the band to measure.
+
+Return Value:
+
+    Returns the height of the bar, in rows.
+
+--*/
+
+{
+
+    UCHAR Bin;
+    UCHAR End;
+    UCHAR Height;
+    USHORT Magnitude;
+    USHORT Maximum;
+    USHORT Minimum;
+    USHORT Value;
+
+    Bin = RtlReadProgramSpace8(&(SpectrumBandStart[Band]));
+    End = RtlReadProgramSpace8(&(SpectrumBandStart[Band + 1]));
+    Magnitude = 0;
+    while (Bin < End) {
+
+        //
+        // Estimate the length of the complex value as the larger part plus
+        // half the smaller one, which is within about 12% and avoids a square
+        // root.
+        //
+
+        Maximum = Spectrum->Real[Bin];
+        if (Spectrum->Real[Bin] < 0) {
+            Maximum = -Spectrum->Real[Bin];
+        }
+
+        Minimum = Spectrum->Imaginary[Bin];
+        if (Spectrum->Imaginary[Bin] < 0) {
+            Minimum = -Spectrum->Imaginary[Bin];
+        }
+
+        if (Minimum > Maximum) {
+            Value = Minimum;
+            Minimum = Maximum;
+            Maximum = Value;
+        }
+
+        Value = Maximum + (Minimum >> 1);
+        if (Value > Magnitude) {
+            Magnitude = Value;
+        }
+
+        Bin += 1;
+    }
+
+    if (Magnitude == 0) {
+        return 0;
+    }
+
+    //
+    // Count two rows for each bit below the top one, plus one more if the
+    // next bit down is set too.
+    //
+
+    Height = 1;
+    while (Magnitude > 3) {
+        Height += 2;
+        Magnitude >>= 1;
+    }
+
+    if (Magnitude == 2) {
+        Height += 2;
+
+    } else if (Magnitude == 3) {
+        Height += 3;
+    }
+
+    if (Height > SPECTRUM_ROWS) {
+        Height = SPECTRUM_ROWS;
+    }
+
+    return Height;
+}
+
@@ -0,0 +1,557 @@
+/*++
+
+Copyright (c) 2011 Evan Green
+
+Module Name:
+
+    stream.c
+
+Abstract:
+
+    This module implements a matrix app that shows video streamed from a PC
+    over the serial port. Frames are decoded straight into the matrix while
+    the display is held, so the slaves keep showing the last whole frame until
+    the next one is complete.
+
+Author:
+
+    Evan Green 22-Jan-2011
+
+Environment:
+
+    x86/AVR
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "mainboard.h"
+#include "stream.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define how often the serial port is checked for frame data, in ms/32. At
+// full speed the 128 byte receive buffer fills up in about 2.6ms, so this
+// leaves room for only about one late poll.
+//
+
+#define STREAM_POLL_INTERVAL (32 * 1)
+
+//
+// Define how long the stream can be quiet before the ready byte is sent
+// again, in ms/32.
+//
+
+#define STREAM_RETRY_INTERVAL (32 * 1000)
+
+//
+// Define how often the frame counts are updated on the LCD, in ms/32.
+//
+
+#define STREAM_STATUS_INTERVAL (32 * 1000UL)
+
+//
+// Define how many bytes are pulled out of the serial port at a time.
+//
+
+#define STREAM_READ_SIZE 16
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef enum _STREAM_STATE {
+    StreamStateSyncByte0,
+    StreamStateSyncByte1,
+    StreamStateSyncByte2,
+    StreamStateLength,
+    StreamStateColorHigh,
+    StreamStateColorLow,
+    StreamStatePresenting
+} STREAM_STATE, *PSTREAM_STATE;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the video stream.
+
+Members:
+
+    PollTimer - Stores the timer that checks the serial port for data.
+
+    StatusTimer - Stores the timer that prints the frame counts.
+
+    QuietTime - Stores how long it's been since anything was received, in
+        ms/32.
+
+    Frames - Stores the number of frames shown.
+
+    DroppedFrames - Stores the number of frames thrown away because they were
+        garbled or bytes of them were lost.
+
+    Color - Stores the color of the run being received.
+
+    State - Stores where in the frame the next byte belongs.
+
+    Length - Stores the length of the run being received.
+
+    Row - Stores the row of the next pixel in the frame.
+
+    Column - Stores the column of the next pixel in the frame.
+
+    PresentedFrame - Stores the frame count at the time the last frame was
+        finished. Once it changes, the frame has gone out and the matrix can
+        be reused.
+
+--*/
+
+typedef struct _STREAM {
+    TIMER PollTimer;
+    TIMER StatusTimer;
+    USHORT QuietTime;
+    USHORT Frames;
+    USHORT DroppedFrames;
+    USHORT Color;
+    STREAM_STATE State;
+    UCHAR Length;
+    UCHAR Row;
+    UCHAR Column;
+    UCHAR PresentedFrame;
+} STREAM, *PSTREAM;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+StppPoll (
+    PVOID Context
+    );
+
+VOID
+StppProcessByte (
+    PSTREAM Stream,
+    UCHAR Data
+    );
+
+VOID
+StppRequestFrame (
+    PSTREAM Stream
+    );
+
+VOID
+StppDropFrame (
+    PSTREAM Stream
+    );
+
+VOID
+StppPrintStatus (
+    PVOID Context
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+APPLICATION
+StreamEntry (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the video stream app, which shows
+    frames sent from a PC over the serial port.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
+{
+
+    APPLICATION NextApplication;
+    STREAM Stream;
+
+    Stream.Frames = 0;
+    Stream.DroppedFrames = 0;
+    HlStartSerial(STREAM_BAUD_RATE);
+    StppRequestFrame(&Stream);
+    StppPrintStatus(&Stream);
+    KeInitializeTimer(&(Stream.PollTimer));
+    KeInitializeTimer(&(Stream.StatusTimer));
+    KeQueueTimer(&(Stream.PollTimer),
+                 STREAM_POLL_INTERVAL,
+                 STREAM_POLL_INTERVAL,
+                 StppPoll,
+                 &Stream);
+
+    KeQueueTimer(&(Stream.StatusTimer),
+                 STREAM_STATUS_INTERVAL,
+                 STREAM_STATUS_INTERVAL,
+                 StppPrintStatus,
+                 &Stream);
+
+    NextApplication = KeRunEventLoop();
+    KeDisplayHeld = FALSE;
+    HlStopSerial();
+    return NextApplication;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+StppPoll (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decodes whatever frame data has come in over the serial port.
+    It is called by the poll timer.
+
+Arguments:
+
+    Context - Supplies a pointer to the stream state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Buffer[STREAM_READ_SIZE];
+    UCHAR Count;
+    UCHAR Index;
+    UCHAR Overflowed;
+    UCHAR Received;
+    PSTREAM Stream;
+
+    Stream = Context;
+
+    //
+    // Once the finished frame has gone out, the matrix is free to take the
+    // next one.
+    //
+
+    if (Stream->State == StreamStatePresenting) {
+        if (KeFrameCount == Stream->PresentedFrame) {
+            return;
+        }
+
+        StppRequestFrame(Stream);
+    }
+
+    Received = FALSE;
+    while (TRUE) {
+        Count = HlReadSerial(Buffer, STREAM_READ_SIZE, &Overflowed);
+        if (Overflowed != FALSE) {
+            StppDropFrame(Stream);
+        }
+
+        if (Count == 0) {
+            break;
+        }
+
+        Received = TRUE;
+        for (Index = 0; Index < Count; Index += 1) {
+            StppProcessByte(Stream, Buffer[Index]);
+
+            //
+            // The host only sends one frame per ready byte, so anything
+            // after a finished frame is garbage.
+            //
+
+            if (Stream->State == StreamStatePresenting) {
+                return;
+            }
+        }
+    }
+
+    if (Received != FALSE) {
+        Stream->QuietTime = 0;
+        return;
+    }
+
+    //
+    // If nothing has come in for a long time, the ready byte may have been
+    // lost on the way to the host. Ask again, giving up on any partial frame.
+    //
+
+    Stream->QuietTime += STREAM_POLL_INTERVAL;
+    if (Stream->QuietTime >= STREAM_RETRY_INTERVAL) {
+        if (Stream->State != StreamStateSyncByte0) {
+            StppDropFrame(Stream);
+
+        } else {
+            StppRequestFrame(Stream);
+        }
+    }
+
+    return;
+}
+
+VOID
+StppProcessByte (
+    PSTREAM Stream,
+    UCHAR Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine feeds one byte of the stream into the frame decoder, drawing
+    each run into the matrix as it completes.
+
+Arguments:
+
+    Stream - Supplies a pointer to the stream state.
+
+    Data - Supplies the byte received.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Length;
+
+    switch (Stream->State) {
+    case StreamStateSyncByte0:
+        if (Data == SYNC_BYTE0) {
+            Stream->State = StreamStateSyncByte1;
+        }
+
+        break;
+
+    case StreamStateSyncByte1:
+        if (Data == SYNC_BYTE1) {
+            Stream->State = StreamStateSyncByte2;
+
+        } else if (Data != SYNC_BYTE0) {
+            Stream->State = StreamStateSyncByte0;
+        }
+
+        break;
+
+    case StreamStateSyncByte2:
+        Stream->State = StreamStateSyncByte0;
+        if (Data == SYNC_BYTE2) {
+            Stream->State = StreamStateLength;
+            Stream->Row = 0;
+            Stream->Column = 0;
+        }
+
+        break;
+
+    //
+    // An empty run means the stream is out of sync.
+    //
+
+    case StreamStateLength:
+        if (Data == 0) {
+            StppDropFrame(Stream);
+            break;
+        }
+
+        Stream->Length = Data;
+        Stream->State = StreamStateColorHigh;
+        break;
+
+    case StreamStateColorHigh:
+        Stream->Color = (USHORT)Data << 8;
+        Stream->State = StreamStateColorLow;
+        break;
+
+    case StreamStateColorLow:
+        Stream->Color |= Data;
+        Length = Stream->Length;
+        while (Length != 0) {
+
+            //
+            // A run that goes off the end of the matrix means the stream is
+            // out of sync.
+            //
+
+            if (Stream->Row == MATRIX_HEIGHT) {
+                StppDropFrame(Stream);
+                return;
+            }
+
+            KeMatrix[Stream->Row][Stream->Column] = Stream->Color;
+            Stream->Column += 1;
+            if (Stream->Column == MATRIX_WIDTH) {
+                Stream->Column = 0;
+                Stream->Row += 1;
+            }
+
+            Length -= 1;
+        }
+
+        Stream->State = StreamStateLength;
+
+        //
+        // If the frame is complete, let it go out, and remember the frame
+        // count so it's clear when it has.
+        //
+
+        if (Stream->Row == MATRIX_HEIGHT) {
+            Stream->Frames += 1;
+            Stream->State = StreamStatePresenting;
+            Stream->PresentedFrame = KeFrameCount;
+            KeDisplayHeld = FALSE;
+        }
+
+        break;
+
+    default:
+        break;
+    }
+
+    return;
+}
+
+VOID
+StppRequestFrame (
+    PSTREAM Stream
+    )
+
+/*++
+
+Routine Description:
+
+    This routine holds the display and asks the host for the next frame.
+
+Arguments:
+
+    Stream - Supplies a pointer to the stream state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeDisplayHeld = TRUE;
+    Stream->State = StreamStateSyncByte0;
+    Stream->QuietTime = 0;
+    HlWriteSerial(STREAM_READY);
+    return;
+}
+
+VOID
+StppDropFrame (
+    PSTREAM Stream
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gives up on the frame being received and asks for another.
+    Whatever part of the frame made it into the matrix stays hidden until the
+    next whole frame covers it.
+
+Arguments:
+
+    Stream - Supplies a pointer to the stream state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Stream->DroppedFrames += 1;
+    StppRequestFrame(Stream);
+    return;
+}
+
+VOID
+StppPrintStatus (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the number of frames shown and dropped on the LCD. It
+    is called by the status timer.
+
+Arguments:
+
+    Context - Supplies a pointer to the stream state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCHAR End;
+    CHAR Line[LCD_LINE_LENGTH + 1];
+    PSTREAM Stream;
+
+    Stream = Context;
+    HlClearLcdScreen();
+    HlSetLcdAddress(LCD_FIRST_LINE);
+    Line[0] = 'F';
+    Line[1] = 'r';
+    Line[2] = 'a';
+    Line[3] = 'm';
+    Line[4] = 'e';
+    Line[5] = 's';
+    Line[6] = ' ';
+    End = KeFormatDecimal(&(Line[7]), Stream->Frames);
+    *End = '\0';
+    HlLcdPrintString(Line);
+    HlSetLcdAddress(LCD_SECOND_LINE);
+    Line[0] = 'D';
+    Line[1] = 'r';
+    Line[2] = 'o';
+    Line[3] = 'p';
+    Line[4] = 'p';
+    Line[5] = 'e';
+    Line[6] = 'd';
+    Line[7] = ' ';
+    End = KeFormatDecimal(&(Line[8]), Stream->DroppedFrames);
+    *End = '\0';
+    HlLcdPrintString(Line);
+    return;
+}
+
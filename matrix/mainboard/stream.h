@@ -0,0 +1,67 @@
+/*++
+
+Copyright (c) 2011 Evan Green
+
+Module Name:
+
+    stream.h
+
+Abstract:
+
+    This header contains definitions for streaming video from a PC to the
+    matrix over the serial port.
+
+Author:
+
+    Evan Green 22-Jan-2011
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the serial port settings. Characters are 8 bits with no parity and
+// one stop bit.
+//
+
+#define STREAM_BAUD_RATE 500000
+
+//
+// Define how frames are sent. Each frame uses the same encoding as the full
+// frame sent to the matrix slaves: the three sync bytes, followed by runs of
+// a length byte and a pixel (high byte first) covering the whole protocol
+// grid row by row. A run can't be empty.
+//
+// Before each frame, the host must wait for the matrix to send the ready
+// byte, which it does once the previous frame is out on the display. The
+// matrix sends the ready byte again if it hears nothing for a while, in case
+// the last one was lost.
+//
+
+#define STREAM_READY 0x52
+
+//
+// Define the size of the largest possible frame, where every pixel is its own
+// run.
+//
+
+#define STREAM_MAX_FRAME_SIZE \
+    (3 + (3 * MATRIX_PROTOCOL_ROWS * MATRIX_PROTOCOL_COLUMNS))
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
@@ -27,18 +27,12 @@ Environment:
 
 #include "types.h"
 #include "mainboard.h"
+#include "tetris.h"
 
 //
 // ---------------------------------------------------------------- Definitions
 //
 
-//
-// Define the borders created to keep the game manageable.
-//
-
-#define TETRIS_LEFT_BORDER 5
-#define TETRIS_RIGHT_BORDER 16
-
 //
 // Define the X coordinate for the level and line indicators.
 //
@@ -70,18 +64,6 @@ Environment:
 
 #define TETRIS_LINES_PER_LEVEL 10
 
-//
-// Define the initial location where pieces show up.
-//
-
-#define TETRIS_INITIAL_X 10
-
-//
-// Define the "invalid piece", which is no piece at all.
-//
-
-#define TETRIS_INVALID_PIECE 7
-
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -90,30 +72,10 @@ Environment:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
-UCHAR
-TtpGenerateNewPiece (
-    PUCHAR PositionX,
-    PUCHAR PositionY
-    );
-
-UCHAR
-TtpMovePiece (
-    PUCHAR PieceX,
-    PUCHAR PieceY,
-    CHAR VectorX,
-    CHAR VectorY
-    );
-
-UCHAR
-TtpHandlePieceLockdown (
-    UCHAR PieceX,
-    UCHAR PieceY
-    );
-
 VOID
-TtpRotatePiece (
-    PUCHAR PieceX,
-    PUCHAR PieceY
+TtpDrawPiece (
+    PTETRIS_PIECE Piece,
+    USHORT Pixel
     );
 
 VOID
@@ -126,6 +88,101 @@ TtpDrawIndicators (
 // -------------------------------------------------------------------- Globals
 //
 
+//
+// Define the shape of each piece in each rotation, as one mask per row of the
+// piece's box. Bit zero is the leftmost column of the box, so each rotation
+// is also a masked sprite eight pixels wide. Each rotation is the previous
+// one turned clockwise and pushed back up into the top left corner of the box.
+//
+
+const UCHAR TetrisPieceShape[TETRIS_PIECE_COUNT][TETRIS_ROTATIONS]
+                            [TETRIS_PIECE_SIZE] PROGMEM = {
+
+    //
+    // The line (I).
+    //
+
+    {{0xF, 0x0, 0x0, 0x0},
+     {0x1, 0x1, 0x1, 0x1},
+     {0xF, 0x0, 0x0, 0x0},
+     {0x1, 0x1, 0x1, 0x1}},
+
+    //
+    // The L poking up on the left (J).
+    //
+
+    {{0x1, 0x7, 0x0, 0x0},
+     {0x3, 0x1, 0x1, 0x0},
+     {0x7, 0x4, 0x0, 0x0},
+     {0x2, 0x2, 0x3, 0x0}},
+
+    //
+    // The L poking up on the right (L).
+    //
+
+    {{0x4, 0x7, 0x0, 0x0},
+     {0x1, 0x1, 0x3, 0x0},
+     {0x7, 0x1, 0x0, 0x0},
+     {0x3, 0x2, 0x2, 0x0}},
+
+    //
+    // The box (O).
+    //
+
+    {{0x3, 0x3, 0x0, 0x0},
+     {0x3, 0x3, 0x0, 0x0},
+     {0x3, 0x3, 0x0, 0x0},
+     {0x3, 0x3, 0x0, 0x0}},
+
+    //
+    // The zigzag going up and right (S).
+    //
+
+    {{0x6, 0x3, 0x0, 0x0},
+     {0x1, 0x3, 0x2, 0x0},
+     {0x6, 0x3, 0x0, 0x0},
+     {0x1, 0x3, 0x2, 0x0}},
+
+    //
+    // The tee (T).
+    //
+
+    {{0x2, 0x7, 0x0, 0x0},
+     {0x1, 0x3, 0x1, 0x0},
+     {0x7, 0x2, 0x0, 0x0},
+     {0x2, 0x3, 0x2, 0x0}},
+
+    //
+    // The zigzag going down and right (Z).
+    //
+
+    {{0x3, 0x6, 0x0, 0x0},
+     {0x2, 0x3, 0x1, 0x0},
+     {0x3, 0x6, 0x0, 0x0},
+     {0x2, 0x3, 0x1, 0x0}}
+};
+
+//
+// Define the color of each piece.
+//
+
+const USHORT TetrisPieceColor[TETRIS_PIECE_COUNT] PROGMEM = {
+    RGB_PIXEL(0x0, MAX_INTENSITY, MAX_INTENSITY),
+    RGB_PIXEL(0x0, 0x0, MAX_INTENSITY),
+    RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY / 2, 0x0),
+    RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, 0x0),
+    RGB_PIXEL(0x0, MAX_INTENSITY, 0x0),
+    RGB_PIXEL(MAX_INTENSITY, 0x0, MAX_INTENSITY),
+    RGB_PIXEL(0x0, MAX_INTENSITY, 0x0)
+};
+
+//
+// Store the occupancy mask of each row of the playfield. Only blocks that have
+// settled are in here, the falling piece is not.
+//
+
+USHORT TetrisBoard[MATRIX_HEIGHT];
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -153,17 +210,16 @@ Return Value:
 
 {
 
-    UCHAR CurrentPiece;
+    TETRIS_PIECE CurrentPiece;
+    INPUT_EVENT Event;
     UCHAR GameRunning;
     ULONG NextUpdateTime;
     UCHAR Level;
     UCHAR LinesCompleted;
     APPLICATION NextApplication;
     UCHAR PieceMoved;
-    UCHAR PieceX;
-    UCHAR PieceY;
+    UCHAR Row;
     USHORT UpdateInterval;
-    UCHAR YPixel;
 
     NextApplication = ApplicationNone;
     while (NextApplication == ApplicationNone) {
@@ -173,18 +229,25 @@ Return Value:
         // Draw the borders.
         //
 
-        for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
-            KeMatrix[YPixel][TETRIS_LEFT_BORDER] =
-                        RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, MAX_INTENSITY);
+        GrFillRectangle(TETRIS_LEFT_BORDER,
+                        0,
+                        1,
+                        MATRIX_HEIGHT,
+                        RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, MAX_INTENSITY));
 
-            KeMatrix[YPixel][TETRIS_RIGHT_BORDER] =
-                        RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, MAX_INTENSITY);
+        GrFillRectangle(TETRIS_RIGHT_BORDER,
+                        0,
+                        1,
+                        MATRIX_HEIGHT,
+                        RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, MAX_INTENSITY));
 
+        for (Row = 0; Row < MATRIX_HEIGHT; Row += 1) {
+            TetrisBoard[Row] = TETRIS_EMPTY_ROW;
         }
 
         UpdateInterval = TETRIS_INITIAL_DROP_RATE;
         GameRunning = TRUE;
-        CurrentPiece = TETRIS_INVALID_PIECE;
+        CurrentPiece.Type = TETRIS_INVALID_PIECE;
         KeTrackball1 = RGB_PIXEL(0, 0, MAX_INTENSITY);
         KeTrackball2 = 0;
         NextUpdateTime = KeRawTime + UpdateInterval;
@@ -201,39 +264,43 @@ Return Value:
             // If a new piece is needed, generate one.
             //
 
-            if (CurrentPiece == TETRIS_INVALID_PIECE) {
-                CurrentPiece = TtpGenerateNewPiece(&PieceX, &PieceY);
-                if (CurrentPiece == TETRIS_INVALID_PIECE) {
+            if (CurrentPiece.Type == TETRIS_INVALID_PIECE) {
+                if (TtGenerateNewPiece(&CurrentPiece) ==
+                    TETRIS_INVALID_PIECE) {
+
                     GameRunning = FALSE;
                     break;
                 }
             }
 
             //
-            // Stall for 1ms and process input signals.
+            // Stall for 1ms and process input signals. Go through the queued
+            // events rather than the edge bits so that a fast spin of the
+            // trackball moves the piece once per tick.
             //
 
             KeStall(32);
-            if ((KeInputEdges & INPUT_LEFT1) != 0) {
-                KeInputEdges &= ~INPUT_LEFT1;
-                TtpMovePiece(&PieceX, &PieceY, -1, 0);
-            }
+            while (KeGetInputEvent(&Event) != FALSE) {
+                if ((Event.Inputs & INPUT_LEFT1) != 0) {
+                    TtMovePiece(&CurrentPiece, -1, 0);
+                }
 
-            if ((KeInputEdges & INPUT_RIGHT1) != 0) {
-                KeInputEdges &= ~INPUT_RIGHT1;
-                TtpMovePiece(&PieceX, &PieceY, 1, 0);
-            }
+                if ((Event.Inputs & INPUT_RIGHT1) != 0) {
+                    TtMovePiece(&CurrentPiece, 1, 0);
+                }
 
-            if ((KeInputEdges & INPUT_DOWN1) != 0) {
-                KeInputEdges &= ~INPUT_DOWN1;
-                NextUpdateTime = KeRawTime + UpdateInterval;
-            }
+                if ((Event.Inputs & INPUT_DOWN1) != 0) {
+                    NextUpdateTime = Event.Time + UpdateInterval;
+                }
 
-            if ((KeInputEdges & INPUT_UP1) != 0) {
-                KeInputEdges &= ~INPUT_UP1;
-                TtpRotatePiece(&PieceX, &PieceY);
+                if ((Event.Inputs & INPUT_UP1) != 0) {
+                    TtRotatePiece(&CurrentPiece);
+                }
             }
 
+            KeAcknowledgeInputEdges(INPUT_LEFT1 | INPUT_RIGHT1 | INPUT_DOWN1 |
+                                    INPUT_UP1);
+
             //
             // If the update interval has gone by, move the piece down.
             //
@@ -244,9 +311,9 @@ Return Value:
                     NextUpdateTime = 0xFFFFFFFFUL;
                 }
 
-                PieceMoved = TtpMovePiece(&PieceX, &PieceY, 0, 1);
+                PieceMoved = TtMovePiece(&CurrentPiece, 0, 1);
                 if (PieceMoved == FALSE) {
-                    LinesCompleted += TtpHandlePieceLockdown(PieceX, PieceY);
+                    LinesCompleted += TtHandlePieceLockdown(&CurrentPiece);
                     TtpDrawIndicators(Level, LinesCompleted);
                     if (LinesCompleted == TETRIS_LINES_PER_LEVEL) {
                         LinesCompleted = 0;
@@ -256,7 +323,7 @@ Return Value:
                         }
                     }
 
-                    CurrentPiece = TETRIS_INVALID_PIECE;
+                    CurrentPiece.Type = TETRIS_INVALID_PIECE;
                 }
             }
         }
@@ -279,20 +346,15 @@ Return Value:
             KeStall(1);
         }
 
-        KeInputEdges &= ~INPUT_BUTTON1;
+        KeAcknowledgeInputEdges(INPUT_BUTTON1);
     }
 
     return NextApplication;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
 UCHAR
-TtpGenerateNewPiece (
-    PUCHAR PositionX,
-    PUCHAR PositionY
+TtGenerateNewPiece (
+    PTETRIS_PIECE Piece
     )
 
 /*++
@@ -303,11 +365,7 @@ Routine Description:
 
 Arguments:
 
-    PositionX - Supplies a pointer where the X coordinate of the top left of
-        the new piece will be returned.
-
-    PositionY - Supplies a pointer where the Y coordinate of the top left of
-        the new piece will be returned.
+    Piece - Supplies a pointer where the new piece will be returned.
 
 Return Value:
 
@@ -320,143 +378,32 @@ Return Value:
 
 {
 
-    UCHAR Piece;
-    UCHAR PieceX;
-    UCHAR PieceY;
-    USHORT Pixel;
-    UCHAR XPixel;
-    UCHAR YPixel;
+    UCHAR Type;
 
     do {
-        Piece = HlRandom() & 7;
-    } while (Piece == TETRIS_INVALID_PIECE);
-
-    PieceX = TETRIS_INITIAL_X;
-    PieceY = 0;
-    switch (Piece) {
-
-    //
-    // The line (I).
-    //
-
-    case 0:
-        Pixel = RGB_PIXEL(0x0, MAX_INTENSITY, MAX_INTENSITY) |
-                PIXEL_USER_BIT;
-
-        KeMatrix[PieceY][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 2] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 3] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The L poking up on the left (J).
-    //
-
-    case 1:
-        Pixel = RGB_PIXEL(0x0, 0x0, MAX_INTENSITY) | PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 2] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The L poking up on the right (L).
-    //
-
-    case 2:
-        Pixel = RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY / 2, 0x0) |
-                PIXEL_USER_BIT;
-
-        KeMatrix[PieceY + 1][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 2] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 2] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The box (O).
-    //
-
-    case 3:
-        Pixel = RGB_PIXEL(MAX_INTENSITY, MAX_INTENSITY, 0x0) |
-                PIXEL_USER_BIT;
-
-        KeMatrix[PieceY][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The zigzag going up and right (S).
-    //
-
-    case 4:
-        Pixel = RGB_PIXEL(0x0, MAX_INTENSITY, 0x0) | PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 2] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The tee (T).
-    //
-
-    case 5:
-        Pixel = RGB_PIXEL(MAX_INTENSITY, 0x0, MAX_INTENSITY) |
-                PIXEL_USER_BIT;
-
-        KeMatrix[PieceY + 1][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 2] |= PIXEL_USER_BIT;
-        break;
-
-    //
-    // The zigzag going down and right (Z).
-    //
-
-    case 6:
-    default:
-        Pixel = RGB_PIXEL(0x0, MAX_INTENSITY, 0x0) | PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 1] |= PIXEL_USER_BIT;
-        KeMatrix[PieceY + 1][PieceX + 2] |= PIXEL_USER_BIT;
-        break;
+        Type = HlRandom() & 7;
+    } while (Type == TETRIS_INVALID_PIECE);
+
+    Piece->Rotation = 0;
+    Piece->XPosition = TETRIS_INITIAL_X;
+    Piece->YPosition = 0;
+    if (TtDoesPieceFit(Type,
+                       Piece->Rotation,
+                       Piece->XPosition,
+                       Piece->YPosition) == FALSE) {
+
+        Piece->Type = TETRIS_INVALID_PIECE;
+        return TETRIS_INVALID_PIECE;
     }
 
-    *PositionX = PieceX;
-    *PositionY = PieceY;
-
-    //
-    // Check to see if any pieces marked were already blocks. If they were,
-    // fail.
-    //
-
-    for (YPixel = PieceY; YPixel < PieceY + 4; YPixel += 1) {
-        for (XPixel = PieceX; XPixel < PieceX + 4; XPixel += 1) {
-            if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                if ((KeMatrix[YPixel][XPixel] & (~PIXEL_USER_BIT)) != 0) {
-                    return TETRIS_INVALID_PIECE;
-
-                } else {
-                    KeMatrix[YPixel][XPixel] = Pixel;
-                }
-            }
-        }
-    }
-
-    return Piece;
+    Piece->Type = Type;
+    TtpDrawPiece(Piece, RtlReadProgramSpace16(&(TetrisPieceColor[Type])));
+    return Type;
 }
 
 UCHAR
-TtpMovePiece (
-    PUCHAR PieceX,
-    PUCHAR PieceY,
+TtMovePiece (
+    PTETRIS_PIECE Piece,
     CHAR VectorX,
     CHAR VectorY
     )
@@ -470,19 +417,16 @@ Routine Description:
 
 Arguments:
 
-    PieceX - Supplies a pointer to the current piece's X position on input. On
-        output, contains the piece's new position.
-
-    PieceY - Supplies a pointer to the current piece's Y position on input. On
-        output, contains the piece's new position.
+    Piece - Supplies a pointer to the current piece. On output, contains the
+        piece's new position.
 
     VectorX - Supplies how far to move the piece in the X direction. Valid
         values are -1, 0, and 1. If this value is non-zero, the Y vector is
         expected to be 0.
 
     VectorY - Supplies how far to move the piece in the Y direction. Valid
-        values are -1, 0, and 1. If this value is non-zero, the X vector is
-        expected to be 0.
+        values are 0 and 1, since pieces never move up. If this value is
+        non-zero, the X vector is expected to be 0.
 
 Return Value:
 
@@ -495,215 +439,27 @@ Return Value:
 
 {
 
-    USHORT NextPixel;
-    UCHAR OkayToMove;
-    UCHAR XPixel;
-    UCHAR YPixel;
-
-    OkayToMove = TRUE;
-
-    //
-    // Move the piece right.
-    //
-
-    if (VectorX == 1) {
-
-        //
-        // Check if every row can handle the move right.
-        //
-
-        for (YPixel = *PieceY;
-             ((YPixel < *PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-             YPixel += 1) {
-
-            for (XPixel = *PieceX + 3; XPixel >= *PieceX; XPixel -= 1) {
-
-                //
-                // If this box has a piece in it, then it is the rightmost
-                // pixel. If the pixel beyond it is not free, then the move
-                // must be vetoed.
-                //
-
-                if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                    NextPixel = KeMatrix[YPixel][XPixel + 1];
-                    if ((NextPixel != 0) &&
-                        ((NextPixel & PIXEL_USER_BIT) == 0)) {
-
-                        OkayToMove = FALSE;
-                        break;
-                    }
-                }
-            }
-
-            if (OkayToMove == FALSE) {
-                break;
-            }
-        }
-
-        //
-        // Move the piece if that's okay.
-        //
-
-        if (OkayToMove != FALSE) {
-            for (YPixel = *PieceY;
-                 ((YPixel < *PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-                 YPixel += 1) {
-
-                for (XPixel = *PieceX + 3; XPixel >= *PieceX; XPixel -= 1) {
-                    if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                        KeMatrix[YPixel][XPixel + 1] = KeMatrix[YPixel][XPixel];
-                        KeMatrix[YPixel][XPixel] = 0;
-                    }
-                }
-            }
-
-            *PieceX += 1;
-        }
-
-    //
-    // Move the piece left.
-    //
-
-    } else if (VectorX != 0) {
-
-        //
-        // Check if every row can handle the move left.
-        //
-
-        for (YPixel = *PieceY;
-             ((YPixel < *PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-             YPixel += 1) {
-
-            for (XPixel = *PieceX; XPixel < *PieceX + 4; XPixel += 1) {
-
-                //
-                // If this box has a piece in it, then it is the leftmost
-                // pixel. If the pixel beyond it is not free, then the move
-                // must be vetoed.
-                //
-
-                if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                    NextPixel = KeMatrix[YPixel][XPixel - 1];
-                    if ((NextPixel != 0) &&
-                        ((NextPixel & PIXEL_USER_BIT) == 0)) {
-
-                        OkayToMove = FALSE;
-                        break;
-                    }
-                }
-            }
-
-            if (OkayToMove == FALSE) {
-                break;
-            }
-        }
-
-        //
-        // Move the piece if that's okay.
-        //
-
-        if (OkayToMove != FALSE) {
-            for (YPixel = *PieceY;
-                 ((YPixel < *PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-                 YPixel += 1) {
-
-                for (XPixel = *PieceX; XPixel < *PieceX + 4; XPixel += 1) {
-                    if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                        KeMatrix[YPixel][XPixel - 1] = KeMatrix[YPixel][XPixel];
-                        KeMatrix[YPixel][XPixel] = 0;
-                    }
-                }
-            }
-
-            *PieceX -= 1;
-        }
-
-    //
-    // Move the piece down.
-    //
-
-    } else if (VectorY == 1) {
-
-        //
-        // Check if every column can move down.
-        //
-
-        for (XPixel = *PieceX; XPixel < *PieceX + 4; XPixel += 1) {
-            YPixel = *PieceY + 3;
-            if (YPixel > MATRIX_HEIGHT - 1) {
-                YPixel = MATRIX_HEIGHT - 1;
-            }
-
-            for (NOTHING;
-                 ((YPixel >= *PieceY) && (YPixel != (UCHAR)-1));
-                 YPixel -= 1) {
-
-                //
-                // If this pixel has a piece in it, then it is the bottom most
-                // pixel. If it cannot move down, then the move is vetoed.
-                //
-
-                if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                    if (YPixel == MATRIX_HEIGHT - 1) {
-                        OkayToMove = FALSE;
-                        break;
-                    }
-
-                    NextPixel = KeMatrix[YPixel + 1][XPixel];
-                    if ((NextPixel != 0) &&
-                        ((NextPixel & PIXEL_USER_BIT) == 0)) {
-
-                        OkayToMove = FALSE;
-                        break;
-                    }
-                }
-            }
-
-            if (OkayToMove == FALSE) {
-                break;
-            }
-        }
-
-        //
-        // Move the piece if that's okay.
-        //
-
-        if (OkayToMove != FALSE) {
-            for (XPixel = *PieceX ; XPixel < *PieceX + 4; XPixel += 1) {
-                YPixel = *PieceY + 3;
-                if (YPixel > MATRIX_HEIGHT - 1) {
-                    YPixel = MATRIX_HEIGHT - 1;
-                }
-
-                for (NOTHING;
-                     ((YPixel >= *PieceY) && (YPixel != (UCHAR)-1));
-                     YPixel -= 1) {
-
-                    if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                        KeMatrix[YPixel + 1][XPixel] = KeMatrix[YPixel][XPixel];
-                        KeMatrix[YPixel][XPixel] = 0;
-                    }
-                }
-            }
-
-            *PieceY += 1;
-        }
-
-    //
-    // Move the piece up. Not implemented.
-    //
+    UCHAR NewX;
+    UCHAR NewY;
+    USHORT Pixel;
 
-    } else if (VectorY != 0) {
-        OkayToMove = FALSE;
+    NewX = Piece->XPosition + VectorX;
+    NewY = Piece->YPosition + VectorY;
+    if (TtDoesPieceFit(Piece->Type, Piece->Rotation, NewX, NewY) == FALSE) {
+        return FALSE;
     }
 
-    return OkayToMove;
+    TtpDrawPiece(Piece, 0);
+    Piece->XPosition = NewX;
+    Piece->YPosition = NewY;
+    Pixel = RtlReadProgramSpace16(&(TetrisPieceColor[Piece->Type]));
+    TtpDrawPiece(Piece, Pixel);
+    return TRUE;
 }
 
 UCHAR
-TtpHandlePieceLockdown (
-    UCHAR PieceX,
-    UCHAR PieceY
+TtHandlePieceLockdown (
+    PTETRIS_PIECE Piece
     )
 
 /*++
@@ -714,9 +470,7 @@ Routine Description:
 
 Arguments:
 
-    PieceX - Supplies the piece's current X position.
-
-    PieceY - Supplies the piece's current Y position.
+    Piece - Supplies a pointer to the piece that has landed.
 
 Return Value:
 
@@ -726,55 +480,40 @@ Return Value:
 
 {
 
-    UCHAR CopyY;
-    UCHAR LineCompleted;
     UCHAR LinesCompleted;
+    USHORT Mask;
+    UCHAR Row;
+    UCHAR Shift;
     UCHAR SmallestY;
-    UCHAR XPixel;
     UCHAR YPixel;
 
     LinesCompleted = 0;
 
     //
-    // Unmark the piece as active.
+    // Merge the piece into the playfield, and light up any lines it completed.
     //
 
-    for (YPixel = PieceY;
-         ((YPixel < PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-         YPixel += 1) {
-
-        for (XPixel = PieceX; XPixel < PieceX + 4; XPixel += 1) {
-            KeMatrix[YPixel][XPixel] &= ~PIXEL_USER_BIT;
+    Shift = Piece->XPosition - TETRIS_LEFT_BORDER;
+    for (Row = 0; Row < TETRIS_PIECE_SIZE; Row += 1) {
+        YPixel = Piece->YPosition + Row;
+        if (YPixel >= MATRIX_HEIGHT) {
+            break;
         }
-    }
-
-    //
-    // Look for and mark completed lines.
-    //
-
-    for (YPixel = PieceY;
-         ((YPixel < PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-         YPixel += 1) {
 
-        LineCompleted = TRUE;
-        for (XPixel = TETRIS_LEFT_BORDER + 1;
-             XPixel < TETRIS_RIGHT_BORDER;
-             XPixel += 1) {
+        Mask = RtlReadProgramSpace8(
+                &(TetrisPieceShape[Piece->Type][Piece->Rotation][Row]));
 
-            if (KeMatrix[YPixel][XPixel] == 0) {
-                LineCompleted = FALSE;
-                break;
-            }
-        }
+        TetrisBoard[YPixel] |= Mask << Shift;
 
-        if (LineCompleted != FALSE) {
+        if (TetrisBoard[YPixel] == TETRIS_FULL_ROW) {
             LinesCompleted += 1;
-            for (XPixel = TETRIS_LEFT_BORDER + 1;
-                 XPixel < TETRIS_RIGHT_BORDER;
-                 XPixel += 1) {
-
-                KeMatrix[YPixel][XPixel] = 0xFFFF;
-            }
+            GrFillRectangle(TETRIS_LEFT_BORDER + 1,
+                            YPixel,
+                            TETRIS_RIGHT_BORDER - TETRIS_LEFT_BORDER - 1,
+                            1,
+                            RGB_PIXEL(MAX_INTENSITY,
+                                      MAX_INTENSITY,
+                                      MAX_INTENSITY));
         }
     }
 
@@ -789,86 +528,51 @@ Return Value:
     KeStall(32 * 150);
 
     //
-    // If lines are going to be deleted, find the highest (lowest value) line
-    // with a valid pixel in it, to optimize the block copies.
+    // Find the highest (lowest value) line with a block in it, to optimize the
+    // block copies.
     //
 
     SmallestY = 0;
-    while (TRUE) {
-        for (XPixel = TETRIS_LEFT_BORDER + 1;
-             XPixel < TETRIS_RIGHT_BORDER;
-             XPixel += 1) {
-
-            if (KeMatrix[SmallestY][XPixel] != 0) {
-                break;
-            }
-        }
-
-        //
-        // If the loop exited early then a filled pixel must have been found,
-        // in which case the highest up Y value has been located.
-        //
-
-        if (XPixel != TETRIS_RIGHT_BORDER) {
-            break;
-        }
-
+    while (TetrisBoard[SmallestY] == TETRIS_EMPTY_ROW) {
         SmallestY += 1;
     }
 
     //
-    // Take out any completed lines.
+    // Take out any completed lines by shifting everything between the highest
+    // filled line and this one down a row, blanking out the highest line.
     //
 
-    for (YPixel = PieceY;
-         ((YPixel < PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-         YPixel += 1) {
-
-        //
-        // Delete if the first pixel in the row has been marked for deletion.
-        //
-
-        if ((KeMatrix[YPixel][TETRIS_LEFT_BORDER + 1] & PIXEL_USER_BIT) != 0) {
-
-            //
-            // Copy each line from the line above it (watch out for the top
-            // line).
-            //
-
-            for (CopyY = YPixel; CopyY > SmallestY; CopyY -= 1) {
-                for (XPixel = TETRIS_LEFT_BORDER + 1;
-                     XPixel < TETRIS_RIGHT_BORDER;
-                     XPixel += 1) {
-
-                    if (CopyY == 0) {
-                        KeMatrix[CopyY][XPixel] = 0;
-
-                    } else {
-                        KeMatrix[CopyY][XPixel] = KeMatrix[CopyY - 1][XPixel];
-                    }
-                }
-            }
+    for (Row = 0; Row < TETRIS_PIECE_SIZE; Row += 1) {
+        YPixel = Piece->YPosition + Row;
+        if (YPixel >= MATRIX_HEIGHT) {
+            break;
+        }
 
-            //
-            // Blank out the highest line.
-            //
+        if (TetrisBoard[YPixel] != TETRIS_FULL_ROW) {
+            continue;
+        }
 
-            for (XPixel = TETRIS_LEFT_BORDER + 1;
-                 XPixel < TETRIS_RIGHT_BORDER;
-                 XPixel += 1) {
+        GrScrollRows(TETRIS_LEFT_BORDER + 1,
+                     SmallestY,
+                     TETRIS_RIGHT_BORDER - TETRIS_LEFT_BORDER - 1,
+                     YPixel - SmallestY + 1,
+                     1,
+                     0);
 
-                KeMatrix[SmallestY][XPixel] = 0;
-            }
+        while (YPixel > SmallestY) {
+            TetrisBoard[YPixel] = TetrisBoard[YPixel - 1];
+            YPixel -= 1;
         }
+
+        TetrisBoard[SmallestY] = TETRIS_EMPTY_ROW;
     }
 
     return LinesCompleted;
 }
 
 VOID
-TtpRotatePiece (
-    PUCHAR PieceX,
-    PUCHAR PieceY
+TtRotatePiece (
+    PTETRIS_PIECE Piece
     )
 
 /*++
@@ -879,11 +583,8 @@ Routine Description:
 
 Arguments:
 
-    PieceX - Supplies a pointer to the current piece's X position on input. On
-        output, contains the piece's new position.
-
-    PieceY - Supplies a pointer to the current piece's Y position on input. On
-        output, contains the piece's new position.
+    Piece - Supplies a pointer to the current piece. On output, contains the
+        piece's new rotation.
 
 Return Value:
 
@@ -893,117 +594,120 @@ Return Value:
 
 {
 
-    USHORT DestinationPixel;
-    UCHAR DimensionX;
-    UCHAR DimensionY;
     USHORT Pixel;
-    UCHAR RotatedPiece[4][4];
-    USHORT SourcePixel;
-    UCHAR XPixel;
-    UCHAR YPixel;
+    UCHAR Rotation;
 
-    //
-    // Determine the dimension of this piece and zero out the rotate local.
-    //
+    Rotation = (Piece->Rotation + 1) & (TETRIS_ROTATIONS - 1);
+    if (TtDoesPieceFit(Piece->Type,
+                       Rotation,
+                       Piece->XPosition,
+                       Piece->YPosition) == FALSE) {
 
-    DimensionX = 0;
-    DimensionY = 0;
-    Pixel = 0;
-    for (YPixel = *PieceY;
-         ((YPixel < *PieceY + 4) && (YPixel < MATRIX_HEIGHT));
-         YPixel += 1) {
-
-        for (XPixel = *PieceX; XPixel < *PieceX + 4; XPixel += 1) {
-            RotatedPiece[YPixel - *PieceY][XPixel - *PieceX] = 0;
-            if ((KeMatrix[YPixel][XPixel] & PIXEL_USER_BIT) != 0) {
-                Pixel = KeMatrix[YPixel][XPixel];
-                if ((YPixel - *PieceY) > DimensionY) {
-                    DimensionY = YPixel - *PieceY;
-                }
-
-                if ((XPixel - *PieceX) > DimensionX) {
-                    DimensionX = XPixel - *PieceX;
-                }
-            }
-        }
+        return;
     }
 
-    //
-    // If rotating the image causes the image to fall off the bottom, don't
-    // do it.
-    //
+    TtpDrawPiece(Piece, 0);
+    Piece->Rotation = Rotation;
+    Pixel = RtlReadProgramSpace16(&(TetrisPieceColor[Piece->Type]));
+    TtpDrawPiece(Piece, Pixel);
+    return;
+}
 
-    if (*PieceY + DimensionX >= MATRIX_HEIGHT) {
-        return;
-    }
+UCHAR
+TtDoesPieceFit (
+    UCHAR Type,
+    UCHAR Rotation,
+    UCHAR XPosition,
+    UCHAR YPosition
+    )
 
-    //
-    // Construct the rotated image and check to see if it can be rotated at
-    // the same time.
-    //
+/*++
 
-    for (YPixel = 0; YPixel <= DimensionX; YPixel += 1) {
-        for (XPixel = 0; XPixel <= DimensionY; XPixel += 1) {
+Routine Description:
 
-            //
-            // If the *source* pixel was originally marked, check the
-            // destination pixel.
-            //
+    This routine determines whether a piece could sit at the given position
+    without running into the borders, the floor, or any settled blocks.
 
-            SourcePixel = KeMatrix[*PieceY + (DimensionY - XPixel)]
-                                  [*PieceX + YPixel];
+Arguments:
 
-            if ((SourcePixel & PIXEL_USER_BIT) != 0) {
+    Type - Supplies the index of the piece.
 
-                //
-                // If the destination pixel is not an active pixel but is
-                // colored, the block cannot rotate.
-                //
+    Rotation - Supplies the rotation of the piece.
 
-                DestinationPixel = KeMatrix[*PieceY + YPixel][*PieceX + XPixel];
-                if (((DestinationPixel & PIXEL_USER_BIT) == 0) &&
-                    ((DestinationPixel & (~PIXEL_USER_BIT)) != 0)) {
+    XPosition - Supplies the X coordinate of the top left of the piece's box.
 
-                    return;
-                }
+    YPosition - Supplies the Y coordinate of the top left of the piece's box.
 
-                RotatedPiece[YPixel][XPixel] = 1;
-            }
-        }
-    }
+Return Value:
 
-    //
-    // If execution got here without returning, the piece must be okay to
-    // rotate. Light up any new pixels and blank out any old ones.
-    //
+    TRUE if the piece fits.
 
-    for (YPixel = 0; YPixel < 4; YPixel += 1) {
-        if (YPixel >= MATRIX_HEIGHT) {
-            break;
-        }
+    FALSE if the piece would overlap something.
 
-        for (XPixel = 0; XPixel < 4; XPixel += 1) {
+--*/
 
-            //
-            // If the pixel is set in the destination, just set it.
-            //
+{
 
-            if (RotatedPiece[YPixel][XPixel] != 0) {
-                KeMatrix[*PieceY + YPixel][*PieceX + XPixel] = Pixel;
+    USHORT Mask;
+    UCHAR Row;
+    UCHAR Shift;
 
-            //
-            // If the piece wasn't set in the destination but was set in the
-            // source as part of the active piece, blank it out.
-            //
+    Shift = XPosition - TETRIS_LEFT_BORDER;
+    for (Row = 0; Row < TETRIS_PIECE_SIZE; Row += 1) {
+        Mask = RtlReadProgramSpace8(&(TetrisPieceShape[Type][Rotation][Row]));
+        if (Mask == 0) {
+            continue;
+        }
 
-            } else if ((KeMatrix[*PieceY + YPixel][*PieceX + XPixel] &
-                        PIXEL_USER_BIT) != 0) {
+        if (YPosition + Row >= MATRIX_HEIGHT) {
+            return FALSE;
+        }
 
-                KeMatrix[*PieceY + YPixel][*PieceX + XPixel] = 0;
-            }
+        if ((TetrisBoard[YPosition + Row] & (Mask << Shift)) != 0) {
+            return FALSE;
         }
     }
 
+    return TRUE;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+TtpDrawPiece (
+    PTETRIS_PIECE Piece,
+    USHORT Pixel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine paints every block of a piece onto the screen.
+
+Arguments:
+
+    Piece - Supplies a pointer to the piece to draw.
+
+    Pixel - Supplies the color to paint the piece with. Supply 0 to erase it.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    GrBlitMaskedSprite(Piece->XPosition,
+                       Piece->YPosition,
+                       8,
+                       TETRIS_PIECE_SIZE,
+                       (PPGM)(TetrisPieceShape[Piece->Type][Piece->Rotation]),
+                       Pixel);
+
     return;
 }
 
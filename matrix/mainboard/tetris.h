@@ -0,0 +1,271 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    tetris.h
+
+Abstract:
+
+    This header contains definitions related to the Tetris game, shared
+    between the game and the host benchmark that plays it.
+
+Author:
+
+    Evan Green 14-Nov-2010
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the borders created to keep the game manageable.
+//
+
+#define TETRIS_LEFT_BORDER 5
+#define TETRIS_RIGHT_BORDER 16
+
+//
+// Define the initial location where pieces show up.
+//
+
+#define TETRIS_INITIAL_X 10
+
+//
+// Define the "invalid piece", which is no piece at all.
+//
+
+#define TETRIS_INVALID_PIECE 7
+
+//
+// Define the number of different pieces and the number of ways each can be
+// turned.
+//
+
+#define TETRIS_PIECE_COUNT 7
+#define TETRIS_ROTATIONS 4
+
+//
+// Define the size of the box each piece and rotation fits inside.
+//
+
+#define TETRIS_PIECE_SIZE 4
+
+//
+// Define the most lines a single piece can complete.
+//
+
+#define TETRIS_MAX_LINES TETRIS_PIECE_SIZE
+
+//
+// The playfield is mirrored as one occupancy mask per row, where bit zero is
+// the left border column. The right border and everything past it always read
+// as occupied, so a row is complete when every bit is set.
+//
+
+#define TETRIS_EMPTY_ROW \
+    (USHORT)((0xFFFF << (TETRIS_RIGHT_BORDER - TETRIS_LEFT_BORDER)) | 0x0001)
+
+#define TETRIS_FULL_ROW 0xFFFF
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the falling piece.
+
+Members:
+
+    Type - Stores the index of the piece, or TETRIS_INVALID_PIECE if there is
+        no piece in play.
+
+    Rotation - Stores how many times the piece has been turned clockwise from
+        the way it first appears.
+
+    XPosition - Stores the X coordinate of the top left of the piece's box.
+
+    YPosition - Stores the Y coordinate of the top left of the piece's box.
+
+--*/
+
+typedef struct _TETRIS_PIECE {
+    UCHAR Type;
+    UCHAR Rotation;
+    UCHAR XPosition;
+    UCHAR YPosition;
+} TETRIS_PIECE, *PTETRIS_PIECE;
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Define a global containing the shape of each piece in each rotation, as one
+// mask per row of the piece's box.
+//
+
+extern const UCHAR TetrisPieceShape[TETRIS_PIECE_COUNT][TETRIS_ROTATIONS]
+                                   [TETRIS_PIECE_SIZE] PROGMEM;
+
+//
+// Define a global containing the occupancy mask of each row of the playfield.
+// This header must come after mainboard.h for the matrix height.
+//
+
+extern USHORT TetrisBoard[MATRIX_HEIGHT];
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+//
+// Game Engine Functions
+//
+
+UCHAR
+TtGenerateNewPiece (
+    PTETRIS_PIECE Piece
+    );
+
+/*++
+
+Routine Description:
+
+    This routine generates a new tetris piece.
+
+Arguments:
+
+    Piece - Supplies a pointer where the new piece will be returned.
+
+Return Value:
+
+    Returns the index of the new piece.
+
+    TETRIS_INVALID_PIECE if the piece could not be generated because there were
+    blocks in the way. The game is over.
+
+--*/
+
+UCHAR
+TtMovePiece (
+    PTETRIS_PIECE Piece,
+    CHAR VectorX,
+    CHAR VectorY
+    );
+
+/*++
+
+Routine Description:
+
+    This routine moves a tetris piece by one position. It is assumed that the
+    piece moves in either the X direction or the Y direction, but not both.
+
+Arguments:
+
+    Piece - Supplies a pointer to the current piece. On output, contains the
+        piece's new position.
+
+    VectorX - Supplies how far to move the piece in the X direction. Valid
+        values are -1, 0, and 1. If this value is non-zero, the Y vector is
+        expected to be 0.
+
+    VectorY - Supplies how far to move the piece in the Y direction. Valid
+        values are -1, 0, and 1. If this value is non-zero, the X vector is
+        expected to be 0.
+
+Return Value:
+
+    Returns TRUE if the piece was successfully moved.
+
+    Returns FALSE if an obstacle blocks that piece from moving in the desired
+    direction.
+
+--*/
+
+UCHAR
+TtHandlePieceLockdown (
+    PTETRIS_PIECE Piece
+    );
+
+/*++
+
+Routine Description:
+
+    This routine locks a piece in place and handles any disappearing rows.
+
+Arguments:
+
+    Piece - Supplies a pointer to the piece that has landed.
+
+Return Value:
+
+    Returns the number of lines that were cleared by this piece setting in.
+
+--*/
+
+VOID
+TtRotatePiece (
+    PTETRIS_PIECE Piece
+    );
+
+/*++
+
+Routine Description:
+
+    This routine rotates a tetris piece 90 degrees clockwise if possible.
+
+Arguments:
+
+    Piece - Supplies a pointer to the current piece. On output, contains the
+        piece's new rotation.
+
+Return Value:
+
+    None.
+
+--*/
+
+UCHAR
+TtDoesPieceFit (
+    UCHAR Type,
+    UCHAR Rotation,
+    UCHAR XPosition,
+    UCHAR YPosition
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether a piece could sit at the given position
+    without running into the borders, the floor, or any settled blocks.
+
+Arguments:
+
+    Type - Supplies the index of the piece.
+
+    Rotation - Supplies the rotation of the piece.
+
+    XPosition - Supplies the X coordinate of the top left of the piece's box.
+
+    YPosition - Supplies the Y coordinate of the top left of the piece's box.
+
+Return Value:
+
+    TRUE if the piece fits.
+
+    FALSE if the piece would overlap something.
+
+--*/
+
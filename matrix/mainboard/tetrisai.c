@@ -0,0 +1,1093 @@
+/*++
+
+Copyright (c) 2010 Evan Green
+
+Module Name:
+
+    tetrisai.c
+
+Abstract:
+
+    This module implements a headless Tetris player, used to benchmark the
+    game engine. A heuristic player picks where every piece goes and feeds the
+    moves straight to the engine, playing as many pieces as it is told to
+    while checking the playfield after every one. The same games are then
+    replayed without the player to time the engine by itself.
+
+Author:
+
+    Evan Green 14-Nov-2010
+
+Environment:
+
+    Build
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#define MATRIX_HOST_PROGRAM
+
+#include "types.h"
+#include "mainboard.h"
+#include "tetris.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define USAGE_STRING \
+    "TetrisAi plays Tetris against itself as fast as it can, and reports how " \
+    "fast the\ngame engine went. Every game is played twice: once with the " \
+    "player choosing\nthe moves and checking the playfield, and once " \
+    "replaying the same moves to\ntime the engine by itself.\n\n" \
+    "Usage: TetrisAi [-p Pieces] [-s Seed]\n\n" \
+    "Options:\n" \
+    "    -p  Play the given number of pieces. The default is %d.\n" \
+    "    -s  Seed the piece generator with the given value. The default is " \
+    "%d.\n\n"
+
+#define DEFAULT_PIECE_COUNT 1000000
+#define DEFAULT_SEED 1
+
+//
+// Define the mask of the playfield columns within a row of the board.
+//
+
+#define PLAYFIELD_MASK (USHORT)(~TETRIS_EMPTY_ROW)
+
+//
+// Define the number of columns in the playfield.
+//
+
+#define PLAYFIELD_WIDTH (TETRIS_RIGHT_BORDER - TETRIS_LEFT_BORDER - 1)
+
+//
+// Define how many blocks are in every piece.
+//
+
+#define PIECE_BLOCKS 4
+
+//
+// Define the weights the player scores a placement with, in thousandths.
+// Tall stacks, covered holes and jagged surfaces are bad, and completed lines
+// are good.
+//
+
+#define WEIGHT_HEIGHT (-510)
+#define WEIGHT_LINES 761
+#define WEIGHT_HOLES (-357)
+#define WEIGHT_BUMPINESS (-184)
+
+//
+// Define how a move is recorded for the replay: the rotation in the low bits
+// and the X position above it.
+//
+
+#define MOVE_ROTATION_MASK 0x03
+#define MOVE_X_SHIFT 2
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef unsigned char BOOL;
+
+/*++
+
+Structure Description:
+
+    This structure stores the results of a run of games.
+
+Members:
+
+    Pieces - Stores the number of pieces played.
+
+    Games - Stores the number of games started.
+
+    Lines - Stores the number of pieces that completed each number of lines.
+
+    Violations - Stores the number of times the engine broke one of its
+        invariants.
+
+    Seconds - Stores the time the run took.
+
+--*/
+
+typedef struct _BENCHMARK_RESULTS {
+    ULONG Pieces;
+    ULONG Games;
+    ULONG Lines[TETRIS_MAX_LINES + 1];
+    ULONG Violations;
+    double Seconds;
+} BENCHMARK_RESULTS, *PBENCHMARK_RESULTS;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+PlayGames (
+    ULONG PieceCount,
+    ULONG Seed,
+    PUCHAR Moves,
+    BOOL Replay,
+    PBENCHMARK_RESULTS Results
+    );
+
+VOID
+ResetGame (
+    VOID
+    );
+
+VOID
+ChoosePlacement (
+    PTETRIS_PIECE Piece,
+    PUCHAR Rotation,
+    PUCHAR XPosition
+    );
+
+LONG
+ScorePlacement (
+    UCHAR Type,
+    UCHAR Rotation,
+    UCHAR XPosition,
+    UCHAR YPosition
+    );
+
+BOOL
+PlacePiece (
+    PTETRIS_PIECE Piece,
+    UCHAR Rotation,
+    UCHAR XPosition
+    );
+
+ULONG
+CheckPlayfield (
+    ULONG PreviousBlocks,
+    UCHAR LinesCleared,
+    PULONG Blocks
+    );
+
+ULONG
+CountBits (
+    USHORT Value
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Define the parts of the kernel state the game touches.
+//
+
+volatile USHORT KeMatrix[MATRIX_HEIGHT][MATRIX_WIDTH];
+volatile USHORT KeTrackball1;
+volatile USHORT KeTrackball2;
+volatile USHORT KeInputEdges;
+volatile ULONG KeRawTime;
+
+//
+// Store the state of the piece generator.
+//
+
+ULONG RandomState;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INT
+main (
+    INT argc,
+    CHAR **argv
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the program. It collects the
+    options passed to it, plays the games, replays them, and prints the
+    results.
+
+Arguments:
+
+    argc - Supplies the number of command line arguments the program was invoked
+           with.
+
+    argv - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 if the engine kept all of its invariants,
+    nonzero otherwise.
+
+--*/
+
+{
+
+    PCHAR Argument;
+    ULONG Index;
+    PUCHAR Moves;
+    ULONG PieceCount;
+    BENCHMARK_RESULTS Play;
+    BENCHMARK_RESULTS Replay;
+    INT Result;
+    ULONG Seed;
+
+    PieceCount = DEFAULT_PIECE_COUNT;
+    Seed = DEFAULT_SEED;
+    while ((argc > 1) && (argv[1][0] == '-')) {
+        Argument = &(argv[1][1]);
+        if ((strcmp(Argument, "p") == 0) || (strcmp(Argument, "s") == 0)) {
+            argc -= 1;
+            argv += 1;
+            if (argv[1] == NULL) {
+                fprintf(stderr, USAGE_STRING, DEFAULT_PIECE_COUNT,
+                        DEFAULT_SEED);
+
+                return 1;
+            }
+
+            if (*Argument == 'p') {
+                PieceCount = strtoul(argv[1], NULL, 10);
+
+            } else {
+                Seed = strtoul(argv[1], NULL, 10);
+            }
+
+        } else {
+            fprintf(stderr, "%s: Invalid option\n\n", Argument);
+            fprintf(stderr, USAGE_STRING, DEFAULT_PIECE_COUNT, DEFAULT_SEED);
+            return 1;
+        }
+
+        argc -= 1;
+        argv += 1;
+    }
+
+    if ((argc > 1) || (PieceCount == 0)) {
+        fprintf(stderr, USAGE_STRING, DEFAULT_PIECE_COUNT, DEFAULT_SEED);
+        return 1;
+    }
+
+    Moves = malloc(PieceCount);
+    if (Moves == NULL) {
+        fprintf(stderr, "Error: Failed to allocate %d moves.\n",
+                (INT)PieceCount);
+
+        return 1;
+    }
+
+    PlayGames(PieceCount, Seed, Moves, FALSE, &Play);
+    PlayGames(PieceCount, Seed, Moves, TRUE, &Replay);
+
+    //
+    // The replay makes the same moves with the same pieces, so it had better
+    // come out the same.
+    //
+
+    if ((Replay.Games != Play.Games) ||
+        (memcmp(Replay.Lines, Play.Lines, sizeof(Play.Lines)) != 0)) {
+
+        fprintf(stderr, "Error: The replay did not match the original game.\n");
+        Play.Violations += 1;
+    }
+
+    Play.Violations += Replay.Violations;
+    printf("TetrisAi: Played %d pieces in %d games with seed %d.\n",
+           (INT)Play.Pieces,
+           (INT)Play.Games,
+           (INT)Seed);
+
+    printf("TetrisAi: Play:   %8.3f seconds, %10.0f pieces per second.\n",
+           Play.Seconds,
+           Play.Pieces / Play.Seconds);
+
+    printf("TetrisAi: Replay: %8.3f seconds, %10.0f pieces per second.\n",
+           Replay.Seconds,
+           Replay.Pieces / Replay.Seconds);
+
+    printf("TetrisAi: %-6s %10s\n", "Lines", "Pieces");
+    for (Index = 0; Index <= TETRIS_MAX_LINES; Index += 1) {
+        printf("TetrisAi: %-6d %10d\n", (INT)Index, (INT)Play.Lines[Index]);
+    }
+
+    printf("TetrisAi: %d invariant violations.\n", (INT)Play.Violations);
+    Result = 0;
+    if (Play.Violations != 0) {
+        Result = 1;
+    }
+
+    free(Moves);
+    return Result;
+}
+
+//
+// The game calls into these kernel routines. The benchmark never waits, so the
+// pause that shows off completed lines goes by instantly.
+//
+
+APPLICATION
+KeRunMenu (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine polls for a menu keypress. There is no menu here.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns ApplicationNone.
+
+--*/
+
+{
+
+    return ApplicationNone;
+}
+
+UCHAR
+KeGetInputEvent (
+    PINPUT_EVENT Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the oldest entry from the input event queue. The
+    player feeds its moves to the game directly, so the queue is always empty.
+
+Arguments:
+
+    Event - Supplies a pointer where the input event would be returned.
+
+Return Value:
+
+    FALSE, as there are never any events.
+
+--*/
+
+{
+
+    return FALSE;
+}
+
+VOID
+KeStall (
+    ULONG StallTime
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stalls execution for the desired amount of time, which here
+    is no time at all.
+
+Arguments:
+
+    StallTime - Supplies the time to stall in ms/32.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    return;
+}
+
+VOID
+KeClearScreen (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine blanks the output matrix.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR XPixel;
+    UCHAR YPixel;
+
+    for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
+        for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
+            KeMatrix[YPixel][XPixel] = 0;
+        }
+    }
+
+    return;
+}
+
+VOID
+KeAcknowledgeInputEdges (
+    USHORT Inputs
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clears the given inputs out of the input edges. There are no
+    interrupts here to race with.
+
+Arguments:
+
+    Inputs - Supplies the mask of inputs to clear.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeInputEdges &= ~Inputs;
+    return;
+}
+
+USHORT
+HlRandom (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a random number between 0 and 65535. The sequence
+    only depends on the seed, so a run can be played again exactly.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a random number.
+
+--*/
+
+{
+
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    RandomState &= 0xFFFFFFFFUL;
+    return (USHORT)(RandomState >> 16);
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+PlayGames (
+    ULONG PieceCount,
+    ULONG Seed,
+    PUCHAR Moves,
+    BOOL Replay,
+    PBENCHMARK_RESULTS Results
+    )
+
+/*++
+
+Routine Description:
+
+    This routine plays games until the given number of pieces have been
+    played, starting a new game whenever the last one ends.
+
+Arguments:
+
+    PieceCount - Supplies the number of pieces to play.
+
+    Seed - Supplies the seed for the piece generator.
+
+    Moves - Supplies a pointer to the move made with each piece. When playing,
+        the player's moves are recorded here. When replaying, the moves are
+        read from here instead.
+
+    Replay - Supplies a boolean indicating whether to replay the recorded
+        moves (TRUE) or have the player pick them and check the playfield after
+        every piece (FALSE).
+
+    Results - Supplies a pointer where the results of the run will be
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Blocks;
+    clock_t End;
+    UCHAR LinesCleared;
+    TETRIS_PIECE Piece;
+    UCHAR Rotation;
+    clock_t Start;
+    UCHAR XPosition;
+
+    memset(Results, 0, sizeof(BENCHMARK_RESULTS));
+    RandomState = Seed;
+    if (RandomState == 0) {
+        RandomState = DEFAULT_SEED;
+    }
+
+    Blocks = 0;
+    Start = clock();
+    ResetGame();
+    Results->Games = 1;
+    while (Results->Pieces < PieceCount) {
+        if (TtGenerateNewPiece(&Piece) == TETRIS_INVALID_PIECE) {
+            ResetGame();
+            Blocks = 0;
+            Results->Games += 1;
+            continue;
+        }
+
+        if (Replay != FALSE) {
+            Rotation = Moves[Results->Pieces] & MOVE_ROTATION_MASK;
+            XPosition = Moves[Results->Pieces] >> MOVE_X_SHIFT;
+
+        } else {
+            ChoosePlacement(&Piece, &Rotation, &XPosition);
+            Moves[Results->Pieces] = (XPosition << MOVE_X_SHIFT) | Rotation;
+        }
+
+        //
+        // The player only picks places it checked the piece could get to, so
+        // the engine disagreeing with its own fit test is a bug.
+        //
+
+        if (PlacePiece(&Piece, Rotation, XPosition) == FALSE) {
+            Results->Violations += 1;
+        }
+
+        LinesCleared = TtHandlePieceLockdown(&Piece);
+        if (Replay == FALSE) {
+            Results->Violations += CheckPlayfield(Blocks,
+                                                  LinesCleared,
+                                                  &Blocks);
+        }
+
+        if (LinesCleared > TETRIS_MAX_LINES) {
+            LinesCleared = TETRIS_MAX_LINES;
+        }
+
+        Results->Lines[LinesCleared] += 1;
+        Results->Pieces += 1;
+    }
+
+    End = clock();
+    Results->Seconds = (double)(End - Start) / CLOCKS_PER_SEC;
+    if (Results->Seconds == 0) {
+        Results->Seconds = 1.0 / CLOCKS_PER_SEC;
+    }
+
+    return;
+}
+
+VOID
+ResetGame (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine empties the playfield and the screen for a new game.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Row;
+
+    KeClearScreen();
+    for (Row = 0; Row < MATRIX_HEIGHT; Row += 1) {
+        TetrisBoard[Row] = TETRIS_EMPTY_ROW;
+    }
+
+    return;
+}
+
+VOID
+ChoosePlacement (
+    PTETRIS_PIECE Piece,
+    PUCHAR Rotation,
+    PUCHAR XPosition
+    )
+
+/*++
+
+Routine Description:
+
+    This routine picks where a freshly generated piece should go. Every
+    rotation and column the piece can reach by turning where it appeared and
+    then sliding sideways is dropped and scored, and the best one wins.
+
+Arguments:
+
+    Piece - Supplies a pointer to the new piece.
+
+    Rotation - Supplies a pointer where the chosen rotation will be returned.
+
+    XPosition - Supplies a pointer where the chosen X position will be
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LONG BestScore;
+    BOOL Chosen;
+    UCHAR CurrentRotation;
+    UCHAR CurrentX;
+    UCHAR MaxX;
+    UCHAR MinX;
+    LONG Score;
+    UCHAR YPosition;
+
+    BestScore = 0;
+    Chosen = FALSE;
+    *Rotation = Piece->Rotation;
+    *XPosition = Piece->XPosition;
+    for (CurrentRotation = 0;
+         CurrentRotation < TETRIS_ROTATIONS;
+         CurrentRotation += 1) {
+
+        //
+        // Every turn has to fit, so once one doesn't, the ones after it are
+        // out of reach too.
+        //
+
+        if (TtDoesPieceFit(Piece->Type,
+                           CurrentRotation,
+                           Piece->XPosition,
+                           Piece->YPosition) == FALSE) {
+
+            break;
+        }
+
+        MinX = Piece->XPosition;
+        while (TtDoesPieceFit(Piece->Type,
+                              CurrentRotation,
+                              MinX - 1,
+                              Piece->YPosition) != FALSE) {
+
+            MinX -= 1;
+        }
+
+        MaxX = Piece->XPosition;
+        while (TtDoesPieceFit(Piece->Type,
+                              CurrentRotation,
+                              MaxX + 1,
+                              Piece->YPosition) != FALSE) {
+
+            MaxX += 1;
+        }
+
+        for (CurrentX = MinX; CurrentX <= MaxX; CurrentX += 1) {
+            YPosition = Piece->YPosition;
+            while (TtDoesPieceFit(Piece->Type,
+                                  CurrentRotation,
+                                  CurrentX,
+                                  YPosition + 1) != FALSE) {
+
+                YPosition += 1;
+            }
+
+            Score = ScorePlacement(Piece->Type,
+                                   CurrentRotation,
+                                   CurrentX,
+                                   YPosition);
+
+            if ((Chosen == FALSE) || (Score > BestScore)) {
+                BestScore = Score;
+                Chosen = TRUE;
+                *Rotation = CurrentRotation;
+                *XPosition = CurrentX;
+            }
+        }
+    }
+
+    return;
+}
+
+LONG
+ScorePlacement (
+    UCHAR Type,
+    UCHAR Rotation,
+    UCHAR XPosition,
+    UCHAR YPosition
+    )
+
+/*++
+
+Routine Description:
+
+    This routine scores the playfield that would be left by setting a piece
+    down in the given place.
+
+Arguments:
+
+    Type - Supplies the index of the piece.
+
+    Rotation - Supplies the rotation of the piece.
+
+    XPosition - Supplies the X coordinate of the top left of the piece's box.
+
+    YPosition - Supplies the Y coordinate where the piece comes to rest.
+
+Return Value:
+
+    Returns the score of the placement. Higher is better.
+
+--*/
+
+{
+
+    USHORT Board[MATRIX_HEIGHT];
+    USHORT Column;
+    USHORT Covered;
+    LONG Height;
+    LONG Heights[TETRIS_RIGHT_BORDER - TETRIS_LEFT_BORDER];
+    LONG Holes;
+    UCHAR Index;
+    LONG Lines;
+    USHORT Mask;
+    USHORT NewlyCovered;
+    LONG Roughness;
+    LONG Row;
+    LONG Source;
+    UCHAR Shift;
+    LONG TotalHeight;
+
+    //
+    // Set the piece down on a copy of the playfield.
+    //
+
+    memcpy(Board, TetrisBoard, sizeof(Board));
+    Shift = XPosition - TETRIS_LEFT_BORDER;
+    for (Index = 0; Index < TETRIS_PIECE_SIZE; Index += 1) {
+        if (YPosition + Index >= MATRIX_HEIGHT) {
+            break;
+        }
+
+        Mask = RtlReadProgramSpace8(&(TetrisPieceShape[Type][Rotation][Index]));
+        Board[YPosition + Index] |= Mask << Shift;
+    }
+
+    //
+    // Take out the completed lines, working up from the bottom.
+    //
+
+    Lines = 0;
+    Source = MATRIX_HEIGHT - 1;
+    for (Row = MATRIX_HEIGHT - 1; Row >= 0; Row -= 1) {
+        while ((Source >= 0) && (Board[Source] == TETRIS_FULL_ROW)) {
+            Lines += 1;
+            Source -= 1;
+        }
+
+        if (Source >= 0) {
+            Board[Row] = Board[Source];
+            Source -= 1;
+
+        } else {
+            Board[Row] = TETRIS_EMPTY_ROW;
+        }
+    }
+
+    //
+    // Work down from the top. A column's height is set by its first block,
+    // every empty cell under a block is a hole, and every row a column is
+    // covered in adds one to the total height.
+    //
+
+    memset(Heights, 0, sizeof(Heights));
+    Covered = 0;
+    Holes = 0;
+    TotalHeight = 0;
+    Row = 0;
+    while ((Row < MATRIX_HEIGHT) && (Board[Row] == TETRIS_EMPTY_ROW)) {
+        Row += 1;
+    }
+
+    while (Row < MATRIX_HEIGHT) {
+        Holes += CountBits(Covered & ~Board[Row]);
+        NewlyCovered = Board[Row] & PLAYFIELD_MASK & ~Covered;
+        Covered |= NewlyCovered;
+        TotalHeight += CountBits(Covered);
+        Column = 0;
+        while (NewlyCovered != 0) {
+            if ((NewlyCovered & 0x1) != 0) {
+                Heights[Column] = MATRIX_HEIGHT - Row;
+            }
+
+            NewlyCovered >>= 1;
+            Column += 1;
+        }
+
+        Row += 1;
+    }
+
+    Roughness = 0;
+    for (Column = 2; Column <= PLAYFIELD_WIDTH; Column += 1) {
+        Height = Heights[Column] - Heights[Column - 1];
+        if (Height < 0) {
+            Height = -Height;
+        }
+
+        Roughness += Height;
+    }
+
+    return (WEIGHT_HEIGHT * TotalHeight) + (WEIGHT_LINES * Lines) +
+           (WEIGHT_HOLES * Holes) + (WEIGHT_BUMPINESS * Roughness);
+}
+
+BOOL
+PlacePiece (
+    PTETRIS_PIECE Piece,
+    UCHAR Rotation,
+    UCHAR XPosition
+    )
+
+/*++
+
+Routine Description:
+
+    This routine makes the moves that take a piece to the given place: turning
+    it, sliding it over, and letting it fall until it lands.
+
+Arguments:
+
+    Piece - Supplies a pointer to the piece to move.
+
+    Rotation - Supplies the rotation to turn the piece to.
+
+    XPosition - Supplies the X position to slide the piece to.
+
+Return Value:
+
+    TRUE if the piece got there.
+
+    FALSE if the engine refused one of the moves.
+
+--*/
+
+{
+
+    UCHAR PreviousRotation;
+
+    while (Piece->Rotation != Rotation) {
+        PreviousRotation = Piece->Rotation;
+        TtRotatePiece(Piece);
+        if (Piece->Rotation == PreviousRotation) {
+            return FALSE;
+        }
+    }
+
+    while (Piece->XPosition > XPosition) {
+        if (TtMovePiece(Piece, -1, 0) == FALSE) {
+            return FALSE;
+        }
+    }
+
+    while (Piece->XPosition < XPosition) {
+        if (TtMovePiece(Piece, 1, 0) == FALSE) {
+            return FALSE;
+        }
+    }
+
+    while (TtMovePiece(Piece, 0, 1) != FALSE) {
+        NOTHING;
+    }
+
+    return TRUE;
+}
+
+ULONG
+CheckPlayfield (
+    ULONG PreviousBlocks,
+    UCHAR LinesCleared,
+    PULONG Blocks
+    )
+
+/*++
+
+Routine Description:
+
+    This routine checks the playfield after a piece has locked down. The
+    borders must still be solid, no completed line may be left behind, every
+    block must be accounted for, and the screen must show exactly the blocks
+    in the playfield.
+
+Arguments:
+
+    PreviousBlocks - Supplies the number of blocks in the playfield before the
+        piece locked down.
+
+    LinesCleared - Supplies the number of lines the engine said the piece
+        cleared.
+
+    Blocks - Supplies a pointer where the number of blocks now in the
+        playfield will be returned.
+
+Return Value:
+
+    Returns the number of invariants that were broken.
+
+--*/
+
+{
+
+    USHORT Bit;
+    ULONG Count;
+    UCHAR Lit;
+    UCHAR Row;
+    ULONG Violations;
+    UCHAR XPixel;
+
+    Count = 0;
+    Violations = 0;
+    if (LinesCleared > TETRIS_MAX_LINES) {
+        fprintf(stderr, "Error: One piece cleared %d lines.\n", LinesCleared);
+        Violations += 1;
+    }
+
+    for (Row = 0; Row < MATRIX_HEIGHT; Row += 1) {
+        if ((TetrisBoard[Row] & TETRIS_EMPTY_ROW) != TETRIS_EMPTY_ROW) {
+            fprintf(stderr, "Error: Row %d lost its border.\n", Row);
+            Violations += 1;
+        }
+
+        if (TetrisBoard[Row] == TETRIS_FULL_ROW) {
+            fprintf(stderr, "Error: Row %d was completed but left.\n", Row);
+            Violations += 1;
+        }
+
+        Count += CountBits(TetrisBoard[Row] & PLAYFIELD_MASK);
+        for (XPixel = TETRIS_LEFT_BORDER + 1;
+             XPixel < TETRIS_RIGHT_BORDER;
+             XPixel += 1) {
+
+            Bit = (TetrisBoard[Row] >> (XPixel - TETRIS_LEFT_BORDER)) & 0x1;
+            Lit = FALSE;
+            if (KeMatrix[Row][XPixel] != 0) {
+                Lit = TRUE;
+            }
+
+            if (Lit != Bit) {
+                fprintf(stderr,
+                        "Error: The screen at (%d, %d) does not match the "
+                        "playfield.\n",
+                        XPixel,
+                        Row);
+
+                Violations += 1;
+            }
+        }
+    }
+
+    if (Count != PreviousBlocks + PIECE_BLOCKS -
+                 (LinesCleared * PLAYFIELD_WIDTH)) {
+
+        fprintf(stderr,
+                "Error: The playfield went from %d to %d blocks clearing %d "
+                "lines.\n",
+                (INT)PreviousBlocks,
+                (INT)Count,
+                LinesCleared);
+
+        Violations += 1;
+    }
+
+    *Blocks = Count;
+    return Violations;
+}
+
+ULONG
+CountBits (
+    USHORT Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine counts the bits set in a value.
+
+Arguments:
+
+    Value - Supplies the value.
+
+Return Value:
+
+    Returns the number of bits set.
+
+--*/
+
+{
+
+    ULONG Count;
+
+    Count = 0;
+    while (Value != 0) {
+        Value &= Value - 1;
+        Count += 1;
+    }
+
+    return Count;
+}
+
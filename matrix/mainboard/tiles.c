@@ -0,0 +1,356 @@
+/*++
+
+Copyright (c) 2011 Evan Green
+
+Module Name:
+
+    tiles.c
+
+Abstract:
+
+    This module implements the tile setup app, which numbers the matrix slaves
+    according to where they sit in the wall. The selected tile blinks, and
+    holding down the button on the slave board sitting in that spot gives it
+    that tile's number.
+
+Author:
+
+    Evan Green 20-Jan-2011
+
+Environment:
+
+    x86/AVR
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "types.h"
+#include "mainboard.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define how often the selected tile blinks, in ms/32.
+//
+
+#define TILE_BLINK_INTERVAL (32 * 250)
+
+//
+// Define the colors of the selected tile and the rest of the tiles.
+//
+
+#define TILE_SELECTED_PIXEL RGB_PIXEL(0, MAX_INTENSITY, 0)
+#define TILE_OTHER_PIXEL RGB_PIXEL(0, 0, 4)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the tile setup app.
+
+Members:
+
+    BlinkTimer - Stores the timer that blinks the selected tile.
+
+    Tile - Stores the tile number being offered to the slaves.
+
+    BlinkOn - Stores whether the selected tile is lit right now.
+
+--*/
+
+typedef struct _TILE_SETUP {
+    TIMER BlinkTimer;
+    UCHAR Tile;
+    UCHAR BlinkOn;
+} TILE_SETUP, *PTILE_SETUP;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+TilepSelectTile (
+    PTILE_SETUP Setup,
+    UCHAR Tile
+    );
+
+VOID
+TilepBlink (
+    PVOID Context
+    );
+
+VOID
+TilepHandleInput (
+    USHORT Inputs,
+    PVOID Context
+    );
+
+VOID
+TilepDrawTiles (
+    PTILE_SETUP Setup
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+const CHAR TileSetupPrompt[] PROGMEM = "Hold its button";
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+APPLICATION
+TileSetupEntry (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the tile setup app, which numbers the
+    matrix slaves according to where they sit in the wall.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the next application to be run.
+
+--*/
+
+{
+
+    APPLICATION NextApplication;
+    TILE_SETUP Setup;
+
+    Setup.BlinkOn = TRUE;
+    TilepSelectTile(&Setup, 0);
+    KeInitializeTimer(&(Setup.BlinkTimer));
+    KeQueueTimer(&(Setup.BlinkTimer),
+                 TILE_BLINK_INTERVAL,
+                 TILE_BLINK_INTERVAL,
+                 TilepBlink,
+                 &Setup);
+
+    KeSetInputHandler(INPUT_LEFT1 | INPUT_RIGHT1 | INPUT_UP1 | INPUT_DOWN1 |
+                      INPUT_LEFT2 | INPUT_RIGHT2 | INPUT_UP2 | INPUT_DOWN2,
+                      TilepHandleInput,
+                      &Setup);
+
+    NextApplication = KeRunEventLoop();
+
+    //
+    // Stop offering the number so that nobody renumbers a slave by pressing
+    // its button later on.
+    //
+
+    HlRequestSlaveTile(SLAVE_TILE_NONE);
+    return NextApplication;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+TilepSelectTile (
+    PTILE_SETUP Setup,
+    UCHAR Tile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine makes the given tile the selected one, offers its number to
+    the slaves, and shows it on the LCD.
+
+Arguments:
+
+    Setup - Supplies a pointer to the app state.
+
+    Tile - Supplies the tile number to select.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCHAR End;
+    CHAR Line[LCD_LINE_LENGTH + 1];
+
+    Setup->Tile = Tile;
+    HlRequestSlaveTile(Tile);
+    TilepDrawTiles(Setup);
+    HlClearLcdScreen();
+    HlSetLcdAddress(LCD_FIRST_LINE);
+    Line[0] = 'T';
+    Line[1] = 'i';
+    Line[2] = 'l';
+    Line[3] = 'e';
+    Line[4] = ' ';
+    End = KeFormatDecimal(&(Line[5]), Tile);
+    *End = '\0';
+    HlLcdPrintString(Line);
+    HlSetLcdAddress(LCD_SECOND_LINE);
+    HlLcdPrintStringFromFlash(TileSetupPrompt);
+    return;
+}
+
+VOID
+TilepBlink (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine blinks the selected tile. It is called by the blink timer.
+
+Arguments:
+
+    Context - Supplies a pointer to the app state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTILE_SETUP Setup;
+
+    Setup = Context;
+    Setup->BlinkOn = !Setup->BlinkOn;
+    TilepDrawTiles(Setup);
+    return;
+}
+
+VOID
+TilepHandleInput (
+    USHORT Inputs,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves the selection around the wall in response to either
+    trackball.
+
+Arguments:
+
+    Inputs - Supplies the input edges that were pressed.
+
+    Context - Supplies a pointer to the app state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTILE_SETUP Setup;
+    UCHAR Tile;
+
+    Setup = Context;
+    Tile = Setup->Tile;
+    if ((Inputs & (INPUT_LEFT1 | INPUT_LEFT2)) != 0) {
+        if (Tile == 0) {
+            Tile = MATRIX_TILE_COUNT;
+        }
+
+        Tile -= 1;
+
+    } else if ((Inputs & (INPUT_RIGHT1 | INPUT_RIGHT2)) != 0) {
+        Tile += 1;
+        if (Tile == MATRIX_TILE_COUNT) {
+            Tile = 0;
+        }
+
+    } else if ((Inputs & (INPUT_UP1 | INPUT_UP2)) != 0) {
+        if (Tile >= MATRIX_TILES_PER_ROW) {
+            Tile -= MATRIX_TILES_PER_ROW;
+        }
+
+    } else if ((Inputs & (INPUT_DOWN1 | INPUT_DOWN2)) != 0) {
+        if (Tile + MATRIX_TILES_PER_ROW < MATRIX_TILE_COUNT) {
+            Tile += MATRIX_TILES_PER_ROW;
+        }
+    }
+
+    if (Tile != Setup->Tile) {
+        Setup->BlinkOn = TRUE;
+        TilepSelectTile(Setup, Tile);
+    }
+
+    return;
+}
+
+VOID
+TilepDrawTiles (
+    PTILE_SETUP Setup
+    )
+
+/*++
+
+Routine Description:
+
+    This routine draws every tile of the wall, with the selected one lit if
+    the blink is on.
+
+Arguments:
+
+    Setup - Supplies a pointer to the app state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT Pixel;
+    UCHAR Tile;
+
+    for (Tile = 0; Tile < MATRIX_TILE_COUNT; Tile += 1) {
+        Pixel = TILE_OTHER_PIXEL;
+        if (Tile == Setup->Tile) {
+            Pixel = 0;
+            if (Setup->BlinkOn != FALSE) {
+                Pixel = TILE_SELECTED_PIXEL;
+            }
+        }
+
+        GrFillRectangle((Tile % MATRIX_TILES_PER_ROW) * MATRIX_TILE_COLUMNS,
+                        (Tile / MATRIX_TILES_PER_ROW) * MATRIX_TILE_ROWS,
+                        MATRIX_TILE_COLUMNS,
+                        MATRIX_TILE_ROWS,
+                        Pixel);
+    }
+
+    return;
+}
+
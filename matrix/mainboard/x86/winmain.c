@@ -196,6 +196,11 @@ HlpProcessInputs (
     BOOLEAN KeyDown
     );
 
+VOID
+HlpSynthesizeAudio (
+    ULONG TimePassed
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -256,6 +261,13 @@ USHORT HlWhiteLeds;
 USHORT HlRawInputs;
 USHORT HlInputEdges;
 
+//
+// Define the lock the timer callback holds while it touches state shared with
+// the application, standing in for disabled interrupts.
+//
+
+CRITICAL_SECTION HlInterruptLock;
+
 //
 // Remember the value of QPC when the app started.
 //
@@ -263,6 +275,18 @@ USHORT HlInputEdges;
 ULONGLONG HlInitialQpcValue;
 ULONGLONG HlLastTime;
 
+//
+// Define the audio capture ring buffer. There's no microphone, so the timer
+// callback fills it with a test signal while the capture is running.
+//
+
+UCHAR HlAudioSamples[AUDIO_BUFFER_SIZE];
+UCHAR HlAudioSampleHead;
+BOOLEAN HlAudioCaptureRunning;
+ULONG HlAudioSampleDebt;
+USHORT HlAudioPhase;
+USHORT HlAudioPhaseStep;
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -354,6 +378,7 @@ Return Value:
     KeCurrentHours = SystemTime.wHour;
     KeCurrentMinutes = SystemTime.wMinute;
     KeCurrentHalfSeconds = SystemTime.wSecond * 2;
+    InitializeCriticalSection(&HlInterruptLock);
 
     //
     // Kick off the UI thread.
@@ -534,6 +559,39 @@ Return Value:
     return (USHORT)rand();
 }
 
+USHORT
+HlReadAnalogInput (
+    UCHAR Input
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the latest filtered value of an analog input. The
+    inputs are sampled in the background, so this never waits on the ADC.
+
+Arguments:
+
+    Input - Supplies the analog input to read. See ANALOG_INPUT_*
+        definitions.
+
+Return Value:
+
+    Returns the 10-bit value of the input.
+
+--*/
+
+{
+
+    //
+    // There are no sensors in the simulator, so every input sits at half
+    // scale.
+    //
+
+    return 0x200;
+}
+
 VOID
 HlPrintText (
     UCHAR Size,
@@ -750,28 +808,33 @@ Return Value:
 
     for (YPixel = 0; YPixel < MATRIX_HEIGHT; YPixel += 1) {
         for (XPixel = 0; XPixel < MATRIX_WIDTH; XPixel += 1) {
+            KeMatrix[YPixel][XPixel] = 0;
             HlTextColor[YPixel][XPixel] = 0;
         }
     }
 
+    KeDisplayDirty = TRUE;
     HlNewTextPrinted = TRUE;
     return;
 }
 
 VOID
 HlUpdateDisplay (
-    VOID
+    USHORT Tiles
     )
 
 /*++
 
 Routine Description:
 
-    This routine allows the hardware layer to update the matrix display.
+    This routine sends out the matrix and samples the inputs. It is called by
+    the executive from the periodic timer interrupt, applications should set
+    KeDisplayDirty instead.
 
 Arguments:
 
-    None.
+    Tiles - Supplies the mask of slave tiles to send out. The window is
+        always redrawn from the whole matrix, so this is ignored.
 
 Return Value:
 
@@ -793,6 +856,380 @@ Return Value:
     return;
 }
 
+VOID
+HlRequestSlaveTile (
+    UCHAR Tile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine offers a tile number to the matrix slaves with every frame
+    sent out, until it is called again. A slave takes the number if its button
+    is held down, and keeps it across power cycles.
+
+Arguments:
+
+    Tile - Supplies the tile number to offer, or SLAVE_TILE_NONE to stop.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // The simulated matrix is a single window, so there are no slaves to
+    // number.
+    //
+
+    return;
+}
+
+VOID
+HlUpdateInputs (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine samples the inputs without sending out the matrix.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // The inputs come in from the window procedure and are handed to the
+    // executive by the timer callback, so there's nothing to do here.
+    //
+
+    return;
+}
+
+VOID
+HlWaitForInterrupt (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine idles the processor until the next interrupt, which is at
+    most one periodic timer tick away.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // Give up the rest of this time slice rather than spinning. The periodic
+    // timer callback runs every TIMER_RATE_MS.
+    //
+
+    Sleep(TIMER_RATE_MS);
+    return;
+}
+
+VOID
+HlEnterCriticalSection (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine holds off the periodic timer and input interrupts, so that
+    state they share with the application can be updated atomically. It
+    must not be called from an interrupt.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // The timer callback runs on its own thread, so a lock stands in for
+    // disabling interrupts.
+    //
+
+    EnterCriticalSection(&HlInterruptLock);
+    return;
+}
+
+VOID
+HlLeaveCriticalSection (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine lets the interrupts held off by HlEnterCriticalSection run
+    again.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LeaveCriticalSection(&HlInterruptLock);
+    return;
+}
+
+VOID
+HlStartAudioCapture (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts sampling the audio input continuously in the
+    background. The other analog inputs keep their last values while the
+    capture is running.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    memset(HlAudioSamples, 0x80, sizeof(HlAudioSamples));
+    HlAudioSampleHead = 0;
+    HlAudioSampleDebt = 0;
+    HlAudioCaptureRunning = TRUE;
+    return;
+}
+
+VOID
+HlStopAudioCapture (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops the background audio capture.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    HlAudioCaptureRunning = FALSE;
+    return;
+}
+
+VOID
+HlReadAudioSamples (
+    PUCHAR Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies out the most recent audio samples.
+
+Arguments:
+
+    Buffer - Supplies a pointer where AUDIO_BUFFER_SIZE samples will be
+        returned, oldest first. Samples are unsigned 8-bit values centered
+        around 128.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Count;
+    UCHAR Index;
+
+    Index = HlAudioSampleHead;
+    for (Count = 0; Count < AUDIO_BUFFER_SIZE; Count += 1) {
+        Buffer[Count] = HlAudioSamples[Index];
+        Index = (Index + 1) & (AUDIO_BUFFER_SIZE - 1);
+    }
+
+    return;
+}
+
+VOID
+HlStartSerial (
+    ULONG BaudRate
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns on the serial port. Received bytes are buffered in the
+    background until they are read.
+
+Arguments:
+
+    BaudRate - Supplies the baud rate to run the port at.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // The simulator has no serial port, so nothing ever arrives.
+    //
+
+    return;
+}
+
+VOID
+HlStopSerial (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns off the serial port and throws away anything received.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    return;
+}
+
+UCHAR
+HlReadSerial (
+    PUCHAR Buffer,
+    UCHAR Size,
+    PUCHAR Overflowed
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads whatever has been received on the serial port, without
+    waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the received bytes will be returned.
+
+    Size - Supplies the size of the buffer in bytes.
+
+    Overflowed - Supplies a pointer where TRUE will be returned if bytes were
+        lost since the last read because nobody read them in time.
+
+Return Value:
+
+    Returns the number of bytes read.
+
+--*/
+
+{
+
+    *Overflowed = FALSE;
+    return 0;
+}
+
+VOID
+HlWriteSerial (
+    UCHAR Byte
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends a byte out of the serial port, waiting for the
+    previous one to get out of the way first.
+
+Arguments:
+
+    Byte - Supplies the byte to send.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -1069,14 +1506,32 @@ Return Value:
     TimeDifference = (ULONG)(CurrentTime - HlLastTime);
     KeUpdateTime((USHORT)TimeDifference);
     HlLastTime = CurrentTime;
+    if (HlAudioCaptureRunning != FALSE) {
+        HlpSynthesizeAudio(TimeDifference);
+    }
 
     //
     // Update the inputs.
     //
 
+    EnterCriticalSection(&HlInterruptLock);
     KeRawInputs = HlRawInputs;
     KeInputEdges |= HlInputEdges;
+    LeaveCriticalSection(&HlInterruptLock);
+    if (HlInputEdges != 0) {
+        KeQueueInputEvent(HlInputEdges);
+    }
+
     HlInputEdges = 0;
+
+    //
+    // Push out a frame if one is due.
+    //
+
+    if (KeFramePending != FALSE) {
+        KeRefreshDisplay();
+    }
+
     return;
 }
 
@@ -1614,3 +2069,60 @@ Return Value:
 
     return Handled;
 }
+
+VOID
+HlpSynthesizeAudio (
+    ULONG TimePassed
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds however many audio samples would have been captured in
+    the given time to the ring buffer. The test signal is a square wave that
+    sweeps up through the spectrum, with a little noise on top.
+
+Arguments:
+
+    TimePassed - Supplies the time since the last call, in ms/32.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LONG Sample;
+
+    HlAudioSampleDebt += TimePassed * AUDIO_SAMPLE_RATE;
+    while (HlAudioSampleDebt >= 1000 * 32) {
+        HlAudioSampleDebt -= 1000 * 32;
+        Sample = 0x80 + (rand() & 0xF) - 8;
+        if (HlAudioPhase < 0x8000) {
+            Sample += 0x30;
+
+        } else {
+            Sample -= 0x30;
+        }
+
+        HlAudioSamples[HlAudioSampleHead] = (UCHAR)Sample;
+        HlAudioSampleHead = (HlAudioSampleHead + 1) & (AUDIO_BUFFER_SIZE - 1);
+
+        //
+        // A phase step of 1024 lands the fundamental on the lowest bin of a
+        // 64 sample transform. Sweep up from there until the harmonics start
+        // folding back down.
+        //
+
+        HlAudioPhase += HlAudioPhaseStep;
+        HlAudioPhaseStep += 1;
+        if ((HlAudioPhaseStep < 1024) || (HlAudioPhaseStep > 1024 * 16)) {
+            HlAudioPhaseStep = 1024;
+        }
+    }
+
+    return;
+}
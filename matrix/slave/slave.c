@@ -32,11 +32,12 @@ Environment:
 //
 
 //
-// Define this board's offset from the origin in the SPI protocol.
+// Define the tile this board shows until it has been given a number, and the
+// location in EEPROM where that number is kept.
 //
 
-#define MATRIX_PROTOCOL_ROW_OFFSET 0
-#define MATRIX_PROTOCOL_COLUMN_OFFSET 0
+#define DEFAULT_TILE 0
+#define EEPROM_TILE_ADDRESS 0x0000
 
 //
 // Define the length of the SPI buffer.
@@ -63,6 +64,22 @@ Environment:
 
 #define PERIODIC_TIMER_RATE 1000
 
+//
+// Define the number of display refreshes in one PWM cycle. Each LED is on for
+// some number of these time slots at the start of every cycle.
+//
+
+#define PWM_TIME_SLOTS 32
+
+//
+// Define the number of low bits of an LED's on-time that are a fraction of a
+// time slot. The fraction is carried over into the next PWM cycle, so it
+// shows up as an extra slot every few cycles.
+//
+
+#define PWM_FRACTION_BITS 3
+#define PWM_FRACTION_MASK ((1 << PWM_FRACTION_BITS) - 1)
+
 //
 // Define the number of ASCII characters not present in the font data. To
 // print an ASCII character, one must first subtract this value to get an
@@ -152,6 +169,11 @@ typedef enum _MATRIX_PROTOCOL_STATE {
     MatrixStateWaiting,
     MatrixStateSyncByte1,
     MatrixStateSyncByte2,
+    MatrixStateTileNumber,
+    MatrixStateTileRunCount,
+    MatrixStateAddressNumber,
+    MatrixStateAddressCheck,
+    MatrixStateSkipping,
     MatrixStateByte0,
     MatrixStateByte1,
     MatrixStateByte2,
@@ -167,6 +189,11 @@ KeProcessSpiBuffer (
     VOID
     );
 
+VOID
+KeSetTile (
+    UCHAR Tile
+    );
+
 VOID
 HlDisplayByte (
     UCHAR Row,
@@ -190,22 +217,26 @@ HlShiftOut (
     UCHAR Data3
     );
 
+VOID
+HlComputeOnTimes (
+    VOID
+    );
+
 UCHAR
-HlIsColorOn (
-    UCHAR Intensity,
-    UCHAR TimeSlot
+HlReadEeprom (
+    USHORT Address
     );
 
-//
-// -------------------------------------------------------------------- Globals
-//
+VOID
+HlWriteEeprom (
+    USHORT Address,
+    UCHAR Value
+    );
 
 //
-// Declare the font data global.
+// -------------------------------------------------------------------- Globals
 //
 
-extern UCHAR HlFontData5x7[][5] PROGMEM;
-
 //
 // Stores the current state of the matrix.
 //
@@ -218,6 +249,25 @@ volatile USHORT HlDisplay[MATRIX_ROWS][MATRIX_COLUMNS];
 
 volatile UCHAR HlDisplayIteration;
 
+//
+// Define the gamma curve, which maps each 5-bit intensity to an on-time in
+// eighths of a time slot. The eye is much more sensitive to changes at the
+// dim end, so that's where the steps are smallest.
+//
+
+const UCHAR HlGammaTable[32] PROGMEM = {
+    0, 1, 2, 3, 4, 5, 7, 9, 13, 16, 21, 25, 31, 37, 43, 50,
+    58, 66, 75, 84, 95, 105, 117, 129, 141, 154, 168, 183, 198, 214, 231, 248
+};
+
+//
+// Store the on-time of each LED for the current PWM cycle, in eighths of a
+// time slot. The LED is on for the whole slots, and the leftover fraction is
+// added to the next cycle's on-time. The colors are in red, green, blue order.
+//
+
+UCHAR HlOnTime[MATRIX_ROWS][MATRIX_COLUMNS][3];
+
 //
 // Store the number of milliseconds that have passed, useful for stalling. This
 // will roll over approximately every 49 days.
@@ -242,6 +292,32 @@ volatile UCHAR KeMatrixProtocolFrame[3];
 volatile UCHAR KeMatrixProtocolColumn;
 volatile UCHAR KeMatrixProtocolRow;
 
+//
+// Store the size of the area the current packet covers, and where this
+// board's pixels start within it. A tile packet covers just this board, while
+// a full frame covers the whole protocol grid.
+//
+
+volatile UCHAR KeMatrixProtocolRows;
+volatile UCHAR KeMatrixProtocolColumns;
+volatile UCHAR KeMatrixProtocolRowOffset;
+volatile UCHAR KeMatrixProtocolColumnOffset;
+
+//
+// Store the number of bytes left to skip in a packet meant for another tile.
+//
+
+volatile UCHAR KeMatrixProtocolSkip;
+
+//
+// Store this board's tile number, and where that tile falls within a full
+// frame.
+//
+
+UCHAR KeTile;
+UCHAR KeTileRowOffset;
+UCHAR KeTileColumnOffset;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -272,11 +348,24 @@ Return Value:
     UCHAR Column;
     UCHAR Row;
     USHORT TickCount;
+    UCHAR Tile;
 
     KeMatrixProtocolState = MatrixStateWaiting;
     KeMatrixProtocolColumn = 0;
     KeMatrixProtocolRow = 0;
 
+    //
+    // Look up which tile this board is. An EEPROM that has never been written
+    // reads back as all ones.
+    //
+
+    Tile = HlReadEeprom(EEPROM_TILE_ADDRESS);
+    if (Tile == 0xFF) {
+        Tile = DEFAULT_TILE;
+    }
+
+    KeSetTile(Tile);
+
     //
     // Set up the I/O ports to the proper directions. LEDs go out, the button
     // goes in.
@@ -436,6 +525,7 @@ Return Value:
 
 {
 
+    UCHAR Available;
     USHORT Color;
     UCHAR Column;
     UCHAR Data;
@@ -444,6 +534,40 @@ Return Value:
 
     while (KeSpiBufferNextUnprocessedIndex != KeSpiBufferNextEmptyIndex) {
 
+        //
+        // Throw away bytes belonging to another tile's packet in bulk, without
+        // looking at them.
+        //
+
+        if (KeMatrixProtocolState == MatrixStateSkipping) {
+            Available = KeSpiBufferNextEmptyIndex -
+                        KeSpiBufferNextUnprocessedIndex;
+
+            //
+            // The subtraction wraps around if the data does.
+            //
+
+            if (Available > SPI_BUFFER_LENGTH) {
+                Available += SPI_BUFFER_LENGTH;
+            }
+
+            if (Available > KeMatrixProtocolSkip) {
+                Available = KeMatrixProtocolSkip;
+            }
+
+            KeSpiBufferNextUnprocessedIndex += Available;
+            if (KeSpiBufferNextUnprocessedIndex >= SPI_BUFFER_LENGTH) {
+                KeSpiBufferNextUnprocessedIndex -= SPI_BUFFER_LENGTH;
+            }
+
+            KeMatrixProtocolSkip -= Available;
+            if (KeMatrixProtocolSkip == 0) {
+                KeMatrixProtocolState = MatrixStateWaiting;
+            }
+
+            continue;
+        }
+
         //
         // Read the incoming data from the SPI bus.
         //
@@ -458,7 +582,8 @@ Return Value:
         // If the protocol is synchronizing, check for the magic byte sequence.
         // Increment the state (towards receiving actual data) on success or
         // reset the synchronization counter if something other than the
-        // sync bytes are received.
+        // sync bytes are received. The last sync byte says what kind of
+        // packet follows.
         //
 
         if (KeMatrixProtocolState < MatrixStateByte0) {
@@ -475,15 +600,84 @@ Return Value:
             } else if ((KeMatrixProtocolState == MatrixStateSyncByte2) &&
                        (Data == SYNC_BYTE2)) {
 
+                //
+                // A full frame covers the whole protocol grid, and this board
+                // picks its tile out of it.
+                //
+
                 KeMatrixProtocolState = MatrixStateByte0;
                 KeMatrixProtocolColumn = 0;
                 KeMatrixProtocolRow = 0;
+                KeMatrixProtocolRows = MATRIX_PROTOCOL_ROWS;
+                KeMatrixProtocolColumns = MATRIX_PROTOCOL_COLUMNS;
+                KeMatrixProtocolRowOffset = KeTileRowOffset;
+                KeMatrixProtocolColumnOffset = KeTileColumnOffset;
+
+            } else if ((KeMatrixProtocolState == MatrixStateSyncByte2) &&
+                       (Data == SYNC_BYTE_TILE)) {
+
+                KeMatrixProtocolState = MatrixStateTileNumber;
+
+            } else if ((KeMatrixProtocolState == MatrixStateSyncByte2) &&
+                       (Data == SYNC_BYTE_ADDRESS)) {
+
+                KeMatrixProtocolState = MatrixStateAddressNumber;
+
+            } else if (KeMatrixProtocolState == MatrixStateTileNumber) {
+                KeMatrixProtocolFrame[0] = Data;
+                KeMatrixProtocolState = MatrixStateTileRunCount;
+
+            //
+            // The run count is the last byte of a tile packet's header. If
+            // the packet is for this board, its runs cover exactly this
+            // board's pixels. Otherwise skip over the runs.
+            //
+
+            } else if (KeMatrixProtocolState == MatrixStateTileRunCount) {
+                if (KeMatrixProtocolFrame[0] == KeTile) {
+                    KeMatrixProtocolState = MatrixStateByte0;
+                    KeMatrixProtocolColumn = 0;
+                    KeMatrixProtocolRow = 0;
+                    KeMatrixProtocolRows = MATRIX_ROWS;
+                    KeMatrixProtocolColumns = MATRIX_COLUMNS;
+                    KeMatrixProtocolRowOffset = 0;
+                    KeMatrixProtocolColumnOffset = 0;
+
+                } else {
+                    KeMatrixProtocolSkip = Data * 3;
+                    KeMatrixProtocolState = MatrixStateSkipping;
+                    if (KeMatrixProtocolSkip == 0) {
+                        KeMatrixProtocolState = MatrixStateWaiting;
+                    }
+                }
+
+            } else if (KeMatrixProtocolState == MatrixStateAddressNumber) {
+                KeMatrixProtocolFrame[0] = Data;
+                KeMatrixProtocolState = MatrixStateAddressCheck;
+
+            //
+            // Take on a new tile number if it arrived intact and the button is
+            // held down, which is how the person setting up the wall picks
+            // out this board. Don't wear out the EEPROM rewriting the same
+            // number over and over while the button is down.
+            //
+
+            } else if (KeMatrixProtocolState == MatrixStateAddressCheck) {
+                KeMatrixProtocolState = MatrixStateWaiting;
+                if (((UCHAR)~Data == KeMatrixProtocolFrame[0]) &&
+                    ((HlReadIo(PORTB_INPUT) & BUTTON_BIT) == 0) &&
+                    (KeMatrixProtocolFrame[0] != KeTile)) {
+
+                    Data = KeMatrixProtocolFrame[0];
+                    HlWriteEeprom(EEPROM_TILE_ADDRESS, Data);
+                    KeSetTile(Data);
+                }
 
             } else {
                 KeMatrixProtocolState = MatrixStateWaiting;
             }
 
-            return;
+            continue;
         }
 
         //
@@ -529,9 +723,9 @@ Return Value:
             while (Length != 0) {
                 Length -= 1;
                 Column = KeMatrixProtocolColumn -
-                         MATRIX_PROTOCOL_COLUMN_OFFSET;
+                         KeMatrixProtocolColumnOffset;
 
-                Row = KeMatrixProtocolRow - MATRIX_PROTOCOL_ROW_OFFSET;
+                Row = KeMatrixProtocolRow - KeMatrixProtocolRowOffset;
                 if ((Row < MATRIX_ROWS) && (Column < MATRIX_COLUMNS)) {
                     HlDisplay[Row][Column] = Color;
                 }
@@ -541,7 +735,7 @@ Return Value:
                 //
 
                 KeMatrixProtocolColumn += 1;
-                if (KeMatrixProtocolColumn == MATRIX_PROTOCOL_COLUMNS) {
+                if (KeMatrixProtocolColumn == KeMatrixProtocolColumns) {
                     KeMatrixProtocolColumn = 0;
                     KeMatrixProtocolRow += 1;
 
@@ -549,7 +743,7 @@ Return Value:
                     // If this was the last pixel, reset the protocol.
                     //
 
-                    if (KeMatrixProtocolRow == MATRIX_PROTOCOL_ROWS) {
+                    if (KeMatrixProtocolRow == KeMatrixProtocolRows) {
                         KeMatrixProtocolState = MatrixStateWaiting;
                         return;
                     }
@@ -561,6 +755,50 @@ Return Value:
     return;
 }
 
+VOID
+KeSetTile (
+    UCHAR Tile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets which tile of the wall this board shows.
+
+Arguments:
+
+    Tile - Supplies the tile number.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KeTile = Tile;
+
+    //
+    // Tiles outside the protocol grid only show up in tile packets. Put their
+    // offset off the end of the grid so that no pixel of a full frame lands on
+    // them.
+    //
+
+    if (Tile < MATRIX_TILE_COUNT) {
+        KeTileRowOffset = (Tile / MATRIX_TILES_PER_ROW) * MATRIX_TILE_ROWS;
+        KeTileColumnOffset = (Tile % MATRIX_TILES_PER_ROW) *
+                             MATRIX_TILE_COLUMNS;
+
+    } else {
+        KeTileRowOffset = MATRIX_PROTOCOL_ROWS;
+        KeTileColumnOffset = MATRIX_PROTOCOL_COLUMNS;
+    }
+
+    return;
+}
+
 VOID
 HlDisplayByte (
     UCHAR Row,
@@ -704,14 +942,27 @@ Return Value:
 {
 
     UCHAR Color;
-    UCHAR ColorValue;
     UCHAR Column;
     UCHAR Data1;
     UCHAR Data2;
     UCHAR Data3;
+    UCHAR Limit;
     UCHAR Row;
+    UCHAR TimeSlot;
 
     HlDisplayIteration += 1;
+    TimeSlot = HlDisplayIteration & (PWM_TIME_SLOTS - 1);
+    if (TimeSlot == 0) {
+        HlComputeOnTimes();
+    }
+
+    //
+    // An LED is on in this slot if its whole number of slots goes past it,
+    // which is the same as its on-time being above the last fraction of this
+    // slot.
+    //
+
+    Limit = (TimeSlot << PWM_FRACTION_BITS) | PWM_FRACTION_MASK;
     for (Row = 0; Row < MATRIX_ROWS; Row += 1) {
 
         //
@@ -723,15 +974,6 @@ Return Value:
         Data3 = 0;
         for (Column = 0; Column < MATRIX_COLUMNS; Column += 1) {
             for (Color = 0; Color < 3; Color += 1) {
-                if (Color == 0) {
-                    ColorValue = PIXEL_RED(HlDisplay[Row][Column]);
-
-                } else if (Color == 1) {
-                    ColorValue = PIXEL_GREEN(HlDisplay[Row][Column]);
-
-                } else {
-                    ColorValue = PIXEL_BLUE(HlDisplay[Row][Column]);
-                }
 
                 //
                 // If the pixel should be turned on, turn it on. The hardware is
@@ -745,7 +987,7 @@ Return Value:
                 // Byte3 R1 G1 B2 R3 G3 B4 R5 B5
                 //
 
-                if (HlIsColorOn(ColorValue, HlDisplayIteration) != FALSE) {
+                if (HlOnTime[Row][Column][Color] > Limit) {
                     switch ((Column * 3) + Color) {
 
                     //
@@ -996,26 +1238,24 @@ Return Value:
     }
 }
 
-UCHAR
-HlIsColorOn (
-    UCHAR Intensity,
-    UCHAR TimeSlot
+VOID
+HlComputeOnTimes (
+    VOID
     )
 
 /*++
 
 Routine Description:
 
-    This routine determines whether a pixel should be on given the intensity
-    being shot for. This routine assumes there are 32 different intensities,
-    therefore there are 32 different timeslots.
+    This routine works out how long each LED should be on for in the PWM cycle
+    that's about to start. The display color goes through the gamma curve
+    into eighths of a time slot, and the fraction that didn't fit into the
+    last cycle is added in. Over eight cycles this gives 256 shades per color
+    out of 32 time slots.
 
 Arguments:
 
-    Intensity - Supplies the intensity of the pixel. Valid values are 0 through
-        31.
-
-    TimeSlot - Supplies the current iteration. Valid values are 0 through 32.
+    None.
 
 Return Value:
 
@@ -1025,27 +1265,126 @@ Return Value:
 
 {
 
-    TimeSlot &= 0x1F;
-    if (TimeSlot < Intensity) {
-        return TRUE;
+    UCHAR Color;
+    UCHAR Column;
+    UCHAR Intensity;
+    PUCHAR OnTime;
+    USHORT Pixel;
+    UCHAR Row;
+
+    for (Row = 0; Row < MATRIX_ROWS; Row += 1) {
+        for (Column = 0; Column < MATRIX_COLUMNS; Column += 1) {
+            Pixel = HlDisplay[Row][Column];
+            OnTime = HlOnTime[Row][Column];
+            for (Color = 0; Color < 3; Color += 1) {
+                if (Color == 0) {
+                    Intensity = PIXEL_RED(Pixel);
+
+                } else if (Color == 1) {
+                    Intensity = PIXEL_GREEN(Pixel);
+
+                } else {
+                    Intensity = PIXEL_BLUE(Pixel);
+                }
+
+                //
+                // The brightest intensity plus the largest leftover fraction
+                // still fits in a byte.
+                //
+
+                OnTime[Color] =
+                            RtlReadProgramSpace8(&(HlGammaTable[Intensity])) +
+                            (OnTime[Color] & PWM_FRACTION_MASK);
+            }
+        }
+    }
+
+    return;
+}
+
+UCHAR
+HlReadEeprom (
+    USHORT Address
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads a byte out of the EEPROM.
+
+Arguments:
+
+    Address - Supplies the EEPROM address to read.
+
+Return Value:
+
+    Returns the byte at the given address.
+
+--*/
+
+{
+
+    //
+    // Wait for any write in progress to finish.
+    //
+
+    while ((HlReadIo(EEPROM_CONTROL) & EEPROM_CONTROL_WRITE_ENABLE) != 0) {
+        NOTHING;
     }
 
-#if 0
+    HlWriteIo(EEPROM_ADDRESS_HIGH, (UCHAR)(Address >> 8));
+    HlWriteIo(EEPROM_ADDRESS_LOW, (UCHAR)Address);
+    HlWriteIo(EEPROM_CONTROL, EEPROM_CONTROL_READ_ENABLE);
+    return HlReadIo(EEPROM_DATA);
+}
+
+VOID
+HlWriteEeprom (
+    USHORT Address,
+    UCHAR Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes a byte to the EEPROM. The write finishes in the
+    background a few milliseconds later.
+
+Arguments:
+
+    Address - Supplies the EEPROM address to write.
+
+    Value - Supplies the byte to write.
 
-    if ((Intensity >= 16) && ((Ticks & 0x01) == 0)) {
-        return TRUE;
+Return Value:
 
-    } else if ((Intensity >= 8) && ((Ticks & 0x03) == 0)) {
-        return TRUE;
+    None.
 
-    } else if ((Intensity >= 4) && ((Ticks & 0x07) == 0)) {
-        return TRUE;
+--*/
+
+{
 
-    } else if (Ticks < Intensity) {
-        return TRUE;
+    while ((HlReadIo(EEPROM_CONTROL) & EEPROM_CONTROL_WRITE_ENABLE) != 0) {
+        NOTHING;
     }
 
-#endif
+    HlWriteIo(EEPROM_ADDRESS_HIGH, (UCHAR)(Address >> 8));
+    HlWriteIo(EEPROM_ADDRESS_LOW, (UCHAR)Address);
+    HlWriteIo(EEPROM_DATA, Value);
 
-    return FALSE;
+    //
+    // The write has to be started within four cycles of enabling it, so keep
+    // interrupts out of the way.
+    //
+
+    HlDisableInterrupts();
+    HlWriteIo(EEPROM_CONTROL, EEPROM_CONTROL_MASTER_WRITE_ENABLE);
+    HlWriteIo(EEPROM_CONTROL,
+              EEPROM_CONTROL_MASTER_WRITE_ENABLE |
+              EEPROM_CONTROL_WRITE_ENABLE);
+
+    HlEnableInterrupts();
+    return;
 }
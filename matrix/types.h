@@ -153,6 +153,34 @@ typedef const void *PPGM;
 #define MATRIX_PROTOCOL_ROWS 24
 #define MATRIX_PROTOCOL_COLUMNS 24
 
+//
+// Define the sync byte that, in place of SYNC_BYTE2, starts a packet for a
+// single tile. The tile number and the number of runs in the packet follow,
+// and then the runs themselves, which cover the tile's pixels row by row.
+// Slaves driving other tiles skip over the runs without decoding them.
+//
+
+#define SYNC_BYTE_TILE 0x5D
+
+//
+// Define the sync byte that, in place of SYNC_BYTE2, starts a request to
+// renumber a slave. The new tile number follows, and then its complement.
+// Only a slave whose button is held down takes the new number.
+//
+
+#define SYNC_BYTE_ADDRESS 0x5E
+
+//
+// Define the size of each slave's tile and the number of tiles in the
+// protocol grid. Tiles are numbered row by row from the top left.
+//
+
+#define MATRIX_TILE_ROWS 8
+#define MATRIX_TILE_COLUMNS 8
+#define MATRIX_TILES_PER_ROW (MATRIX_PROTOCOL_COLUMNS / MATRIX_TILE_COLUMNS)
+#define MATRIX_TILE_COUNT \
+    (MATRIX_TILES_PER_ROW * (MATRIX_PROTOCOL_ROWS / MATRIX_TILE_ROWS))
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
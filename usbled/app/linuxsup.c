@@ -31,6 +31,16 @@ Environment:
 #include <errno.h>
 #include <time.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
 #include "ossup.h"
 
 //
@@ -38,11 +48,19 @@ Environment:
 //
 
 //
-// Define the maximum length of a line of /proc/stat
+// Define the maximum length of a path.
 //
 
 #define LINE_MAX 1024
 
+//
+// Define the size of the buffer /proc files are read into. This needs to hold
+// every cpu line of /proc/stat, and everything up to the Ip statistics in
+// /proc/net/netstat.
+//
+
+#define PROC_BUFFER_SIZE 65536
+
 //
 // Define the start of the network statistics line containing the total bytes
 // moved.
@@ -52,12 +70,57 @@ Environment:
 #define IN_OCTETS_TITLE "InOctets"
 #define OUT_OCTETS_TITLE "OutOctets"
 
+//
+// Define the directory holding a directory of device nodes for each USB bus,
+// and how often to look for devices if it can't be watched.
+//
+
+#define USB_DEVICE_DIRECTORY "/dev/bus/usb"
+#define DEVICE_POLL_INTERVAL 250
+
+//
+// Define the size of the buffer that device change notifications are read
+// into.
+//
+
+#define NOTIFY_BUFFER_SIZE 1024
+
+//
+// Define the size of the buffer netlink replies are read into. This needs to
+// hold everything the kernel says about one interface.
+//
+
+#define NETLINK_BUFFER_SIZE 16384
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
 typedef unsigned long long ULONGLONG, *PULONGLONG;
 
+/*++
+
+Structure Description:
+
+    This structure stores a netlink request for the attributes of one
+    network interface, looked up by name.
+
+Members:
+
+    Header - Stores the netlink message header.
+
+    Information - Stores the interface information message.
+
+    Attributes - Stores the interface name attribute.
+
+--*/
+
+typedef struct _LINK_REQUEST {
+    struct nlmsghdr Header;
+    struct ifinfomsg Information;
+    char Attributes[RTA_SPACE(IFNAMSIZ)];
+} LINK_REQUEST, *PLINK_REQUEST;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -66,17 +129,44 @@ void
 DestroyOsDependentSupport (
     );
 
+int
+ReadProcFile (
+    int Descriptor
+    );
+
+char *
+ScanInteger (
+    char *String,
+    PULONGLONG Value
+    );
+
+char *
+FindLine (
+    char *String,
+    char *Prefix
+    );
+
+char *
+SkipLine (
+    char *String
+    );
+
+int
+WatchUsbDevices (
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 //
-// Store a pointer to the various /proc files.
+// Store the descriptors of the various /proc files, which are kept open and
+// read again from the start for each sample.
 //
 
-FILE *StatFile = NULL;
-FILE *MemoryInfoFile = NULL;
-FILE *NetstatFile = NULL;
+int StatDescriptor = -1;
+int MemoryInfoDescriptor = -1;
+int NetstatDescriptor = -1;
 
 //
 // Store the number of processors in the system.
@@ -101,11 +191,11 @@ ULONGLONG LastSummaryTotalTime;
 
 //
 // Store the indices within the stats file where total bytes sent/received
-// are stored.
+// are stored. These are found the first time the file is read.
 //
 
-int InBytesIndex;
-int OutBytesIndex;
+int InBytesIndex = -1;
+int OutBytesIndex = -1;
 
 //
 // Store the last networking snapshot.
@@ -121,6 +211,28 @@ ULONGLONG LastNetworkSystemTime;
 
 char Line[LINE_MAX];
 
+//
+// Store the contents of the last /proc file read.
+//
+
+char ProcBuffer[PROC_BUFFER_SIZE];
+
+//
+// Store the descriptor notified when USB device nodes come or go. This is -1
+// before it's opened, and -2 if it couldn't be.
+//
+
+int UsbNotifyDescriptor = -1;
+
+//
+// Store the netlink socket interface statistics are requested over, the
+// sequence number of the last request, and the buffer replies come back in.
+//
+
+int NetlinkDescriptor = -1;
+unsigned int NetlinkSequence;
+unsigned int NetlinkBuffer[NETLINK_BUFFER_SIZE / sizeof(unsigned int)];
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -162,8 +274,8 @@ Return Value:
     // Attempt to open the stat file.
     //
 
-    StatFile = fopen("/proc/stat", "r");
-    if (StatFile == NULL) {
+    StatDescriptor = open("/proc/stat", O_RDONLY);
+    if (StatDescriptor < 0) {
         printf("Error: Failed to open /proc/stat.\nError: %s\n",
                strerror(errno));
 
@@ -174,8 +286,8 @@ Return Value:
     // Attempt to open the meminfo file.
     //
 
-    MemoryInfoFile = fopen("/proc/meminfo", "r");
-    if (MemoryInfoFile == NULL) {
+    MemoryInfoDescriptor = open("/proc/meminfo", O_RDONLY);
+    if (MemoryInfoDescriptor < 0) {
         printf("Error: Failed to open /proc/meminfo.\nError: %s\n",
                strerror(errno));
 
@@ -186,8 +298,8 @@ Return Value:
     // Attempt to open the netstat file.
     //
 
-    NetstatFile = fopen("/proc/net/netstat", "r");
-    if (NetstatFile == NULL) {
+    NetstatDescriptor = open("/proc/net/netstat", O_RDONLY);
+    if (NetstatDescriptor < 0) {
         printf("Error: Failed to open /proc/netstat.\nError: %s\n",
                strerror(errno));
 
@@ -241,19 +353,24 @@ Return Value:
 
 {
 
-    if (StatFile != NULL) {
-        fclose(StatFile);
-        StatFile = NULL;
+    if (StatDescriptor >= 0) {
+        close(StatDescriptor);
+        StatDescriptor = -1;
+    }
+
+    if (MemoryInfoDescriptor >= 0) {
+        close(MemoryInfoDescriptor);
+        MemoryInfoDescriptor = -1;
     }
 
-    if (MemoryInfoFile != NULL) {
-        fclose(MemoryInfoFile);
-        MemoryInfoFile = NULL;
+    if (NetstatDescriptor >= 0) {
+        close(NetstatDescriptor);
+        NetstatDescriptor = -1;
     }
 
-    if (NetstatFile != NULL) {
-        fclose(NetstatFile);
-        NetstatFile = NULL;
+    if (NetlinkDescriptor >= 0) {
+        close(NetlinkDescriptor);
+        NetlinkDescriptor = -1;
     }
 
     NumberOfProcessors = 0;
@@ -301,6 +418,7 @@ Return Value:
 {
 
     int CpuIndex;
+    char *Current;
     ULONGLONG IdleDifference;
     ULONGLONG IdleTime;
     ULONGLONG KernelTime;
@@ -316,7 +434,7 @@ Return Value:
     // Potentially perform one-time initialization.
     //
 
-    if (StatFile == NULL) {
+    if (StatDescriptor < 0) {
         Result = InitializeOsDependentSupport();
         if (Result == 0) {
             printf("Error: Unable to initialize linux support.\n");
@@ -325,22 +443,16 @@ Return Value:
     }
 
     MaxBufferIndex = UsageBufferSize / sizeof(int);
+    if (ReadProcFile(StatDescriptor) < 0) {
+        printf("Error: Unable to read /proc/stat.\n");
+        return 0;
+    }
 
     //
-    // Start the file at the beginning.
+    // Skip the first line, which sums up all the processors.
     //
 
-    rewind(StatFile);
-    fflush(StatFile);
-
-    //
-    // Get (and skip) the first line.
-    //
-
-    if (fgets(Line, LINE_MAX, StatFile) == NULL) {
-        printf("Error: Unable to read first line of /proc/stat.\n");
-        return 0;
-    }
+    Current = SkipLine(ProcBuffer);
 
     //
     // Loop over each CPU in the system.
@@ -348,36 +460,33 @@ Return Value:
 
     CpuIndex = 0;
     Results = 0;
-    while (1) {
-        if (fgets(Line, sizeof(Line), StatFile) == NULL) {
-            printf("Error: Unable to read StatFile.\n");
-            return 0;
-        }
+    while (Current != NULL) {
 
         //
         // If this is not a CPU entry, break.
         //
 
-        if ((Line[0] != 'c') || (Line[1] != 'p') || (Line[2] != 'u')) {
-            Line[511] = '\0';
+        if ((Current[0] != 'c') || (Current[1] != 'p') ||
+            (Current[2] != 'u')) {
+
             break;
         }
 
         //
-        // Get the needed integers.
+        // Get the needed integers, skipping the processor number.
         //
 
-        Result = sscanf(Line,
-                        "%*s %llu %llu %llu %llu",
-                        &UserTime,
-                        &KernelTime,
-                        &NiceTime,
-                        &IdleTime);
-
-        if (Result < 4) {
-            printf("Error: Only read %d values from scanning /proc/stat.\n",
-                   Result);
+        Current += 3;
+        while ((*Current >= '0') && (*Current <= '9')) {
+            Current += 1;
+        }
 
+        Current = ScanInteger(Current, &UserTime);
+        Current = ScanInteger(Current, &KernelTime);
+        Current = ScanInteger(Current, &NiceTime);
+        Current = ScanInteger(Current, &IdleTime);
+        if (Current == NULL) {
+            printf("Error: Unable to scan cpu%d of /proc/stat.\n", CpuIndex);
             return 0;
         }
 
@@ -404,6 +513,7 @@ Return Value:
         }
 
         CpuIndex += 1;
+        Current = SkipLine(Current);
     }
 
     if (Results != 0) {
@@ -445,6 +555,7 @@ Return Value:
 
 {
 
+    char *Current;
     ULONGLONG FreeMemory;
     ULONGLONG KernelTime;
     ULONGLONG IdleTime;
@@ -460,7 +571,7 @@ Return Value:
     // Potentially perform one-time initialization.
     //
 
-    if ((MemoryInfoFile == NULL) || (StatFile == NULL)) {
+    if ((MemoryInfoDescriptor < 0) || (StatDescriptor < 0)) {
         Result = InitializeOsDependentSupport();
         if (Result == 0) {
             printf("Error: Unable to initialize linux support.\n");
@@ -468,26 +579,13 @@ Return Value:
         }
     }
 
-    //
-    // Start the files at the beginning.
-    //
-
-    rewind(StatFile);
-    fflush(StatFile);
-    rewind(MemoryInfoFile);
-    fflush(MemoryInfoFile);
-
-    //
-    // Get the first line.
-    //
-
-    if (fgets(Line, LINE_MAX, StatFile) == NULL) {
-        printf("Error: Unable to read first line of /proc/stat.\n");
+    if (ReadProcFile(StatDescriptor) < 0) {
+        printf("Error: Unable to read /proc/stat.\n");
         return 0;
     }
 
-    if ((Line[0] != 'c') || (Line[1] != 'p') || (Line[2] != 'u') |
-        (Line[3] != ' ')) {
+    if ((ProcBuffer[0] != 'c') || (ProcBuffer[1] != 'p') ||
+        (ProcBuffer[2] != 'u') || (ProcBuffer[3] != ' ')) {
 
         printf("Error: Expected beginning of /proc/stat to be cpu info.\n");
         return 0;
@@ -497,17 +595,12 @@ Return Value:
     // Get the needed integers.
     //
 
-    Result = sscanf(Line,
-                    "%*s %llu %llu %llu %llu",
-                    &UserTime,
-                    &KernelTime,
-                    &NiceTime,
-                    &IdleTime);
-
-    if (Result < 4) {
-        printf("Error: Only read %d values from scanning /proc/stat.\n",
-               Result);
-
+    Current = ScanInteger(ProcBuffer + 4, &UserTime);
+    Current = ScanInteger(Current, &KernelTime);
+    Current = ScanInteger(Current, &NiceTime);
+    Current = ScanInteger(Current, &IdleTime);
+    if (Current == NULL) {
+        printf("Error: Unable to scan the cpu line of /proc/stat.\n");
         return 0;
     }
 
@@ -518,40 +611,39 @@ Return Value:
     TotalTime = UserTime + KernelTime + NiceTime + IdleTime;
     TotalTimeDifference = TotalTime - LastSummaryTotalTime;
     IdleTimeDifference = IdleTime - LastSummaryIdleTime;
-    LastSummaryTotalTime = TotalTime;
-    LastSummaryIdleTime = IdleTime;
-    *ProcessorUsage =
+    if (TotalTimeDifference != 0) {
+        LastSummaryTotalTime = TotalTime;
+        LastSummaryIdleTime = IdleTime;
+        *ProcessorUsage =
                 (int)(1000 - (IdleTimeDifference * 1000 / TotalTimeDifference));
+    }
 
     //
-    // Get the first two lines of the meminfo file.
+    // Get the total and free memory out of the meminfo file.
     //
 
-    if (fgets(Line, LINE_MAX, MemoryInfoFile) == NULL) {
-        printf("Error: Unable to read first line of /proc/meminfo.\n");
+    if (ReadProcFile(MemoryInfoDescriptor) < 0) {
+        printf("Error: Unable to read /proc/meminfo.\n");
         return 0;
     }
 
-    Result = sscanf(Line, "MemTotal: %llu", &TotalMemory);
-    if (Result < 1) {
-        printf("Error: Only read %d values from scanning MemTotal of "
-               "/proc/meminfo.\n",
-               Result);
-
-        return 0;
+    Current = FindLine(ProcBuffer, "MemTotal:");
+    if (Current != NULL) {
+        Current = ScanInteger(Current + strlen("MemTotal:"), &TotalMemory);
     }
 
-    if (fgets(Line, LINE_MAX, MemoryInfoFile) == NULL) {
-        printf("Error: Unable to read second line of /proc/meminfo.\n");
+    if ((Current == NULL) || (TotalMemory == 0)) {
+        printf("Error: Unable to scan MemTotal of /proc/meminfo.\n");
         return 0;
     }
 
-    Result = sscanf(Line, "MemFree: %llu", &FreeMemory);
-    if (Result < 1) {
-        printf("Error: Only read %d values from scanning MemFree of "
-               "/proc/meminfo.\n",
-               Result);
+    Current = FindLine(Current, "MemFree:");
+    if (Current != NULL) {
+        Current = ScanInteger(Current + strlen("MemFree:"), &FreeMemory);
+    }
 
+    if (Current == NULL) {
+        printf("Error: Unable to scan MemFree of /proc/meminfo.\n");
         return 0;
     }
 
@@ -591,16 +683,18 @@ Return Value:
 
     ULONGLONG BytesReceived;
     ULONGLONG BytesSent;
+    char *Current;
     ULONGLONG InDifference;
     ULONGLONG OutDifference;
     int Result;
     ULONGLONG SystemTime;
     ULONGLONG TimeDifference;
     struct timeval TimeOfDay;
-    char *Title;
     int TitleIndex;
+    int TitleLength;
+    ULONGLONG Value;
 
-    if (NetstatFile == NULL) {
+    if (NetstatDescriptor < 0) {
         Result = InitializeOsDependentSupport();
         if (Result == 0) {
             printf("Error: Unable to initialize linux support.\n");
@@ -608,108 +702,90 @@ Return Value:
         }
     }
 
-    rewind(NetstatFile);
-    fflush(NetstatFile);
+    if (ReadProcFile(NetstatDescriptor) < 0) {
+        printf("Error: Unable to read /proc/net/netstat.\n");
+        return 0;
+    }
 
     //
-    // Scan lines until the Ip statistics are found.
+    // Find the Ip statistics, which are a line of titles followed by a line
+    // of values.
     //
 
-    while (1) {
-        if (fgets(Line, LINE_MAX, NetstatFile) == NULL) {
-            printf("Error: Unable to read line of /proc/net/netstat.\n");
-            return 0;
-        }
-
-        if (strncmp(Line, IP_EXT_LINE, strlen(IP_EXT_LINE)) == 0) {
-            break;
-        }
+    Current = FindLine(ProcBuffer, IP_EXT_LINE);
+    if (Current == NULL) {
+        printf("Error: Unable to find Ip statistics in /proc/net/netstat.\n");
+        return 0;
     }
 
     //
-    // Search for the title of the inbound and outbound octets.
+    // Search for the title of the inbound and outbound octets the first time
+    // through. The columns stay put after that.
     //
 
-    if ((InBytesIndex == 0) || (OutBytesIndex == 0)) {
-        if (strtok(Line, " ") == NULL) {
-            printf("Error: Unable to tokenize titles.\n");
-            return 0;
-        }
-
+    Current += strlen(IP_EXT_LINE);
+    if ((InBytesIndex < 0) || (OutBytesIndex < 0)) {
         TitleIndex = 0;
-        while ((InBytesIndex == 0) || (OutBytesIndex == 0)) {
-            Title = strtok(NULL, " ");
-            if (Title == NULL) {
-                printf("Error: Unable to get titles.\n");
-                return 0;
+        while ((*Current != '\n') && (*Current != '\0')) {
+            TitleLength = 0;
+            while ((Current[TitleLength] != ' ') &&
+                   (Current[TitleLength] != '\n') &&
+                   (Current[TitleLength] != '\0')) {
+
+                TitleLength += 1;
             }
 
-            if (InBytesIndex == 0) {
-                if (strncmp(Title,
-                            IN_OCTETS_TITLE,
-                            strlen(IN_OCTETS_TITLE)) == 0) {
+            if ((TitleLength == strlen(IN_OCTETS_TITLE)) &&
+                (strncmp(Current, IN_OCTETS_TITLE, TitleLength) == 0)) {
 
-                    InBytesIndex = TitleIndex;
-                }
-            }
+                InBytesIndex = TitleIndex;
+
+            } else if ((TitleLength == strlen(OUT_OCTETS_TITLE)) &&
+                       (strncmp(Current, OUT_OCTETS_TITLE, TitleLength) == 0)) {
 
-            if (OutBytesIndex == 0) {
-                if (strncmp(Title,
-                            OUT_OCTETS_TITLE,
-                            strlen(OUT_OCTETS_TITLE)) == 0) {
+                OutBytesIndex = TitleIndex;
+            }
 
-                    OutBytesIndex = TitleIndex;
-                }
+            Current += TitleLength;
+            while (*Current == ' ') {
+                Current += 1;
             }
 
             TitleIndex += 1;
         }
+
+        if ((InBytesIndex < 0) || (OutBytesIndex < 0)) {
+            printf("Error: Unable to get titles.\n");
+            return 0;
+        }
     }
 
     //
     // Now scan the line that has the data.
     //
 
-    if (fgets(Line, LINE_MAX, NetstatFile) == NULL) {
+    Current = FindLine(Current, IP_EXT_LINE);
+    if (Current == NULL) {
         printf("Error: Unable to read data line of /proc/net/netstat.\n");
         return 0;
     }
 
-    //
-    // Tokenize to get the data.
-    //
-
-    if (strtok(Line, " ") == NULL) {
-        printf("Error: Unable to tokenize titles.\n");
-        return 0;
-    }
-
+    Current += strlen(IP_EXT_LINE);
+    BytesReceived = 0;
+    BytesSent = 0;
     TitleIndex = 0;
     while ((TitleIndex <= InBytesIndex) || (TitleIndex <= OutBytesIndex)) {
-        Title = strtok(NULL, " ");
-        if (Title == NULL) {
-            printf("Error: Unable to get titles.\n");
+        Current = ScanInteger(Current, &Value);
+        if (Current == NULL) {
+            printf("Error: Unable to scan Ip statistics.\n");
             return 0;
         }
 
         if (TitleIndex == InBytesIndex) {
-            Result = sscanf(Title, "%llu", &BytesReceived);
-            if (Result != 1) {
-                printf("Error: Got %d result for scanning bytes received.\n",
-                       Result);
+            BytesReceived = Value;
 
-                return 0;
-            }
-        }
-
-        if (TitleIndex == OutBytesIndex) {
-            Result = sscanf(Title, "%llu", &BytesSent);
-            if (Result != 1) {
-                printf("Error: Got %d result for scanning bytes received.\n",
-                       Result);
-
-                return 0;
-            }
+        } else if (TitleIndex == OutBytesIndex) {
+            BytesSent = Value;
         }
 
         TitleIndex += 1;
@@ -738,6 +814,163 @@ Return Value:
     return 1;
 }
 
+int
+GetNetworkCounters (
+    char *Interface,
+    unsigned long long *BytesReceived,
+    unsigned long long *BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queries how many bytes one network interface has moved
+    since it came up. The counters come straight out of the kernel's 64-bit
+    link statistics over netlink, so there's no text to parse.
+
+Arguments:
+
+    Interface - Supplies the name of the interface.
+
+    BytesReceived - Supplies a pointer where the total number of bytes
+        received on the interface will be returned.
+
+    BytesSent - Supplies a pointer where the total number of bytes sent on the
+        interface will be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure, including if there is no interface by that name.
+
+--*/
+
+{
+
+    struct rtattr *Attribute;
+    int AttributeLength;
+    struct nlmsgerr *Error;
+    struct ifinfomsg *Information;
+    struct nlmsghdr *Message;
+    int NameLength;
+    LINK_REQUEST Request;
+    ssize_t Size;
+    struct rtnl_link_stats64 Statistics;
+    int StatisticsLength;
+
+    NameLength = strlen(Interface) + 1;
+    if (NameLength > IFNAMSIZ) {
+        printf("Error: Interface name %s is too long.\n", Interface);
+        return 0;
+    }
+
+    if (NetlinkDescriptor < 0) {
+        NetlinkDescriptor = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+        if (NetlinkDescriptor < 0) {
+            printf("Error: Failed to open netlink socket.\nError: %s\n",
+                   strerror(errno));
+
+            return 0;
+        }
+    }
+
+    //
+    // Ask for the one interface by name, which saves dumping every interface
+    // in the system.
+    //
+
+    memset(&Request, 0, sizeof(Request));
+    NetlinkSequence += 1;
+    Request.Header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg)) +
+                               RTA_LENGTH(NameLength);
+
+    Request.Header.nlmsg_type = RTM_GETLINK;
+    Request.Header.nlmsg_flags = NLM_F_REQUEST;
+    Request.Header.nlmsg_seq = NetlinkSequence;
+    Request.Information.ifi_family = AF_UNSPEC;
+    Attribute = IFLA_RTA(&(Request.Information));
+    Attribute->rta_type = IFLA_IFNAME;
+    Attribute->rta_len = RTA_LENGTH(NameLength);
+    memcpy(RTA_DATA(Attribute), Interface, NameLength);
+    if (send(NetlinkDescriptor, &Request, Request.Header.nlmsg_len, 0) < 0) {
+        printf("Error: Failed to send netlink request.\nError: %s\n",
+               strerror(errno));
+
+        return 0;
+    }
+
+    //
+    // Read until the reply to this request shows up, passing over any left
+    // from an earlier request that gave up.
+    //
+
+    Message = NULL;
+    while (Message == NULL) {
+        Size = recv(NetlinkDescriptor,
+                    NetlinkBuffer,
+                    sizeof(NetlinkBuffer),
+                    0);
+
+        if (Size < 0) {
+            printf("Error: Failed to receive netlink reply.\nError: %s\n",
+                   strerror(errno));
+
+            return 0;
+        }
+
+        Message = (struct nlmsghdr *)NetlinkBuffer;
+        while ((NLMSG_OK(Message, Size)) &&
+               (Message->nlmsg_seq != NetlinkSequence)) {
+
+            Message = NLMSG_NEXT(Message, Size);
+        }
+
+        if (!NLMSG_OK(Message, Size)) {
+            Message = NULL;
+        }
+    }
+
+    if (Message->nlmsg_type == NLMSG_ERROR) {
+        Error = NLMSG_DATA(Message);
+        printf("Error: Unable to get statistics for %s.\nError: %s\n",
+               Interface,
+               strerror(-Error->error));
+
+        return 0;
+    }
+
+    //
+    // Find the 64-bit statistics among the interface's attributes. Older
+    // kernels send a shorter structure, and the attribute is only 4-byte
+    // aligned, so copy out what's there.
+    //
+
+    Information = NLMSG_DATA(Message);
+    Attribute = IFLA_RTA(Information);
+    AttributeLength = IFLA_PAYLOAD(Message);
+    while (RTA_OK(Attribute, AttributeLength)) {
+        if (Attribute->rta_type == IFLA_STATS64) {
+            StatisticsLength = RTA_PAYLOAD(Attribute);
+            if (StatisticsLength > sizeof(Statistics)) {
+                StatisticsLength = sizeof(Statistics);
+            }
+
+            memset(&Statistics, 0, sizeof(Statistics));
+            memcpy(&Statistics, RTA_DATA(Attribute), StatisticsLength);
+            *BytesReceived = Statistics.rx_bytes;
+            *BytesSent = Statistics.tx_bytes;
+            return 1;
+        }
+
+        Attribute = RTA_NEXT(Attribute, AttributeLength);
+    }
+
+    printf("Error: No statistics for interface %s.\n", Interface);
+    return 0;
+}
+
 int
 GetCurrentDateAndTime (
     int *Year,
@@ -804,7 +1037,407 @@ Return Value:
     return 1;
 }
 
+int
+WaitForDeviceChange (
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for USB devices to come or go.
+
+Arguments:
+
+    Milliseconds - Supplies the longest time to wait. If the system can't
+        report device changes, a shorter interval is waited instead.
+
+Return Value:
+
+    Non-zero if the devices may have changed.
+
+    0 if the wait timed out with no change, or if the system can't report
+    device changes. In that case the caller decides when to look again.
+
+--*/
+
+{
+
+    char Buffer[NOTIFY_BUFFER_SIZE];
+    struct pollfd Poll;
+    int Result;
+
+    if (UsbNotifyDescriptor == -1) {
+        UsbNotifyDescriptor = inotify_init();
+        if (UsbNotifyDescriptor >= 0) {
+            if (WatchUsbDevices() == 0) {
+                close(UsbNotifyDescriptor);
+                UsbNotifyDescriptor = -1;
+            }
+        }
+
+        if (UsbNotifyDescriptor < 0) {
+            UsbNotifyDescriptor = -2;
+        }
+    }
+
+    //
+    // Fall back to sleeping if device nodes can't be watched, leaving it to
+    // the caller to decide when to rescan.
+    //
+
+    if (UsbNotifyDescriptor < 0) {
+        if (Milliseconds > DEVICE_POLL_INTERVAL) {
+            Milliseconds = DEVICE_POLL_INTERVAL;
+        }
+
+        usleep(Milliseconds * 1000);
+        return 0;
+    }
+
+    Poll.fd = UsbNotifyDescriptor;
+    Poll.events = POLLIN;
+    Poll.revents = 0;
+    Result = poll(&Poll, 1, Milliseconds);
+    if (Result <= 0) {
+        return 0;
+    }
+
+    //
+    // Swallow the notifications, as the caller rescans the devices anyway.
+    // A new bus may have shown up, so watch any new bus directories too.
+    //
+
+    Result = read(UsbNotifyDescriptor, Buffer, NOTIFY_BUFFER_SIZE);
+    if (Result < 0) {
+        return 1;
+    }
+
+    WatchUsbDevices();
+    return 1;
+}
+
+int
+ReadInput (
+    char *Buffer,
+    int BufferSize,
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for input to come in on stdin, then reads whatever is
+    there without waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the input will be returned.
+
+    BufferSize - Supplies the size of the buffer, in bytes.
+
+    Milliseconds - Supplies the longest time to wait for input.
+
+Return Value:
+
+    Returns the number of bytes read, which is 0 if the wait timed out.
+
+    -1 at the end of the input, or on failure.
+
+--*/
+
+{
+
+    struct pollfd Poll;
+    int Result;
+
+    Poll.fd = STDIN_FILENO;
+    Poll.events = POLLIN;
+    Poll.revents = 0;
+    Result = poll(&Poll, 1, Milliseconds);
+    if (Result < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    if (Result == 0) {
+        return 0;
+    }
+
+    Result = read(STDIN_FILENO, Buffer, BufferSize);
+    if (Result < 0) {
+        if ((errno == EINTR) || (errno == EAGAIN)) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    if (Result == 0) {
+        return -1;
+    }
+
+    return Result;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+int
+WatchUsbDevices (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine asks to be notified when device nodes are added or removed
+    under each USB bus directory, and when buses are added. Directories that
+    are already watched are left alone.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 if the USB device directory can't be watched.
+
+--*/
+
+{
+
+    DIR *Directory;
+    struct dirent *Entry;
+    unsigned int Mask;
+
+    Mask = IN_CREATE | IN_DELETE | IN_ATTRIB;
+    if (inotify_add_watch(UsbNotifyDescriptor,
+                          USB_DEVICE_DIRECTORY,
+                          Mask) < 0) {
+
+        return 0;
+    }
+
+    Directory = opendir(USB_DEVICE_DIRECTORY);
+    if (Directory == NULL) {
+        return 0;
+    }
+
+    Entry = readdir(Directory);
+    while (Entry != NULL) {
+        if (Entry->d_name[0] != '.') {
+            snprintf(Line,
+                     LINE_MAX,
+                     "%s/%s",
+                     USB_DEVICE_DIRECTORY,
+                     Entry->d_name);
+
+            inotify_add_watch(UsbNotifyDescriptor, Line, Mask);
+        }
+
+        Entry = readdir(Directory);
+    }
+
+    closedir(Directory);
+    return 1;
+}
+
+int
+ReadProcFile (
+    int Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads a /proc file from the start into the global proc
+    buffer, and null terminates it. Anything past the end of the buffer is
+    left unread.
+
+Arguments:
+
+    Descriptor - Supplies the open descriptor of the file.
+
+Return Value:
+
+    Returns the number of bytes read.
+
+    -1 on failure.
+
+--*/
+
+{
+
+    int BytesRead;
+    int Size;
+
+    Size = 0;
+    while (Size < PROC_BUFFER_SIZE - 1) {
+        BytesRead = pread(Descriptor,
+                          ProcBuffer + Size,
+                          PROC_BUFFER_SIZE - 1 - Size,
+                          Size);
+
+        if (BytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        if (BytesRead == 0) {
+            break;
+        }
+
+        Size += BytesRead;
+    }
+
+    ProcBuffer[Size] = '\0';
+    return Size;
+}
+
+char *
+ScanInteger (
+    char *String,
+    PULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine scans an unsigned decimal integer, skipping any spaces in
+    front of it.
+
+Arguments:
+
+    String - Supplies a pointer to the string to scan. NULL is passed through,
+        so that scans can be chained and checked once at the end.
+
+    Value - Supplies a pointer where the integer will be returned.
+
+Return Value:
+
+    Returns a pointer just past the integer.
+
+    NULL if there was no integer.
+
+--*/
+
+{
+
+    ULONGLONG Integer;
+
+    if (String == NULL) {
+        return NULL;
+    }
+
+    while (*String == ' ') {
+        String += 1;
+    }
+
+    if ((*String < '0') || (*String > '9')) {
+        return NULL;
+    }
+
+    Integer = 0;
+    while ((*String >= '0') && (*String <= '9')) {
+        Integer = (Integer * 10) + (*String - '0');
+        String += 1;
+    }
+
+    *Value = Integer;
+    return String;
+}
+
+char *
+FindLine (
+    char *String,
+    char *Prefix
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the next line that starts with the given prefix.
+
+Arguments:
+
+    String - Supplies a pointer to where to start looking. If this is in the
+        middle of a line, the search starts at the next one.
+
+    Prefix - Supplies a pointer to the prefix to look for.
+
+Return Value:
+
+    Returns a pointer to the start of the line.
+
+    NULL if no line starts with the prefix.
+
+--*/
+
+{
+
+    int Length;
+
+    Length = strlen(Prefix);
+    if ((String != ProcBuffer) && (String[-1] != '\n')) {
+        String = SkipLine(String);
+    }
+
+    while (String != NULL) {
+        if (strncmp(String, Prefix, Length) == 0) {
+            return String;
+        }
+
+        String = SkipLine(String);
+    }
+
+    return NULL;
+}
+
+char *
+SkipLine (
+    char *String
+    )
+
+/*++
+
+Routine Description:
+
+    This routine skips to the start of the next line.
+
+Arguments:
+
+    String - Supplies a pointer within the current line.
+
+Return Value:
+
+    Returns a pointer to the start of the next line.
+
+    NULL if this is the last line.
+
+--*/
+
+{
+
+    String = strchr(String, '\n');
+    if ((String == NULL) || (String[1] == '\0')) {
+        return NULL;
+    }
+
+    return String + 1;
+}
+
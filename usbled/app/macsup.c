@@ -31,6 +31,8 @@ Environment:
 #include <errno.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/select.h>
+#include <unistd.h>
 #include <sys/sysctl.h>
 #include <netinet/in.h>
 #include <net/if.h>
@@ -42,6 +44,13 @@ Environment:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define how often to look for USB devices, since there's no notification
+// here when they change.
+//
+
+#define DEVICE_POLL_INTERVAL 250
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -56,6 +65,13 @@ void
 DestroyOsDependentSupport (
     );
 
+int
+ReadInterfaceCounters (
+    unsigned int InterfaceIndex,
+    PULONGLONG BytesReceived,
+    PULONGLONG BytesSent
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -453,12 +469,8 @@ Return Value:
 
 {
 
-    char *BufferEnd;
     ULONGLONG InDifference;
-    struct if_msghdr *MessageHeader;
-    struct if_msghdr2 *MessageHeader2;
     ULONGLONG OutDifference;
-    int Request[6];
     int Result;
     ULONGLONG SystemTime;
     ULONGLONG TimeDifference;
@@ -466,83 +478,9 @@ Return Value:
     ULONGLONG TotalBytesIn;
     ULONGLONG TotalBytesOut;
 
-    TotalBytesIn = 0;
-    TotalBytesOut = 0;
-    Request[0] = CTL_NET;
-    Request[1] = PF_ROUTE;
-    Request[2] = 0;
-    Request[3] = 0;
-    Request[4] = NET_RT_IFLIST2;
-    Request[5] = 0;
-
-    //
-    // If a buffer has not been created, set one up.
-    //
-
-    if (NetworkControlBufferLength == 0) {
-
-        //
-        // Perform the sysctl once to get the length of the result.
-        //
-
-        Result = sysctl(Request, 6, NULL, &NetworkControlBufferLength, NULL, 0);
-        if (Result < 0) {
-            printf("Error: sysctl errored out: %s\n", strerror(errno));
-            return 0;
-        }
-
-        //
-        // Allocate the buffer space.
-        //
-
-        NetworkControlBuffer = malloc(NetworkControlBufferLength);
-        if (NetworkControlBuffer == NULL) {
-            printf("Error: Unable to allocate %d byte for network control "
-                   "buffer.\n",
-                   (int)NetworkControlBufferLength);
-
-            return 0;
-        }
-    }
-
-    //
-    // Perform the sysctl to get networking statistics from the kernel.
-    //
-
-    Result = sysctl(Request,
-                    6,
-                    NetworkControlBuffer,
-                    &NetworkControlBufferLength,
-                    NULL,
-                    0);
-
-    if (Result < 0) {
-        free(NetworkControlBuffer);
-        NetworkControlBuffer = 0;
-        NetworkControlBufferLength = 0;
-        Result = GetNetworkUsage(DownloadSpeed, UploadSpeed);
-        if (Result < 0) {
-            printf("Error: sysctl errored out: %s\n", strerror(errno));
-            Result = 0;
-
-        } else {
-            Result = 1;
-        }
-
-        return Result;
-    }
-
-    BufferEnd = NetworkControlBuffer + NetworkControlBufferLength;
-    MessageHeader = (struct if_msghdr *)NetworkControlBuffer;
-    while ((char *)MessageHeader + sizeof(struct if_msghdr) <= BufferEnd) {
-        if (MessageHeader->ifm_type == RTM_IFINFO2) {
-            MessageHeader2 = (struct if_msghdr2 *)MessageHeader;
-            TotalBytesIn += MessageHeader2->ifm_data.ifi_ibytes;
-            TotalBytesOut += MessageHeader2->ifm_data.ifi_obytes;
-        }
-
-        MessageHeader = (struct if_msghdr *)((char *)MessageHeader +
-                                             MessageHeader->ifm_msglen);
+    Result = ReadInterfaceCounters(0, &TotalBytesIn, &TotalBytesOut);
+    if (Result == 0) {
+        return 0;
     }
 
     //
@@ -568,6 +506,51 @@ Return Value:
     return 1;
 }
 
+int
+GetNetworkCounters (
+    char *Interface,
+    unsigned long long *BytesReceived,
+    unsigned long long *BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queries how many bytes one network interface has moved
+    since it came up.
+
+Arguments:
+
+    Interface - Supplies the name of the interface.
+
+    BytesReceived - Supplies a pointer where the total number of bytes
+        received on the interface will be returned.
+
+    BytesSent - Supplies a pointer where the total number of bytes sent on the
+        interface will be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure, including if there is no interface by that name.
+
+--*/
+
+{
+
+    unsigned int InterfaceIndex;
+
+    InterfaceIndex = if_nametoindex(Interface);
+    if (InterfaceIndex == 0) {
+        printf("Error: There is no network interface %s.\n", Interface);
+        return 0;
+    }
+
+    return ReadInterfaceCounters(InterfaceIndex, BytesReceived, BytesSent);
+}
+
 int
 GetCurrentDateAndTime (
     int *Year,
@@ -634,7 +617,246 @@ Return Value:
     return 1;
 }
 
+int
+WaitForDeviceChange (
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for USB devices to come or go.
+
+Arguments:
+
+    Milliseconds - Supplies the longest time to wait. If the system can't
+        report device changes, a shorter interval is waited instead.
+
+Return Value:
+
+    Non-zero if the devices may have changed.
+
+    0 if the wait timed out with no change, or if the system can't report
+    device changes. In that case the caller decides when to look again.
+
+--*/
+
+{
+
+    if (Milliseconds > DEVICE_POLL_INTERVAL) {
+        Milliseconds = DEVICE_POLL_INTERVAL;
+    }
+
+    usleep(Milliseconds * 1000);
+    return 0;
+}
+
+int
+ReadInput (
+    char *Buffer,
+    int BufferSize,
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for input to come in on stdin, then reads whatever is
+    there without waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the input will be returned.
+
+    BufferSize - Supplies the size of the buffer, in bytes.
+
+    Milliseconds - Supplies the longest time to wait for input.
+
+Return Value:
+
+    Returns the number of bytes read, which is 0 if the wait timed out.
+
+    -1 at the end of the input, or on failure.
+
+--*/
+
+{
+
+    fd_set Descriptors;
+    int Result;
+    struct timeval Timeout;
+
+    //
+    // Use select rather than poll, since poll doesn't work on terminals here.
+    //
+
+    FD_ZERO(&Descriptors);
+    FD_SET(STDIN_FILENO, &Descriptors);
+    Timeout.tv_sec = Milliseconds / 1000;
+    Timeout.tv_usec = (Milliseconds % 1000) * 1000;
+    Result = select(STDIN_FILENO + 1, &Descriptors, NULL, NULL, &Timeout);
+    if (Result < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    if (Result == 0) {
+        return 0;
+    }
+
+    Result = read(STDIN_FILENO, Buffer, BufferSize);
+    if (Result < 0) {
+        if ((errno == EINTR) || (errno == EAGAIN)) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    if (Result == 0) {
+        return -1;
+    }
+
+    return Result;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+int
+ReadInterfaceCounters (
+    unsigned int InterfaceIndex,
+    PULONGLONG BytesReceived,
+    PULONGLONG BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the byte counters of the network interfaces out of the
+    kernel.
+
+Arguments:
+
+    InterfaceIndex - Supplies the index of the interface to read, or 0 to
+        total up every interface.
+
+    BytesReceived - Supplies a pointer where the total number of bytes
+        received will be returned.
+
+    BytesSent - Supplies a pointer where the total number of bytes sent will
+        be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure, including if the given interface wasn't found.
+
+--*/
+
+{
+
+    char *BufferEnd;
+    int Found;
+    struct if_msghdr *MessageHeader;
+    struct if_msghdr2 *MessageHeader2;
+    int Request[6];
+    int Result;
+    ULONGLONG TotalBytesIn;
+    ULONGLONG TotalBytesOut;
+
+    Found = 0;
+    TotalBytesIn = 0;
+    TotalBytesOut = 0;
+    Request[0] = CTL_NET;
+    Request[1] = PF_ROUTE;
+    Request[2] = 0;
+    Request[3] = 0;
+    Request[4] = NET_RT_IFLIST2;
+    Request[5] = 0;
+
+    //
+    // If a buffer has not been created, set one up.
+    //
+
+    if (NetworkControlBufferLength == 0) {
+
+        //
+        // Perform the sysctl once to get the length of the result.
+        //
+
+        Result = sysctl(Request, 6, NULL, &NetworkControlBufferLength, NULL, 0);
+        if (Result < 0) {
+            printf("Error: sysctl errored out: %s\n", strerror(errno));
+            return 0;
+        }
+
+        //
+        // Allocate the buffer space.
+        //
+
+        NetworkControlBuffer = malloc(NetworkControlBufferLength);
+        if (NetworkControlBuffer == NULL) {
+            printf("Error: Unable to allocate %d byte for network control "
+                   "buffer.\n",
+                   (int)NetworkControlBufferLength);
+
+            return 0;
+        }
+    }
+
+    //
+    // Perform the sysctl to get networking statistics from the kernel. If
+    // it fails the buffer may have gotten too small, so start over with a new
+    // one.
+    //
+
+    Result = sysctl(Request,
+                    6,
+                    NetworkControlBuffer,
+                    &NetworkControlBufferLength,
+                    NULL,
+                    0);
+
+    if (Result < 0) {
+        free(NetworkControlBuffer);
+        NetworkControlBuffer = 0;
+        NetworkControlBufferLength = 0;
+        return ReadInterfaceCounters(InterfaceIndex, BytesReceived, BytesSent);
+    }
+
+    BufferEnd = NetworkControlBuffer + NetworkControlBufferLength;
+    MessageHeader = (struct if_msghdr *)NetworkControlBuffer;
+    while ((char *)MessageHeader + sizeof(struct if_msghdr) <= BufferEnd) {
+        if ((MessageHeader->ifm_type == RTM_IFINFO2) &&
+            ((InterfaceIndex == 0) ||
+             (MessageHeader->ifm_index == InterfaceIndex))) {
+
+            MessageHeader2 = (struct if_msghdr2 *)MessageHeader;
+            TotalBytesIn += MessageHeader2->ifm_data.ifi_ibytes;
+            TotalBytesOut += MessageHeader2->ifm_data.ifi_obytes;
+            Found = 1;
+        }
+
+        MessageHeader = (struct if_msghdr *)((char *)MessageHeader +
+                                             MessageHeader->ifm_msglen);
+    }
+
+    if ((InterfaceIndex != 0) && (Found == 0)) {
+        printf("Error: No statistics for interface %d.\n", InterfaceIndex);
+        return 0;
+    }
+
+    *BytesReceived = TotalBytesIn;
+    *BytesSent = TotalBytesOut;
+    return 1;
+}
+
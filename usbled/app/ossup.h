@@ -133,6 +133,38 @@ Return Value:
 
 --*/
 
+int
+GetNetworkCounters (
+    char *Interface,
+    unsigned long long *BytesReceived,
+    unsigned long long *BytesSent
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queries how many bytes one network interface has moved
+    since it came up.
+
+Arguments:
+
+    Interface - Supplies the name of the interface.
+
+    BytesReceived - Supplies a pointer where the total number of bytes
+        received on the interface will be returned.
+
+    BytesSent - Supplies a pointer where the total number of bytes sent on the
+        interface will be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure, including if there is no interface by that name.
+
+--*/
+
 int
 GetCurrentDateAndTime (
     int *Year,
@@ -182,3 +214,58 @@ Return Value:
 
 --*/
 
+int
+WaitForDeviceChange (
+    int Milliseconds
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for USB devices to come or go.
+
+Arguments:
+
+    Milliseconds - Supplies the longest time to wait. If the system can't
+        report device changes, a shorter interval is waited instead.
+
+Return Value:
+
+    Non-zero if the devices may have changed.
+
+    0 if the wait timed out with no change, or if the system can't report
+    device changes. In that case the caller decides when to look again.
+
+--*/
+
+int
+ReadInput (
+    char *Buffer,
+    int BufferSize,
+    int Milliseconds
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for input to come in on stdin, then reads whatever is
+    there without waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the input will be returned.
+
+    BufferSize - Supplies the size of the buffer, in bytes.
+
+    Milliseconds - Supplies the longest time to wait for input.
+
+Return Value:
+
+    Returns the number of bytes read, which is 0 if the wait timed out.
+
+    -1 at the end of the input, or on failure.
+
+--*/
+
@@ -0,0 +1,314 @@
+/*++
+
+Copyright (c) 2011 Evan Green
+
+Module Name:
+
+    samplebench.c
+
+Abstract:
+
+    This module implements a benchmark of the system sampling routines the
+    USB LED app displays, reporting how many samples of each it can take per
+    second.
+
+Author:
+
+    Evan Green 18-Jul-2011
+
+Environment:
+
+    User Mode (Linux)
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "ossup.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define USAGE_STRING \
+    "SampleBench takes samples of the processor, memory and network usage " \
+    "as fast as\nit can, and reports how many of each it took per second.\n\n" \
+    "Usage: samplebench [-n Samples] [-i Interface]\n\n" \
+    "Options:\n" \
+    "    -n  Take the given number of samples of each. The default is %d.\n" \
+    "    -i  Also sample the byte counters of the given network interface.\n\n"
+
+#define DEFAULT_SAMPLE_COUNT 100000
+
+//
+// Define the most processors reported on.
+//
+
+#define MAX_PROCESSORS 1024
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef enum _SAMPLE_TYPE {
+    SampleProcessors,
+    SampleProcessorAndMemory,
+    SampleNetwork,
+    SampleNetworkCounters,
+    SampleTypeCount
+} SAMPLE_TYPE, *PSAMPLE_TYPE;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+double
+TimeSamples (
+    SAMPLE_TYPE Type,
+    int SampleCount
+    );
+
+double
+GetSeconds (
+    void
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+char *SampleNames[SampleTypeCount] = {
+    "GetProcessorUsage",
+    "GetProcessorAndMemoryUsage",
+    "GetNetworkUsage",
+    "GetNetworkCounters"
+};
+
+//
+// Store the network interface whose counters are sampled, if any.
+//
+
+char *InterfaceName;
+
+int ProcessorUsage[MAX_PROCESSORS];
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+int
+main (
+    int argc,
+    char **argv
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the program. It collects the
+    options passed to it, times each kind of sample, and prints the results.
+
+Arguments:
+
+    argc - Supplies the number of command line arguments the program was invoked
+           with.
+
+    argv - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
+{
+
+    char *Argument;
+    int ProcessorCount;
+    int SampleCount;
+    double Seconds;
+    SAMPLE_TYPE Type;
+
+    SampleCount = DEFAULT_SAMPLE_COUNT;
+    while ((argc > 1) && (argv[1][0] == '-')) {
+        Argument = &(argv[1][1]);
+
+        //
+        // 'n' sets the number of samples.
+        //
+
+        if ((strcmp(Argument, "n") == 0) && (argc > 2)) {
+            SampleCount = strtol(argv[2], NULL, 10);
+            argc -= 1;
+            argv += 1;
+
+        //
+        // 'i' sets the network interface to sample the counters of.
+        //
+
+        } else if ((strcmp(Argument, "i") == 0) && (argc > 2)) {
+            InterfaceName = argv[2];
+            argc -= 1;
+            argv += 1;
+
+        } else {
+            fprintf(stderr, "%s: Invalid option\n\n", Argument);
+            fprintf(stderr, USAGE_STRING, DEFAULT_SAMPLE_COUNT);
+            return 1;
+        }
+
+        argc -= 1;
+        argv += 1;
+    }
+
+    if ((argc > 1) || (SampleCount <= 0)) {
+        fprintf(stderr, USAGE_STRING, DEFAULT_SAMPLE_COUNT);
+        return 1;
+    }
+
+    ProcessorCount = GetProcessorUsage(NULL, 0, 0);
+    if (ProcessorCount == 0) {
+        return 1;
+    }
+
+    printf("SampleBench: %d samples of each, %d processors.\n",
+           SampleCount,
+           ProcessorCount);
+
+    for (Type = 0; Type < SampleTypeCount; Type += 1) {
+        if ((Type == SampleNetworkCounters) && (InterfaceName == NULL)) {
+            continue;
+        }
+
+        Seconds = TimeSamples(Type, SampleCount);
+        if (Seconds < 0) {
+            fprintf(stderr, "Error: %s failed.\n", SampleNames[Type]);
+            return 1;
+        }
+
+        printf("SampleBench: %-28s %10.0f samples per second, "
+               "%7.2f us each.\n",
+               SampleNames[Type],
+               SampleCount / Seconds,
+               Seconds * 1000000 / SampleCount);
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+double
+TimeSamples (
+    SAMPLE_TYPE Type,
+    int SampleCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes the given number of samples of one kind back to back.
+
+Arguments:
+
+    Type - Supplies the kind of sample to take.
+
+    SampleCount - Supplies the number of samples to take.
+
+Return Value:
+
+    Returns the number of seconds the samples took.
+
+    -1 if a sample failed.
+
+--*/
+
+{
+
+    unsigned long long BytesReceived;
+    unsigned long long BytesSent;
+    int Download;
+    int Index;
+    int Memory;
+    int Processor;
+    int Result;
+    double Start;
+    int Upload;
+
+    Start = GetSeconds();
+    for (Index = 0; Index < SampleCount; Index += 1) {
+        switch (Type) {
+        case SampleProcessors:
+            Result = GetProcessorUsage(ProcessorUsage,
+                                       sizeof(ProcessorUsage),
+                                       0);
+
+            break;
+
+        case SampleProcessorAndMemory:
+            Result = GetProcessorAndMemoryUsage(&Processor, &Memory);
+            break;
+
+        case SampleNetwork:
+            Result = GetNetworkUsage(&Download, &Upload);
+            break;
+
+        case SampleNetworkCounters:
+            Result = GetNetworkCounters(InterfaceName,
+                                        &BytesReceived,
+                                        &BytesSent);
+
+            break;
+
+        default:
+            Result = 0;
+            break;
+        }
+
+        if (Result == 0) {
+            return -1;
+        }
+    }
+
+    return GetSeconds() - Start;
+}
+
+double
+GetSeconds (
+    void
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets the current time in seconds.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the seconds since the epoch, to the microsecond.
+
+--*/
+
+{
+
+    struct timeval TimeOfDay;
+
+    gettimeofday(&TimeOfDay, NULL);
+    return TimeOfDay.tv_sec + (TimeOfDay.tv_usec / 1000000.0);
+}
+
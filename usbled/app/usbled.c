@@ -34,6 +34,8 @@ Environment:
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <pthread.h>
 #include <usb.h>
 
 #endif
@@ -82,11 +84,12 @@ Environment:
     "   -m       CPU and Memory usage. This feature displays how busy all\n" \
     "            cores are (aggregated into one percentage), and shows how\n" \
     "            much system memory is available (as a percentage).\n\n"\
-    "   -n       Network usage. Shows the upload and download rates of all\n"\
+    "    -n [if] Network usage. Shows the upload and download rates of all\n"\
     "            network adapters in the system. If the rate is less than\n"\
     "            1MB/s, it is displayed in units of kB/s without a decimal \n"\
     "            point. For rates greater than 1MB/s, the rate is displayed\n"\
-    "            with a decimal point.\n\n"\
+    "            with a decimal point. Supply an optional interface name to\n"\
+    "            show the rates of just that adapter, like -n eth1.\n\n"\
     "   -d       Current date. Shows the current month and date.\n\n"\
     "   -t       Current time. Shows the current time of the day. By\n"\
     "            default the time shows in the form \"hh mm ss\" in 12-hour\n"\
@@ -115,7 +118,24 @@ Environment:
     "            number. Use the -l switch to get the serial numbers of all\n"\
     "            connected devices.\n\n"\
     "    -o      Print the current state of the button on the display.\n\n"\
+    "    -w <N>  Brightness. Set how bright the digits are, from 0 (off) to\n"\
+    "            16 (full). The device remembers this until it is unplugged.\n"\
+    "\n"\
+    "    -x <ms> Marquee. Scroll each line of the display around by one\n"\
+    "            digit every <ms> milliseconds. The display does the\n"\
+    "            scrolling itself, so it works with any feature or value.\n\n"\
     "    -i      Grab the input from stdin instead of the command line.\n\n"\
+    "    -p      Pipe. Like -i, but for a program that writes lines faster\n"\
+    "            than the display should change. Each update shows only\n"\
+    "            the newest whole line, at most once per update interval,\n"\
+    "            so the display never falls behind. Lines in between are\n"\
+    "            dropped, and verbose mode counts them.\n\n"\
+    "    +       Another display. The features and options after this go\n"\
+    "            to the next USB LED device, so one instance can drive\n"\
+    "            several displays from the same samples. Options carry over\n"\
+    "            from the display before, except for the features, -s and\n"\
+    "            -r. Without -s or -r, each display uses the next device.\n"\
+    "            Verbose mode shows how fast each display is keeping up.\n\n"\
     "    -e      Exit immediately if no devices are found.\n\n"\
     "    -h or --help  Shows this help message.\n\n"\
     "Values:\n\n"\
@@ -139,6 +159,9 @@ Environment:
     "usbled -c   Displays how busy each core in the machine is.\n\n" \
     "usbled -c 4 -s 1  Displays how busy cores 4-7 are on the second USB LED\n"\
     "            or USB LED Mini device.\n\n" \
+    "usbled -m -t + -c + -n -d  Shows CPU, memory and time on the first\n"\
+    "            device, per-core usage on the second, and network usage\n"\
+    "            and the date on the third.\n\n" \
     "Troubleshooting:\n\n" \
     "    If the app hangs, ensure that the USB LED device is plugged in. If \n"\
     "    successfully connected, the device will turn on the first decimal \n"\
@@ -210,6 +233,100 @@ Environment:
 
 #define USBLED_COMMAND_GET_BUTTON_STATE 1
 
+//
+// This command sets the brightness of one digit, or of every digit if the
+// digit index is past the last one.
+//
+
+#define USBLED_COMMAND_SET_BRIGHTNESS 2
+
+//
+// Define the brightness range, and the digit index that means all digits.
+//
+
+#define USBLED_MAX_BRIGHTNESS 16
+#define USBLED_ALL_DIGITS 0xFF
+
+//
+// This command writes raw segment masks into the digits, one byte per digit,
+// starting at the digit in the index. Devices from this version on support
+// it.
+//
+
+#define USBLED_COMMAND_SET_SEGMENTS 3
+#define USBLED_RAW_SEGMENTS_VERSION 0x102
+
+//
+// Define the number of digits on the display, and the number in one line.
+//
+
+#define USBLED_DIGIT_COUNT 16
+#define USBLED_LINE_DIGITS 8
+
+//
+// Define the segment masks for a period and a dash.
+//
+
+#define USBLED_PERIOD 0x10
+#define USBLED_DASH 0x40
+
+//
+// These commands set up blinking digits and scrolling lines, which the device
+// then animates on its own. Devices from this version on support them.
+//
+
+#define USBLED_COMMAND_SET_BLINK 4
+#define USBLED_COMMAND_SET_SCROLL 5
+#define USBLED_ANIMATION_VERSION 0x103
+
+//
+// Define how long the device takes to go once around all its digits, which
+// is the unit the device animates in, and the most frames it can count.
+//
+
+#define USBLED_FRAME_MICROSECONDS 5461
+#define USBLED_MAX_FRAMES 255
+
+//
+// Define the mask covering both lines of the display.
+//
+
+#define USBLED_ALL_LINES 0x3
+
+//
+// Define how long blinking decimals stay on and off for, in milliseconds.
+//
+
+#define USBLED_BLINK_INTERVAL 500
+
+//
+// Define the longest time to wait for the USB devices to change before
+// rescanning the busses anyway, in milliseconds.
+//
+
+#define USBLED_RESCAN_INTERVAL 5000
+
+//
+// Define the most displays one instance can drive, and the most processors
+// sampled for them.
+//
+
+#define USBLED_MAX_DISPLAYS 8
+#define USBLED_MAX_PROCESSORS 256
+
+//
+// Define how often verbose mode shows how each display is keeping up, in
+// milliseconds.
+//
+
+#define USBLED_STATISTICS_INTERVAL 10000
+
+//
+// Define how much of stdin is read at once in pipe mode.
+//
+
+#define USBLED_INPUT_BUFFER_SIZE 4096
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -224,22 +341,257 @@ typedef enum _STOCK_FEATURE {
     StockFeatureCurrentTimeShort,
 } STOCK_FEATURE, *PSTOCK_FEATURE;
 
-typedef struct _OPTION_LIST {
+typedef struct _DISPLAY_OPTIONS {
     STOCK_FEATURE Selection[USBLED_MAX_ROWS];
-    int Verbose;
-    int UpdateInterval;
     int CpuOffset;
+    char *NetworkInterface;
     int MilitaryTime;
     int ShowBlinkyDecimals;
     int SkipDeviceCount;
-    char *StringToWrite;
     char *SerialNumber;
+    int Brightness;
+    int ScrollInterval;
+} DISPLAY_OPTIONS, *PDISPLAY_OPTIONS;
+
+typedef struct _OPTION_LIST {
+    DISPLAY_OPTIONS Display[USBLED_MAX_DISPLAYS];
+    int DisplayCount;
+    int Verbose;
+    int UpdateInterval;
+    char *StringToWrite;
     int ListDeviceSerialNumbers;
     int PrintButtonState;
     int UseStdin;
+    int StreamStdin;
     int ExitImmediately;
 } OPTION_LIST, *POPTION_LIST;
 
+/*++
+
+Structure Description:
+
+    This structure stores the network rates of one interface, or of every
+    interface together.
+
+Members:
+
+    Interface - Stores the name of the interface, or NULL for every interface.
+
+    BytesReceived - Stores the number of bytes the interface had received
+        when it was last sampled.
+
+    BytesSent - Stores the number of bytes the interface had sent when it was
+        last sampled.
+
+    Time - Stores the time the interface was last sampled, in microseconds.
+
+    DownloadSpeed - Stores the download speed, in kilobytes per second.
+
+    UploadSpeed - Stores the upload speed, in kilobytes per second.
+
+--*/
+
+typedef struct _NETWORK_SAMPLE {
+    char *Interface;
+    unsigned long long BytesReceived;
+    unsigned long long BytesSent;
+    unsigned long long Time;
+    int DownloadSpeed;
+    int UploadSpeed;
+} NETWORK_SAMPLE, *PNETWORK_SAMPLE;
+
+/*++
+
+Structure Description:
+
+    This structure stores one sample of the system, which every display
+    shows its features from.
+
+Members:
+
+    ProcessorCount - Stores the number of processors in the system.
+
+    ProcessorUsage - Stores the usage of each processor, in percent times 10.
+
+    CpuUsage - Stores the usage of all processors together, in percent times
+        10.
+
+    MemoryUsage - Stores the memory usage, in percent times 10.
+
+    NetworkCount - Stores the number of network rates being sampled.
+
+    Network - Stores the network rates of each interface a display shows.
+
+--*/
+
+typedef struct _SYSTEM_SAMPLE {
+    int ProcessorCount;
+    int ProcessorUsage[USBLED_MAX_PROCESSORS];
+    int CpuUsage;
+    int MemoryUsage;
+    int NetworkCount;
+    NETWORK_SAMPLE Network[USBLED_MAX_DISPLAYS];
+} SYSTEM_SAMPLE, *PSYSTEM_SAMPLE;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the thread that writes frames out to
+    a device, so that gathering the next frame never waits on USB.
+
+Members:
+
+    Thread - Stores the thread writing to the device.
+
+    Lock - Stores the lock guarding the rest of the structure.
+
+    Signal - Stores the signal the thread waits on for work.
+
+    Handle - Stores the open device.
+
+    RawSegments - Stores a non-zero value if the device takes raw segments.
+
+    String - Stores the newest frame not yet written.
+
+    BlinkMask - Stores the digits that should blink with the newest frame.
+
+    WrittenBlinkMask - Stores the digits last set blinking on the device.
+
+    Pending - Stores a non-zero value if there is a frame waiting to be
+        written.
+
+    Stop - Stores a non-zero value if the thread should exit once it has
+        written the waiting frame.
+
+    Result - Stores the result of the last write. Once this is negative, the
+        thread stops writing.
+
+    FramesDropped - Stores the number of frames replaced by a newer frame
+        before they could be written.
+
+    FramesWritten - Stores the number of frames written.
+
+    WriteTime - Stores the total time spent writing frames, in microseconds.
+
+    LongestWriteTime - Stores the longest time spent writing one frame, in
+        microseconds.
+
+--*/
+
+typedef struct _DISPLAY_WRITER {
+
+#ifdef __WIN32__
+
+    HANDLE Thread;
+    CRITICAL_SECTION Lock;
+    HANDLE Signal;
+
+#else
+
+    pthread_t Thread;
+    pthread_mutex_t Lock;
+    pthread_cond_t Signal;
+
+#endif
+
+    usb_dev_handle *Handle;
+    int RawSegments;
+    char String[USBLED_MAX_STRING_LENGTH];
+    int BlinkMask;
+    int WrittenBlinkMask;
+    int Pending;
+    int Stop;
+    int Result;
+    int FramesDropped;
+    int FramesWritten;
+    unsigned long long WriteTime;
+    int LongestWriteTime;
+} DISPLAY_WRITER, *PDISPLAY_WRITER;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of one display.
+
+Members:
+
+    Options - Stores a pointer to what the display shows and which device it
+        uses.
+
+    Device - Stores the device the display is using, if it's open.
+
+    Handle - Stores the open device, or NULL if the display isn't connected.
+
+    RawSegments - Stores a non-zero value if the device takes raw segments.
+
+    Animation - Stores a non-zero value if the device can blink and scroll on
+        its own.
+
+    BlinkDecimals - Stores a non-zero value if the host has to blink the
+        decimals in the time itself.
+
+    Writer - Stores the thread writing frames to the device.
+
+    WriterRunning - Stores a non-zero value if the writer has been started.
+
+    LastString - Stores the last frame handed to the writer.
+
+    LastBlinkMask - Stores the digits blinking in the last frame.
+
+--*/
+
+typedef struct _DISPLAY {
+    PDISPLAY_OPTIONS Options;
+    struct usb_device *Device;
+    usb_dev_handle *Handle;
+    int RawSegments;
+    int Animation;
+    int BlinkDecimals;
+    DISPLAY_WRITER Writer;
+    int WriterRunning;
+    char LastString[USBLED_MAX_STRING_LENGTH];
+    int LastBlinkMask;
+} DISPLAY, *PDISPLAY;
+
+/*++
+
+Structure Description:
+
+    This structure stores the lines coming in on stdin in pipe mode, keeping
+    only the newest whole one.
+
+Members:
+
+    Line - Stores the line being read in.
+
+    LineLength - Stores the number of characters in the line so far.
+
+    Frame - Stores the newest whole line.
+
+    FramePending - Stores a boolean indicating if the newest line hasn't been
+        shown yet.
+
+    FramesRead - Stores the number of whole lines read.
+
+    FramesDropped - Stores the number of whole lines replaced by a newer one
+        before they were shown.
+
+    Ended - Stores a boolean indicating if the input has run out.
+
+--*/
+
+typedef struct _INPUT_STREAM {
+    char Line[USBLED_MAX_STRING_LENGTH];
+    int LineLength;
+    char Frame[USBLED_MAX_STRING_LENGTH];
+    int FramePending;
+    int FramesRead;
+    int FramesDropped;
+    int Ended;
+} INPUT_STREAM, *PINPUT_STREAM;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -249,9 +601,21 @@ ConfigureDevice (
     struct usb_device *Device
     );
 
+int
+RunDisplays (
+    void
+    );
+
+struct usb_device *
+FindDevice (
+    char *SerialNumber,
+    int SkipDeviceCount
+    );
+
 struct usb_device *
 SearchForDevice (
     struct usb_device *Device,
+    char *SerialNumber,
     int *SkipDeviceCount,
     int RecursionLevel
     );
@@ -286,6 +650,11 @@ MillisecondSleep (
     unsigned int Milliseconds
     );
 
+unsigned long long
+GetMicroseconds (
+    void
+    );
+
 int
 ReadButtonState (
     usb_dev_handle *Handle,
@@ -299,119 +668,337 @@ WriteStringToLeds (
     );
 
 int
-WriteFeatureToString (
-    STOCK_FEATURE Feature,
-    char *String,
-    int StringLength,
-    int *Offset
+SetLedBrightness (
+    usb_dev_handle *Handle,
+    int Digit,
+    int Brightness
     );
 
 int
-PrintPerCpuUsage (
-    char *String,
-    int StringSize,
-    int CpuOffset
+WriteSegmentsToLeds (
+    usb_dev_handle *Handle,
+    unsigned char *Segments,
+    int Count
     );
 
 int
-PrintCpuMemoryUsage (
+ConvertStringToSegments (
     char *String,
-    int StringSize
+    unsigned char *Segments
     );
 
 int
-PrintNetworkUsage (
+WriteDisplay (
+    usb_dev_handle *Handle,
     char *String,
-    int StringSize
+    int RawSegments
     );
 
 int
-PrintCurrentDate (
-    char *String,
-    int StringSize
+SetLedBlink (
+    usb_dev_handle *Handle,
+    int DigitMask,
+    int Milliseconds,
+    int Segments
     );
 
 int
-PrintCurrentTime (
+SetLedScroll (
+    usb_dev_handle *Handle,
+    int LineMask,
+    int Milliseconds
+    );
+
+int
+ConvertMillisecondsToFrames (
+    int Milliseconds
+    );
+
+int
+CountStringDigits (
     char *String,
-    int StringSize,
-    int MilitaryTime,
-    int ShowSeconds,
-    int ShowBlinkyDecimals
+    int Length
     );
 
-//
-// -------------------------------------------------------------------- Globals
-//
+int
+OpenDisplay (
+    PDISPLAY Display,
+    struct usb_device *Device
+    );
 
-OPTION_LIST Options;
+int
+ResetDisplayAnimation (
+    PDISPLAY Display
+    );
 
-//
-// ------------------------------------------------------------------ Functions
-//
+void
+CloseDisplay (
+    PDISPLAY Display
+    );
 
 int
-main (
-    int argc,
-    char **argv
-    )
+RenderDisplay (
+    PDISPLAY Display,
+    PSYSTEM_SAMPLE Sample,
+    char *Input,
+    char *String,
+    int *BlinkMask
+    );
 
-/*++
+int
+TakeSystemSample (
+    PSYSTEM_SAMPLE Sample,
+    int FeatureMask
+    );
 
-Routine Description:
+PNETWORK_SAMPLE
+FindNetworkSample (
+    PSYSTEM_SAMPLE Sample,
+    char *Interface
+    );
 
-    This routine is the main entry point for the program. It collects the
-    options passed to it, and executes the desired command.
+int
+SampleNetworkUsage (
+    PNETWORK_SAMPLE Network
+    );
 
-Arguments:
+void
+PrintDisplayStatistics (
+    int Index,
+    PDISPLAY Display
+    );
 
-    argc - Supplies the number of command line arguments the program was invoked
-           with.
+void
+ReadInputFrames (
+    PINPUT_STREAM Stream,
+    int Milliseconds
+    );
 
-    argv - Supplies a tokenized array of command line arguments.
+int
+StartDisplayWriter (
+    PDISPLAY_WRITER Writer,
+    usb_dev_handle *Handle,
+    int RawSegments
+    );
 
-Return Value:
+int
+PostDisplayFrame (
+    PDISPLAY_WRITER Writer,
+    char *String,
+    int BlinkMask
+    );
 
-    Returns an integer exit code. 0 for success, nonzero otherwise.
+void
+StopDisplayWriter (
+    PDISPLAY_WRITER Writer
+    );
 
---*/
+#ifdef __WIN32__
 
-{
+DWORD
+WINAPI
+DisplayWriterThread (
+    LPVOID Context
+    );
 
-    char *Argument;
-    int ButtonState;
-    int CurrentLine;
+#else
+
+void *
+DisplayWriterThread (
+    void *Context
+    );
+
+#endif
+
+void
+AcquireWriterLock (
+    PDISPLAY_WRITER Writer
+    );
+
+void
+ReleaseWriterLock (
+    PDISPLAY_WRITER Writer
+    );
+
+void
+SignalWriter (
+    PDISPLAY_WRITER Writer
+    );
+
+void
+WaitForWriterSignal (
+    PDISPLAY_WRITER Writer
+    );
+
+int
+WriteFeatureToString (
+    STOCK_FEATURE Feature,
+    PDISPLAY_OPTIONS DisplayOptions,
+    PSYSTEM_SAMPLE Sample,
+    char *String,
+    int StringLength,
+    int *Offset,
+    int BlinkDecimals
+    );
+
+int
+PrintPerCpuUsage (
+    char *String,
+    int StringSize,
+    PSYSTEM_SAMPLE Sample,
+    int CpuOffset
+    );
+
+int
+PrintCpuMemoryUsage (
+    char *String,
+    int StringSize,
+    PSYSTEM_SAMPLE Sample
+    );
+
+int
+PrintNetworkUsage (
+    char *String,
+    int StringSize,
+    PSYSTEM_SAMPLE Sample,
+    char *Interface
+    );
+
+int
+PrintCurrentDate (
+    char *String,
+    int StringSize
+    );
+
+int
+PrintCurrentTime (
+    char *String,
+    int StringSize,
+    int MilitaryTime,
+    int ShowSeconds,
+    int ShowBlinkyDecimals
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+OPTION_LIST Options;
+
+//
+// Store the state of each display, and the sample of the system they show.
+//
+
+DISPLAY Displays[USBLED_MAX_DISPLAYS];
+SYSTEM_SAMPLE SystemSample;
+
+//
+// Define the segments lit for each hex digit, which matches the table in the
+// firmware.
+//
+
+unsigned char CharacterToSegments[16] = {
+    0xAF, 0x21, 0xCD, 0x6D, 0x63, 0x6E, 0xEE, 0x25,
+    0xEF, 0x6F, 0xE7, 0xEA, 0xC8, 0xE9, 0xCE, 0xC6
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+int
+main (
+    int argc,
+    char **argv
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the program. It collects the
+    options passed to it, and executes the desired command.
+
+Arguments:
+
+    argc - Supplies the number of command line arguments the program was invoked
+           with.
+
+    argv - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
+{
+
+    char *Argument;
+    int ButtonState;
+    int CurrentLine;
     struct usb_device *Device;
     int DevicesChanged;
-    usb_dev_handle *Handle;
+    PDISPLAY Display;
+    PDISPLAY_OPTIONS DisplayOptions;
+    int FeatureMode;
+    int Index;
     STOCK_FEATURE NextFeature;
     int Result;
-    struct usb_device *PotentialDevice;
-    int SkipDeviceCount;
-    char String[USBLED_MAX_STRING_LENGTH];
-    int StringOffset;
-    struct usb_bus *UsbBus;
 
     CurrentLine = 0;
-    Handle = NULL;
     Options.UpdateInterval = USBLED_DEFAULT_UPDATE_INTERVAL;
-    Options.ShowBlinkyDecimals = TRUE;
+    Options.DisplayCount = 1;
+    DisplayOptions = &(Options.Display[0]);
+    DisplayOptions->ShowBlinkyDecimals = TRUE;
+    DisplayOptions->Brightness = -1;
 
     //
     // Process the command line options
     //
 
-    while ((argc > 1) && (argv[1][0] == '-')) {
+    while ((argc > 1) &&
+           ((argv[1][0] == '-') || (strcmp(argv[1], "+") == 0))) {
+
         NextFeature = StockFeatureInvalid;
         Argument = &(argv[1][1]);
 
+        //
+        // '+' starts the options for another display. Everything but the
+        // features and which device to use carries over from the display
+        // before it.
+        //
+
+        if (strcmp(argv[1], "+") == 0) {
+            if (Options.DisplayCount == USBLED_MAX_DISPLAYS) {
+                printf("Error: Too many displays have been specified. "
+                       "Please specify at most %d displays.\n",
+                       USBLED_MAX_DISPLAYS);
+
+                return 1;
+            }
+
+            DisplayOptions = &(Options.Display[Options.DisplayCount]);
+            memcpy(DisplayOptions,
+                   &(Options.Display[Options.DisplayCount - 1]),
+                   sizeof(DISPLAY_OPTIONS));
+
+            memset(DisplayOptions->Selection,
+                   0,
+                   sizeof(DisplayOptions->Selection));
+
+            DisplayOptions->SerialNumber = NULL;
+            DisplayOptions->SkipDeviceCount = Options.DisplayCount;
+            Options.DisplayCount += 1;
+            CurrentLine = 0;
+
         //
         // 'b' specifies that the blinky decimals on current time should be
         // turned off.
         //
 
-        if (strcmp(Argument, "b") == 0) {
-            Options.ShowBlinkyDecimals = FALSE;
+        } else if (strcmp(Argument, "b") == 0) {
+            DisplayOptions->ShowBlinkyDecimals = FALSE;
 
         //
         // 'v' specifies verbose mode.
@@ -426,10 +1013,12 @@ Return Value:
 
         } else if (strcmp(Argument, "c") == 0) {
             NextFeature = StockFeaturePerCpuUsage;
-            if ((argc > 2) && (argv[2][0] != '-') && (argv[2][0] != '"')) {
-                Options.CpuOffset = strtol(argv[2], NULL, 10);
-                if (Options.CpuOffset < 0) {
-                    Options.CpuOffset = 0;
+            if ((argc > 2) && (argv[2][0] != '-') && (argv[2][0] != '"') &&
+                (strcmp(argv[2], "+") != 0)) {
+
+                DisplayOptions->CpuOffset = strtol(argv[2], NULL, 10);
+                if (DisplayOptions->CpuOffset < 0) {
+                    DisplayOptions->CpuOffset = 0;
                 }
 
                 argc -= 1;
@@ -449,6 +1038,13 @@ Return Value:
 
         } else if (strcmp(Argument, "n") == 0) {
             NextFeature = StockFeatureNetworkUsage;
+            if ((argc > 2) && (argv[2][0] != '-') && (argv[2][0] != '"') &&
+                (strcmp(argv[2], "+") != 0)) {
+
+                DisplayOptions->NetworkInterface = argv[2];
+                argc -= 1;
+                argv += 1;
+            }
 
         //
         // 'd' specifies the current date.
@@ -482,7 +1078,7 @@ Return Value:
         //
 
         } else if (strcmp(Argument, "a") == 0) {
-            Options.MilitaryTime = TRUE;
+            DisplayOptions->MilitaryTime = TRUE;
 
         //
         // 'i' grabs input from stdin instead of the command line.
@@ -490,6 +1086,14 @@ Return Value:
         
         } else if (strcmp(Argument, "i") == 0) {
             Options.UseStdin = TRUE;
+
+        //
+        // 'p' grabs input from stdin, showing only the newest line.
+        //
+
+        } else if (strcmp(Argument, "p") == 0) {
+            Options.UseStdin = TRUE;
+            Options.StreamStdin = TRUE;
            
         //
         // 'e' exits immediately if no devices are found.
@@ -509,9 +1113,9 @@ Return Value:
                 return 1;
             }
 
-            Options.SkipDeviceCount = strtol(argv[2], NULL, 10);
-            if (Options.SkipDeviceCount <= 0) {
-                Options.SkipDeviceCount = 0;
+            DisplayOptions->SkipDeviceCount = strtol(argv[2], NULL, 10);
+            if (DisplayOptions->SkipDeviceCount <= 0) {
+                DisplayOptions->SkipDeviceCount = 0;
             }
 
             argc -= 1;
@@ -561,7 +1165,7 @@ Return Value:
 
             argc -= 1;
             argv += 1;
-            Options.SerialNumber = argv[1];
+            DisplayOptions->SerialNumber = argv[1];
 
         //
         // 'o' prints the output of the button.
@@ -570,6 +1174,44 @@ Return Value:
         } else if (strcmp(Argument, "o") == 0) {
             Options.PrintButtonState = 1;
 
+        //
+        // 'w' sets the brightness of the digits.
+        //
+
+        } else if (strcmp(Argument, "w") == 0) {
+            if ((argc <= 2) || (argv[2][0] == '-')) {
+                printf("Error: -w requires an integer argument after it.\n");
+                printf(USAGE_STRING);
+                return 1;
+            }
+
+            DisplayOptions->Brightness = strtol(argv[2], NULL, 10);
+            if (DisplayOptions->Brightness > USBLED_MAX_BRIGHTNESS) {
+                DisplayOptions->Brightness = USBLED_MAX_BRIGHTNESS;
+            }
+
+            argc -= 1;
+            argv += 1;
+
+        //
+        // 'x' scrolls the display like a marquee.
+        //
+
+        } else if (strcmp(Argument, "x") == 0) {
+            if ((argc <= 2) || (argv[2][0] == '-')) {
+                printf("Error: -x requires an integer argument after it.\n");
+                printf(USAGE_STRING);
+                return 1;
+            }
+
+            DisplayOptions->ScrollInterval = strtol(argv[2], NULL, 10);
+            if (DisplayOptions->ScrollInterval < 0) {
+                DisplayOptions->ScrollInterval = 0;
+            }
+
+            argc -= 1;
+            argv += 1;
+
         } else {
             printf("%s: Invalid option\n\n%s", Argument, USAGE_STRING);
             return 1;
@@ -589,7 +1231,7 @@ Return Value:
                 return 1;
             }
 
-            Options.Selection[CurrentLine] = NextFeature;
+            DisplayOptions->Selection[CurrentLine] = NextFeature;
             CurrentLine += 1;
         }
 
@@ -602,9 +1244,11 @@ Return Value:
     // then fail and print the usage.
     //
 
-    if ((argc < 2) && (Options.Selection[0] == StockFeatureInvalid) &&
+    if ((argc < 2) &&
+        (Options.Display[0].Selection[0] == StockFeatureInvalid) &&
         (Options.ListDeviceSerialNumbers == FALSE) &&
         (Options.PrintButtonState == FALSE) &&
+        (Options.Display[0].Brightness < 0) &&
         (Options.UseStdin == FALSE)) {
 
         printf(USAGE_STRING);
@@ -615,210 +1259,435 @@ Return Value:
         Options.StringToWrite = argv[1];
     }
 
+    //
+    // Figure out if the displays are going to be updated continually. Every
+    // display needs something to show if they are.
+    //
+
+    FeatureMode = FALSE;
+    if ((Options.StringToWrite == NULL) &&
+        (Options.ListDeviceSerialNumbers == FALSE) &&
+        (Options.PrintButtonState == FALSE) &&
+        ((Options.Display[0].Selection[0] != StockFeatureInvalid) ||
+         (Options.UseStdin != FALSE))) {
+
+        FeatureMode = TRUE;
+        for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+            if ((Options.Display[Index].Selection[0] == StockFeatureInvalid) &&
+                (Options.UseStdin == FALSE)) {
+
+                printf("Error: Display %d has no features.\n", Index);
+                return 1;
+            }
+        }
+    }
+
     //
     // Initialize libUSB.
     //
 
     usb_init();
     usb_find_busses();
-    while (TRUE) {
-
-        //
-        // Attempt to find a USB LED controller.
-        //
+    if (FeatureMode != FALSE) {
+        Result = RunDisplays();
+        if (Result < 0) {
+            return 1;
+        }
 
-        Device = NULL;
-        VERBOSE_PRINT("Looking for device...\n");
-        while (Device == NULL) {
-            SkipDeviceCount = Options.SkipDeviceCount;
-            DevicesChanged = usb_find_devices();
+        return 0;
+    }
 
-            //
-            // Bail now if nothing has changed.
-            //
+    //
+    // Everything else is done once, to the first display. Attempt to find a
+    // USB LED controller.
+    //
 
-            if (DevicesChanged == 0) {
-            	if (Options.ExitImmediately != FALSE) {
-            		goto mainEnd;
-            	}
-            	
-                MillisecondSleep(250);
-                continue;
-            }
+    Display = &(Displays[0]);
+    Display->Options = &(Options.Display[0]);
+    Device = NULL;
+    VERBOSE_PRINT("Looking for device...\n");
+    while (Device == NULL) {
+        DevicesChanged = usb_find_devices();
 
-            UsbBus = usb_get_busses();
-            while (UsbBus != NULL) {
+        //
+        // Bail now if nothing has changed.
+        //
 
-                //
-                // Search the root device.
-                //
+        if (DevicesChanged == 0) {
+        	if (Options.ExitImmediately != FALSE) {
+        		goto mainEnd;
+        	}
+        	
+            WaitForDeviceChange(USBLED_RESCAN_INTERVAL);
+            continue;
+        }
 
-                if (UsbBus->root_dev != NULL) {
-                    Device = SearchForDevice(UsbBus->root_dev,
-                                             &SkipDeviceCount,
-                                             0);
+        Device = FindDevice(Display->Options->SerialNumber,
+                            Display->Options->SkipDeviceCount);
 
-                //
-                // There is no root device, so search all devices on the bus.
-                //
+        if (Options.ListDeviceSerialNumbers != FALSE) {
+            goto mainEnd;
+        }
+    }
 
-                } else {
-                    PotentialDevice = UsbBus->devices;
-                    while (PotentialDevice != NULL) {
-                        Device = SearchForDevice(PotentialDevice,
-                                                 &SkipDeviceCount,
-                                                 0);
-
-                        if (Device != NULL) {
-                            break;
-                        }
+    //
+    // Act on the device that was found.
+    //
 
-                        PotentialDevice = PotentialDevice->next;
-                    }
-                }
+    Result = OpenDisplay(Display, Device);
+    if (Result < 0) {
+        goto mainEnd;
+    }
 
-                //
-                // Stop enumerating busses if a device was found.
-                //
+    if ((Options.StringToWrite == NULL) &&
+        (Options.PrintButtonState != FALSE)) {
 
-                if (Device != NULL) {
-                    break;
-                }
+        ButtonState = 0;
+        Result = ReadButtonState(Display->Handle, &ButtonState);
+        if (Result <= 0) {
+            printf("Error: Failed to get button state.\n");
+            goto mainEnd;
+        }
 
-                //
-                // Get the next USB bus.
-                //
+        printf("%x", ButtonState);
+        goto mainEnd;
+    }
 
-                UsbBus = UsbBus->next;
-            }
+    //
+    // Write out the custom string to the LEDs.
+    //
 
-            if (Options.ListDeviceSerialNumbers != FALSE) {
-                goto mainEnd;
-            }
+    if (Options.StringToWrite != NULL) {
+        Result = ResetDisplayAnimation(Display);
+        if (Result < 0) {
+            goto mainEnd;
         }
 
-        //
-        // If a device was found, act on it.
-        //
+        Result = WriteDisplay(Display->Handle,
+                              Options.StringToWrite,
+                              Display->RawSegments);
 
-        if (Device != NULL) {
-            if (Options.Verbose != 0) {
-                PrintDeviceDescription(Device);
-            }
+        if (Result < 0) {
+            printf("Error writing string to LEDs.\n");
+        }
+    }
 
-            Handle = ConfigureDevice(Device);
-            if (Handle == NULL) {
-                goto mainEnd;
-            }
+mainEnd:
+    CloseDisplay(&(Displays[0]));
+    return 0;
+}
 
-            //
-            // Attempt to enter the various infinite loops if no string was
-            // specified.
-            //
+//
+// --------------------------------------------------------- Internal Functions
+//
 
-            if (Options.StringToWrite == NULL) {
-                if (Options.PrintButtonState != FALSE) {
-                    ButtonState = 0;
-                    Result = ReadButtonState(Handle, &ButtonState);
-                    if (Result <= 0) {
-                        printf("Error: Failed to get button state.\n");
-                        goto mainEnd;
-                    }
+int
+RunDisplays (
+    void
+    )
 
-                    printf("%x", ButtonState);
-                    goto mainEnd;
-                }
+/*++
 
-                while (TRUE) {
-                    StringOffset = 0;
-                    
-                    //
-                    // If input is coming from stdin, get the input now.
-                    //
-                    
-                    if (Options.UseStdin != FALSE) {
-                        Result = scanf("%s", String);
-                        if (Result != 1) {
-                            goto mainEnd;
-                        }
-                        
-                        StringOffset = strlen(String);
-                    }
-                    
-                    //
-                    // Create the string based on the requested features.
-                    //
+Routine Description:
 
-                    for (CurrentLine = 0;
-                         CurrentLine < USBLED_MAX_ROWS;
-                         CurrentLine += 1) {
+    This routine continually updates every display with its features, until
+    the input runs out or something fails. The system is sampled once for
+    each update, and the same sample is shown on all the displays. Displays
+    are connected as their devices show up, and reconnected if they go away.
 
-                        if (Options.Selection[CurrentLine] ==
-                                                         StockFeatureInvalid) {
+Arguments:
 
-                            break;
-                        }
+    None.
 
-                        Result = WriteFeatureToString(
-                                                Options.Selection[CurrentLine],
-                                                String,
-                                                USBLED_MAX_STRING_LENGTH,
-                                                &StringOffset);
+Return Value:
 
-                        if (Result == 0) {
-                            printf("Error: Failed to execute feature %d.\n",
-                                   Options.Selection[CurrentLine]);
+    Returns >= 0 if the displays were updated until the input ran out or no
+    devices were found, and the user asked to exit in that case.
 
-                            goto mainEnd;
-                        }
-                    }
+    Returns < 0 on failure.
 
-                    //
-                    // Write the string out to the LEDs, and chill until the
-                    // next loop iteration.
-                    //
+--*/
 
-                    VERBOSE_PRINT("\"%s\"\n", String);
-                    Result = WriteStringToLeds(Handle, String);
-                    if (Result < 0) {
-                        break;
-                    }
+{
 
-                    MillisecondSleep(Options.UpdateInterval);
-                }
+    int BlinkMask;
+    int Connected;
+    PDISPLAY Display;
+    int DisplayFeatureMask;
+    int FeatureMask;
+    int Index;
+    char Input[USBLED_MAX_STRING_LENGTH];
+    char *Interface;
+    unsigned long long LastScanTime;
+    unsigned long long LastStatisticsTime;
+    int Line;
+    PNETWORK_SAMPLE Network;
+    int Other;
+    int Rescan;
+    int Result;
+    INPUT_STREAM Stream;
+    char String[USBLED_MAX_STRING_LENGTH];
 
-            //
-            // Write out the custom string to the LEDs.
-            //
+    //
+    // Figure out which parts of the system need sampling.
+    //
+
+    FeatureMask = 0;
+    for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+        Displays[Index].Options = &(Options.Display[Index]);
+        DisplayFeatureMask = 0;
+        for (Line = 0; Line < USBLED_MAX_ROWS; Line += 1) {
+            DisplayFeatureMask |= 1 << Options.Display[Index].Selection[Line];
+        }
+
+        //
+        // Sample each network interface shown only once, however many
+        // displays show it.
+        //
+
+        Interface = Options.Display[Index].NetworkInterface;
+        if (((DisplayFeatureMask & (1 << StockFeatureNetworkUsage)) != 0) &&
+            (FindNetworkSample(&SystemSample, Interface) == NULL)) {
+
+            Network = &(SystemSample.Network[SystemSample.NetworkCount]);
+            Network->Interface = Interface;
+            SystemSample.NetworkCount += 1;
+        }
+
+        FeatureMask |= DisplayFeatureMask;
+    }
+
+    Input[0] = '\0';
+    memset(&Stream, 0, sizeof(Stream));
+    LastScanTime = 0;
+    LastStatisticsTime = GetMicroseconds();
+    Rescan = TRUE;
+    Result = 0;
+    while (TRUE) {
+
+        //
+        // Connect any displays that aren't yet. A device already taken by
+        // another display doesn't count.
+        //
+
+        if (Rescan != FALSE) {
+            VERBOSE_PRINT("Looking for devices...\n");
+            Rescan = FALSE;
+            LastScanTime = GetMicroseconds();
+            usb_find_devices();
+            for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+                Display = &(Displays[Index]);
+                if (Display->Handle != NULL) {
+                    continue;
+                }
+
+                Display->Device = FindDevice(Display->Options->SerialNumber,
+                                             Display->Options->SkipDeviceCount);
+
+                for (Other = 0; Other < Options.DisplayCount; Other += 1) {
+                    if ((Other != Index) &&
+                        (Displays[Other].Handle != NULL) &&
+                        (Displays[Other].Device == Display->Device)) {
+
+                        Display->Device = NULL;
+                        break;
+                    }
+                }
+
+                if (Display->Device == NULL) {
+                    continue;
+                }
+
+                Result = OpenDisplay(Display, Display->Device);
+                if (Result >= 0) {
+                    Result = ResetDisplayAnimation(Display);
+                }
+
+                if (Result >= 0) {
+                    Result = StartDisplayWriter(&(Display->Writer),
+                                                Display->Handle,
+                                                Display->RawSegments);
+                }
+
+                //
+                // Leave the display for the next scan if it couldn't be set
+                // up, so the others can carry on.
+                //
 
-            } else {
-                Result = WriteStringToLeds(Handle, Options.StringToWrite);
                 if (Result < 0) {
-                    printf("Error writing string to LEDs.\n");
+                    printf("Error: Failed to set up display %d.\n", Index);
+                    CloseDisplay(Display);
+                    continue;
                 }
 
-                goto mainEnd;
+                Display->WriterRunning = TRUE;
+                Display->LastBlinkMask = 0;
+                Display->LastString[0] = '\0';
             }
         }
 
-        if (Handle != NULL) {
-            usb_close(Handle);
-            Handle = NULL;
+        Connected = 0;
+        for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+            if (Displays[Index].Handle != NULL) {
+                Connected += 1;
+            }
+        }
+
+        //
+        // With nothing to show things on, wait for devices to show up.
+        //
+
+        if (Connected == 0) {
+            if (Options.ExitImmediately != FALSE) {
+                Result = 0;
+                goto RunDisplaysEnd;
+            }
+
+            WaitForDeviceChange(USBLED_RESCAN_INTERVAL);
+            Rescan = TRUE;
+            continue;
+        }
+
+        //
+        // If input is coming from stdin, get the input now. In pipe mode,
+        // take the newest line read in while waiting, and stop once the last
+        // one has been shown.
+        //
+
+        if (Options.StreamStdin != FALSE) {
+            if (Stream.FramePending != FALSE) {
+                strcpy(Input, Stream.Frame);
+                Stream.FramePending = FALSE;
+
+            } else if (Stream.Ended != FALSE) {
+                Result = 0;
+                goto RunDisplaysEnd;
+            }
+
+            //
+            // Like -i, show nothing until the first line comes in.
+            //
+
+            if (Stream.FramesRead == 0) {
+                ReadInputFrames(&Stream, Options.UpdateInterval);
+                continue;
+            }
+
+        } else if (Options.UseStdin != FALSE) {
+            if (scanf("%s", Input) != 1) {
+                Result = 0;
+                goto RunDisplaysEnd;
+            }
+        }
+
+        //
+        // Sample the system once for all the displays, then hand each its
+        // frame if it changed. The writers report failures on the next frame,
+        // since they run behind.
+        //
+
+        Result = TakeSystemSample(&SystemSample, FeatureMask);
+        if (Result == 0) {
+            Result = -1;
+            goto RunDisplaysEnd;
+        }
+
+        for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+            Display = &(Displays[Index]);
+            if (Display->Handle == NULL) {
+                continue;
+            }
+
+            Result = RenderDisplay(Display,
+                                   &SystemSample,
+                                   Input,
+                                   String,
+                                   &BlinkMask);
+
+            if (Result == 0) {
+                Result = -1;
+                goto RunDisplaysEnd;
+            }
+
+            if ((strcmp(String, Display->LastString) == 0) &&
+                (BlinkMask == Display->LastBlinkMask)) {
+
+                continue;
+            }
+
+            VERBOSE_PRINT("%d: \"%s\"\n", Index, String);
+            Result = PostDisplayFrame(&(Display->Writer), String, BlinkMask);
+            if (Result < 0) {
+                VERBOSE_PRINT("Display %d went away.\n", Index);
+                CloseDisplay(Display);
+                Rescan = TRUE;
+                continue;
+            }
+
+            strcpy(Display->LastString, String);
+            Display->LastBlinkMask = BlinkMask;
+        }
+
+        //
+        // Every so often, show how each display is keeping up.
+        //
+
+        if ((Options.Verbose != 0) &&
+            (GetMicroseconds() - LastStatisticsTime >=
+             USBLED_STATISTICS_INTERVAL * 1000ULL)) {
+
+            for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+                if (Displays[Index].Handle != NULL) {
+                    PrintDisplayStatistics(Index, &(Displays[Index]));
+                }
+            }
+
+            if (Options.StreamStdin != FALSE) {
+                printf("Input: %d lines read, %d dropped.\n",
+                       Stream.FramesRead,
+                       Stream.FramesDropped);
+            }
+
+            LastStatisticsTime = GetMicroseconds();
+        }
+
+        //
+        // Chill until the next update, keeping up with stdin in pipe mode so
+        // a fast writer never gets ahead. Look again for any displays missing
+        // their devices if something was plugged in, or every so often in
+        // case the notification was missed.
+        //
+
+        if (Options.StreamStdin != FALSE) {
+            ReadInputFrames(&Stream, Options.UpdateInterval);
+
+        } else {
+            MillisecondSleep(Options.UpdateInterval);
+        }
+
+        if (Connected < Options.DisplayCount) {
+            if ((WaitForDeviceChange(0) != 0) ||
+                (GetMicroseconds() - LastScanTime >=
+                 USBLED_RESCAN_INTERVAL * 1000ULL)) {
+
+                Rescan = TRUE;
+            }
         }
     }
 
-mainEnd:
-    if (Handle != NULL) {
-        usb_close(Handle);
-        Handle = NULL;
+RunDisplaysEnd:
+    for (Index = 0; Index < Options.DisplayCount; Index += 1) {
+        CloseDisplay(&(Displays[Index]));
     }
 
-    return 0;
-}
+    if (Options.StreamStdin != FALSE) {
+        VERBOSE_PRINT("Input: %d lines read, %d dropped.\n",
+                      Stream.FramesRead,
+                      Stream.FramesDropped);
+    }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
+    return Result;
+}
 
 usb_dev_handle *
 ConfigureDevice (
@@ -892,9 +1761,97 @@ ConfigureDeviceEnd:
     return Handle;
 }
 
+struct usb_device *
+FindDevice (
+    char *SerialNumber,
+    int SkipDeviceCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks through every USB bus for a USB LED device. The caller
+    should have asked libUSB to find the devices first.
+
+Arguments:
+
+    SerialNumber - Supplies an optional pointer to the serial number of the
+        device to find.
+
+    SkipDeviceCount - Supplies the number of eligible devices to skip over if
+        no serial number was supplied.
+
+Return Value:
+
+    Returns a pointer to the device on success.
+
+    NULL if the device could not be found.
+
+--*/
+
+{
+
+    struct usb_device *Device;
+    struct usb_device *PotentialDevice;
+    struct usb_bus *UsbBus;
+
+    Device = NULL;
+    UsbBus = usb_get_busses();
+    while (UsbBus != NULL) {
+
+        //
+        // Search the root device.
+        //
+
+        if (UsbBus->root_dev != NULL) {
+            Device = SearchForDevice(UsbBus->root_dev,
+                                     SerialNumber,
+                                     &SkipDeviceCount,
+                                     0);
+
+        //
+        // There is no root device, so search all devices on the bus.
+        //
+
+        } else {
+            PotentialDevice = UsbBus->devices;
+            while (PotentialDevice != NULL) {
+                Device = SearchForDevice(PotentialDevice,
+                                         SerialNumber,
+                                         &SkipDeviceCount,
+                                         0);
+
+                if (Device != NULL) {
+                    break;
+                }
+
+                PotentialDevice = PotentialDevice->next;
+            }
+        }
+
+        //
+        // Stop enumerating busses if a device was found.
+        //
+
+        if (Device != NULL) {
+            break;
+        }
+
+        //
+        // Get the next USB bus.
+        //
+
+        UsbBus = UsbBus->next;
+    }
+
+    return Device;
+}
+
 struct usb_device *
 SearchForDevice (
     struct usb_device *Device,
+    char *SerialNumber,
     int *SkipDeviceCount,
     int RecursionLevel
     )
@@ -910,6 +1867,9 @@ Arguments:
 
     Device - Supplies a pointer to the device to start the search from.
 
+    SerialNumber - Supplies an optional pointer to the serial number of the
+        device to find. If supplied, the skip count is not used.
+
     SkipDeviceCount - Supplies a pointer to an integer containing the number
         of eligible devices to skip over. As devices are skipped, the value in
         this pointer is decremented. If this value is 0 and a device is found,
@@ -930,9 +1890,9 @@ Return Value:
     int ChildIndex;
     struct usb_device *FoundDevice;
     usb_dev_handle *Handle;
+    char FoundSerialNumber[256];
     int RecursionIndex;
     int Result;
-    char SerialNumber[256];
 
     for (RecursionIndex = 0;
          RecursionIndex < RecursionLevel;
@@ -954,7 +1914,7 @@ Return Value:
          (Device->descriptor.idProduct == USBLED_MINI_PRODUCT_ID))) {
 
         VERBOSE_PRINT(" <-- Found Device.");
-        if ((Options.SerialNumber != NULL) ||
+        if ((SerialNumber != NULL) ||
             (Options.ListDeviceSerialNumbers != FALSE)) {
 
             if (Device->descriptor.iSerialNumber != 0) {
@@ -962,26 +1922,26 @@ Return Value:
                 Handle = usb_open(Device);
                 Result = usb_get_string_simple(Handle,
                                                Device->descriptor.iSerialNumber,
-                                               SerialNumber,
-                                               sizeof(SerialNumber));
+                                               FoundSerialNumber,
+                                               sizeof(FoundSerialNumber));
 
                 usb_close(Handle);
                 if (Result > 0) {
                     if (Options.ListDeviceSerialNumbers != FALSE) {
-                        printf("%s\n", SerialNumber);
+                        printf("%s\n", FoundSerialNumber);
 
                     } else {
-                        if (strcmp(SerialNumber, Options.SerialNumber) == 0) {
+                        if (strcmp(FoundSerialNumber, SerialNumber) == 0) {
                             VERBOSE_PRINT("Found Device with Serial %s.\n",
-                                          SerialNumber);
+                                          FoundSerialNumber);
 
                             return Device;
 
                         } else {
                             VERBOSE_PRINT("Device serial number %s does not "
                                           "match requested: %s.\n",
-                                          SerialNumber,
-                                          Options.SerialNumber);
+                                          FoundSerialNumber,
+                                          SerialNumber);
                         }
                     }
 
@@ -1009,6 +1969,7 @@ Return Value:
 
     for (ChildIndex = 0; ChildIndex < Device->num_children; ChildIndex += 1) {
         FoundDevice = SearchForDevice(Device->children[ChildIndex],
+                                      SerialNumber,
                                       SkipDeviceCount,
                                       RecursionLevel + 1);
 
@@ -1143,72 +2104,1543 @@ Return Value:
         }
     }
 
-    printf("\n");
-    return;
+    printf("\n");
+    return;
+}
+
+void
+PrintDeviceConfiguration (
+    struct usb_config_descriptor *Configuration
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints out a USB device configuration descriptor description.
+
+Arguments:
+
+    Device - Supplies a pointer to the configuration to print a description of.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int InterfaceIndex;
+
+    printf("TotalLength: %d\n", Configuration->wTotalLength);
+    printf("InterfaceCount: %d\n", Configuration->bNumInterfaces);
+    printf("ConfigurationValue: %d\n", Configuration->bConfigurationValue);
+    printf("Configuration: %d\n", Configuration->iConfiguration);
+    printf("Attributes: 0x%02x\n", Configuration->bmAttributes);
+    printf("MaxPower: %d\n", Configuration->MaxPower);
+
+    //
+    // Print out all interfaces in this configuration.
+    //
+
+    for (InterfaceIndex = 0;
+         InterfaceIndex < Configuration->bNumInterfaces;
+         InterfaceIndex += 1) {
+
+        printf("Interface %d:\n\n", InterfaceIndex);
+        PrintInterface(&(Configuration->interface[InterfaceIndex]));
+    }
+
+    printf("\n");
+    return;
+}
+
+void
+PrintInterface (
+    struct usb_interface *Interface
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints out a USB device interface description.
+
+Arguments:
+
+    Interface - Supplies a pointer to the interface to print a description of.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int DescriptorIndex;
+
+    for (DescriptorIndex = 0;
+         DescriptorIndex < Interface->num_altsetting;
+         DescriptorIndex += 1) {
+
+        printf("Descriptor %d:\n\n", DescriptorIndex);
+        PrintDescriptor(&(Interface->altsetting[DescriptorIndex]));
+    }
+
+    printf("\n");
+    return;
+}
+
+void
+PrintDescriptor (
+    struct usb_interface_descriptor *Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints out a USB descriptor description.
+
+Arguments:
+
+    Descriptor - Supplies a pointer to the descriptor to print a description
+        of.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int EndpointIndex;
+
+    printf("InterfaceNumber: %d\n", Descriptor->bInterfaceNumber);
+    printf("AlternateSetting: %d\n", Descriptor->bAlternateSetting);
+    printf("EndpointCount: %d\n", Descriptor->bNumEndpoints);
+    printf("InterfaceClass: 0x%x\n", Descriptor->bInterfaceClass);
+    printf("InterfaceSubclass: 0x%x\n", Descriptor->bInterfaceSubClass);
+    printf("InterfaceProtocol: 0x%x\n", Descriptor->bInterfaceProtocol);
+    printf("Interface: %d\n", Descriptor->iInterface);
+
+    //
+    // Print out all endpoints in this descriptor.
+    //
+
+    for (EndpointIndex = 0;
+         EndpointIndex < Descriptor->bNumEndpoints;
+         EndpointIndex += 1) {
+
+        printf("Endpoint %d:\n\n", EndpointIndex);
+        PrintEndpoint(&(Descriptor->endpoint[EndpointIndex]));
+    }
+
+    printf("\n");
+    return;
+}
+
+void
+PrintEndpoint (
+    struct usb_endpoint_descriptor *Endpoint
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints out a USB endpoint description.
+
+Arguments:
+
+    Endpoint - Supplies a pointer to the endpoint to print a description of.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    printf("EndpointAddress: 0x%02x\n", Endpoint->bEndpointAddress);
+    printf("Attributes: 0x%02x\n", Endpoint->bmAttributes);
+    printf("MaxPacketSize: %d\n", Endpoint->wMaxPacketSize);
+    printf("Interval: %d\n", Endpoint->bInterval);
+    printf("Refresh: %d\n", Endpoint->bRefresh);
+    printf("SynchAddress: %d\n", Endpoint->bSynchAddress);
+    printf("\n");
+    return;
+}
+
+void
+MillisecondSleep (
+    unsigned int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine suspends the current thread's execution for at least the
+    specified number of milliseconds.
+
+Arguments:
+
+    Milliseconds - Supplies the number of milliseconds to suspend the thread
+        for.
+
+Return Value:
+
+    None. The function will simply return after approximately the specified
+    number of milliseconds.
+
+--*/
+
+{
+
+#ifdef __WIN32__
+
+    Sleep(Milliseconds);
+
+#else
+
+    struct timespec PollInterval;
+
+    PollInterval.tv_sec = 0;
+    PollInterval.tv_nsec = Milliseconds * 1000 * 1000;
+    nanosleep(&PollInterval, NULL);
+
+#endif
+
+    return;
+}
+
+unsigned long long
+GetMicroseconds (
+    void
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets the current time, for measuring how long things take.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in microseconds, from an arbitrary starting
+    point.
+
+--*/
+
+{
+
+#ifdef __WIN32__
+
+    LARGE_INTEGER Counter;
+    LARGE_INTEGER Frequency;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    return (unsigned long long)Counter.QuadPart * 1000000ULL /
+           Frequency.QuadPart;
+
+#else
+
+    struct timeval TimeOfDay;
+
+    gettimeofday(&TimeOfDay, NULL);
+    return ((unsigned long long)TimeOfDay.tv_sec * 1000000ULL) +
+           TimeOfDay.tv_usec;
+
+#endif
+
+}
+
+
+int
+ReadButtonState (
+    usb_dev_handle *Handle,
+    int *ButtonState
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads whether or not there has been a button press on the LED
+    device.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    ButtonState - Supplies a pointer where the button state will be returned.
+        The value will be zero if the button has not been pressed since the
+        last time it was checked, or 1 if the button was pressed since the last
+        time it was checked.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    unsigned long RequestType;
+    int Result;
+
+    RequestType = USB_ENDPOINT_IN | USB_TYPE_VENDOR | USB_RECIP_DEVICE;
+    Result = usb_control_msg(Handle,
+                             RequestType,
+                             USBLED_COMMAND_GET_BUTTON_STATE,
+                             0,
+                             0,
+                             (char *)ButtonState,
+                             1,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error writing command, got %d of %d bytes.\n"
+               "Status: %s\n",
+               Result,
+               1,
+               strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+WriteStringToLeds (
+    usb_dev_handle *Handle,
+    char *String
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes the given null-terminated ASCII string to the LED
+    display.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    String - Supplies the string to write.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Result;
+
+    Result = usb_control_msg(Handle,
+                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
+                             USBLED_COMMAND_WRITE,
+                             0,
+                             0,
+                             String,
+                             strlen(String) + 1,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error writing command, wrote %d of %d bytes.\n"
+               "Status: %s\n",
+               Result,
+               (int)sizeof(Result),
+               strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+SetLedBrightness (
+    usb_dev_handle *Handle,
+    int Digit,
+    int Brightness
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets how bright a digit on the LED display is.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    Digit - Supplies the index of the digit to set, or USBLED_ALL_DIGITS to
+        set every digit.
+
+    Brightness - Supplies the brightness, from 0 (off) to
+        USBLED_MAX_BRIGHTNESS (fully on).
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Result;
+
+    Result = usb_control_msg(Handle,
+                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
+                             USBLED_COMMAND_SET_BRIGHTNESS,
+                             Brightness,
+                             Digit,
+                             NULL,
+                             0,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error setting brightness.\nStatus: %s\n", strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+WriteSegmentsToLeds (
+    usb_dev_handle *Handle,
+    unsigned char *Segments,
+    int Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes raw segment masks to the first digits of the LED
+    display in a single transfer. Digits past the given count are left alone.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    Segments - Supplies the segment mask for each digit.
+
+    Count - Supplies the number of digits to write.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Result;
+
+    Result = usb_control_msg(Handle,
+                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
+                             USBLED_COMMAND_SET_SEGMENTS,
+                             0,
+                             0,
+                             (char *)Segments,
+                             Count,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error writing segments, wrote %d of %d bytes.\n"
+               "Status: %s\n",
+               Result,
+               Count,
+               strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+ConvertStringToSegments (
+    char *String,
+    unsigned char *Segments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a string into the segments the display would show
+    for it, following the same rules the firmware uses for text: a period
+    lights the decimal of the digit before it, a newline jumps to the second
+    line, and characters that can't be shown are blank.
+
+Arguments:
+
+    String - Supplies the null-terminated string to convert.
+
+    Segments - Supplies a pointer to an array of USBLED_DIGIT_COUNT bytes
+        where the segment masks will be returned.
+
+Return Value:
+
+    Returns the number of digits the string covers.
+
+--*/
+
+{
+
+    char Character;
+    int Cursor;
+    int Index;
+    unsigned char Value;
+
+    memset(Segments, 0, USBLED_DIGIT_COUNT);
+    Cursor = 0;
+    for (Index = 0; String[Index] != '\0'; Index += 1) {
+        Character = String[Index];
+        if (Character == '\n') {
+            Cursor = (Cursor + USBLED_LINE_DIGITS - 1) &
+                     ~(USBLED_LINE_DIGITS - 1);
+
+            continue;
+        }
+
+        if (Character == '.') {
+            if ((Cursor > 0) && (Cursor <= USBLED_DIGIT_COUNT)) {
+                Segments[Cursor - 1] |= USBLED_PERIOD;
+            }
+
+            continue;
+        }
+
+        if (Cursor >= USBLED_DIGIT_COUNT) {
+            continue;
+        }
+
+        if (Character == '-') {
+            Value = USBLED_DASH;
+
+        } else if ((Character >= '0') && (Character <= '9')) {
+            Value = CharacterToSegments[Character - '0'];
+
+        } else if ((Character >= 'A') && (Character <= 'F')) {
+            Value = CharacterToSegments[Character + 0xA - 'A'];
+
+        } else if ((Character >= 'a') && (Character <= 'f')) {
+            Value = CharacterToSegments[Character + 0xA - 'a'];
+
+        } else {
+            Value = 0;
+        }
+
+        Segments[Cursor] = Value;
+        Cursor += 1;
+    }
+
+    if (Cursor > USBLED_DIGIT_COUNT) {
+        Cursor = USBLED_DIGIT_COUNT;
+    }
+
+    return Cursor;
+}
+
+int
+WriteDisplay (
+    usb_dev_handle *Handle,
+    char *String,
+    int RawSegments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine shows the given string on the LED display, converting it to
+    segments here if the device takes them.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    String - Supplies the null-terminated string to show.
+
+    RawSegments - Supplies a non-zero value if the device supports raw segment
+        writes.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Count;
+    unsigned char Segments[USBLED_DIGIT_COUNT];
+
+    if (RawSegments == FALSE) {
+        return WriteStringToLeds(Handle, String);
+    }
+
+    Count = ConvertStringToSegments(String, Segments);
+    if (Count == 0) {
+        return 0;
+    }
+
+    return WriteSegmentsToLeds(Handle, Segments, Count);
+}
+
+int
+SetLedBlink (
+    usb_dev_handle *Handle,
+    int DigitMask,
+    int Milliseconds,
+    int Segments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine has the LED display blink some of its digits on its own.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    DigitMask - Supplies the mask of digits that blink, where bit 0 is the
+        first digit.
+
+    Milliseconds - Supplies how long the digits stay on and off for. Supply 0
+        to stop the blinking.
+
+    Segments - Supplies the mask of segments in those digits that blink.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Frames;
+    int Result;
+
+    Frames = ConvertMillisecondsToFrames(Milliseconds);
+    Result = usb_control_msg(Handle,
+                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
+                             USBLED_COMMAND_SET_BLINK,
+                             DigitMask,
+                             Frames | (Segments << 8),
+                             NULL,
+                             0,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error setting blink.\nStatus: %s\n", strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+SetLedScroll (
+    usb_dev_handle *Handle,
+    int LineMask,
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine has the LED display scroll some of its lines around on its
+    own, like a marquee.
+
+Arguments:
+
+    Handle - Supplies a pointer to the open device.
+
+    LineMask - Supplies the mask of lines that scroll, where bit 0 is the
+        first line.
+
+    Milliseconds - Supplies how long the display waits between steps. Supply
+        0 to stop the scrolling.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Frames;
+    int Result;
+
+    Frames = ConvertMillisecondsToFrames(Milliseconds);
+    Result = usb_control_msg(Handle,
+                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
+                             USBLED_COMMAND_SET_SCROLL,
+                             Frames,
+                             LineMask,
+                             NULL,
+                             0,
+                             USBLED_TIMEOUT);
+
+    if (Result < 0) {
+        printf("Error setting scroll.\nStatus: %s\n", strerror(-Result));
+    }
+
+    return Result;
+}
+
+int
+ConvertMillisecondsToFrames (
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a time into the frames the device animates in,
+    rounding to the nearest frame.
+
+Arguments:
+
+    Milliseconds - Supplies the time to convert.
+
+Return Value:
+
+    Returns the number of frames, between 1 and USBLED_MAX_FRAMES. Returns 0
+    if the time is 0.
+
+--*/
+
+{
+
+    int Frames;
+
+    if (Milliseconds <= 0) {
+        return 0;
+    }
+
+    Frames = ((Milliseconds * 1000) + (USBLED_FRAME_MICROSECONDS / 2)) /
+             USBLED_FRAME_MICROSECONDS;
+
+    if (Frames == 0) {
+        Frames = 1;
+
+    } else if (Frames > USBLED_MAX_FRAMES) {
+        Frames = USBLED_MAX_FRAMES;
+    }
+
+    return Frames;
+}
+
+int
+CountStringDigits (
+    char *String,
+    int Length
+    )
+
+/*++
+
+Routine Description:
+
+    This routine counts how many digits of the display the start of a string
+    takes up. Periods share a digit with the character before them.
+
+Arguments:
+
+    String - Supplies a pointer to the string.
+
+    Length - Supplies the number of characters to count.
+
+Return Value:
+
+    Returns the number of digits.
+
+--*/
+
+{
+
+    int Digits;
+    int Index;
+
+    Digits = 0;
+    for (Index = 0; Index < Length; Index += 1) {
+        if (String[Index] != '.') {
+            Digits += 1;
+        }
+    }
+
+    return Digits;
+}
+
+int
+OpenDisplay (
+    PDISPLAY Display,
+    struct usb_device *Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine opens the device for a display, figures out what it can do,
+    and sets its brightness if asked to.
+
+Arguments:
+
+    Display - Supplies a pointer to the display. Its options must already be
+        filled in.
+
+    Device - Supplies a pointer to the device to open.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Result;
+
+    if (Options.Verbose != 0) {
+        PrintDeviceDescription(Device);
+    }
+
+    Display->Device = Device;
+    Display->Handle = ConfigureDevice(Device);
+    if (Display->Handle == NULL) {
+        return -1;
+    }
+
+    //
+    // Newer devices take the segments directly, which saves sending and
+    // parsing the text.
+    //
+
+    Display->RawSegments = FALSE;
+    if (Device->descriptor.bcdDevice >= USBLED_RAW_SEGMENTS_VERSION) {
+        Display->RawSegments = TRUE;
+    }
+
+    //
+    // Devices that animate on their own blink the decimals for the time, so
+    // the host doesn't have to rewrite the display to do it.
+    //
+
+    Display->Animation = FALSE;
+    Display->BlinkDecimals = Display->Options->ShowBlinkyDecimals;
+    if (Device->descriptor.bcdDevice >= USBLED_ANIMATION_VERSION) {
+        Display->Animation = TRUE;
+        Display->BlinkDecimals = FALSE;
+
+    } else if (Display->Options->ScrollInterval != 0) {
+        printf("Warning: This device can't scroll.\n");
+    }
+
+    if (Display->Options->Brightness >= 0) {
+        Result = SetLedBrightness(Display->Handle,
+                                  USBLED_ALL_DIGITS,
+                                  Display->Options->Brightness);
+
+        if (Result < 0) {
+            return Result;
+        }
+    }
+
+    return 0;
+}
+
+int
+ResetDisplayAnimation (
+    PDISPLAY Display
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts the animations on a display over, which also stops
+    any left running by whoever used the device last.
+
+Arguments:
+
+    Display - Supplies a pointer to the open display.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    int Result;
+
+    if (Display->Animation == FALSE) {
+        return 0;
+    }
+
+    Result = SetLedBlink(Display->Handle, 0, 0, 0);
+    if (Result >= 0) {
+        Result = SetLedScroll(Display->Handle,
+                              USBLED_ALL_LINES,
+                              Display->Options->ScrollInterval);
+    }
+
+    return Result;
+}
+
+void
+CloseDisplay (
+    PDISPLAY Display
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops a display's writer if it has one, and closes its
+    device. Displays that aren't open are left alone.
+
+Arguments:
+
+    Display - Supplies a pointer to the display.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Display->WriterRunning != FALSE) {
+        StopDisplayWriter(&(Display->Writer));
+        Display->WriterRunning = FALSE;
+        if (Options.Verbose != 0) {
+            PrintDisplayStatistics(Display - Displays, Display);
+        }
+    }
+
+    if (Display->Handle != NULL) {
+        usb_close(Display->Handle);
+        Display->Handle = NULL;
+    }
+
+    Display->Device = NULL;
+    return;
+}
+
+int
+RenderDisplay (
+    PDISPLAY Display,
+    PSYSTEM_SAMPLE Sample,
+    char *Input,
+    char *String,
+    int *BlinkMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the string a display shows from its features.
+
+Arguments:
+
+    Display - Supplies a pointer to the open display.
+
+    Sample - Supplies a pointer to the latest sample of the system.
+
+    Input - Supplies a pointer to the text to show before the features.
+
+    String - Supplies a pointer to a buffer of USBLED_MAX_STRING_LENGTH bytes
+        where the string will be returned.
+
+    BlinkMask - Supplies a pointer where the mask of digits the device should
+        blink will be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure.
+
+--*/
+
+{
+
+    int FirstDigit;
+    int Line;
+    int Result;
+    STOCK_FEATURE Selection;
+    int StringOffset;
+
+    strcpy(String, Input);
+    StringOffset = strlen(String);
+    *BlinkMask = 0;
+    for (Line = 0; Line < USBLED_MAX_ROWS; Line += 1) {
+        Selection = Display->Options->Selection[Line];
+        if (Selection == StockFeatureInvalid) {
+            break;
+        }
+
+        FirstDigit = CountStringDigits(String, StringOffset);
+        Result = WriteFeatureToString(Selection,
+                                      Display->Options,
+                                      Sample,
+                                      String,
+                                      USBLED_MAX_STRING_LENGTH,
+                                      &StringOffset,
+                                      Display->BlinkDecimals);
+
+        if (Result == 0) {
+            printf("Error: Failed to execute feature %d.\n", Selection);
+            return 0;
+        }
+
+        //
+        // Have the device blink the decimals in the digits the time landed
+        // in.
+        //
+
+        if ((Display->Animation != FALSE) &&
+            (Display->Options->ShowBlinkyDecimals != FALSE) &&
+            ((Selection == StockFeatureCurrentTime) ||
+             (Selection == StockFeatureCurrentTimeShort))) {
+
+            while (FirstDigit < CountStringDigits(String, StringOffset)) {
+                *BlinkMask |= 1 << FirstDigit;
+                FirstDigit += 1;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int
+TakeSystemSample (
+    PSYSTEM_SAMPLE Sample,
+    int FeatureMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine samples the parts of the system the given features show.
+
+Arguments:
+
+    Sample - Supplies a pointer where the sample will be returned.
+
+    FeatureMask - Supplies the mask of features that will be shown, where
+        each feature's bit is 1 shifted left by its STOCK_FEATURE value.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure.
+
+--*/
+
+{
+
+    int Index;
+    int Result;
+
+    if ((FeatureMask & (1 << StockFeaturePerCpuUsage)) != 0) {
+        memset(Sample->ProcessorUsage, 0, sizeof(Sample->ProcessorUsage));
+        Sample->ProcessorCount = GetProcessorUsage(
+                                              Sample->ProcessorUsage,
+                                              sizeof(Sample->ProcessorUsage),
+                                              0);
+
+        if (Sample->ProcessorCount == 0) {
+            printf("Error getting processor usage.\n");
+            return 0;
+        }
+    }
+
+    if ((FeatureMask & (1 << StockFeatureCpuMemoryUsage)) != 0) {
+        Result = GetProcessorAndMemoryUsage(&(Sample->CpuUsage),
+                                            &(Sample->MemoryUsage));
+
+        if (Result == 0) {
+            printf("Error getting CPU usage.\n");
+            return 0;
+        }
+    }
+
+    if ((FeatureMask & (1 << StockFeatureNetworkUsage)) != 0) {
+        for (Index = 0; Index < Sample->NetworkCount; Index += 1) {
+            Result = SampleNetworkUsage(&(Sample->Network[Index]));
+            if (Result == 0) {
+                printf("Error getting network usage.\n");
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+PNETWORK_SAMPLE
+FindNetworkSample (
+    PSYSTEM_SAMPLE Sample,
+    char *Interface
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the network rates sampled for an interface.
+
+Arguments:
+
+    Sample - Supplies a pointer to the sample of the system.
+
+    Interface - Supplies the name of the interface, or NULL for every
+        interface together.
+
+Return Value:
+
+    Returns a pointer to the network rates of the interface.
+
+    NULL if the interface isn't being sampled.
+
+--*/
+
+{
+
+    int Index;
+    PNETWORK_SAMPLE Network;
+
+    for (Index = 0; Index < Sample->NetworkCount; Index += 1) {
+        Network = &(Sample->Network[Index]);
+        if (Network->Interface == NULL) {
+            if (Interface == NULL) {
+                return Network;
+            }
+
+        } else if ((Interface != NULL) &&
+                   (strcmp(Network->Interface, Interface) == 0)) {
+
+            return Network;
+        }
+    }
+
+    return NULL;
+}
+
+int
+SampleNetworkUsage (
+    PNETWORK_SAMPLE Network
+    )
+
+/*++
+
+Routine Description:
+
+    This routine updates the network rates of one interface, or of every
+    interface together.
+
+Arguments:
+
+    Network - Supplies a pointer to the network rates to update.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure.
+
+--*/
+
+{
+
+    unsigned long long BytesReceived;
+    unsigned long long BytesSent;
+    unsigned long long Difference;
+    int Result;
+    unsigned long long Time;
+    unsigned long long TimeDifference;
+
+    if (Network->Interface == NULL) {
+        return GetNetworkUsage(&(Network->DownloadSpeed),
+                               &(Network->UploadSpeed));
+    }
+
+    Result = GetNetworkCounters(Network->Interface,
+                                &BytesReceived,
+                                &BytesSent);
+
+    if (Result == 0) {
+        return 0;
+    }
+
+    //
+    // The first sample only sets the starting point. If the counters went
+    // backwards, the interface was reset, so show nothing for this sample.
+    //
+
+    Time = GetMicroseconds();
+    TimeDifference = Time - Network->Time;
+    Network->DownloadSpeed = 0;
+    Network->UploadSpeed = 0;
+    if ((Network->Time != 0) && (TimeDifference != 0)) {
+        if (BytesReceived >= Network->BytesReceived) {
+            Difference = BytesReceived - Network->BytesReceived;
+            Network->DownloadSpeed = (int)((Difference >> 10) * 1000000 /
+                                           TimeDifference);
+        }
+
+        if (BytesSent >= Network->BytesSent) {
+            Difference = BytesSent - Network->BytesSent;
+            Network->UploadSpeed = (int)((Difference >> 10) * 1000000 /
+                                         TimeDifference);
+        }
+    }
+
+    Network->BytesReceived = BytesReceived;
+    Network->BytesSent = BytesSent;
+    Network->Time = Time;
+    return 1;
+}
+
+void
+PrintDisplayStatistics (
+    int Index,
+    PDISPLAY Display
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints how a display's writer has kept up since the last
+    time its statistics were printed, and starts them over.
+
+Arguments:
+
+    Index - Supplies the number of the display.
+
+    Display - Supplies a pointer to the display.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int Average;
+    PDISPLAY_WRITER Writer;
+
+    Writer = &(Display->Writer);
+    if (Display->WriterRunning != FALSE) {
+        AcquireWriterLock(Writer);
+    }
+
+    Average = 0;
+    if (Writer->FramesWritten != 0) {
+        Average = (int)(Writer->WriteTime / Writer->FramesWritten);
+    }
+
+    printf("Display %d: %d frames written, %d dropped, %d.%03dms average "
+           "write, %d.%03dms longest.\n",
+           Index,
+           Writer->FramesWritten,
+           Writer->FramesDropped,
+           Average / 1000,
+           Average % 1000,
+           Writer->LongestWriteTime / 1000,
+           Writer->LongestWriteTime % 1000);
+
+    Writer->FramesWritten = 0;
+    Writer->FramesDropped = 0;
+    Writer->WriteTime = 0;
+    Writer->LongestWriteTime = 0;
+    if (Display->WriterRunning != FALSE) {
+        ReleaseWriterLock(Writer);
+    }
+
+    return;
+}
+
+void
+ReadInputFrames (
+    PINPUT_STREAM Stream,
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads lines from stdin for the given time, keeping the
+    newest whole one and counting any it replaces before they were shown.
+    It returns early if the input runs out, treating whatever is left as the
+    last line.
+
+Arguments:
+
+    Stream - Supplies a pointer to the state of the input.
+
+    Milliseconds - Supplies how long to read for.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char Buffer[USBLED_INPUT_BUFFER_SIZE];
+    char Character;
+    int Elapsed;
+    int Index;
+    int Size;
+    unsigned long long Start;
+
+    Start = GetMicroseconds();
+    Elapsed = 0;
+    while (Stream->Ended == FALSE) {
+        Size = ReadInput(Buffer, sizeof(Buffer), Milliseconds - Elapsed);
+        if (Size < 0) {
+            Stream->Ended = TRUE;
+            Buffer[0] = '\n';
+            Size = 1;
+        }
+
+        for (Index = 0; Index < Size; Index += 1) {
+            Character = Buffer[Index];
+            if (Character == '\n') {
+                if (Stream->LineLength == 0) {
+                    continue;
+                }
+
+                if (Stream->FramePending != FALSE) {
+                    Stream->FramesDropped += 1;
+                }
+
+                Stream->Line[Stream->LineLength] = '\0';
+                strcpy(Stream->Frame, Stream->Line);
+                Stream->LineLength = 0;
+                Stream->FramePending = TRUE;
+                Stream->FramesRead += 1;
+
+            //
+            // Drop carriage returns, and anything past what fits on a display.
+            //
+
+            } else if ((Character != '\r') &&
+                       (Stream->LineLength < USBLED_MAX_STRING_LENGTH - 1)) {
+
+                Stream->Line[Stream->LineLength] = Character;
+                Stream->LineLength += 1;
+            }
+        }
+
+        Elapsed = (int)((GetMicroseconds() - Start) / 1000);
+        if (Elapsed >= Milliseconds) {
+            break;
+        }
+    }
+
+    return;
+}
+
+int
+StartDisplayWriter (
+    PDISPLAY_WRITER Writer,
+    usb_dev_handle *Handle,
+    int RawSegments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts a thread that writes frames out to a device as fast
+    as the device takes them.
+
+Arguments:
+
+    Writer - Supplies a pointer to the writer to start.
+
+    Handle - Supplies a pointer to the open device.
+
+    RawSegments - Supplies a non-zero value if the device takes raw segments.
+
+Return Value:
+
+    Returns >= 0 on success.
+
+    Returns < 0 on failure.
+
+--*/
+
+{
+
+    memset(Writer, 0, sizeof(DISPLAY_WRITER));
+    Writer->Handle = Handle;
+    Writer->RawSegments = RawSegments;
+
+#ifdef __WIN32__
+
+    InitializeCriticalSection(&(Writer->Lock));
+    Writer->Signal = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (Writer->Signal == NULL) {
+        DeleteCriticalSection(&(Writer->Lock));
+        goto StartDisplayWriterEnd;
+    }
+
+    Writer->Thread = CreateThread(NULL,
+                                  0,
+                                  DisplayWriterThread,
+                                  Writer,
+                                  0,
+                                  NULL);
+
+    if (Writer->Thread == NULL) {
+        CloseHandle(Writer->Signal);
+        DeleteCriticalSection(&(Writer->Lock));
+        goto StartDisplayWriterEnd;
+    }
+
+#else
+
+    pthread_mutex_init(&(Writer->Lock), NULL);
+    pthread_cond_init(&(Writer->Signal), NULL);
+    if (pthread_create(&(Writer->Thread),
+                       NULL,
+                       DisplayWriterThread,
+                       Writer) != 0) {
+
+        pthread_cond_destroy(&(Writer->Signal));
+        pthread_mutex_destroy(&(Writer->Lock));
+        goto StartDisplayWriterEnd;
+    }
+
+#endif
+
+    return 0;
+
+StartDisplayWriterEnd:
+    printf("Error: Failed to start the display writer.\n");
+    return -1;
 }
 
-void
-PrintDeviceConfiguration (
-    struct usb_config_descriptor *Configuration
+int
+PostDisplayFrame (
+    PDISPLAY_WRITER Writer,
+    char *String,
+    int BlinkMask
     )
 
 /*++
 
 Routine Description:
 
-    This routine prints out a USB device configuration descriptor description.
+    This routine hands a frame to the writer thread without waiting for it to
+    be written. If the writer is still busy with an older frame, the frame
+    waiting behind it is replaced, so the device always gets the newest one.
 
 Arguments:
 
-    Device - Supplies a pointer to the configuration to print a description of.
+    Writer - Supplies a pointer to the running writer.
+
+    String - Supplies a pointer to the string to display.
+
+    BlinkMask - Supplies the mask of digits that should blink.
 
 Return Value:
 
-    None.
+    Returns >= 0 on success.
+
+    Returns < 0 if an earlier frame failed to be written.
 
 --*/
 
 {
 
-    int InterfaceIndex;
-
-    printf("TotalLength: %d\n", Configuration->wTotalLength);
-    printf("InterfaceCount: %d\n", Configuration->bNumInterfaces);
-    printf("ConfigurationValue: %d\n", Configuration->bConfigurationValue);
-    printf("Configuration: %d\n", Configuration->iConfiguration);
-    printf("Attributes: 0x%02x\n", Configuration->bmAttributes);
-    printf("MaxPower: %d\n", Configuration->MaxPower);
-
-    //
-    // Print out all interfaces in this configuration.
-    //
+    int Result;
 
-    for (InterfaceIndex = 0;
-         InterfaceIndex < Configuration->bNumInterfaces;
-         InterfaceIndex += 1) {
+    AcquireWriterLock(Writer);
+    Result = Writer->Result;
+    if (Result >= 0) {
+        if (Writer->Pending != FALSE) {
+            Writer->FramesDropped += 1;
+        }
 
-        printf("Interface %d:\n\n", InterfaceIndex);
-        PrintInterface(&(Configuration->interface[InterfaceIndex]));
+        strcpy(Writer->String, String);
+        Writer->BlinkMask = BlinkMask;
+        Writer->Pending = TRUE;
+        SignalWriter(Writer);
     }
 
-    printf("\n");
-    return;
+    ReleaseWriterLock(Writer);
+    return Result;
 }
 
 void
-PrintInterface (
-    struct usb_interface *Interface
+StopDisplayWriter (
+    PDISPLAY_WRITER Writer
     )
 
 /*++
 
 Routine Description:
 
-    This routine prints out a USB device interface description.
+    This routine stops a writer thread once it has written the frame waiting
+    for it, if any, and waits for the thread to exit.
 
 Arguments:
 
-    Interface - Supplies a pointer to the interface to print a description of.
+    Writer - Supplies a pointer to the running writer.
 
 Return Value:
 
@@ -1218,84 +3650,143 @@ Return Value:
 
 {
 
-    int DescriptorIndex;
+    AcquireWriterLock(Writer);
+    Writer->Stop = TRUE;
+    SignalWriter(Writer);
+    ReleaseWriterLock(Writer);
 
-    for (DescriptorIndex = 0;
-         DescriptorIndex < Interface->num_altsetting;
-         DescriptorIndex += 1) {
+#ifdef __WIN32__
 
-        printf("Descriptor %d:\n\n", DescriptorIndex);
-        PrintDescriptor(&(Interface->altsetting[DescriptorIndex]));
-    }
+    WaitForSingleObject(Writer->Thread, INFINITE);
+    CloseHandle(Writer->Thread);
+    CloseHandle(Writer->Signal);
+    DeleteCriticalSection(&(Writer->Lock));
+
+#else
+
+    pthread_join(Writer->Thread, NULL);
+    pthread_cond_destroy(&(Writer->Signal));
+    pthread_mutex_destroy(&(Writer->Lock));
+
+#endif
 
-    printf("\n");
     return;
 }
 
-void
-PrintDescriptor (
-    struct usb_interface_descriptor *Descriptor
+#ifdef __WIN32__
+
+DWORD
+WINAPI
+DisplayWriterThread (
+    LPVOID Context
+    )
+
+#else
+
+void *
+DisplayWriterThread (
+    void *Context
     )
 
+#endif
+
 /*++
 
 Routine Description:
 
-    This routine prints out a USB descriptor description.
+    This routine implements the writer thread, which writes each frame posted
+    to it out to the device.
 
 Arguments:
 
-    Descriptor - Supplies a pointer to the descriptor to print a description
-        of.
+    Context - Supplies a pointer to the writer.
 
 Return Value:
 
-    None.
+    0 always.
 
 --*/
 
 {
 
-    int EndpointIndex;
+    int BlinkMask;
+    int Result;
+    unsigned long long StartTime;
+    char String[USBLED_MAX_STRING_LENGTH];
+    int WriteTime;
+    PDISPLAY_WRITER Writer;
 
-    printf("InterfaceNumber: %d\n", Descriptor->bInterfaceNumber);
-    printf("AlternateSetting: %d\n", Descriptor->bAlternateSetting);
-    printf("EndpointCount: %d\n", Descriptor->bNumEndpoints);
-    printf("InterfaceClass: 0x%x\n", Descriptor->bInterfaceClass);
-    printf("InterfaceSubclass: 0x%x\n", Descriptor->bInterfaceSubClass);
-    printf("InterfaceProtocol: 0x%x\n", Descriptor->bInterfaceProtocol);
-    printf("Interface: %d\n", Descriptor->iInterface);
+    Writer = Context;
+    AcquireWriterLock(Writer);
+    while (TRUE) {
+        while ((Writer->Pending == FALSE) && (Writer->Stop == FALSE)) {
+            WaitForWriterSignal(Writer);
+        }
 
-    //
-    // Print out all endpoints in this descriptor.
-    //
+        if (Writer->Pending == FALSE) {
+            break;
+        }
 
-    for (EndpointIndex = 0;
-         EndpointIndex < Descriptor->bNumEndpoints;
-         EndpointIndex += 1) {
+        //
+        // Take the frame and let go of the lock while it's written, so new
+        // frames can be posted in the meantime.
+        //
 
-        printf("Endpoint %d:\n\n", EndpointIndex);
-        PrintEndpoint(&(Descriptor->endpoint[EndpointIndex]));
+        strcpy(String, Writer->String);
+        BlinkMask = Writer->BlinkMask;
+        Writer->Pending = FALSE;
+        ReleaseWriterLock(Writer);
+        StartTime = GetMicroseconds();
+        Result = 0;
+        if (BlinkMask != Writer->WrittenBlinkMask) {
+            Result = SetLedBlink(Writer->Handle,
+                                 BlinkMask,
+                                 USBLED_BLINK_INTERVAL,
+                                 USBLED_PERIOD);
+
+            if (Result >= 0) {
+                Writer->WrittenBlinkMask = BlinkMask;
+            }
+        }
+
+        if (Result >= 0) {
+            Result = WriteDisplay(Writer->Handle,
+                                  String,
+                                  Writer->RawSegments);
+        }
+
+        WriteTime = (int)(GetMicroseconds() - StartTime);
+        AcquireWriterLock(Writer);
+        if (Result < 0) {
+            Writer->Result = Result;
+            break;
+        }
+
+        Writer->FramesWritten += 1;
+        Writer->WriteTime += WriteTime;
+        if (WriteTime > Writer->LongestWriteTime) {
+            Writer->LongestWriteTime = WriteTime;
+        }
     }
 
-    printf("\n");
-    return;
+    ReleaseWriterLock(Writer);
+    return 0;
 }
 
 void
-PrintEndpoint (
-    struct usb_endpoint_descriptor *Endpoint
+AcquireWriterLock (
+    PDISPLAY_WRITER Writer
     )
 
 /*++
 
 Routine Description:
 
-    This routine prints out a USB endpoint description.
+    This routine acquires the lock guarding a writer.
 
 Arguments:
 
-    Endpoint - Supplies a pointer to the endpoint to print a description of.
+    Writer - Supplies a pointer to the writer.
 
 Return Value:
 
@@ -1305,37 +3796,37 @@ Return Value:
 
 {
 
-    printf("EndpointAddress: 0x%02x\n", Endpoint->bEndpointAddress);
-    printf("Attributes: 0x%02x\n", Endpoint->bmAttributes);
-    printf("MaxPacketSize: %d\n", Endpoint->wMaxPacketSize);
-    printf("Interval: %d\n", Endpoint->bInterval);
-    printf("Refresh: %d\n", Endpoint->bRefresh);
-    printf("SynchAddress: %d\n", Endpoint->bSynchAddress);
-    printf("\n");
+#ifdef __WIN32__
+
+    EnterCriticalSection(&(Writer->Lock));
+
+#else
+
+    pthread_mutex_lock(&(Writer->Lock));
+
+#endif
+
     return;
 }
 
 void
-MillisecondSleep (
-    unsigned int Milliseconds
+ReleaseWriterLock (
+    PDISPLAY_WRITER Writer
     )
 
 /*++
 
 Routine Description:
 
-    This routine suspends the current thread's execution for at least the
-    specified number of milliseconds.
+    This routine releases the lock guarding a writer.
 
 Arguments:
 
-    Milliseconds - Supplies the number of milliseconds to suspend the thread
-        for.
+    Writer - Supplies a pointer to the writer.
 
 Return Value:
 
-    None. The function will simply return after approximately the specified
-    number of milliseconds.
+    None.
 
 --*/
 
@@ -1343,134 +3834,109 @@ Return Value:
 
 #ifdef __WIN32__
 
-    Sleep(Milliseconds);
+    LeaveCriticalSection(&(Writer->Lock));
 
 #else
 
-    struct timespec PollInterval;
-
-    PollInterval.tv_sec = 0;
-    PollInterval.tv_nsec = Milliseconds * 1000 * 1000;
-    nanosleep(&PollInterval, NULL);
+    pthread_mutex_unlock(&(Writer->Lock));
 
 #endif
 
     return;
 }
 
-int
-ReadButtonState (
-    usb_dev_handle *Handle,
-    int *ButtonState
+void
+SignalWriter (
+    PDISPLAY_WRITER Writer
     )
 
 /*++
 
 Routine Description:
 
-    This routine reads whether or not there has been a button press on the LED
-    device.
+    This routine wakes the writer thread. The caller must hold the writer
+    lock.
 
 Arguments:
 
-    Handle - Supplies a pointer to the open device.
-
-    ButtonState - Supplies a pointer where the button state will be returned.
-        The value will be zero if the button has not been pressed since the
-        last time it was checked, or 1 if the button was pressed since the last
-        time it was checked.
+    Writer - Supplies a pointer to the writer.
 
 Return Value:
 
-    Returns >= 0 on success.
-
-    Returns < 0 on failure.
+    None.
 
 --*/
 
 {
 
-    unsigned long RequestType;
-    int Result;
+#ifdef __WIN32__
 
-    RequestType = USB_ENDPOINT_IN | USB_TYPE_VENDOR | USB_RECIP_DEVICE;
-    Result = usb_control_msg(Handle,
-                             RequestType,
-                             USBLED_COMMAND_GET_BUTTON_STATE,
-                             0,
-                             0,
-                             (char *)ButtonState,
-                             1,
-                             USBLED_TIMEOUT);
+    SetEvent(Writer->Signal);
 
-    if (Result < 0) {
-        printf("Error writing command, got %d of %d bytes.\n"
-               "Status: %s\n",
-               Result,
-               1,
-               strerror(-Result));
-    }
+#else
 
-    return Result;
+    pthread_cond_signal(&(Writer->Signal));
+
+#endif
+
+    return;
 }
 
-int
-WriteStringToLeds (
-    usb_dev_handle *Handle,
-    char *String
+void
+WaitForWriterSignal (
+    PDISPLAY_WRITER Writer
     )
 
 /*++
 
 Routine Description:
 
-    This routine writes the given null-terminated ASCII string to the LED
-    display.
+    This routine waits for the writer thread to be woken. The caller must
+    hold the writer lock, which is released during the wait and held again
+    on return. Only the writer thread may wait, and it may wake without
+    being signaled.
 
 Arguments:
 
-    Handle - Supplies a pointer to the open device.
-
-    String - Supplies the string to write.
+    Writer - Supplies a pointer to the writer.
 
 Return Value:
 
-    Returns >= 0 on success.
-
-    Returns < 0 on failure.
+    None.
 
 --*/
 
 {
 
-    int Result;
+#ifdef __WIN32__
 
-    Result = usb_control_msg(Handle,
-                             USB_TYPE_VENDOR | USB_RECIP_DEVICE,
-                             USBLED_COMMAND_WRITE,
-                             0,
-                             0,
-                             String,
-                             strlen(String) + 1,
-                             USBLED_TIMEOUT);
+    //
+    // The event stays set until the one waiter wakes, so a signal between
+    // leaving the lock and waiting isn't lost.
+    //
 
-    if (Result < 0) {
-        printf("Error writing command, wrote %d of %d bytes.\n"
-               "Status: %s\n",
-               Result,
-               (int)sizeof(Result),
-               strerror(-Result));
-    }
+    LeaveCriticalSection(&(Writer->Lock));
+    WaitForSingleObject(Writer->Signal, INFINITE);
+    EnterCriticalSection(&(Writer->Lock));
 
-    return Result;
+#else
+
+    pthread_cond_wait(&(Writer->Signal), &(Writer->Lock));
+
+#endif
+
+    return;
 }
 
 int
 WriteFeatureToString (
     STOCK_FEATURE Feature,
+    PDISPLAY_OPTIONS DisplayOptions,
+    PSYSTEM_SAMPLE Sample,
     char *String,
     int StringLength,
-    int *Offset
+    int *Offset,
+    int BlinkDecimals
     )
 
 /*++
@@ -1484,6 +3950,11 @@ Arguments:
 
     Feature - Supplies the feature to perform.
 
+    DisplayOptions - Supplies a pointer to the options of the display the
+        feature is for.
+
+    Sample - Supplies a pointer to the latest sample of the system.
+
     String - Supplies a pointer to the string that will receive the result.
 
     StringLength - Supplies the size of the string buffer, in bytes, from the
@@ -1494,6 +3965,9 @@ Arguments:
         value of the pointer supplied is accumulated wiht the length of the
         string printed.
 
+    BlinkDecimals - Supplies a non-zero value if the decimals in the current
+        time should blink.
+
 Return Value:
 
     Non-zero on success.
@@ -1514,18 +3988,24 @@ Return Value:
     case StockFeaturePerCpuUsage:
         Result = PrintPerCpuUsage(String + *Offset,
                                   StringLength - *Offset,
-                                  Options.CpuOffset);
+                                  Sample,
+                                  DisplayOptions->CpuOffset);
 
         break;
 
     case StockFeatureCpuMemoryUsage:
         Result = PrintCpuMemoryUsage(String + *Offset,
-                                     StringLength - *Offset);
+                                     StringLength - *Offset,
+                                     Sample);
 
         break;
 
     case StockFeatureNetworkUsage:
-        Result = PrintNetworkUsage(String + *Offset, StringLength - *Offset);
+        Result = PrintNetworkUsage(String + *Offset,
+                                   StringLength - *Offset,
+                                   Sample,
+                                   DisplayOptions->NetworkInterface);
+
         break;
 
     case StockFeatureCurrentDate:
@@ -1535,18 +4015,18 @@ Return Value:
     case StockFeatureCurrentTimeShort:
         Result = PrintCurrentTime(String + *Offset,
                                   StringLength - *Offset,
-                                  Options.MilitaryTime,
+                                  DisplayOptions->MilitaryTime,
                                   FALSE,
-                                  Options.ShowBlinkyDecimals);
+                                  BlinkDecimals);
 
         break;
 
     case StockFeatureCurrentTime:
         Result = PrintCurrentTime(String + *Offset,
                                   StringLength - *Offset,
-                                  Options.MilitaryTime,
+                                  DisplayOptions->MilitaryTime,
                                   TRUE,
-                                  Options.ShowBlinkyDecimals);
+                                  BlinkDecimals);
 
         break;
 
@@ -1563,6 +4043,7 @@ int
 PrintPerCpuUsage (
     char *String,
     int StringSize,
+    PSYSTEM_SAMPLE Sample,
     int CpuOffset
     )
 
@@ -1579,6 +4060,8 @@ Arguments:
 
     StringSize - Supplies the size of the string buffer, in bytes.
 
+    Sample - Supplies a pointer to the latest sample of the system.
+
     CpuOffset - Supplies the processor number to start printing usage
         from.
 
@@ -1594,17 +4077,25 @@ Return Value:
 
     int CpuCount;
     int CpuIndex;
-    int CpuUsage[USBLED_MAX_ROWS * 2];
+    int CpuUsage;
     char SprintResult[6];
 
     if (StringSize < 4) {
         return 0;
     }
 
-    memset(CpuUsage, 0, sizeof(CpuUsage));
-    CpuCount = GetProcessorUsage(CpuUsage, sizeof(CpuUsage), CpuOffset);
-    if (CpuCount == 0) {
-        return 0;
+    //
+    // Show the processors from the offset on. If there aren't any, show
+    // zeros for as many as there are.
+    //
+
+    CpuCount = Sample->ProcessorCount - CpuOffset;
+    if (CpuCount <= 0) {
+        CpuCount = Sample->ProcessorCount;
+    }
+
+    if (CpuCount > USBLED_MAX_ROWS * 2) {
+        CpuCount = USBLED_MAX_ROWS * 2;
     }
 
     //
@@ -1621,7 +4112,14 @@ Return Value:
          (CpuIndex < CpuCount) && (StringSize > 5);
          CpuIndex += 1, StringSize -= 4) {
 
-        sprintf(SprintResult, "%5.1f", (double)(CpuUsage[CpuIndex] / 10.0));
+        CpuUsage = 0;
+        if ((CpuOffset + CpuIndex < Sample->ProcessorCount) &&
+            (CpuOffset + CpuIndex < USBLED_MAX_PROCESSORS)) {
+
+            CpuUsage = Sample->ProcessorUsage[CpuOffset + CpuIndex];
+        }
+
+        sprintf(SprintResult, "%5.1f", (double)(CpuUsage / 10.0));
         strcat(String, SprintResult);
     }
 
@@ -1631,7 +4129,8 @@ Return Value:
 int
 PrintCpuMemoryUsage (
     char *String,
-    int StringSize
+    int StringSize,
+    PSYSTEM_SAMPLE Sample
     )
 
 /*++
@@ -1648,6 +4147,8 @@ Arguments:
     StringSize - Supplies the size of the string buffer, in bytes. This must be
         at least 11 bytes.
 
+    Sample - Supplies a pointer to the latest sample of the system.
+
 Return Value:
 
     Returns the length of the string printed.
@@ -1658,24 +4159,14 @@ Return Value:
 
 {
 
-    int CpuUsage;
-    int MemoryUsage;
-    int Result;
-
     if (StringSize < 11) {
         return 0;
     }
 
-    Result = GetProcessorAndMemoryUsage(&CpuUsage, &MemoryUsage);
-    if (Result == 0) {
-        printf("Error getting CPU usage.\n");
-        return 0;
-    }
-
     sprintf(String,
             "%5.1f%5.1f",
-            (double)(CpuUsage / 10.0),
-            (double)(MemoryUsage / 10.0));
+            (double)(Sample->CpuUsage / 10.0),
+            (double)(Sample->MemoryUsage / 10.0));
 
     return 10;
 }
@@ -1683,7 +4174,9 @@ Return Value:
 int
 PrintNetworkUsage (
     char *String,
-    int StringSize
+    int StringSize,
+    PSYSTEM_SAMPLE Sample,
+    char *Interface
     )
 
 /*++
@@ -1699,6 +4192,11 @@ Arguments:
 
     StringSize - Supplies the size of the string buffer, in bytes.
 
+    Sample - Supplies a pointer to the latest sample of the system.
+
+    Interface - Supplies the name of the network interface to show, or NULL
+        for every interface together.
+
 Return Value:
 
     Returns the length of the string printed.
@@ -1710,16 +4208,18 @@ Return Value:
 {
 
     int DownloadSpeed;
-    int Result;
+    PNETWORK_SAMPLE Network;
     int ResultSize;
     int UploadSpeed;
 
-    Result = GetNetworkUsage(&DownloadSpeed, &UploadSpeed);
-    if (Result == 0) {
-        printf("Error getting network usage.\n");
+    Network = FindNetworkSample(Sample, Interface);
+    if (Network == NULL) {
         return 0;
     }
 
+    DownloadSpeed = Network->DownloadSpeed;
+    UploadSpeed = Network->UploadSpeed;
+
     //
     // Print out kilobytes per second without a decimal point if the rate
     // is less than 10MB/s. Otherwise, print out the rate in megabytes per
@@ -36,12 +36,28 @@ Environment:
 #include <ws2tcpip.h>
 #include <iphlpapi.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "ossup.h"
 
 //
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define how often to look for USB devices, since there's no notification
+// here when they change.
+//
+
+#define DEVICE_POLL_INTERVAL 250
+
+//
+// Define how often to check a pipe for input while waiting on it, in
+// milliseconds.
+//
+
+#define INPUT_POLL_INTERVAL 10
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -96,6 +112,10 @@ NTSTATUS
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+int
+ReadInterfaceTable (
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -571,66 +591,16 @@ Return Value:
     int InterfaceIndex;
     MIB_IFROW *InterfaceRow;
     int Result;
-    DWORD Size;
     ULONGLONG SystemTime;
     ULONGLONG TimeDifference;
     SYSTEMTIME SystemTimeStructure;
-    DWORD Status;
     ULONGLONG TotalBytesSent;
     ULONGLONG TotalBytesReceived;
 
-    //
-    // Attempt to get the interface table.
-    //
-
     GetSystemTime(&SystemTimeStructure);
-    Size = InterfaceTableSize;
-    Status = GetIfTable(InterfaceTable, &Size, FALSE);
-    if (Status != NO_ERROR) {
-
-        //
-        // If this is the first time and there is no buffer, or the required
-        // buffer got bigger, reallocate with the needed size.
-        //
-
-        if (Status == ERROR_INSUFFICIENT_BUFFER) {
-
-            //
-            // Free the old table and allocate a new one of the required size.
-            //
-
-            if (InterfaceTable != NULL) {
-                free(InterfaceTable);
-            }
-
-            InterfaceTable = malloc(Size);
-            if (InterfaceTable == NULL) {
-                printf("Error: Unable to allocate %d bytes for interface "
-                       "table.\n",
-                       (int)Size);
-
-                Result = 0;
-                goto GetNetworkUsageEnd;
-            }
-
-            InterfaceTableSize = Size;
-
-            //
-            // Try the call again.
-            //
-
-            Status = GetIfTable(InterfaceTable, &Size, FALSE);
-        }
-
-        //
-        // Recheck the result.
-        //
-
-        if (Status != NO_ERROR) {
-            printf("Error: GetIfTable failed with status 0x%x.\n", (int)Status);
-            Result = 0;
-            goto GetNetworkUsageEnd;
-        }
+    Result = ReadInterfaceTable();
+    if (Result == 0) {
+        goto GetNetworkUsageEnd;
     }
 
     //
@@ -690,6 +660,83 @@ GetNetworkUsageEnd:
     return Result;
 }
 
+int
+GetNetworkCounters (
+    char *Interface,
+    unsigned long long *BytesReceived,
+    unsigned long long *BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queries how many bytes one network interface has moved
+    since it came up.
+
+Arguments:
+
+    Interface - Supplies the description of the interface, or its interface
+        index as a number, since descriptions can be long.
+
+    BytesReceived - Supplies a pointer where the total number of bytes
+        received on the interface will be returned.
+
+    BytesSent - Supplies a pointer where the total number of bytes sent on the
+        interface will be returned.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure, including if there is no interface by that name.
+
+--*/
+
+{
+
+    char *AfterNumber;
+    DWORD DescriptionLength;
+    int InterfaceIndex;
+    DWORD InterfaceNumber;
+    MIB_IFROW *InterfaceRow;
+    int Result;
+
+    Result = ReadInterfaceTable();
+    if (Result == 0) {
+        return 0;
+    }
+
+    InterfaceNumber = strtoul(Interface, &AfterNumber, 10);
+    if ((AfterNumber == Interface) || (*AfterNumber != '\0')) {
+        InterfaceNumber = 0;
+    }
+
+    DescriptionLength = strlen(Interface);
+    for (InterfaceIndex = 0;
+         InterfaceIndex < InterfaceTable->dwNumEntries;
+         InterfaceIndex += 1) {
+
+        InterfaceRow = (MIB_IFROW *)&(InterfaceTable->table[InterfaceIndex]);
+        if (((InterfaceNumber != 0) &&
+             (InterfaceRow->dwIndex == InterfaceNumber)) ||
+            ((InterfaceRow->dwDescrLen >= DescriptionLength) &&
+             (strncmp((char *)InterfaceRow->bDescr,
+                      Interface,
+                      DescriptionLength) == 0) &&
+             ((InterfaceRow->dwDescrLen == DescriptionLength) ||
+              (InterfaceRow->bDescr[DescriptionLength] == '\0')))) {
+
+            *BytesReceived = InterfaceRow->dwInOctets;
+            *BytesSent = InterfaceRow->dwOutOctets;
+            return 1;
+        }
+    }
+
+    printf("Error: There is no network interface %s.\n", Interface);
+    return 0;
+}
+
 int
 GetCurrentDateAndTime (
     int *Year,
@@ -754,7 +801,201 @@ Return Value:
     return 1;
 }
 
+int
+WaitForDeviceChange (
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for USB devices to come or go.
+
+Arguments:
+
+    Milliseconds - Supplies the longest time to wait. If the system can't
+        report device changes, a shorter interval is waited instead.
+
+Return Value:
+
+    Non-zero if the devices may have changed.
+
+    0 if the wait timed out with no change, or if the system can't report
+    device changes. In that case the caller decides when to look again.
+
+--*/
+
+{
+
+    if (Milliseconds > DEVICE_POLL_INTERVAL) {
+        Milliseconds = DEVICE_POLL_INTERVAL;
+    }
+
+    Sleep(Milliseconds);
+    return 0;
+}
+
+int
+ReadInput (
+    char *Buffer,
+    int BufferSize,
+    int Milliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for input to come in on stdin, then reads whatever is
+    there without waiting for more.
+
+Arguments:
+
+    Buffer - Supplies a pointer where the input will be returned.
+
+    BufferSize - Supplies the size of the buffer, in bytes.
+
+    Milliseconds - Supplies the longest time to wait for input.
+
+Return Value:
+
+    Returns the number of bytes read, which is 0 if the wait timed out.
+
+    -1 at the end of the input, or on failure.
+
+--*/
+
+{
+
+    DWORD Available;
+    DWORD BytesRead;
+    HANDLE Input;
+    DWORD Waited;
+
+    //
+    // Pipes can be checked for input without blocking, but there's no way to
+    // wait on one, so check every so often. Anything else, like a file, is
+    // just read.
+    //
+
+    Input = GetStdHandle(STD_INPUT_HANDLE);
+    Waited = 0;
+    while (TRUE) {
+        if (PeekNamedPipe(Input, NULL, 0, NULL, &Available, NULL) == FALSE) {
+            if (GetLastError() == ERROR_BROKEN_PIPE) {
+                return -1;
+            }
+
+            Available = (DWORD)BufferSize;
+            break;
+        }
+
+        if (Available != 0) {
+            if (Available > (DWORD)BufferSize) {
+                Available = (DWORD)BufferSize;
+            }
+
+            break;
+        }
+
+        if (Waited >= (DWORD)Milliseconds) {
+            return 0;
+        }
+
+        Sleep(INPUT_POLL_INTERVAL);
+        Waited += INPUT_POLL_INTERVAL;
+    }
+
+    if ((ReadFile(Input, Buffer, Available, &BytesRead, NULL) == FALSE) ||
+        (BytesRead == 0)) {
+
+        return -1;
+    }
+
+    return BytesRead;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+int
+ReadInterfaceTable (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the table of network interfaces, growing the buffer it
+    goes in if need be.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Non-zero on success.
+
+    0 on failure.
+
+--*/
+
+{
+
+    DWORD Size;
+    DWORD Status;
+
+    Size = InterfaceTableSize;
+    Status = GetIfTable(InterfaceTable, &Size, FALSE);
+    if (Status != NO_ERROR) {
+
+        //
+        // If this is the first time and there is no buffer, or the required
+        // buffer got bigger, reallocate with the needed size.
+        //
+
+        if (Status == ERROR_INSUFFICIENT_BUFFER) {
+
+            //
+            // Free the old table and allocate a new one of the required size.
+            //
+
+            if (InterfaceTable != NULL) {
+                free(InterfaceTable);
+            }
+
+            InterfaceTable = malloc(Size);
+            if (InterfaceTable == NULL) {
+                printf("Error: Unable to allocate %d bytes for interface "
+                       "table.\n",
+                       (int)Size);
+
+                InterfaceTableSize = 0;
+                return 0;
+            }
+
+            InterfaceTableSize = Size;
+
+            //
+            // Try the call again.
+            //
+
+            Status = GetIfTable(InterfaceTable, &Size, FALSE);
+        }
+
+        //
+        // Recheck the result.
+        //
+
+        if (Status != NO_ERROR) {
+            printf("Error: GetIfTable failed with status 0x%x.\n", (int)Status);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
@@ -30,6 +30,7 @@ Environment:
 //
 
 #include <avr/pgmspace.h>
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include "usb.h"
 #include "usbled.h"
@@ -72,6 +73,38 @@ Environment:
 
 #define USBLED_GET_BUTTON_STATE 1
 
+//
+// This command sets the brightness of a digit. The value holds the
+// brightness, and the index holds the digit. An index past the last digit
+// sets every digit.
+//
+
+#define USBLED_SET_BRIGHTNESS 2
+
+//
+// This command writes raw segment masks straight into the digits, one byte
+// per digit, starting at the digit in the index.
+//
+
+#define USBLED_SET_SEGMENTS 3
+
+//
+// This command makes digits blink. The value holds the mask of digits that
+// blink, the low byte of the index holds how many frames they stay on and
+// off for, and the high byte holds the segments that blink. A period of zero
+// stops the blinking.
+//
+
+#define USBLED_SET_BLINK 4
+
+//
+// This command scrolls lines across the display like a marquee. The value
+// holds how many frames go by between steps, and the index holds the mask
+// of lines that scroll. A period of zero stops the scrolling.
+//
+
+#define USBLED_SET_SCROLL 5
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -101,13 +134,70 @@ Return Value:
 
 --*/
 
+unsigned char
+GetDigitSegments (
+    unsigned char Digit,
+    unsigned char Time,
+    unsigned char *End
+    );
+
+/*++
+
+Routine Description:
+
+    This routine figures out what a digit of the display shows at the given
+    point in its slot, after scrolling, blinking and brightness.
+
+Arguments:
+
+    Digit - Supplies the position of the digit on the display.
+
+    Time - Supplies how far into the slot the timer is, in timer ticks.
+
+    End - Supplies a pointer to the time of the next change in the slot. This
+        is moved up if the digit goes dark sooner.
+
+Return Value:
+
+    Returns the segments to light for the digit.
+
+--*/
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 unsigned char DigitState[USBLED_DIGIT_COUNT];
+unsigned char DigitBrightness[USBLED_DIGIT_COUNT];
 unsigned char CurrentCursor;
+unsigned char RawSegments;
 unsigned char ButtonPressed;
+
+//
+// Store the state of the display multiplexing, which is only touched by the
+// timer interrupt. The time is how far into the current column's slot the
+// timer is, in timer ticks.
+//
+
+unsigned char MultiplexColumn;
+unsigned char MultiplexTime;
+unsigned char MultiplexBusy;
+
+//
+// Store the animation state. The host sets up the blinking and scrolling once,
+// and the timer interrupt runs them every frame (each time around all eight
+// columns) from then on.
+//
+
+unsigned short BlinkMask;
+unsigned char BlinkSegments;
+unsigned char BlinkPeriod;
+unsigned char BlinkCount;
+unsigned char BlinkOff;
+unsigned char ScrollLines;
+unsigned char ScrollPeriod;
+unsigned char ScrollCount;
+unsigned char ScrollOffset;
 unsigned char CharacterToDigit[] PROGMEM = {
     0xAF, // 0
     0x21, // 1
@@ -156,6 +246,8 @@ Return Value:
 
 {
 
+    unsigned char Index;
+    unsigned char Level;
     unsigned char Request;
     unsigned char ReturnCount;
 
@@ -163,11 +255,41 @@ Return Value:
     ReturnCount = 0;
     if (Request == USBLED_SET_DISPLAY) {
         CurrentCursor = 0;
+        RawSegments = 0;
+
+    } else if (Request == USBLED_SET_SEGMENTS) {
+        CurrentCursor = Data[4];
+        RawSegments = 1;
+
+    } else if (Request == USBLED_SET_BLINK) {
+        BlinkMask = Data[2] | ((unsigned short)Data[3] << 8);
+        BlinkPeriod = Data[4];
+        BlinkSegments = Data[5];
+        BlinkCount = 0;
+        BlinkOff = 0;
+
+    } else if (Request == USBLED_SET_SCROLL) {
+        ScrollPeriod = Data[2];
+        ScrollLines = Data[4];
+        ScrollCount = 0;
+        ScrollOffset = 0;
 
     } else if (Request == USBLED_GET_BUTTON_STATE) {
         Data[0] = ButtonPressed;
         ButtonPressed = 0;
         ReturnCount = 1;
+
+    } else if (Request == USBLED_SET_BRIGHTNESS) {
+        Level = Data[2];
+        if (Level > USBLED_MAX_BRIGHTNESS) {
+            Level = USBLED_MAX_BRIGHTNESS;
+        }
+
+        for (Index = 0; Index < USBLED_DIGIT_COUNT; Index += 1) {
+            if ((Data[4] >= USBLED_DIGIT_COUNT) || (Data[4] == Index)) {
+                DigitBrightness[Index] = Level;
+            }
+        }
     }
 
     return ReturnCount;
@@ -215,7 +337,8 @@ usb_out (
 Routine Description:
 
     This routine handles host to device packets. It receives data coming from
-    the host into this device.
+    the host into this device, either as text or as raw segment masks
+    depending on the command that started the transfer.
 
 Arguments:
 
@@ -235,6 +358,17 @@ Return Value:
     unsigned char LookupIndex;
     unsigned char Value;
 
+    if (RawSegments != 0) {
+        for (Index = 0; Index < Length; Index += 1) {
+            if (CurrentCursor < USBLED_DIGIT_COUNT) {
+                DigitState[CurrentCursor] = Data[Index];
+                CurrentCursor += 1;
+            }
+        }
+
+        return;
+    }
+
     for (Index = 0; Index < Length; Index += 1) {
 
         //
@@ -304,6 +438,137 @@ Return Value:
     return;
 }
 
+ISR(TIMER0_COMPA_vect, ISR_NOBLOCK)
+
+/*++
+
+Routine Description:
+
+    This routine multiplexes the display. Each of the eight columns gets a slot
+    of the same length in turn, and each digit in the column stays lit for the
+    part of the slot its brightness calls for. The timer interrupts at the
+    start of every slot and whenever a digit goes dark partway through one.
+    Blinking and scrolling move along once per frame.
+
+    Interrupts are enabled on the way in, as the USB interrupt can't wait for
+    the shift register to be written. If the USB interrupt holds this one off
+    long enough for it to come around again, the second one simply returns.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    unsigned char Column;
+    unsigned char End;
+    unsigned char FirstLine;
+    unsigned char SecondLine;
+    unsigned char Time;
+
+    if (MultiplexBusy != 0) {
+        return;
+    }
+
+    MultiplexBusy = 1;
+    Column = MultiplexColumn;
+    Time = MultiplexTime;
+    if (Time == USBLED_SLOT_TICKS) {
+        Column = (Column + 1) & (USBLED_COLUMNS - 1);
+        MultiplexColumn = Column;
+        Time = 0;
+
+        //
+        // At the start of each frame, move the blinking and scrolling along.
+        //
+
+        if (Column == 0) {
+            BlinkCount += 1;
+            if ((BlinkPeriod != 0) && (BlinkCount >= BlinkPeriod)) {
+                BlinkCount = 0;
+                BlinkOff ^= 1;
+            }
+
+            ScrollCount += 1;
+            if ((ScrollPeriod != 0) && (ScrollCount >= ScrollPeriod)) {
+                ScrollCount = 0;
+                ScrollOffset = (ScrollOffset + 1) & (USBLED_COLUMNS - 1);
+            }
+        }
+    }
+
+    //
+    // Figure out what the column's two digits show at this point in the slot,
+    // and when the next change happens.
+    //
+
+    End = USBLED_SLOT_TICKS;
+    SecondLine = GetDigitSegments(Column + USBLED_COLUMNS, Time, &End);
+    FirstLine = GetDigitSegments(Column, Time, &End);
+
+    //
+    // Turn the selector off, write out the new bytes, and flip them into the
+    // register.
+    //
+
+    PORTB &= ~SELECT_DIGIT0;
+    PORTD = 0;
+    WriteSpiByte(SecondLine);
+    WriteSpiByte(FirstLine);
+    PORTB |= SHIFT_REGISTER_CS;
+    PORTB &= ~SHIFT_REGISTER_CS;
+
+    //
+    // Select the column if anything in it is lit. The USB LED and USB LED Mini
+    // differ here in that digits 1-4 and 5-8 are reversed.
+    //
+
+    if ((FirstLine | SecondLine) != 0) {
+
+#ifdef USBLED_MINI
+
+        if (Column == 4) {
+            PORTB |= SELECT_DIGIT0;
+
+        } else {
+            PORTD |= 1 << ((3 - Column) & 0x7);
+        }
+
+#else
+
+        if (Column == 0) {
+            PORTB |= SELECT_DIGIT0;
+
+        } else {
+            PORTD |= 1 << ((7 - Column) & 0x7);
+        }
+
+#endif
+
+    }
+
+    //
+    // Set the timer to go off at the next change. If the USB interrupt held
+    // this one up past that point, start the wait over rather than letting the
+    // timer run all the way around.
+    //
+
+    OCR0A = End - Time - 1;
+    if (TCNT0 >= OCR0A) {
+        TCNT0 = 0;
+    }
+
+    MultiplexTime = End;
+    MultiplexBusy = 0;
+    return;
+}
+
 __attribute__((naked))
 extern
 int
@@ -331,9 +596,12 @@ Return Value:
 
 {
 
-    unsigned char Column;
+    unsigned char Index;
 
     ButtonPressed = 0;
+    for (Index = 0; Index < USBLED_DIGIT_COUNT; Index += 1) {
+        DigitBrightness[Index] = USBLED_MAX_BRIGHTNESS;
+    }
 
     //
     // Set up the I/O port initial values and data direction registers.
@@ -345,7 +613,18 @@ Return Value:
     DDRD = PORTD_DATA_DIRECTION_VALUE;
 
     //
-    // Initialize the USB library.
+    // Start the timer that multiplexes the display. It counts up to the end
+    // of each slot and starts over.
+    //
+
+    MultiplexTime = USBLED_SLOT_TICKS;
+    OCR0A = USBLED_SLOT_TICKS - 1;
+    TCCR0A = 1 << WGM01;
+    TCCR0B = USBLED_TIMER_PRESCALER;
+    TIMSK |= 1 << OCIE0A;
+
+    //
+    // Initialize the USB library. This also enables interrupts.
     //
 
     usb_init();
@@ -359,10 +638,10 @@ Return Value:
     DigitState[0] = USBLED_DASH;
 
     //
-    // Enter the main program loop.
+    // Enter the main program loop. The display takes care of itself in the
+    // timer interrupt, so all that's left is USB and the button.
     //
 
-    Column = 0;
     while (1) {
 
         //
@@ -372,72 +651,76 @@ Return Value:
         usb_poll();
 
         //
-        // Flip the data into the register.
+        // Check the button state.
         //
 
-        PORTB |= SHIFT_REGISTER_CS;
+        if ((PINB & BUTTON_BIT) == 0) {
+            ButtonPressed = 1;
+        }
+    }
 
-        //
-        // The USB LED and USB LED Mini differ here in that digits 1-4 and 5-8
-        // are reversed.
-        //
+    return 0;
+}
 
-#ifdef USBLED_MINI
+//
+// --------------------------------------------------------- Internal Functions
+//
 
-        if (Column == 5) {
-            PORTB |= SELECT_DIGIT0;
+unsigned char
+GetDigitSegments (
+    unsigned char Digit,
+    unsigned char Time,
+    unsigned char *End
+    )
 
-        } else {
-            PORTD |= 1 << ((4 - Column) & 0x7);
-        }
+/*++
 
-#else
+Routine Description:
 
-        if (Column == 1) {
-            PORTB |= SELECT_DIGIT0;
+    This routine figures out what a digit of the display shows at the given
+    point in its slot, after scrolling, blinking and brightness.
 
-        } else {
-            PORTD |= 1 << ((8 - Column) & 0x7);
-        }
-#endif
+Arguments:
 
-        //
-        // Write out the next bytes.
-        //
+    Digit - Supplies the position of the digit on the display.
 
-        WriteSpiByte(DigitState[Column + 8]);
-        WriteSpiByte(DigitState[Column]);
+    Time - Supplies how far into the slot the timer is, in timer ticks.
 
-        //
-        // Turn the selector off.
-        //
+    End - Supplies a pointer to the time of the next change in the slot. This
+        is moved up if the digit goes dark sooner.
+
+Return Value:
 
-        PORTB &= ~SELECT_DIGIT0;
-        PORTD = 0;
-        PORTB &= ~SHIFT_REGISTER_CS;
+    Returns the segments to light for the digit.
 
-        //
-        // Move to the next column.
-        //
+--*/
 
-        Column += 1;
-        if (Column == 8) {
-            Column = 0;
-        }
+{
 
-        //
-        // Check the button state.
-        //
+    unsigned char Level;
+    unsigned char Segments;
+    unsigned char Source;
 
-        if ((PINB & BUTTON_BIT) == 0) {
-            ButtonPressed = 1;
-        }
+    Source = Digit;
+    if ((ScrollLines & (1 << (Digit / USBLED_COLUMNS))) != 0) {
+        Source = (Digit & ~(USBLED_COLUMNS - 1)) |
+                 ((Digit + ScrollOffset) & (USBLED_COLUMNS - 1));
     }
 
-    return 0;
-}
+    Level = DigitBrightness[Source] << USBLED_BRIGHTNESS_SHIFT;
+    if (Level <= Time) {
+        return 0;
+    }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
+    if (Level < *End) {
+        *End = Level;
+    }
+
+    Segments = DigitState[Source];
+    if ((BlinkOff != 0) && ((BlinkMask & ((unsigned short)1 << Source)) != 0)) {
+        Segments &= ~BlinkSegments;
+    }
+
+    return Segments;
+}
 
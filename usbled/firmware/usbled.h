@@ -65,6 +65,19 @@ Author:
 #define USBLED_PERIOD 0x10
 #define USBLED_DASH 0x40
 
+//
+// Define the display multiplexing timer. Timer 0 runs at 12MHz / 64, and each
+// column gets a slot of 128 ticks (683us), so the whole display is refreshed
+// about 183 times a second. A digit stays lit for eight ticks of its slot for
+// each level of brightness, so a brightness of 16 lights it for the whole
+// slot.
+//
+
+#define USBLED_TIMER_PRESCALER ((1 << CS01) | (1 << CS00))
+#define USBLED_MAX_BRIGHTNESS 16
+#define USBLED_BRIGHTNESS_SHIFT 3
+#define USBLED_SLOT_TICKS (USBLED_MAX_BRIGHTNESS << USBLED_BRIGHTNESS_SHIFT)
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -72,6 +85,7 @@ Author:
 #ifndef __ASSEMBLY__
 
 extern unsigned char DigitState[USBLED_DIGIT_COUNT];
+extern unsigned char DigitBrightness[USBLED_DIGIT_COUNT];
 extern unsigned char CurrentCursor;
 extern unsigned char CharacterToDigit[] PROGMEM;
 
@@ -51,7 +51,7 @@
 //#define    USBTINY_DEVICE_ID        0x0650
 
 // The version of the device as a 16-bit number: 256*major + minor.
-#define    USBTINY_DEVICE_VERSION        0x101
+#define    USBTINY_DEVICE_VERSION        0x103
 
 // The following optional macros may be used as an identification of
 // your device. Undefine them when you run out of flash space.